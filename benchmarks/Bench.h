@@ -0,0 +1,251 @@
+#ifndef CONFIG4CPP_BENCHMARKS_BENCH_H_
+#define CONFIG4CPP_BENCHMARKS_BENCH_H_
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// Support shared by the benchmarks.
+//
+// Each measurement is repeated, and the best time is reported, because it is
+// the one least disturbed by whatever else the machine was doing.  Inputs are
+// generated deterministically, so runs on the same machine are comparable.
+//
+// Every benchmark accepts "--json <file>", and then also writes its results
+// to that file, for tracking regressions over time.  Any other arguments are
+// left for the benchmark itself.
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+// The best time, in seconds, of several runs of fn.
+template <typename FnT>
+double
+best_seconds(int trials, FnT && fn)
+{
+    double best = 0;
+    for (int trial = 0; trial < trials; ++trial) {
+        auto const start = Clock::now();
+        fn();
+        auto const stop = Clock::now();
+        double const secs = std::chrono::duration<double>(stop - start).count();
+        if (trial == 0 || secs < best) {
+            best = secs;
+        }
+    }
+    return best;
+}
+
+// The best time per operation, in nanoseconds, when fn performs ops
+// operations.
+template <typename FnT>
+double
+ns_per_op(std::size_t ops, FnT && fn)
+{
+    return best_seconds(5, fn) * 1e9 / double(ops);
+}
+
+// The number of bytes of heap in use, or -1 if the C library cannot say.
+inline long long
+heap_in_use()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 const info = mallinfo2();
+    return static_cast<long long>(info.uordblks + info.hblkhd);
+#else
+    return -1;
+#endif
+}
+
+// The peak resident set size of the process so far, in bytes, or -1 if it
+// is not known.
+inline long long
+peak_rss()
+{
+#if defined(__APPLE__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<long long>(usage.ru_maxrss);
+#elif defined(__unix__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<long long>(usage.ru_maxrss) * 1024;
+#else
+    return -1;
+#endif
+}
+
+// A named parameter of a result, such as the size of a scope.  The value is
+// held as JSON text.
+struct Param
+{
+    std::string name;
+    std::string json;
+};
+
+inline std::string
+json_string(std::string const & str)
+{
+    std::string result = "\"";
+    for (char ch : str) {
+        if (ch == '"' || ch == '\\') {
+            result += '\\';
+            result += ch;
+        } else if (static_cast<unsigned char>(ch) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+            result += buf;
+        } else {
+            result += ch;
+        }
+    }
+    return result + '"';
+}
+
+inline Param
+param(std::string name, std::string const & value)
+{
+    return {std::move(name), json_string(value)};
+}
+
+inline Param
+param(std::string name, char const * value)
+{
+    return param(std::move(name), std::string(value));
+}
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic_v<T>, Param>
+param(std::string name, T value)
+{
+    std::ostringstream strm;
+    strm << std::boolalpha << value;
+    return {std::move(name), strm.str()};
+}
+
+class Results
+{
+public:
+    Results(char const * suite, int argc, char * argv[])
+    : suite_(suite)
+    {
+        for (int i = 1; i < argc; ++i) {
+            if (std::string(argv[i]) == "--json") {
+                if (i + 1 == argc) {
+                    throw std::runtime_error("--json requires a file name");
+                }
+                json_path_ = argv[++i];
+            } else {
+                args_.push_back(argv[i]);
+            }
+        }
+    }
+
+    // The command-line arguments, other than "--json <file>".
+    std::vector<std::string> const & args() const { return args_; }
+
+    void add(
+        std::string name,
+        std::vector<Param> params,
+        double value,
+        char const * unit)
+    {
+        results_.push_back({std::move(name), std::move(params), value, unit});
+    }
+
+    // Write the results as JSON, if that was asked for.
+    void write() const
+    {
+        if (json_path_.empty()) {
+            return;
+        }
+        std::ofstream out(json_path_);
+        out << "{\n"
+            << "  \"suite\": " << json_string(suite_) << ",\n"
+            << "  \"context\": {\n"
+            << "    \"timestamp\": " << json_string(timestamp()) << ",\n"
+            << "    \"compiler\": " << json_string(compiler()) << ",\n"
+#ifdef NDEBUG
+            << "    \"build\": \"release\",\n"
+#else
+            << "    \"build\": \"debug\",\n"
+#endif
+            << "    \"hardware_concurrency\": "
+            << std::thread::hardware_concurrency() << "\n"
+            << "  },\n"
+            << "  \"results\": [";
+        char const * separator = "\n";
+        for (auto const & result : results_) {
+            out << separator << "    {\"name\": " << json_string(result.name)
+                << ", \"params\": {";
+            char const * param_separator = "";
+            for (auto const & p : result.params) {
+                out << param_separator << json_string(p.name) << ": "
+                    << p.json;
+                param_separator = ", ";
+            }
+            char value[64];
+            std::snprintf(value, sizeof(value), "%.6g", result.value);
+            out << "}, \"value\": " << value
+                << ", \"unit\": " << json_string(result.unit) << "}";
+            separator = ",\n";
+        }
+        out << "\n  ]\n}\n";
+        if (not out) {
+            throw std::runtime_error("cannot write " + json_path_);
+        }
+    }
+
+private:
+    struct Result
+    {
+        std::string name;
+        std::vector<Param> params;
+        double value;
+        std::string unit;
+    };
+
+    static std::string timestamp()
+    {
+        std::time_t const now = std::time(nullptr);
+        char buf[32];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+        return buf;
+    }
+
+    static std::string compiler()
+    {
+#if defined(__clang__)
+        return "clang " __clang_version__;
+#elif defined(__GNUC__)
+        return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc " + std::to_string(_MSC_VER);
+#else
+        return "unknown";
+#endif
+    }
+
+    std::string suite_;
+    std::string json_path_;
+    std::vector<std::string> args_;
+    std::vector<Result> results_;
+};
+
+} // namespace bench
+
+#endif
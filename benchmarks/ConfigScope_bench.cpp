@@ -0,0 +1,256 @@
+#include "Bench.h"
+#include "src/ConfigItem.h"
+#include "src/ConfigScope.h"
+#include "src/SourceFileTable.h"
+#include "src/StringPool.h"
+
+#include "config4cpp/ConfigurationException.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Measures the cost of ConfigScope::findItem() for scopes of various sizes.
+// Names are looked up in a random order, so that large scopes do not get the
+// benefit of walking memory in insertion order.  Also reports what it costs,
+// in memory and time, for each of a million items to record the file and
+// line it was defined at, and how much memory interning saves for a
+// configuration made of many "uid-" scopes with the same names.
+
+namespace {
+namespace cfg = CONFIG4CPP_NAMESPACE;
+
+std::vector<std::string>
+make_names(std::mt19937 & rng, std::size_t count, char const * prefix)
+{
+    // Mimic generated configurations, where names are short, and share a
+    // common prefix with a numeric suffix.
+    std::vector<std::string> result;
+    result.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        result.push_back(prefix + std::to_string(i));
+    }
+    std::shuffle(result.begin(), result.end(), rng);
+    return result;
+}
+
+void
+bench_find(bench::Results & results, std::size_t size)
+{
+    std::mt19937 rng(static_cast<std::mt19937::result_type>(size));
+    auto const names = make_names(rng, size, "host_");
+    auto const misses = make_names(rng, size, "port_");
+
+    cfg::ConfigScope scope(nullptr, "");
+    for (auto const & name : names) {
+        if (not scope.addOrReplaceString(name.c_str(), "value")) {
+            throw std::runtime_error("addOrReplaceString returned false");
+        }
+    }
+
+    auto order = names;
+    std::shuffle(order.begin(), order.end(), rng);
+
+    // Repeat small tables so that each measurement covers enough operations
+    // to swamp the cost of reading the clock.
+    std::size_t const rounds = std::max<std::size_t>(1, 4000000 / size);
+    std::size_t found = 0;
+
+    double const hit = bench::ns_per_op(rounds * size, [&] {
+        for (std::size_t r = 0; r < rounds; ++r) {
+            for (auto const & name : order) {
+                found += scope.findItem(name.c_str()) != nullptr;
+            }
+        }
+    });
+    double const miss = bench::ns_per_op(rounds * size, [&] {
+        for (std::size_t r = 0; r < rounds; ++r) {
+            for (auto const & name : misses) {
+                found += scope.findItem(name.c_str()) != nullptr;
+            }
+        }
+    });
+
+    if (found != 5 * rounds * size) {
+        throw std::runtime_error("findItem returned unexpected results");
+    }
+
+    char line[128];
+    std::snprintf(
+        line,
+        sizeof(line),
+        "findItem  entries=%-8zu hit=%7.2f ns/op  miss=%7.2f ns/op",
+        size,
+        hit,
+        miss);
+    std::cout << line << std::endl;
+    results.add(
+        "findItem", {bench::param("entries", size), bench::param("hit", true)},
+        hit, "ns/op");
+    results.add(
+        "findItem", {bench::param("entries", size), bench::param("hit", false)},
+        miss, "ns/op");
+}
+
+// The layout of ConfigItem before it recorded locations, when its value
+// pointers were separate members, for comparison.
+struct ItemWithoutLocation
+{
+    virtual ~ItemWithoutLocation() = default;
+    cfg::Configuration::Type type;
+    char * name;
+    char * stringVal;
+    cfg::StringVector * listVal;
+    cfg::ConfigScope * scope;
+    std::atomic<unsigned long long> cachedValue;
+};
+
+void
+bench_locations(bench::Results & results, std::size_t count)
+{
+    // Generated configurations are typically split over a few files.
+    std::size_t const num_files = 16;
+    std::vector<unsigned int> files;
+    for (std::size_t i = 0; i < num_files; ++i) {
+        auto const name = "ConfigScope_bench_" + std::to_string(i) + ".cfg";
+        files.push_back(cfg::SourceFileTable::intern(name.c_str()));
+    }
+    std::vector<std::string> names;
+    names.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        names.push_back("host_" + std::to_string(i));
+    }
+
+    cfg::ConfigScope scope(nullptr, "");
+    scope.reserve(static_cast<int>(count));
+    double const insert = bench::ns_per_op(count, [&] {
+        for (std::size_t i = 0; i < count; ++i) {
+            cfg::ConfigItem * item =
+                scope.addOrReplaceString(names[i].c_str(), "value");
+            item->setLocation(
+                files[i % num_files], static_cast<unsigned int>(i + 1));
+        }
+    });
+    std::size_t found = 0;
+    double const locate = bench::ns_per_op(count, [&] {
+        for (std::size_t i = 0; i < count; ++i) {
+            cfg::ConfigItem const * item = scope.findItem(names[i].c_str());
+            found += cfg::SourceFileTable::fileName(item->fileIndex())[0] != 0
+                && item->lineNum() == i + 1;
+        }
+    });
+    if (found != 5 * count) {
+        throw std::runtime_error("locations were not recorded");
+    }
+
+    // The only per-item cost is the two 32-bit words in ConfigItem; the
+    // file names are stored once, in SourceFileTable.
+    char line[160];
+    std::snprintf(
+        line,
+        sizeof(line),
+        "locations  items=%-8zu ConfigItem=%zu bytes (was %zu)  "
+        "insert=%7.2f ns/op  locate=%7.2f ns/op",
+        count,
+        sizeof(cfg::ConfigItem),
+        sizeof(ItemWithoutLocation),
+        insert,
+        locate);
+    std::cout << line << std::endl;
+    results.add(
+        "ConfigItem size", {bench::param("locations", true)},
+        double(sizeof(cfg::ConfigItem)), "bytes");
+    results.add(
+        "ConfigItem size", {bench::param("locations", false)},
+        double(sizeof(ItemWithoutLocation)), "bytes");
+    results.add(
+        "insert with location", {bench::param("entries", count)}, insert,
+        "ns/op");
+    results.add(
+        "locate", {bench::param("entries", count)}, locate, "ns/op");
+}
+
+// Builds what a generated configuration looks like: many "uid-" scopes
+// that repeat the same names, and mostly the same values, and reports
+// how much of the arena interning saves.
+void
+bench_interning(bench::Results & results, std::size_t num_scopes)
+{
+    std::size_t reserved = 0;
+    std::size_t saved = 0;
+    int num_strings = 0;
+    double const insert = bench::ns_per_op(num_scopes * 3, [&] {
+        cfg::Arena arena;
+        cfg::StringPool strings(arena);
+        cfg::ConfigScope * root = new (arena) cfg::ConfigScope(&strings);
+        for (std::size_t i = 0; i < num_scopes; ++i) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "uid-%09zu-server", i);
+            cfg::ConfigScope * scope;
+            root->ensureScopeExists(name, scope);
+            auto const host = "db-" + std::to_string(i % 16) + ".example.com";
+            scope->addOrReplaceString("host", host.c_str());
+            scope->addOrReplaceString("port", "5432");
+            scope->addOrReplaceString("timeout", "30");
+        }
+        reserved = arena.bytesReserved();
+        saved = strings.bytesSaved();
+        num_strings = strings.numStrings();
+    });
+
+    char line[200];
+    std::snprintf(
+        line,
+        sizeof(line),
+        "interning  scopes=%-8zu strings=%-8d arena=%7.2f MB  "
+        "saved=%7.2f MB (%4.1f%%)  insert=%7.2f ns/op",
+        num_scopes,
+        num_strings,
+        double(reserved) / (1024 * 1024),
+        double(saved) / (1024 * 1024),
+        100.0 * double(saved) / double(reserved + saved),
+        insert);
+    std::cout << line << std::endl;
+    results.add(
+        "arena", {bench::param("scopes", num_scopes)},
+        double(reserved) / (1024 * 1024), "MB");
+    results.add(
+        "saved by interning", {bench::param("scopes", num_scopes)},
+        double(saved) / (1024 * 1024), "MB");
+    results.add(
+        "insert interned", {bench::param("scopes", num_scopes)}, insert,
+        "ns/op");
+}
+
+int
+Main(int argc, char * argv[])
+{
+    bench::Results results("ConfigScope", argc, argv);
+    for (std::size_t size : {16u, 256u, 4096u, 65536u, 262144u}) {
+        bench_find(results, size);
+    }
+    bench_locations(results, 1000000);
+    bench_interning(results, 200000);
+    results.write();
+    return 0;
+}
+
+} // anonymous namespace
+
+int
+main(int argc, char * argv[])
+{
+    try {
+        return Main(argc, argv);
+    } catch (cfg::ConfigurationException const & ex) {
+        std::cerr << "exception: " << ex.c_str() << '\n';
+    } catch (std::exception const & ex) {
+        std::cerr << "exception: " << ex.what() << '\n';
+    }
+    return 1;
+}
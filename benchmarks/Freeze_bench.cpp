@@ -0,0 +1,138 @@
+#include "Bench.h"
+
+#include "config4cpp/Configuration.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Measures aggregate read throughput when many threads look up values in
+// one configuration: first with every lookup serialised by a mutex, as is
+// needed for a Configuration that may be updated, then with no locking on
+// a frozen copy.
+
+namespace {
+namespace cfg = CONFIG4CPP_NAMESPACE;
+
+using Clock = std::chrono::steady_clock;
+
+// Run fn in num_threads threads, several times, and report the best
+// aggregate rate, in millions of lookups per second.
+template <typename FnT>
+double
+mlookups_per_sec(int num_threads, std::size_t ops_per_thread, FnT && fn)
+{
+    double best = 0;
+    for (int trial = 0; trial < 5; ++trial) {
+        std::vector<std::thread> threads;
+        auto const start = Clock::now();
+        for (int t = 0; t < num_threads; ++t) {
+            threads.emplace_back(fn);
+        }
+        for (auto & thread : threads) {
+            thread.join();
+        }
+        auto const stop = Clock::now();
+        double const us =
+            std::chrono::duration<double, std::micro>(stop - start).count();
+        double const rate = double(ops_per_thread) * num_threads / us;
+        if (rate > best) {
+            best = rate;
+        }
+    }
+    return best;
+}
+
+int
+Main(int argc, char * argv[])
+{
+    bench::Results results("freeze", argc, argv);
+
+    std::string input;
+    for (int i = 0; i < 500; ++i) {
+        input += "server.var_" + std::to_string(i) + " = \"" +
+            std::to_string(i) + "\";\n";
+    }
+    cfg::Configuration * config = cfg::Configuration::create();
+    config->parse(cfg::Configuration::INPUT_STRING, input.c_str());
+    cfg::Configuration * frozen = config->freeze();
+
+    std::vector<cfg::Configuration::Key> keys;
+    for (int i = 0; i < 500; i += 3) {
+        keys.emplace_back("server", ("var_" + std::to_string(i)).c_str());
+    }
+
+    std::size_t const rounds = 200;
+    std::size_t const ops_per_thread = rounds * keys.size();
+    std::mutex mutex;
+    std::atomic<long> sum{0};
+
+    std::cout << "threads   mutex (Mlookups/s)   frozen (Mlookups/s)\n";
+    for (int num_threads : {1, 2, 4, 8, 16, 64}) {
+        double const locked =
+            mlookups_per_sec(num_threads, ops_per_thread, [&] {
+                long local = 0;
+                for (std::size_t r = 0; r < rounds; ++r) {
+                    for (auto const & key : keys) {
+                        std::lock_guard<std::mutex> guard(mutex);
+                        local += config->lookupInt(key);
+                    }
+                }
+                sum += local;
+            });
+        double const lock_free =
+            mlookups_per_sec(num_threads, ops_per_thread, [&] {
+                long local = 0;
+                for (std::size_t r = 0; r < rounds; ++r) {
+                    for (auto const & key : keys) {
+                        local += frozen->lookupInt(key);
+                    }
+                }
+                sum += local;
+            });
+        char line[128];
+        std::snprintf(
+            line,
+            sizeof(line),
+            "%7d   %18.2f   %19.2f",
+            num_threads,
+            locked,
+            lock_free);
+        std::cout << line << std::endl;
+        results.add(
+            "lookupInt (mutex)", {bench::param("threads", num_threads)},
+            locked, "Mlookups/s");
+        results.add(
+            "lookupInt (frozen)", {bench::param("threads", num_threads)},
+            lock_free, "Mlookups/s");
+    }
+
+    frozen->destroy();
+    config->destroy();
+    if (sum == 0) {
+        throw std::runtime_error("lookups returned unexpected results");
+    }
+    results.write();
+    return 0;
+}
+
+} // anonymous namespace
+
+int
+main(int argc, char * argv[])
+{
+    try {
+        return Main(argc, argv);
+    } catch (cfg::ConfigurationException const & ex) {
+        std::cerr << "exception: " << ex.c_str() << '\n';
+    } catch (std::exception const & ex) {
+        std::cerr << "exception: " << ex.what() << '\n';
+    }
+    return 1;
+}
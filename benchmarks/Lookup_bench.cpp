@@ -0,0 +1,511 @@
+#include "Bench.h"
+
+#include "config4cpp/Configuration.h"
+#include "config4cpp/ConfigurationExt.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Measures the lookup path:
+//  - lookupString(), lookupInt() and lookupList(), for scopes at several
+//    depths and of several sizes, both with (scope, localName) strings, which
+//    are merged and split on every call, and with pre-compiled
+//    Configuration::Key objects;
+//  - lookups that fall through to a default value;
+//  - lookups that go through chains of fallback and override configurations;
+//  - listFullyScopedNames(), with and without filter patterns;
+//  - looking up a large list by copying it and as a ListView.
+
+namespace {
+namespace cfg = CONFIG4CPP_NAMESPACE;
+
+using ConfigPtr = std::unique_ptr<cfg::Configuration, void (*)(cfg::Configuration *)>;
+
+ConfigPtr
+make_config()
+{
+    return ConfigPtr(
+        cfg::Configuration::create(), [](cfg::Configuration * c) { c->destroy(); });
+}
+
+// "s0.s1. ... .s<depth-1>"
+std::string
+scope_name(int depth)
+{
+    std::string result;
+    for (int i = 0; i < depth; ++i) {
+        result += (i == 0 ? "s" : ".s") + std::to_string(i);
+    }
+    return result;
+}
+
+// Variables var_<i> (an integer string) and list_<i> (a short list) in the
+// scope at the given depth.
+std::string
+make_input(int depth, int size)
+{
+    std::string input;
+    std::string const scope = scope_name(depth);
+    for (int i = 0; i < size; ++i) {
+        auto const n = std::to_string(i);
+        input += scope + ".var_" + n + " = \"" + n + "\";\n" + scope +
+            ".list_" + n + " = [\"a\", \"b\", \"" + n + "\"];\n";
+    }
+    return input;
+}
+
+// Run a lookup over every name, enough times to swamp the cost of reading the
+// clock.
+template <typename ItemT, typename FnT>
+double
+lookup_ns(std::vector<ItemT> const & items, FnT && fn)
+{
+    std::size_t const rounds = 200000 / items.size();
+    return bench::ns_per_op(rounds * items.size(), [&] {
+        for (std::size_t r = 0; r < rounds; ++r) {
+            for (auto const & item : items) {
+                fn(item);
+            }
+        }
+    });
+}
+
+void
+report(
+    bench::Results & results,
+    char const * name,
+    char const * by,
+    int depth,
+    int size,
+    double ns)
+{
+    char line[128];
+    std::snprintf(
+        line,
+        sizeof(line),
+        "%-20s by=%-4s depth=%-2d size=%-5d %8.2f ns/op",
+        name,
+        by,
+        depth,
+        size,
+        ns);
+    std::cout << line << std::endl;
+    results.add(
+        name,
+        {bench::param("by", by),
+         bench::param("depth", depth),
+         bench::param("size", size)},
+        ns,
+        "ns/op");
+}
+
+long sum = 0;
+
+void
+bench_lookups(bench::Results & results, int depth, int size)
+{
+    auto config = make_config();
+    config->parse(cfg::Configuration::INPUT_STRING, make_input(depth, size).c_str());
+    std::string const scope = scope_name(depth);
+
+    // Look up (at most) 64 names, spread across the scope.
+    std::vector<std::string> vars, lists;
+    std::vector<cfg::Configuration::Key> var_keys, list_keys, missing_keys;
+    for (int i = 0; i < size; i += (size + 63) / 64) {
+        vars.push_back("var_" + std::to_string(i));
+        lists.push_back("list_" + std::to_string(i));
+        var_keys.emplace_back(scope.c_str(), vars.back().c_str());
+        list_keys.emplace_back(scope.c_str(), lists.back().c_str());
+        missing_keys.emplace_back("missing", vars.back().c_str());
+    }
+    char const * const s = scope.c_str();
+    char const ** array;
+    int len;
+
+    report(results, "lookupString", "name", depth, size,
+        lookup_ns(vars, [&](auto const & name) {
+            sum += config->lookupString(s, name.c_str())[0];
+        }));
+    report(results, "lookupString", "key", depth, size,
+        lookup_ns(var_keys, [&](auto const & key) {
+            sum += config->lookupString(key)[0];
+        }));
+    report(results, "lookupInt", "name", depth, size,
+        lookup_ns(vars, [&](auto const & name) {
+            sum += config->lookupInt(s, name.c_str());
+        }));
+    report(results, "lookupInt", "key", depth, size,
+        lookup_ns(var_keys, [&](auto const & key) {
+            sum += config->lookupInt(key);
+        }));
+    report(results, "lookupList", "name", depth, size,
+        lookup_ns(lists, [&](auto const & name) {
+            config->lookupList(s, name.c_str(), array, len);
+            sum += len;
+        }));
+    report(results, "lookupList", "key", depth, size,
+        lookup_ns(list_keys, [&](auto const & key) {
+            config->lookupList(key, array, len);
+            sum += len;
+        }));
+    report(results, "lookupInt (default)", "name", depth, size,
+        lookup_ns(vars, [&](auto const & name) {
+            sum += config->lookupInt("missing", name.c_str(), 1);
+        }));
+    report(results, "lookupInt (default)", "key", depth, size,
+        lookup_ns(missing_keys, [&](auto const & key) {
+            sum += config->lookupInt(key, 1);
+        }));
+}
+
+// A chain of length configurations, each the fallback (or override) of the
+// one before it, with the variables only in the last one.
+void
+bench_chain(bench::Results & results, char const * kind, int length)
+{
+    std::vector<ConfigPtr> chain;
+    for (int i = 0; i <= length; ++i) {
+        chain.push_back(make_config());
+        if (i > 0) {
+            if (std::string(kind) == "fallback") {
+                chain[i - 1]->setFallbackConfiguration(chain[i].get());
+            } else {
+                chain[i - 1]->setOverrideConfiguration(chain[i].get());
+            }
+        }
+    }
+    chain.back()->parse(cfg::Configuration::INPUT_STRING, make_input(2, 256).c_str());
+
+    std::vector<std::string> vars;
+    std::vector<cfg::Configuration::Key> keys;
+    for (int i = 0; i < 256; i += 4) {
+        vars.push_back("var_" + std::to_string(i));
+        keys.emplace_back("s0.s1", vars.back().c_str());
+    }
+    cfg::Configuration * const config = chain.front().get();
+    double const by_name = lookup_ns(vars, [&](auto const & name) {
+        sum += config->lookupInt("s0.s1", name.c_str());
+    });
+    double const by_key = lookup_ns(keys, [&](auto const & key) {
+        sum += config->lookupInt(key);
+    });
+
+    char line[128];
+    std::snprintf(
+        line,
+        sizeof(line),
+        "lookupInt %-9s  length=%-2d name=%8.2f ns/op  key=%8.2f ns/op",
+        kind,
+        length,
+        by_name,
+        by_key);
+    std::cout << line << std::endl;
+    std::string const name = std::string("lookupInt (") + kind + ")";
+    results.add(
+        name,
+        {bench::param("by", "name"), bench::param("length", length)},
+        by_name,
+        "ns/op");
+    results.add(
+        name,
+        {bench::param("by", "key"), bench::param("length", length)},
+        by_key,
+        "ns/op");
+}
+
+// Fifty filter patterns, of every kind that PatternSet distinguishes:
+// exact names, prefixes, suffixes and general patterns.
+std::vector<std::string>
+many_filters(int num_scopes, int size)
+{
+    std::vector<std::string> result;
+    for (int i = 0; i < 50; ++i) {
+        auto const scope = "scope_" + std::to_string(i * 7 % num_scopes);
+        auto const var = "var_" + std::to_string(i * 13 % size);
+        switch (i % 4) {
+        case 0: result.push_back(scope + "." + var); break;
+        case 1: result.push_back(scope + "." + var + "*"); break;
+        case 2: result.push_back("*." + var + "_x"); break;
+        case 3: result.push_back("*_" + std::to_string(i) + ".*" + var); break;
+        }
+    }
+    return result;
+}
+
+void
+bench_list(bench::Results & results, int num_scopes, int size)
+{
+    std::string input;
+    for (int s = 0; s < num_scopes; ++s) {
+        auto const scope = "scope_" + std::to_string(s);
+        for (int i = 0; i < size; ++i) {
+            input += scope + ".var_" + std::to_string(i) + " = \"x\";\n";
+        }
+    }
+    auto config = make_config();
+    config->parse(cfg::Configuration::INPUT_STRING, input.c_str());
+
+    int const total = num_scopes * (size + 1);
+    std::vector<std::pair<char const *, std::vector<std::string>>> const
+        filter_lists = {
+            {"none", {}},
+            {"*.var_1*", {"*.var_1*"}},
+            {"50 patterns", many_filters(num_scopes, size)},
+        };
+    for (auto const & [label, filter_list] : filter_lists) {
+        cfg::StringVector filters, names;
+        for (auto const & filter : filter_list) {
+            filters.add(filter.c_str());
+        }
+        double const us = bench::best_seconds(5, [&] {
+            config->listFullyScopedNames(
+                "", "", cfg::Configuration::CFG_SCOPE_AND_VARS, true, filters,
+                names);
+        }) * 1e6;
+        sum += names.length();
+
+        char line[128];
+        std::snprintf(
+            line,
+            sizeof(line),
+            "listFullyScopedNames entries=%-6d filter=%-11s %10.1f us/op",
+            total,
+            label,
+            us);
+        std::cout << line << std::endl;
+        results.add(
+            "listFullyScopedNames",
+            {bench::param("entries", total),
+             bench::param("filter", label),
+             bench::param("matches", names.length())},
+            us,
+            "us/op");
+    }
+}
+
+// A log-level table of the kind in demos/log-level, with a default
+// row at the end, and a few hundred distinct operation names looked up
+// over and over: by scanning the rows with patternMatch(), as the demo
+// used to, and with a PatternTable.
+void
+bench_pattern_table(bench::Results & results, int num_rows)
+{
+    std::string input = "log_levels = [\n";
+    for (int i = 0; i < num_rows - 1; ++i) {
+        auto const cls = "Class_" + std::to_string(i);
+        input += (i % 2 ? "\"" + cls + "::op_1*\"" : "\"" + cls + "::*\"") +
+            ", \"" + std::to_string(i % 5) + "\",\n";
+    }
+    input += "\"*\", \"0\"\n];\n";
+    auto config = make_config();
+    config->parse(cfg::Configuration::INPUT_STRING, input.c_str());
+
+    std::vector<std::string> names;
+    for (int i = 0; i < 500; ++i) {
+        names.push_back("Class_" + std::to_string(i * 7 % (num_rows * 2)) +
+                        "::op_" + std::to_string(i % 20));
+    }
+    char const ** cells;
+    int num_cells;
+    config->lookupList("", "log_levels", cells, num_cells);
+    double const scan = lookup_ns(names, [&](std::string const & name) {
+        int i = 0;
+        while (i < num_cells &&
+               not cfg::Configuration::patternMatch(name.c_str(), cells[i])) {
+            i += 2;
+        }
+        sum += i / 2 + 1;
+    });
+    cfg::Configuration::PatternTable table(config.get(), "", "log_levels");
+    double const cached = lookup_ns(names, [&](std::string const & name) {
+        sum += table.findRow(name.c_str()) + 1;
+    });
+
+    char line[128];
+    std::snprintf(
+        line,
+        sizeof(line),
+        "log-level table rows=%-5d scan %9.1f ns/op  PatternTable %7.1f ns/op",
+        num_rows,
+        scan,
+        cached);
+    std::cout << line << std::endl;
+    results.add(
+        "logLevelTable",
+        {bench::param("rows", num_rows), bench::param("method", "scan")},
+        scan,
+        "ns/op");
+    results.add(
+        "logLevelTable",
+        {bench::param("rows", num_rows),
+         bench::param("method", "PatternTable")},
+        cached,
+        "ns/op");
+}
+
+// Walking every variable with its value, as an exporter would: by
+// listing the names and looking each one up, and with forEach().
+void
+bench_walk(bench::Results & results, int num_scopes, int size)
+{
+    std::string input;
+    for (int s = 0; s < num_scopes; ++s) {
+        input += "scope_" + std::to_string(s) + " {\n";
+        for (int i = 0; i < size; ++i) {
+            input += "    var_" + std::to_string(i) + " = \"x\";\n";
+        }
+        input += "}\n";
+    }
+    auto config = make_config();
+    config->parse(cfg::Configuration::INPUT_STRING, input.c_str());
+
+    int const total = num_scopes * (size + 1);
+    std::size_t listed_bytes = 0;
+    double const listed = bench::best_seconds(3, [&] {
+        cfg::StringVector names;
+        config->listFullyScopedNames(
+            "", "", cfg::Configuration::CFG_SCOPE_AND_VARS, true, names);
+        for (int i = 0; i < names.length(); ++i) {
+            if (config->type("", names[i]) == cfg::Configuration::CFG_STRING) {
+                listed_bytes +=
+                    std::strlen(config->lookupString("", names[i]));
+            }
+        }
+    }) * 1e3;
+    std::size_t visited_bytes = 0;
+    double const visited = bench::best_seconds(3, [&] {
+        config->forEach(
+            "", "", cfg::Configuration::CFG_SCOPE_AND_VARS, true,
+            [&](cfg::Configuration::Entry const & entry) {
+                if (entry.type == cfg::Configuration::CFG_STRING) {
+                    visited_bytes += std::strlen(entry.stringValue);
+                }
+            });
+    }) * 1e3;
+    sum += listed_bytes + visited_bytes;
+
+    char line[128];
+    std::snprintf(
+        line,
+        sizeof(line),
+        "walk entries=%-8d list+lookup %9.2f ms  forEach %7.2f ms",
+        total,
+        listed,
+        visited);
+    std::cout << line << std::endl;
+    results.add(
+        "walk",
+        {bench::param("entries", total), bench::param("method", "list+lookup")},
+        listed,
+        "ms/op");
+    results.add(
+        "walk",
+        {bench::param("entries", total), bench::param("method", "forEach")},
+        visited,
+        "ms/op");
+}
+
+// An allow-list of size entries, looked up as a copy (a StringVector, or
+// the vector of string_views that ext::Configuration::lookupList() gives)
+// and as a ListView of the stored list.
+void
+bench_list_view(bench::Results & results, int size)
+{
+    std::string input = "allow = [";
+    for (int i = 0; i < size; ++i) {
+        input += (i ? ", \"user_" : "\"user_") + std::to_string(i) + "\"";
+    }
+    input += "];\n";
+    cfg::ext::Configuration config;
+    config.parse(cfg::Configuration::INPUT_STRING, input);
+
+    int const rounds = 2000;
+    std::vector<std::pair<char const *, double>> const methods = {
+        {"StringVector", bench::ns_per_op(rounds, [&] {
+             cfg::StringVector list;
+             for (int r = 0; r < rounds; ++r) {
+                 config->lookupList("", "allow", list);
+                 sum += list.length();
+             }
+         })},
+        {"vector", bench::ns_per_op(rounds, [&] {
+             for (int r = 0; r < rounds; ++r) {
+                 sum += config.lookupList("allow")->size();
+             }
+         })},
+        {"ListView", bench::ns_per_op(rounds, [&] {
+             for (int r = 0; r < rounds; ++r) {
+                 sum += config.lookupListView("allow")->size();
+             }
+         })},
+    };
+    for (auto const & [method, ns] : methods) {
+        char line[128];
+        std::snprintf(
+            line,
+            sizeof(line),
+            "lookupList size=%-6d as=%-13s %12.1f ns/op",
+            size,
+            method,
+            ns);
+        std::cout << line << std::endl;
+        results.add(
+            "lookupList (large)",
+            {bench::param("size", size), bench::param("as", method)},
+            ns,
+            "ns/op");
+    }
+}
+
+int
+Main(int argc, char * argv[])
+{
+    bench::Results results("lookup", argc, argv);
+
+    for (int depth : {1, 4, 8}) {
+        for (int size : {16, 256, 4096}) {
+            bench_lookups(results, depth, size);
+        }
+    }
+    for (char const * kind : {"fallback", "override"}) {
+        for (int length : {0, 1, 2, 4}) {
+            bench_chain(results, kind, length);
+        }
+    }
+    bench_list(results, 16, 64);
+    bench_list(results, 64, 1024);
+    bench_list(results, 200, 1000);
+    bench_walk(results, 64, 1024);
+    bench_walk(results, 1000, 1000);
+    bench_list_view(results, 10000);
+    for (int rows : {4, 32, 256}) {
+        bench_pattern_table(results, rows);
+    }
+
+    if (sum == 0) {
+        throw std::runtime_error("lookups returned unexpected results");
+    }
+    results.write();
+    return 0;
+}
+
+} // anonymous namespace
+
+int
+main(int argc, char * argv[])
+{
+    try {
+        return Main(argc, argv);
+    } catch (cfg::ConfigurationException const & ex) {
+        std::cerr << "exception: " << ex.c_str() << '\n';
+    } catch (std::exception const & ex) {
+        std::cerr << "exception: " << ex.what() << '\n';
+    }
+    return 1;
+}
@@ -0,0 +1,208 @@
+#include "Bench.h"
+
+#include "config4cpp/Configuration.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Measures how long Configuration::parse() takes on large, generated
+// configuration files, read with INPUT_FILE.  Sizes (in MB) can be given on
+// the command line; the files are written to the current directory and
+// removed afterwards.  Each size is measured with two kinds of file: one made
+// of many small entries, and one dominated by long comments and large block
+// strings, such as log templates.  Loading the same configuration from a
+// precompiled (INPUT_BINARY) file is measured too, as are the time taken to
+// destroy() a parsed configuration, the heap it occupies (where the C
+// library can report that) and the peak RSS of the whole run.
+
+namespace {
+namespace cfg = CONFIG4CPP_NAMESPACE;
+
+// Write a file of roughly mb megabytes that looks like a generated
+// configuration: scopes of a few hundred entries, with a mix of strings,
+// lists and comments.
+void
+write_entries(char const * path, std::size_t mb)
+{
+    std::ofstream out(path);
+    std::size_t const limit = mb * 1024 * 1024;
+    std::size_t written = 0;
+    for (int scope = 0; written < limit; ++scope) {
+        std::string text = "# generated scope " + std::to_string(scope) +
+            "\nscope_" + std::to_string(scope) + " {\n";
+        for (int i = 0; i < 250; ++i) {
+            auto const n = std::to_string(i);
+            text += "    host_" + n + " = \"server-" + n +
+                ".example.com\";\n" + "    port_" + n + " = \"" +
+                std::to_string(8000 + i) + "\"; # listening port\n" +
+                "    tags_" + n + " = [\"alpha\", \"beta\", \"gamma\"];\n";
+        }
+        text += "}\n";
+        out << text;
+        written += text.size();
+    }
+}
+
+// Write a file of roughly mb megabytes made of long comments, and templates
+// held in block strings and ordinary strings.
+void
+write_templates(char const * path, std::size_t mb)
+{
+    std::ofstream out(path);
+    std::size_t const limit = mb * 1024 * 1024;
+    std::size_t written = 0;
+    std::string const line =
+        "[%(asctime)s] %(levelname)-8s %(name)s (%(filename)s:%(lineno)d) "
+        "pid=%(process)d thread=%(threadName)s: %(message)s";
+    // In a double-quoted string, '%' is the escape character.
+    std::string escaped;
+    for (char ch : line) {
+        escaped += ch == '%' ? "%%" : std::string(1, ch);
+    }
+    for (int i = 0; written < limit; ++i) {
+        auto const n = std::to_string(i);
+        std::string text =
+            "# Template " + n + " is used by the request logger of service " +
+            n + ", and must be kept in step with the log parsers.\n" +
+            "template_" + n + " = <%\n";
+        for (int j = 0; j < 40; ++j) {
+            text += "    " + line + "\n";
+        }
+        text += "%>;\n";
+        text += "format_" + n + " = \"" + escaped + "%n\";\n";
+        out << text;
+        written += text.size();
+    }
+}
+
+void
+bench_parse(bench::Results & results, char const * kind, std::size_t mb)
+{
+    std::string const path =
+        "Parse_bench_" + std::string(kind) + std::to_string(mb) + "MB.cfg";
+    if (std::string(kind) == "entries") {
+        write_entries(path.c_str(), mb);
+    } else {
+        write_templates(path.c_str(), mb);
+    }
+
+    std::string const binary_path = path + "c";
+    struct Timing
+    {
+        double parse = 0;
+        double destroy = 0;
+        long long heap = -1;
+    };
+    auto const time_parse = [&](cfg::Configuration::SourceType type,
+                                std::string const & source) {
+        Timing best;
+        for (int trial = 0; trial < 3; ++trial) {
+            long long const heap_before = bench::heap_in_use();
+            cfg::Configuration * config = cfg::Configuration::create();
+            auto const start = bench::Clock::now();
+            config->parse(type, source.c_str());
+            auto const stop = bench::Clock::now();
+            long long const heap_after = bench::heap_in_use();
+            if (type == cfg::Configuration::INPUT_FILE && trial == 0) {
+                config->writeBinary(binary_path.c_str());
+            }
+            auto const destroy_start = bench::Clock::now();
+            config->destroy();
+            auto const destroy_stop = bench::Clock::now();
+            double const secs =
+                std::chrono::duration<double>(stop - start).count();
+            double const destroy_secs =
+                std::chrono::duration<double>(destroy_stop - destroy_start)
+                    .count();
+            if (trial == 0 || secs < best.parse) {
+                best.parse = secs;
+            }
+            if (trial == 0 || destroy_secs < best.destroy) {
+                best.destroy = destroy_secs;
+            }
+            if (heap_before >= 0) {
+                best.heap = heap_after - heap_before;
+            }
+        }
+        return best;
+    };
+    Timing const text = time_parse(cfg::Configuration::INPUT_FILE, path);
+    Timing const binary =
+        time_parse(cfg::Configuration::INPUT_BINARY, binary_path);
+    std::remove(path.c_str());
+    std::remove(binary_path.c_str());
+
+    char line[200];
+    std::snprintf(
+        line,
+        sizeof(line),
+        "parse  %-9s size=%4zu MB  text=%8.3f s (%7.2f MB/s)  "
+        "binary=%8.3f s  destroy=%8.3f s  heap=%7.1f MB",
+        kind,
+        mb,
+        text.parse,
+        double(mb) / text.parse,
+        binary.parse,
+        text.destroy,
+        double(text.heap) / (1024 * 1024));
+    std::cout << line << std::endl;
+    results.add(
+        "parse (text)", {bench::param("kind", kind), bench::param("mb", mb)},
+        double(mb) / text.parse, "MB/s");
+    results.add(
+        "parse (binary)", {bench::param("kind", kind), bench::param("mb", mb)},
+        double(mb) / binary.parse, "MB/s");
+    results.add(
+        "destroy", {bench::param("kind", kind), bench::param("mb", mb)},
+        text.destroy * 1e3, "ms");
+    if (text.heap >= 0) {
+        results.add(
+            "heap", {bench::param("kind", kind), bench::param("mb", mb)},
+            double(text.heap) / (1024 * 1024), "MB");
+    }
+}
+
+int
+Main(int argc, char * argv[])
+{
+    bench::Results results("parse", argc, argv);
+    std::vector<std::size_t> sizes = {8, 64};
+    if (not results.args().empty()) {
+        sizes.clear();
+        for (auto const & arg : results.args()) {
+            sizes.push_back(std::strtoul(arg.c_str(), nullptr, 10));
+        }
+    }
+    for (std::size_t mb : sizes) {
+        bench_parse(results, "entries", mb);
+        bench_parse(results, "templates", mb);
+    }
+    if (long long const rss = bench::peak_rss(); rss >= 0) {
+        std::cout << "peak RSS " << double(rss) / (1024 * 1024) << " MB"
+                  << std::endl;
+        results.add("peak RSS", {}, double(rss) / (1024 * 1024), "MB");
+    }
+    results.write();
+    return 0;
+}
+
+} // anonymous namespace
+
+int
+main(int argc, char * argv[])
+{
+    try {
+        return Main(argc, argv);
+    } catch (cfg::ConfigurationException const & ex) {
+        std::cerr << "exception: " << ex.c_str() << '\n';
+    } catch (std::exception const & ex) {
+        std::cerr << "exception: " << ex.what() << '\n';
+    }
+    return 1;
+}
@@ -0,0 +1,147 @@
+#include "Bench.h"
+
+#include "config4cpp/Configuration.h"
+#include "config4cpp/SchemaValidator.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Measures SchemaValidator::validate() on generated configurations of
+// "uid-recipe" scopes, in the style of the recipes demo, with and without
+// scopes that the schema tells the validator to ignore, and with many
+// ignore rules that do not apply, and on several threads.
+
+namespace {
+namespace cfg = CONFIG4CPP_NAMESPACE;
+
+char const * base_schema[] = {
+    "uid-recipe = scope",
+    "uid-recipe.name = string",
+    "uid-recipe.ingredients = list[string]",
+    "uid-recipe.serves = int[1, 100]",
+    "uid-recipe.uid-step = string",
+    "uid-recipe.notes = scope",
+    "@ignoreEverythingIn uid-recipe.notes",
+    nullptr,
+};
+
+std::string
+make_input(int num_recipes, bool with_notes)
+{
+    std::string input;
+    for (int i = 0; i < num_recipes; ++i) {
+        auto const n = std::to_string(i);
+        input += "uid-recipe {\n    name = \"recipe " + n + "\";\n" +
+            "    ingredients = [\"flour\", \"water\", \"salt\"];\n" +
+            "    serves = \"" + std::to_string(i % 100 + 1) + "\";\n";
+        for (int step = 0; step < 4; ++step) {
+            input += "    uid-step = \"step " + std::to_string(step) + "\";\n";
+        }
+        if (with_notes) {
+            input += "    notes { author = \"anon\"; rating = \"5\"; }\n";
+        }
+        input += "}\n";
+    }
+    return input;
+}
+
+// base_schema, plus num_ignore_rules rules for scopes that do not exist.
+// The strings are owned by storage.
+std::vector<char const *>
+make_schema(int num_ignore_rules, std::vector<std::string> & storage)
+{
+    storage.clear();
+    for (int i = 0; i < num_ignore_rules; ++i) {
+        storage.push_back(
+            "@ignoreScopesIn uid-recipe.unused_" + std::to_string(i));
+    }
+    std::vector<char const *> result;
+    for (char const ** rule = base_schema; *rule != nullptr; ++rule) {
+        result.push_back(*rule);
+    }
+    for (auto const & rule : storage) {
+        result.push_back(rule.c_str());
+    }
+    result.push_back(nullptr);
+    return result;
+}
+
+void
+bench_validate(
+    bench::Results & results,
+    int num_recipes,
+    bool with_notes,
+    int num_ignore_rules,
+    int num_threads = 1)
+{
+    cfg::Configuration * config = cfg::Configuration::create();
+    config->parse(
+        cfg::Configuration::INPUT_STRING,
+        make_input(num_recipes, with_notes).c_str());
+    std::vector<std::string> storage;
+    auto schema = make_schema(num_ignore_rules, storage);
+    cfg::SchemaValidator validator;
+    validator.numThreads(num_threads);
+    validator.parseSchema(schema.data());
+
+    double const secs = bench::best_seconds(5, [&] {
+        validator.validate(config, "", "");
+    });
+    config->destroy();
+
+    char line[128];
+    std::snprintf(
+        line,
+        sizeof(line),
+        "validate  recipes=%-6d notes=%-3s ignores=%-3d threads=%-2d "
+        "%10.3f ms  %8.1f ns/recipe",
+        num_recipes,
+        with_notes ? "yes" : "no",
+        num_ignore_rules,
+        num_threads,
+        secs * 1e3,
+        secs * 1e9 / num_recipes);
+    std::cout << line << std::endl;
+    results.add(
+        "validate",
+        {bench::param("recipes", num_recipes),
+         bench::param("notes", with_notes),
+         bench::param("ignore_rules", num_ignore_rules),
+         bench::param("threads", num_threads)},
+        secs * 1e3,
+        "ms");
+}
+
+int
+Main(int argc, char * argv[])
+{
+    bench::Results results("schema", argc, argv);
+    for (int num_recipes : {100, 1000, 10000}) {
+        bench_validate(results, num_recipes, false, 0);
+        bench_validate(results, num_recipes, true, 0);
+        bench_validate(results, num_recipes, true, 50);
+    }
+    for (int num_threads : {2, 4, 8}) {
+        bench_validate(results, 10000, true, 0, num_threads);
+    }
+    results.write();
+    return 0;
+}
+
+} // anonymous namespace
+
+int
+main(int argc, char * argv[])
+{
+    try {
+        return Main(argc, argv);
+    } catch (cfg::ConfigurationException const & ex) {
+        std::cerr << "exception: " << ex.c_str() << '\n';
+    } catch (std::exception const & ex) {
+        std::cerr << "exception: " << ex.what() << '\n';
+    }
+    return 1;
+}
@@ -74,6 +74,7 @@ FooConfigurationException::c_str() const
 FooConfiguration::FooConfiguration()
 {
 	m_cfg = Configuration::create();
+	m_fallbackCfg = Configuration::create();
 	m_scope = 0;
 }
 
@@ -83,6 +84,7 @@ FooConfiguration::~FooConfiguration()
 {
 	delete [] m_scope;
 	((Configuration *)m_cfg)->destroy();
+	((Configuration *)m_fallbackCfg)->destroy();
 }
 
 
@@ -92,6 +94,7 @@ FooConfiguration::parse(
 	const char *		scope)
 {
 	Configuration * cfg = (Configuration *)m_cfg;
+	Configuration * fallbackCfg = (Configuration *)m_fallbackCfg;
 
 	m_scope = new char[strlen(scope) + 1];
 	strcpy(m_scope, scope);
@@ -99,8 +102,15 @@ FooConfiguration::parse(
 		if (cfgSource != 0 && strcmp(cfgSource, "") != 0) {
 			cfg->parse(cfgSource);
 		}
-		cfg->setFallbackConfiguration(Configuration::INPUT_STRING,
-		                              FallbackConfiguration::getString());
+		//--------
+		// The fallback configuration was parsed by "config2cpp
+		// -compiled" when the demo was built, so it is loaded
+		// without being parsed again.
+		//--------
+		fallbackCfg->parseBinaryImage(FallbackConfiguration::getImage(),
+		                              FallbackConfiguration::getImageSize(),
+		                              "FallbackConfiguration.cfg");
+		cfg->setFallbackConfiguration(fallbackCfg);
 	} catch(const ConfigurationException & ex) {
 		throw FooConfigurationException(ex.c_str());
 	}
@@ -81,6 +81,7 @@ private:
 	//--------
 	char *			m_scope;
 	void *			m_cfg;
+	void *			m_fallbackCfg;
 
 	//--------
 	// The following are not implemented
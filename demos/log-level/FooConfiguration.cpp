@@ -79,6 +79,8 @@ FooConfigurationException::c_str() const
 FooConfiguration::FooConfiguration()
 {
 	m_cfg = Configuration::create();
+	m_logLevelTable = new Configuration::PatternTable();
+	m_logLevels = 0;
 }
 
 
@@ -86,6 +88,8 @@ FooConfiguration::FooConfiguration()
 FooConfiguration::~FooConfiguration()
 {
 	((Configuration *)m_cfg)->destroy();
+	delete (Configuration::PatternTable *)m_logLevelTable;
+	delete [] m_logLevels;
 }
 
 
@@ -99,6 +103,9 @@ FooConfiguration::parse(
 {
 	SchemaValidator		sv;
 	Configuration *		cfg = (Configuration*)m_cfg;
+	Configuration::PatternTable * table;
+	int					i;
+	int					level;
 	const char *		schema[] = {
 		"@typedef logLevel = int[0, 4]",
 		"log_levels = table[string,operation-name, logLevel,log-level]",
@@ -119,9 +126,23 @@ FooConfiguration::parse(
 
 		//--------
 		// Cache configuration variables in instance variables for 
-		// faster access.
+		// faster access. The log_levels table is compiled into a
+		// PatternTable, which remembers the row found for each
+		// operation name, and each row's log level is converted once.
 		//--------
-		cfg->lookupList(cfgScope, "log_levels", m_logLevels, m_numLogLevels);
+		table = (Configuration::PatternTable *)m_logLevelTable;
+		table->reload(cfg, cfgScope, "log_levels");
+		delete [] m_logLevels;
+		m_logLevels = new Logger::LogLevel[table->numRows()];
+		for (i = 0; i < table->numRows(); i++) {
+			level = atoi(table->cell(i, 1));
+			if (level > (int)Logger::DEBUG_LEVEL) {
+				level = (int)Logger::DEBUG_LEVEL;
+			} else if (level < 0) {
+				level = 0;
+			}
+			m_logLevels[i] = (Logger::LogLevel)level;
+		}
 	} catch(const ConfigurationException & ex) {
 		throw FooConfigurationException(ex.c_str());
 	}
@@ -132,24 +153,13 @@ FooConfiguration::parse(
 Logger::LogLevel
 FooConfiguration::getLogLevel(const char * opName) const
 {
-	int					i;
-	int					result;
-	const char *		pattern;
-	const char *		logLevelStr;
-
-	for (i = 0; i < m_numLogLevels; i += 2) {
-		pattern     = m_logLevels[i + 0];
-		logLevelStr = m_logLevels[i + 1];
-		if (Configuration::patternMatch(opName, pattern)) {
-			result = atoi(logLevelStr);
-			if (result > (int)Logger::DEBUG_LEVEL) {
-				result = (int)Logger::DEBUG_LEVEL;
-			} else if (result < 0) {
-				result = 0;
-			}
-			return (Logger::LogLevel)result;
-		}
+	int					row;
+
+	row = ((const Configuration::PatternTable *)m_logLevelTable)
+			->findRow(opName);
+	if (row == -1) {
+		return Logger::ERROR_LEVEL; // default log level
 	}
-	return Logger::ERROR_LEVEL; // default log level
+	return m_logLevels[row];
 }
 
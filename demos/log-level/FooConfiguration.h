@@ -68,9 +68,9 @@ public:
 	Logger::LogLevel getLogLevel(const char * opName) const;
 
 private:
-	void *			m_cfg; // opaque pointer to Config4Cpp config object
-	const char **	m_logLevels;
-	int				m_numLogLevels;
+	void *				m_cfg; // opaque pointer to Config4Cpp config object
+	void *				m_logLevelTable; // opaque pointer to a PatternTable
+	Logger::LogLevel *	m_logLevels; // the log level in each of its rows
 
 	//--------
 	// The following are not implemented
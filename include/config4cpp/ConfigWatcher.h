@@ -0,0 +1,142 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+#ifndef CONFIG4CPP_CONFIG_WATCHER_H_
+#define CONFIG4CPP_CONFIG_WATCHER_H_
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include <config4cpp/Configuration.h>
+
+
+
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//----------------------------------------------------------------------
+// Class:	ConfigWatcher
+//
+// Description:	Watches the files and directories that a configuration
+//		depends on (see Configuration::listDependencies()), and
+//		reloads the configuration when they change.
+//
+// Notes:	On Linux, this uses inotify on the directories that hold
+//		the files, so a file replaced by a rename is still seen,
+//		and fileDescriptor() can be added to a service's own
+//		poll() or epoll loop. Elsewhere, or if inotify is not
+//		available, it compares the timestamps of the files every
+//		debounceMillis, and fileDescriptor() returns -1. A
+//		directory that inotify cannot watch (because it is
+//		missing or unreadable, or the limit on watches has been
+//		reached) has the timestamps of its files compared in
+//		the same way.
+//
+//		A ConfigWatcher is not thread-safe, and reloads the
+//		configuration in the thread that calls reloadIfChanged().
+//----------------------------------------------------------------------
+
+class ConfigWatcher
+{
+public:
+	typedef std::function<void (Configuration * cfg)> Callback;
+
+	//--------
+	// Constructors and destructor. Without a callback, a change is
+	// applied with cfg->reparseChanged(); with one, the callback is
+	// called instead, for example to parse and freeze() a new copy.
+	//--------
+	ConfigWatcher(Configuration * cfg, int debounceMillis = 50);
+	ConfigWatcher(
+			Configuration *		cfg,
+			Callback			callback,
+			int					debounceMillis = 50);
+	~ConfigWatcher();
+
+	//--------
+	// reloadIfChanged() waits up to timeoutMillis (or for ever, if it
+	// is -1) for a change. It then waits until there has been no
+	// further change for debounceMillis, so that a burst of edits
+	// causes one reload, and reloads the configuration. It returns
+	// true if the configuration was reloaded and has changed (always
+	// true with a callback). An exception thrown by the reload is
+	// passed on, and the new set of dependencies is watched in
+	// either case.
+	//
+	// rewatch() starts watching the current dependencies, in case
+	// the configuration has been parsed again by other means.
+	//--------
+	bool reloadIfChanged(int timeoutMillis);
+	void rewatch();
+	int  fileDescriptor() const;
+
+private:
+	//--------
+	// A directory that holds dependencies or was searched by a
+	// glob pattern, and, if polling, the stamps of what is watched.
+	//--------
+	struct Watch {
+		int							wd;			// -1 if polling
+		std::string					dirName;
+		std::vector<std::string>	baseNames;	// the files it holds
+		bool						isGlobbed;
+	};
+	struct Stamp {
+		std::string					fileName;
+		size_t						watch;		// in m_watches
+		bool						exists;
+		long long					mtime;
+		long long					size;
+	};
+
+	bool waitForChange(int timeoutMillis);
+	bool readEvents();
+	bool stampsChanged();
+
+	//--------
+	// Instance variables
+	//--------
+	Configuration *				m_cfg;
+	Callback					m_callback;
+	int							m_debounceMillis;
+	int							m_fd;		// inotify, or -1 if polling
+	std::vector<Watch>			m_watches;
+	std::vector<Stamp>			m_stamps;
+	bool						m_isPolling;	// any wd of -1
+
+	//--------
+	// Not implemented
+	//--------
+	ConfigWatcher(const ConfigWatcher &);
+	ConfigWatcher & operator=(const ConfigWatcher &);
+};
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
+#endif
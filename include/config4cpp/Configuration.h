@@ -37,6 +37,7 @@
 #include <config4cpp/StringBuffer.h>
 #include <config4cpp/StringVector.h>
 #include <stddef.h>
+#include <string.h>
 
 #include <functional>
 #include <string>
@@ -77,11 +78,26 @@ public:
 		CFG_SCOPE_AND_VARS = 7  // 0111 = CFG_STRING | CFG_LIST | CFG_SCOPE
 	};
 
-	enum SourceType {INPUT_FILE, INPUT_STRING, INPUT_EXEC};
+	enum SourceType {INPUT_FILE, INPUT_STRING, INPUT_EXEC, INPUT_BINARY};
+
+	class Key;
+	class Pattern;
+	class PatternTable;
 
 	static Configuration * create();
 	virtual void destroy();
 
+	//--------
+	// freeze() returns a deep copy that cannot be updated: parse(),
+	// insert<Type>(), remove(), empty() and the set<...>Configuration()
+	// operations throw an exception.  Since a frozen configuration never
+	// changes, any number of threads can use its lookup and list
+	// operations at the same time without locking.  The caller must
+	// destroy() the copy.
+	//--------
+	virtual Configuration * freeze() const = 0;
+	virtual bool isFrozen() const = 0;
+
 	static void mergeNames(
 					const char *		scope,
 					const char *		localName,
@@ -121,6 +137,39 @@ public:
 					const char *				sourceDescription = "") = 0;
 	inline void	parse(const char * sourceTypeAndSource);
 
+	//--------
+	// reparseChanged() brings the configuration up to date with the
+	// files that parse() read, including those pulled in by @include,
+	// and returns false if none of them has changed.  Where it is
+	// safe, only the changed files are parsed again, and files read
+	// after them still override what they set; otherwise, such as
+	// when @if, @copyFrom or @remove is used, everything is parsed
+	// again.  It throws an exception unless the configuration was
+	// built only by parse(INPUT_FILE, ...).
+	//--------
+	virtual bool reparseChanged() = 0;
+
+	//--------
+	// listDependencies() gives the files that the configuration was
+	// read from: those given to parse(), and those read by @include
+	// (including any that @ifExists found to be missing) and by
+	// readFile(). It also gives the directories that an @include
+	// with a glob pattern searched. A ConfigWatcher watches these.
+	//--------
+	virtual void listDependencies(
+					StringVector &		fileNames,
+					StringVector &		dirNames) const = 0;
+
+	//--------
+	// generation() changes whenever what a lookup can return might
+	// have changed: after parse(), a reparseChanged() that returns
+	// true, insert<Type>(), remove(), empty(), and a change to the
+	// fallback or override configuration. A cache of looked-up
+	// values, such as a PatternTable, compares it with the value it
+	// saw last to know when it is out of date.
+	//--------
+	virtual unsigned long generation() const = 0;
+
 	virtual const char * fileName() const = 0;
 
 	virtual void listFullyScopedNames(
@@ -165,9 +214,43 @@ public:
 					const StringVector &		filterPatterns,
 					StringVector &				names) const = 0;
 
+	//--------
+	// forEach() calls visitor for each entry of the types in typeMask
+	// in the scope, in the order of listFullyScopedNames(), without
+	// building a list of names or looking any of them up again. The
+	// entry's scopedName is valid only during the call; its other
+	// strings are valid until the configuration is changed, which
+	// the visitor must not do.
+	//
+	// Like listFullyScopedNames(), it visits only the entries held by
+	// this configuration, with the values stored in them. Entries of
+	// the fallback and override configurations are not merged in: an
+	// entry set only in the fallback configuration is not visited, and
+	// for one that the override configuration also sets, lookups give
+	// the override's value, not the one visited.
+	//--------
+	struct Entry {
+		const char *			scopedName;		// fully scoped
+		int						scopedNameLength;
+		const char *			localName;
+		Type					type;
+		const char *			stringValue;	// 0 unless CFG_STRING
+		const char * const *	listValue;		// 0 unless CFG_LIST
+		int						listLength;
+	};
+	typedef std::function<void (const Entry & entry)> Visitor;
+
+	virtual void forEach(
+					const char *		scope,
+					const char *		localName,
+					Type				typeMask,
+					bool				recursive,
+					const Visitor &		visitor) const = 0;
+
 	virtual Type type(const char * scope, const char * localName) const = 0;
 
 	static bool	patternMatch(const char * str, const char * pattern);
+	static bool	patternMatch(const char * str, const Pattern & pattern);
 
 	virtual bool uidEquals(const char * s1, const char * s2) const = 0;
 	virtual void expandUid(StringBuffer & spelling) = 0;
@@ -176,7 +259,9 @@ public:
 					StringBuffer &		buf) const = 0;
 
 	//--------
-	// Dump part or all of the configuration
+	// Dump part or all of the configuration. If wantLocations is
+	// true then each variable that was parsed from a file is
+	// followed by a "# file:line" comment.
 	//--------
 	virtual void dump(StringBuffer & buf, bool wantExpandedUidNames) const = 0;
 
@@ -186,6 +271,47 @@ public:
 					const char *		scope,
 					const char *		localName) const = 0;
 
+	virtual void dump(
+					StringBuffer &		buf,
+					bool				wantExpandedUidNames,
+					bool				wantLocations,
+					const char *		scope,
+					const char *		localName) const = 0;
+
+	//--------
+	// lookupLocation() finds the file and line at which a variable
+	// was last assigned. It returns false if they are not known,
+	// which is the case for scopes and for variables that were
+	// not parsed, for example ones added with insertString().
+	// fileName remains valid for the life of the process.
+	//--------
+	virtual bool lookupLocation(
+					const char *		scope,
+					const char *		localName,
+					const char *&		fileName,
+					int &				lineNumber) const = 0;
+
+	//--------
+	// writeBinary() saves the entire contents in the precompiled
+	// (".cfgc") format, which parse(INPUT_BINARY, fileName) loads
+	// without lexing or parsing. @include, @if and exec() are not
+	// evaluated again when the file is loaded; their results are
+	// what was saved.
+	//
+	// writeBinaryImage() and parseBinaryImage() do the same in
+	// memory, for example to embed a configuration in a program
+	// (see config2cpp -compiled). The image holds binary data, in
+	// the same byte order on every machine. The file names that
+	// lookupLocation() gives for its entries are relative to the
+	// directory of the file that was parsed.
+	//--------
+	virtual void writeBinary(const char * fileName) const = 0;
+	virtual void writeBinaryImage(std::string & image) const = 0;
+	virtual void parseBinaryImage(
+					const char *		image,
+					size_t				size,
+					const char *		sourceDescription = "") = 0;
+
 	virtual bool isBoolean(const char * str) const = 0;
 	virtual bool isInt(const char * str) const = 0;
 	virtual bool isFloat(const char * str) const = 0;
@@ -308,6 +434,12 @@ public:
 					const char *		scope,
 					const char *		localName) const = 0;
 
+	//--------
+	// The lookupList() operations that give an array do not copy the
+	// list: the array is the one stored in the configuration, and is
+	// valid until the configuration is changed. Those that give a
+	// StringVector copy every string.
+	//--------
 	virtual void lookupList(
 					const char *		scope,
 					const char *		localName,
@@ -503,6 +635,82 @@ public:
 					const char *		scope,
 					const char *		localName) const = 0;
 
+	//--------
+	// lookup<Type>() operations that take a pre-compiled Key.
+	// These behave like their (scope, localName) counterparts, but
+	// do not allocate memory or re-split the name on each call.
+	//--------
+	virtual Type type(const Key & key) const = 0;
+
+	virtual const char * lookupString(
+					const Key &			key,
+					const char *		defaultVal) const = 0;
+	virtual const char * lookupString(const Key & key) const = 0;
+
+	virtual void lookupList(
+					const Key &			key,
+					const char **&		array,
+					int &				arraySize,
+					const char **		defaultArray,
+					int					defaultArraySize) const = 0;
+	virtual void lookupList(
+					const Key &			key,
+					const char **&		array,
+					int &				arraySize) const = 0;
+
+	virtual int lookupInt(const Key & key, int defaultVal) const = 0;
+	virtual int lookupInt(const Key & key) const = 0;
+
+	virtual float lookupFloat(const Key & key, float defaultVal) const = 0;
+	virtual float lookupFloat(const Key & key) const = 0;
+
+	virtual int lookupEnum(
+					const Key &					key,
+					const char *				typeName,
+					const EnumNameAndValue *	enumInfo,
+					int 						numEnums,
+					const char *				defaultVal) const = 0;
+	virtual int lookupEnum(
+					const Key &					key,
+					const char *				typeName,
+					const EnumNameAndValue *	enumInfo,
+					int 						numEnums,
+					int							defaultVal) const = 0;
+	virtual int lookupEnum(
+					const Key &					key,
+					const char *				typeName,
+					const EnumNameAndValue *	enumInfo,
+					int 						numEnums) const = 0;
+
+	virtual bool lookupBoolean(const Key & key, bool defaultVal) const = 0;
+	virtual bool lookupBoolean(const Key & key) const = 0;
+
+	virtual int lookupDurationMicroseconds(
+					const Key &			key,
+					int					defaultVal) const = 0;
+	virtual int lookupDurationMicroseconds(const Key & key) const = 0;
+	virtual int lookupDurationMilliseconds(
+					const Key &			key,
+					int					defaultVal) const = 0;
+	virtual int lookupDurationMilliseconds(const Key & key) const = 0;
+	virtual int lookupDurationSeconds(
+					const Key &			key,
+					int					defaultVal) const = 0;
+	virtual int lookupDurationSeconds(const Key & key) const = 0;
+
+	virtual int lookupMemorySizeBytes(
+					const Key &			key,
+					int					defaultVal) const = 0;
+	virtual int lookupMemorySizeBytes(const Key & key) const = 0;
+	virtual int lookupMemorySizeKB(
+					const Key &			key,
+					int					defaultVal) const = 0;
+	virtual int lookupMemorySizeKB(const Key & key) const = 0;
+	virtual int lookupMemorySizeMB(
+					const Key &			key,
+					int					defaultVal) const = 0;
+	virtual int lookupMemorySizeMB(const Key & key) const = 0;
+
 	//--------
 	// Update operations
 	//--------
@@ -563,12 +771,8 @@ protected:
 
 private:
 	static bool patternMatchInternal(
-					const wchar_t *		wStr,
-					int					wStrIndex,
-					int					wStrLen,
-					const wchar_t *		wPattern,
-					int					wPatternIndex,
-					int					wPatternLen);
+					const char *		str,
+					const char *		pattern);
 	//--------
 	// Not implemented
 	//--------
@@ -580,6 +784,239 @@ private:
 
 
 
+//--------
+// Class Configuration::Key
+//
+// A (scope, localName) pair that has been merged, split into its
+// scope segments, and hashed, once.  Build a Key for each name that
+// is looked up frequently, and pass it to the lookup<Type>(const Key &)
+// operations.  A Key does not refer to any particular Configuration
+// object, so one Key can be used with many of them.
+//--------
+
+class Configuration::Key
+{
+public:
+	Key();
+	Key(const char * scope, const char * localName);
+
+	inline const char *	scope() const;
+	inline const char *	localName() const;
+	inline const char *	fullyScopedName() const;
+	inline bool			isAbsolute() const;
+	inline int			numSegments() const;
+	inline const char *	segment(int index) const;
+	inline unsigned int	segmentHash(int index) const;
+
+private:
+	std::string					m_scope;
+	std::string					m_localName;
+	std::string					m_fullyScopedName;
+	std::string					m_segmentChars; // nul-separated segments
+	std::vector<int>			m_segmentOffsets;
+	std::vector<unsigned int>	m_segmentHashes;
+	bool						m_isAbsolute;   // name starts with "."
+};
+
+
+inline const char *
+Configuration::Key::scope() const
+{
+	return m_scope.c_str();
+}
+
+
+inline const char *
+Configuration::Key::localName() const
+{
+	return m_localName.c_str();
+}
+
+
+inline const char *
+Configuration::Key::fullyScopedName() const
+{
+	return m_fullyScopedName.c_str();
+}
+
+
+inline bool
+Configuration::Key::isAbsolute() const
+{
+	return m_isAbsolute;
+}
+
+
+inline int
+Configuration::Key::numSegments() const
+{
+	return (int)m_segmentOffsets.size();
+}
+
+
+inline const char *
+Configuration::Key::segment(int index) const
+{
+	return m_segmentChars.c_str() + m_segmentOffsets[index];
+}
+
+
+inline unsigned int
+Configuration::Key::segmentHash(int index) const
+{
+	return m_segmentHashes[index];
+}
+
+
+
+//--------
+// Class Configuration::Pattern
+//
+// A pattern for patternMatch() that has been split, once, into the
+// literal text between its "*" wildcards.  Build a Pattern for each
+// pattern that is matched against many strings.  Matching takes, at
+// worst, time proportional to the length of the string times the
+// length of the pattern, and does not allocate memory.
+//--------
+
+class Configuration::Pattern
+{
+public:
+	Pattern();
+	Pattern(const char * pattern);
+
+	inline const char *	c_str() const;
+	inline int			numWildcards() const;
+	bool				matches(const char * str) const;
+
+private:
+	std::string			m_pattern;
+	std::string			m_literalChars; // nul-separated literals
+	std::vector<int>	m_literalOffsets;
+	std::vector<int>	m_literalLengths;
+	int					m_numWildcards;
+	bool				m_isAscii;
+};
+
+
+inline const char *
+Configuration::Pattern::c_str() const
+{
+	return m_pattern.c_str();
+}
+
+
+inline int
+Configuration::Pattern::numWildcards() const
+{
+	return m_numWildcards;
+}
+
+
+
+//--------
+// Class Configuration::PatternTable
+//
+// A "first matching pattern" table, built from a list that a schema
+// would describe as table[string,pattern, ...]: each row starts with
+// a pattern for patternMatch(), and findRow() gives the first row
+// whose pattern matches a string, or -1 if none does.  The patterns
+// are compiled once, and the row found for each distinct string is
+// remembered, so looking up a string again costs one hash lookup.
+//
+// The table keeps a pointer to the configuration it was built from,
+// which must outlive it.  Whenever that configuration changes (see
+// Configuration::generation()), because of reparseChanged(), a
+// ConfigWatcher reload or anything else, the next findRow() rebuilds
+// the table from it and forgets the remembered rows, so a lookup never
+// gives a row of an out-of-date table.  A row number, and a pointer
+// from cell(), is valid only until the configuration next changes;
+// code that keeps data derived from the rows should rebuild it when
+// generation() changes.  If the rebuilt table is not a whole number
+// of rows, findRow() throws a ConfigurationException, and the table
+// is then empty until the configuration changes again.
+//
+// Any number of threads can call findRow() and cell() at the same
+// time, as long as none of them changes the configuration meanwhile.
+// reload() builds the table from another list or configuration; it
+// must not be called while other threads are using the table.  At
+// most MAX_CACHED strings are remembered; others are matched each time.
+//--------
+
+class Configuration::PatternTable
+{
+public:
+	enum { MAX_CACHED = 16384 };
+
+	PatternTable();
+	PatternTable(
+			const Configuration *	cfg,
+			const char *			scope,
+			const char *			localName,
+			int						numColumns = 2);
+	~PatternTable();
+
+	void	reload(
+			const Configuration *	cfg,
+			const char *			scope,
+			const char *			localName,
+			int						numColumns = 2);
+
+	int					findRow(const char * str) const;
+	inline int			numRows() const;
+	inline int			numColumns() const;
+	inline const char *	cell(int row, int column) const;
+
+private:
+	struct Cache;
+
+	int					matchRow(const char * str) const;
+	void				refresh() const;
+	void				rebuild() const;
+
+	//--------
+	// The rows are mutable because findRow() rebuilds them when the
+	// configuration has changed.
+	//--------
+	const Configuration *	m_cfg;
+	StringBuffer			m_scope;
+	StringBuffer			m_localName;
+	mutable unsigned long	m_generation;
+	mutable StringVector	m_cells;
+	mutable std::vector<Pattern> m_patterns;
+	mutable int				m_numColumns;
+	Cache *					m_cache;
+
+	//--------
+	// Not implemented
+	//--------
+	PatternTable(const PatternTable &);
+	PatternTable & operator=(const PatternTable &);
+};
+
+
+inline int
+Configuration::PatternTable::numRows() const
+{
+	return (int)m_patterns.size();
+}
+
+
+inline int
+Configuration::PatternTable::numColumns() const
+{
+	return m_numColumns;
+}
+
+
+inline const char *
+Configuration::PatternTable::cell(int row, int column) const
+{
+	return m_cells[row * m_numColumns + column];
+}
+
+
+
 inline void
 Configuration::parse(const char * str)
 {
@@ -589,6 +1026,8 @@ Configuration::parse(const char * str)
 		parse(Configuration::INPUT_FILE, &(str[5]));
 	} else if (strncmp(str, "str#", 4) == 0) {
 		parse(Configuration::INPUT_STRING, &(str[4]));
+	} else if (strncmp(str, "bin#", 4) == 0) {
+		parse(Configuration::INPUT_BINARY, &(str[4]));
 	} else {
 		parse(Configuration::INPUT_FILE, str);
 	}
@@ -26,13 +26,21 @@
 
 #include "config4cpp/Configuration.h"
 
+#include <atomic>
 #include <charconv>
+#include <compare>
+#include <cstddef>
 #include <cstdlib>
+#include <functional>
+#include <future>
 #include <iosfwd>
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 namespace CONFIG4CPP_NAMESPACE::ext {
@@ -212,6 +220,81 @@ public:
     }
 };
 
+/**
+ * A read-only view of a list as it is stored in a configuration, without
+ * copying the list or its strings.  It is valid until the configuration is
+ * changed or destroyed.  Each element's length is found when it is read.
+ */
+class ListView
+{
+    char const * const * items = nullptr;
+    std::size_t count = 0;
+
+public:
+    class iterator
+    {
+        char const * const * item = nullptr;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = std::string_view;
+
+        iterator() = default;
+        explicit iterator(char const * const * p) : item(p) { }
+
+        std::string_view operator * () const { return *item; }
+        std::string_view operator [] (difference_type n) const
+        {
+            return item[n];
+        }
+
+        iterator & operator ++ () { ++item; return *this; }
+        iterator operator ++ (int) { auto x = *this; ++item; return x; }
+        iterator & operator -- () { --item; return *this; }
+        iterator operator -- (int) { auto x = *this; --item; return x; }
+        iterator & operator += (difference_type n) { item += n; return *this; }
+        iterator & operator -= (difference_type n) { item -= n; return *this; }
+
+        friend iterator operator + (iterator x, difference_type n)
+        {
+            return x += n;
+        }
+        friend iterator operator + (difference_type n, iterator x)
+        {
+            return x += n;
+        }
+        friend iterator operator - (iterator x, difference_type n)
+        {
+            return x -= n;
+        }
+        friend difference_type operator - (iterator x, iterator y)
+        {
+            return x.item - y.item;
+        }
+        friend bool operator == (iterator x, iterator y) = default;
+        friend auto operator <=> (iterator x, iterator y) = default;
+    };
+
+    ListView() = default;
+    ListView(char const * const * items_, std::size_t count_)
+    : items(items_), count(count_)
+    {
+    }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    std::string_view operator [] (std::size_t i) const { return items[i]; }
+    std::string_view front() const { return items[0]; }
+    std::string_view back() const { return items[count - 1]; }
+    char const * const * data() const { return items; }
+
+    iterator begin() const { return iterator(items); }
+    iterator end() const { return iterator(items + count); }
+};
+
 /**
  * This class adds a more convenient to use API over the top of Configuration.
  * This may add substantial cost for some operations.  However, configuration
@@ -273,6 +356,7 @@ public:
     static constexpr auto INPUT_FILE = cfg::INPUT_FILE;
     static constexpr auto INPUT_STRING = cfg::INPUT_STRING;
     static constexpr auto INPUT_EXEC = cfg::INPUT_EXEC;
+    static constexpr auto INPUT_BINARY = cfg::INPUT_BINARY;
 
     using Type = cfg::Type;
 
@@ -313,6 +397,8 @@ public:
         return parse(sourceTypeAndSource.c_str());
     }
 
+    bool reparseChanged() { return impl->reparseChanged(); }
+
     std::string_view fileName() const { return impl->fileName(); }
 
     std::vector<Name> listFullyScopedNames(
@@ -357,6 +443,22 @@ public:
         return as_vector<Name>(names);
     }
 
+    /**
+     * Calls visitor for each entry, in the order of listFullyScopedNames(),
+     * without building a list of names. Only this configuration's own
+     * entries are visited, not those of its fallback or override
+     * configuration. See Configuration::forEach().
+     */
+    void forEach(
+        Name const & name,
+        Type typeMask,
+        bool recursive,
+        cfg::Visitor const & visitor) const
+    {
+        impl->forEach(
+            name.scope(), name.local_name(), typeMask, recursive, visitor);
+    }
+
     Type type(Name const & name) const
     {
         return impl->type(name.scope(), name.local_name());
@@ -365,13 +467,62 @@ public:
     void dump(
         std::string & destination,
         bool wantExpandedUidNames = true,
-        Name const & name = {})
+        Name const & name = {},
+        bool wantLocations = false)
     {
         StringBuffer buf;
-        impl->dump(buf, wantExpandedUidNames, name.scope(), name.local_name());
+        impl->dump(
+            buf,
+            wantExpandedUidNames,
+            wantLocations,
+            name.scope(),
+            name.local_name());
         destination.append(buf.c_str(), static_cast<std::size_t>(buf.length()));
     }
 
+    struct Location
+    {
+        std::string_view fileName;
+        int lineNumber;
+    };
+
+    /**
+     * Where the variable was last assigned, or nullopt if there is no such
+     * entry or its location is not known.
+     */
+    std::optional<Location> lookupLocation(Name const & name) const
+    {
+        char const * fileName;
+        int lineNumber;
+        if (impl->type(name.scope(), name.local_name()) == cfg::CFG_NO_VALUE
+            || not impl->lookupLocation(
+                name.scope(), name.local_name(), fileName, lineNumber))
+        {
+            return std::nullopt;
+        }
+        return Location{fileName, lineNumber};
+    }
+
+    void writeBinary(std::string const & fileName) const
+    {
+        impl->writeBinary(fileName.c_str());
+    }
+
+    std::string writeBinaryImage() const
+    {
+        std::string image;
+        impl->writeBinaryImage(image);
+        return image;
+    }
+
+    void parseBinaryImage(
+        std::string_view image,
+        std::string const & sourceDescription = "")
+    {
+        impl->parseBinaryImage(
+            image.data(), image.size(), sourceDescription.c_str());
+    }
+
     template <std::size_t N>
     std::size_t lookupName(
         Name const & name,
@@ -428,6 +579,24 @@ public:
         }
     }
 
+    /**
+     * As lookupList(), but gives a view of the list as it is stored, so
+     * nothing is copied or allocated for the list.  The view is valid until
+     * the configuration is changed or destroyed.
+     */
+    std::optional<ListView> lookupListView(Name const & name) const
+    {
+        char const ** arr;
+        int len;
+        char const * defarr[1] = {};
+        impl->lookupList(name.scope(), name.local_name(), arr, len, defarr, 0);
+        if (arr != defarr) {
+            return ListView(arr, static_cast<std::size_t>(len));
+        } else {
+            return std::nullopt;
+        }
+    }
+
     std::optional<std::vector<std::string_view>> locateList(
         Name const & name) const
     {
@@ -526,9 +695,13 @@ public:
 
     std::optional<bool> lookupBoolean(Name const & name)
     {
-        return lookupEnum(
-            name,
-            std::array<EnumNameAndValue, 2>{{{"false", 0}, {"true", 1}}});
+        if (auto result = lookupEnum(
+                name,
+                std::array<EnumNameAndValue, 2>{{{"false", 0}, {"true", 1}}}))
+        {
+            return *result != 0;
+        }
+        return std::nullopt;
     }
 
     void insertString(Name const & name, char const * str)
@@ -591,6 +764,246 @@ public:
     void clear() { impl->empty(); }
 };
 
+/**
+ * Publishes a parsed configuration to any number of reader threads, and lets
+ * it be replaced ("hot reloaded") while they are using it.
+ *
+ * Readers call read(), which returns a Snapshot.  The configuration seen
+ * through a Snapshot never changes, and every pointer obtained from it
+ * (including the const char * results of lookupString and friends) stays
+ * valid until the Snapshot is destroyed.  Taking a Snapshot is lock-free: it
+ * never waits for a reload, however long the reload takes.
+ *
+ * A reload parses and validates the new configuration in the calling thread
+ * (or, with reloadAsync, in a new thread), then publishes it with a single
+ * atomic pointer exchange.  It never waits for readers either.  Each reader
+ * announces the configuration it is using in a hazard slot, and a replaced
+ * configuration is destroyed only when no slot refers to it.  Configurations
+ * that are still in use at the time of a reload are destroyed by a later
+ * reload or by reclaim().
+ *
+ * If parsing or validation throws, the exception propagates and the current
+ * configuration stays published.  A typical validator is:
+ *
+ *     [&](auto const & c) { schemaValidator.validate(&c, "", ""); }
+ */
+class ConfigurationHandle
+{
+    using cfg = CONFIG4CPP_NAMESPACE::Configuration;
+
+    // One per concurrent reader.  Slots are never freed while the handle
+    // exists, so a reader can always touch the slot it found.
+    struct alignas(64) HazardSlot
+    {
+        std::atomic<cfg const *> ptr{nullptr};
+        std::atomic<bool> in_use{false};
+        HazardSlot * next = nullptr;
+    };
+
+    std::atomic<cfg *> current;
+    mutable std::atomic<HazardSlot *> slots{nullptr};
+
+    // Only writers use these, so readers never wait for them.
+    std::mutex writer_mutex;
+    std::vector<cfg *> retired;
+
+    HazardSlot * acquireSlot() const
+    {
+        auto head = slots.load(std::memory_order_acquire);
+        for (auto slot = head; slot; slot = slot->next) {
+            bool expected = false;
+            if (not slot->in_use.load(std::memory_order_relaxed)
+                && slot->in_use.compare_exchange_strong(expected, true))
+            {
+                return slot;
+            }
+        }
+        auto slot = new HazardSlot;
+        slot->in_use.store(true, std::memory_order_relaxed);
+        slot->next = head;
+        while (not slots.compare_exchange_weak(slot->next, slot)) {
+        }
+        return slot;
+    }
+
+    bool isHazard(cfg const * p) const
+    {
+        for (auto slot = slots.load(std::memory_order_acquire); slot;
+             slot = slot->next)
+        {
+            if (slot->ptr.load() == p) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Requires writer_mutex.
+    void reclaimLocked()
+    {
+        auto keep = retired.begin();
+        for (auto p : retired) {
+            if (isHazard(p)) {
+                *keep++ = p;
+            } else {
+                p->destroy();
+            }
+        }
+        retired.erase(keep, retired.end());
+    }
+
+    static void destroyConfig(cfg * p)
+    {
+        if (p) {
+            p->destroy();
+        }
+    }
+
+public:
+    using Validator = std::function<void(cfg const &)>;
+
+    class Snapshot
+    {
+        friend class ConfigurationHandle;
+        HazardSlot * slot = nullptr;
+        cfg const * config = nullptr;
+
+        Snapshot(HazardSlot * s, cfg const * c)
+        : slot(s)
+        , config(c)
+        { }
+
+    public:
+        Snapshot(Snapshot && that) noexcept
+        : slot(std::exchange(that.slot, nullptr))
+        , config(std::exchange(that.config, nullptr))
+        { }
+
+        Snapshot & operator = (Snapshot && that) noexcept
+        {
+            Snapshot tmp(std::move(*this));
+            slot = std::exchange(that.slot, nullptr);
+            config = std::exchange(that.config, nullptr);
+            return *this;
+        }
+
+        ~Snapshot()
+        {
+            if (slot) {
+                slot->ptr.store(nullptr, std::memory_order_release);
+                slot->in_use.store(false, std::memory_order_release);
+            }
+        }
+
+        cfg const * get() const { return config; }
+        cfg const * operator -> () const { return config; }
+        cfg const & operator * () const { return *config; }
+    };
+
+    // Starts out publishing an empty configuration.
+    ConfigurationHandle()
+    : current(cfg::create())
+    { }
+
+    // Takes ownership of config, which must not be updated afterwards.
+    explicit ConfigurationHandle(cfg * config)
+    : current(config)
+    { }
+
+    ConfigurationHandle(ConfigurationHandle const &) = delete;
+    ConfigurationHandle & operator = (ConfigurationHandle const &) = delete;
+
+    // No Snapshot may outlive the handle.
+    ~ConfigurationHandle()
+    {
+        current.load()->destroy();
+        for (auto p : retired) {
+            p->destroy();
+        }
+        for (auto slot = slots.load(); slot;) {
+            delete std::exchange(slot, slot->next);
+        }
+    }
+
+    Snapshot read() const
+    {
+        auto slot = acquireSlot();
+        cfg const * p = current.load();
+        for (;;) {
+            // Announce p, then make sure it was not replaced (and so
+            // possibly reclaimed) before the announcement became visible.
+            slot->ptr.store(p);
+            auto q = current.load();
+            if (q == p) {
+                return Snapshot(slot, p);
+            }
+            p = q;
+        }
+    }
+
+    // Takes ownership of config, which must not be updated afterwards, and
+    // makes it the one returned by future calls to read().
+    void publish(cfg * config)
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        retired.push_back(current.exchange(config));
+        reclaimLocked();
+    }
+
+    void reload(
+        cfg::SourceType sourceType,
+        char const * source,
+        char const * sourceDescription = "",
+        Validator const & validate = Validator())
+    {
+        std::unique_ptr<cfg, void (*)(cfg *)> config{
+            cfg::create(),
+            destroyConfig};
+        config->parse(sourceType, source, sourceDescription);
+        if (validate) {
+            validate(*config);
+        }
+        publish(config.release());
+    }
+
+    // As reload(), but parses and validates in a new thread.  Any exception
+    // is reported through the future.
+    std::future<void> reloadAsync(
+        cfg::SourceType sourceType,
+        std::string source,
+        std::string sourceDescription = "",
+        Validator validate = Validator())
+    {
+        return std::async(
+            std::launch::async,
+            [this,
+             sourceType,
+             source = std::move(source),
+             sourceDescription = std::move(sourceDescription),
+             validate = std::move(validate)] {
+                reload(
+                    sourceType,
+                    source.c_str(),
+                    sourceDescription.c_str(),
+                    validate);
+            });
+    }
+
+    // Destroys replaced configurations that no reader is using any more.
+    void reclaim()
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        reclaimLocked();
+    }
+
+    // The number of replaced configurations not yet destroyed.
+    std::size_t numRetired()
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        return retired.size();
+    }
+};
+
 } // namespace CONFIG4CPP_NAMESPACE::ext
 
 #endif // CONFIG4CPP_CONFIGURATIONEXT_H_
@@ -45,6 +45,8 @@ class SchemaValidator;
 class SchemaParser;
 class SchemaIdRuleInfo;
 class SchemaIgnoreRuleInfo;
+class SchemaRuleIndex;
+class ConfigItem;
 
 
 class SchemaValidator
@@ -52,6 +54,19 @@ class SchemaValidator
 public:
 	enum ForceMode {DO_NOT_FORCE, FORCE_OPTIONAL, FORCE_REQUIRED};
 
+	//--------
+	// An error found by the validate() operation that collects all the
+	// errors, rather than throwing an exception for the first one.
+	//--------
+	struct Error {
+		StringBuffer		fullyScopedName;
+		StringBuffer		rule;		// "" if no rule matches the entry
+		StringBuffer		typeName;	// "" if no rule matches the entry
+		StringBuffer		message;	// the message of the exception
+		StringBuffer		fileName;
+		int					lineNumber;	// -1 if not known
+	};
+
 	//--------
 	// Constructors and destructor
 	//--------
@@ -63,6 +78,18 @@ public:
 	//--------
 	inline void wantDiagnostics(bool value);
 	inline bool wantDiagnostics();
+
+	//--------
+	// If numThreads is more than 1, validate() splits the items by
+	// their top-level scope and validates the parts on up to that
+	// many threads.  The configuration must not be updated while it
+	// is being validated.  If several items are invalid, the error
+	// reported is the one that validating them in order would report.
+	// Diagnostics are printed only when validating on one thread, so
+	// wantDiagnostics(true) disables the threads.
+	//--------
+	inline void numThreads(int value);
+	inline int numThreads();
 	void parseSchema(const char ** schema, int schemaSize);
 	void parseSchema(const char ** nullTerminatedSchema);
 	inline void validate(
@@ -77,6 +104,14 @@ public:
 		bool					recurseIntoSubscopes,
 		Configuration::Type		typeMask,
 		ForceMode				forceMode = DO_NOT_FORCE) const;
+	void validate(
+		const Configuration *	cfg,
+		const char *			scope,
+		const char *			localName,
+		bool					recurseIntoSubscopes,
+		Configuration::Type		typeMask,
+		ForceMode				forceMode,
+		std::vector<Error> &	errors) const;
 protected:
 	//--------
 	// Operations that can be called by a subclass.
@@ -100,16 +135,48 @@ private:
 		const char *			scope,
 		const char *			localName,
 		const StringVector &	itemNames,
-		ForceMode				forceMode) const;
+		const StringVector &	unexpandedItemNames,
+		const std::vector<const ConfigItem *> &	items,
+		ForceMode				forceMode,
+		std::vector<Error> *	errors) const;
+	void validateItems(
+		const Configuration *	cfg,
+		const char *			fullyScopedName,
+		const StringVector &	itemNames,
+		const StringVector &	unexpandedItemNames,
+		const std::vector<const ConfigItem *> &	items,
+		std::vector<Error> *	errors) const;
+	void validateItemsInParallel(
+		const Configuration *	cfg,
+		const char *			fullyScopedName,
+		const StringVector &	itemNames,
+		const StringVector &	unexpandedItemNames,
+		const std::vector<const ConfigItem *> &	items,
+		std::vector<Error> *	errors) const;
+	void validateItem(
+		const Configuration *	cfg,
+		const char *			fullyScopedName,
+		const char *			iName,
+		const char *			unexpandedName,
+		const ConfigItem *		item,
+		std::vector<Error> *	errors) const;
 	void validateForceMode(
 		const Configuration *	cfg,
 		const char *			scope,
 		const char *			localName,
-		ForceMode				forceMode) const;
+		ForceMode				forceMode,
+		std::vector<Error> *	errors) const;
 	void validateRequiredUidEntry(
 		const Configuration *	cfg,
 		const char *			fullScope,
-		SchemaIdRuleInfo *		idRule) const;
+		SchemaIdRuleInfo *		idRule,
+		std::vector<Error> *	errors) const;
+	void reportError(
+		const Configuration *	cfg,
+		const char *			fullyScopedName,
+		const SchemaIdRuleInfo *	idRule,
+		const char *			message,
+		std::vector<Error> *	errors) const;
 
 	void callCheckRule(
 		const SchemaType *		target,
@@ -161,10 +228,8 @@ private:
 
 	SchemaIdRuleInfo * findIdRule(const char * name) const;
 	bool shouldIgnore(
-		const Configuration *	cfg,
-		const char *			scope,
-		const char *			expandedName,
-		const char *			unexpandedName) const;
+		const char *			unexpandedName,
+		Configuration::Type		cfgType) const;
 
 	//--------
 	// Instance variables are NOT visible to subclasses.
@@ -177,11 +242,14 @@ private:
 	int							m_ignoreRulesCurrSize;
 	int							m_ignoreRulesMaxSize;
 
+	SchemaRuleIndex *			m_ruleIndex; // built by parseSchema()
+
 	SchemaType **				m_types;
 	int							m_typesCurrSize;
 	int							m_typesMaxSize;
 	bool						m_areTypesSorted;
 	bool						m_wantDiagnostics;
+	int							m_numThreads;
 
 	//--------
 	// The following are unimplemented
@@ -218,6 +286,18 @@ SchemaValidator::wantDiagnostics()
 	return m_wantDiagnostics;
 }
 
+inline void
+SchemaValidator::numThreads(int value)
+{
+	m_numThreads = value;
+}
+
+inline int
+SchemaValidator::numThreads()
+{
+	return m_numThreads;
+}
+
 
 }; // namespace CONFIG4CPP_NAMESPACE
 #endif
@@ -61,6 +61,7 @@ public:
 	inline void			deleteLastChar();
 	StringBuffer &		append(const StringBuffer & other);
 	StringBuffer &		append(const char * str);
+	StringBuffer &		append(const char * str, int len);
 	StringBuffer &		append(int val);
 	StringBuffer &		append(float val);
 	StringBuffer &		append(char ch);
@@ -0,0 +1,283 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+
+//--------
+// #include's
+//--------
+#include "Arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <utility>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//--------
+// Chunks start small, so that the many configurations that hold only
+// a few entries stay small, and double up to MAX_CHUNK_SIZE.
+//--------
+enum {
+	MIN_CHUNK_SIZE = 1024,
+	MAX_CHUNK_SIZE = 1024 * 1024
+};
+
+
+static inline size_t
+alignUp(size_t size)
+{
+	return (size + Arena::ALIGNMENT - 1) & ~(size_t)(Arena::ALIGNMENT - 1);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	Constructor and destructor
+//
+// Description:
+//----------------------------------------------------------------------
+
+Arena::Arena()
+{
+	m_chunks        = 0;
+	m_largeChunks   = 0;
+	m_next          = 0;
+	m_end           = 0;
+	m_nextChunkSize = MIN_CHUNK_SIZE;
+	m_bytesReserved = 0;
+}
+
+
+
+Arena::~Arena()
+{
+	release();
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	allocate()
+//
+// Description:	Return size bytes, aligned to ALIGNMENT.
+//----------------------------------------------------------------------
+
+void *
+Arena::allocate(size_t size)
+{
+	char *				result;
+
+	//--------
+	// Strings are packed, so m_next may not be aligned. m_end
+	// always is, so result never passes it.
+	//--------
+	size = alignUp(size == 0 ? 1 : size);
+	result = (char *)alignUp((uintptr_t)m_next);
+	if (size < LARGE_BLOCK && size <= (size_t)(m_end - result)) {
+		m_next = result + size;
+		return result;
+	}
+	return allocateSlow(size);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	allocateSlow()
+//
+// Description:	Start a new chunk, or give a large block a chunk of its
+//		own.
+//----------------------------------------------------------------------
+
+void *
+Arena::allocateSlow(size_t size)
+{
+	Chunk *				chunk;
+	size_t				chunkSize;
+	char *				result;
+
+	if (size >= LARGE_BLOCK) {
+		return allocateLarge(size);
+	}
+	chunkSize = m_nextChunkSize;
+	if (m_nextChunkSize < MAX_CHUNK_SIZE) {
+		m_nextChunkSize *= 2;
+	}
+	if (chunkSize < size) {
+		chunkSize = size;
+	}
+	chunk = (Chunk *)malloc(sizeof(Chunk) + chunkSize);
+	if (chunk == 0) {
+		throw std::bad_alloc();
+	}
+	chunk->prev = 0;
+	chunk->next = m_chunks;
+	chunk->size = chunkSize;
+	m_chunks = chunk;
+	m_bytesReserved += chunkSize;
+	result = (char *)(chunk + 1);
+	m_next = result + size;
+	m_end = result + chunkSize;
+	return result;
+}
+
+
+
+void *
+Arena::allocateLarge(size_t size)
+{
+	Chunk *				chunk;
+
+	chunk = (Chunk *)malloc(sizeof(Chunk) + size);
+	if (chunk == 0) {
+		throw std::bad_alloc();
+	}
+	chunk->prev = 0;
+	chunk->next = m_largeChunks;
+	chunk->size = size;
+	if (m_largeChunks != 0) {
+		m_largeChunks->prev = chunk;
+	}
+	m_largeChunks = chunk;
+	m_bytesReserved += size;
+	return chunk + 1;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	deallocate()
+//
+// Description:	Give back a block that is no longer needed.
+//
+// Notes:	size must be the size that was passed to allocate().
+//		Only large blocks are actually freed.
+//----------------------------------------------------------------------
+
+void
+Arena::deallocate(void * ptr, size_t size)
+{
+	Chunk *				chunk;
+
+	if (ptr == 0 || alignUp(size) < LARGE_BLOCK) {
+		return;
+	}
+	chunk = (Chunk *)ptr - 1;
+	if (chunk->prev != 0) {
+		chunk->prev->next = chunk->next;
+	} else {
+		m_largeChunks = chunk->next;
+	}
+	if (chunk->next != 0) {
+		chunk->next->prev = chunk->prev;
+	}
+	m_bytesReserved -= chunk->size;
+	free(chunk);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	copyString()
+//
+// Description:	Return a copy of str in the arena.
+//
+// Notes:	Strings need no alignment, so they are packed. A long
+//		string gets a chunk of its own, like any large block,
+//		so that deallocate() can free it.
+//----------------------------------------------------------------------
+
+char *
+Arena::copyString(const char * str)
+{
+	size_t				size;
+	char *				result;
+
+	size = strlen(str) + 1;
+	if (alignUp(size) < LARGE_BLOCK && size <= (size_t)(m_end - m_next)) {
+		result = m_next;
+		m_next += size;
+	} else {
+		result = (char *)allocateSlow(alignUp(size));
+	}
+	memcpy(result, str, size);
+	return result;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	release()
+//
+// Description:	Free every chunk. Everything that was allocated from
+//		the arena becomes invalid.
+//----------------------------------------------------------------------
+
+void
+Arena::release()
+{
+	Chunk *				chunk;
+	Chunk *				next;
+
+	for (chunk = m_chunks; chunk != 0; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+	for (chunk = m_largeChunks; chunk != 0; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+	m_chunks        = 0;
+	m_largeChunks   = 0;
+	m_next          = 0;
+	m_end           = 0;
+	m_nextChunkSize = MIN_CHUNK_SIZE;
+	m_bytesReserved = 0;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	swap()
+//
+// Description:	Exchange chunks with another arena, so that what was
+//		allocated from each now belongs to the other.
+//----------------------------------------------------------------------
+
+void
+Arena::swap(Arena & other)
+{
+	std::swap(m_chunks, other.m_chunks);
+	std::swap(m_largeChunks, other.m_largeChunks);
+	std::swap(m_next, other.m_next);
+	std::swap(m_end, other.m_end);
+	std::swap(m_nextChunkSize, other.m_nextChunkSize);
+	std::swap(m_bytesReserved, other.m_bytesReserved);
+}
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
@@ -0,0 +1,120 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+
+#ifndef CONFIG4CPP_ARENA_H_
+#define CONFIG4CPP_ARENA_H_
+
+
+//--------
+// #include's and #define's
+//--------
+#include <config4cpp/namespace.h>
+#include <stddef.h>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//----------------------------------------------------------------------
+// Class:	Arena
+//
+// Description:	A bump-pointer allocator. Memory is handed out from
+//		large chunks and is given back all at once, by release()
+//		or the destructor, in time proportional to the number of
+//		chunks rather than the number of allocations.
+//
+// Notes:	Objects allocated from an arena are never destroyed;
+//		they must not own memory that is not also in the arena.
+//		Small blocks cannot be freed individually, so the small
+//		blocks of a replaced or removed entry are reclaimed only
+//		when the whole arena is released. Blocks (and strings) of
+//		at least LARGE_BLOCK bytes get a chunk of their own,
+//		which deallocate() frees at once; this keeps the cost of
+//		growing big hash tables, and of replacing big lists and
+//		strings, the same as with the heap. An Arena is not
+//		thread-safe.
+//----------------------------------------------------------------------
+
+class Arena
+{
+public:
+	enum {
+		ALIGNMENT   = 8,
+		LARGE_BLOCK = 16 * 1024
+	};
+
+	Arena();
+	~Arena();
+
+	void *			allocate(size_t size);
+	void			deallocate(void * ptr, size_t size);
+	char *			copyString(const char * str);
+	void			release();
+	void			swap(Arena & other);
+
+	inline size_t	bytesReserved() const;
+
+private:
+	struct Chunk {
+		Chunk *		prev;
+		Chunk *		next;
+		size_t		size;
+		size_t		padding;	// keeps the data 16-byte aligned
+	};
+
+	void *			allocateSlow(size_t size);
+	void *			allocateLarge(size_t size);
+
+	//--------
+	// Instance variables
+	//--------
+	Chunk *			m_chunks;		// the current chunk is first
+	Chunk *			m_largeChunks;	// one per large block
+	char *			m_next;
+	char *			m_end;
+	size_t			m_nextChunkSize;
+	size_t			m_bytesReserved;
+
+	//--------
+	// Not implemented
+	//--------
+	Arena(const Arena &);
+	Arena & operator=(const Arena &);
+};
+
+
+//--------
+// Inline implementation of operations
+//--------
+
+inline size_t
+Arena::bytesReserved() const
+{
+	return m_bytesReserved;
+}
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
+#endif
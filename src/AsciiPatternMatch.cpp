@@ -32,6 +32,19 @@ namespace CONFIG4CPP_NAMESPACE {
 
 
 
+//----------------------------------------------------------------------
+// Function:	asciiPatternMatchInternal()
+//
+// Description:	Returns true if pattern[patternIndex..patternLen)
+//		matches str[strIndex..strLen).
+//
+// Notes:	After a mismatch, the match resumes just after the most
+//		recent "*", which is made to cover one more character of
+//		str.  Earlier "*"s never need to be revisited, so the
+//		worst case is proportional to strLen * patternLen, rather
+//		than exponential in the number of "*"s.
+//----------------------------------------------------------------------
+
 bool
 asciiPatternMatchInternal(
 	const char *			str,
@@ -41,36 +54,33 @@ asciiPatternMatchInternal(
 	int						patternIndex,
 	int						patternLen)
 {
-	while (patternIndex < patternLen) {
-		if (pattern[patternIndex] != '*') {
-			if (pattern[patternIndex] != str[strIndex]) {
-				return false;
-			}
+	int						starStrIndex;
+	int						starPatternIndex;
+
+	starStrIndex = -1;
+	starPatternIndex = -1;
+	while (strIndex < strLen) {
+		if (patternIndex < patternLen && pattern[patternIndex] == '*') {
 			patternIndex++;
-			if (strIndex < strLen) {
-				strIndex++;
-			}
-		} else {
+			starPatternIndex = patternIndex;
+			starStrIndex = strIndex;
+		} else if (patternIndex < patternLen
+				   && pattern[patternIndex] == str[strIndex])
+		{
 			patternIndex++;
-			while (pattern[patternIndex] == '*') {
-				patternIndex++;
-			}
-			if (patternIndex == patternLen) {
-				return true;
-			}
-			for (; strIndex < strLen; strIndex++) {
-				if (asciiPatternMatchInternal(str, strIndex, strLen,
-											pattern, patternIndex, patternLen))
-				{
-					return true;
-				}
-			}
+			strIndex++;
+		} else if (starPatternIndex != -1) {
+			starStrIndex++;
+			strIndex = starStrIndex;
+			patternIndex = starPatternIndex;
+		} else {
+			return false;
 		}
 	}
-	if (pattern[patternIndex] != str[strIndex]) {
-		return false;
+	while (patternIndex < patternLen && pattern[patternIndex] == '*') {
+		patternIndex++;
 	}
-	return true;
+	return patternIndex == patternLen;
 }
 
 
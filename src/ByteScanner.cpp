@@ -0,0 +1,337 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+//--------
+// #include's and #define's
+//--------
+#include "ByteScanner.h"
+#include <atomic>
+
+#if defined(__GNUC__) \
+    && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#	define CONFIG4CPP_X86_SIMD 1
+#	include <immintrin.h>
+#endif
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+typedef const char * (*FindStopFn)(const char *, const char *, char, char);
+typedef const char * (*SkipBlanksFn)(const char *, const char *);
+
+struct ScanFunctions {
+	ByteScanner::Impl	impl;
+	const char *		name;
+	FindStopFn			findStop;
+	SkipBlanksFn		skipBlanks;
+};
+
+
+
+//----------------------------------------------------------------------
+// Portable implementation. This is also used by the SIMD
+// implementations for the tail of the buffer that is too short
+// to fill a vector register.
+//----------------------------------------------------------------------
+
+static const char *
+findStopPortable(const char * ptr, const char * end, char stop1, char stop2)
+{
+	unsigned char		ch;
+
+	for (; ptr != end; ptr++) {
+		ch = (unsigned char)*ptr;
+		if (ch < 0x20 || ch >= 0x80 || ch == (unsigned char)stop1
+		    || ch == (unsigned char)stop2)
+		{
+			break;
+		}
+	}
+	return ptr;
+}
+
+
+static const char *
+skipBlanksPortable(const char * ptr, const char * end)
+{
+	while (ptr != end && (*ptr == ' ' || *ptr == '\t')) {
+		ptr++;
+	}
+	return ptr;
+}
+
+
+static const ScanFunctions portableFunctions = {
+	ByteScanner::IMPL_PORTABLE, "portable",
+	findStopPortable, skipBlanksPortable
+};
+
+
+#ifdef CONFIG4CPP_X86_SIMD
+//----------------------------------------------------------------------
+// SSE2 implementation. SSE2 is part of the x86-64 baseline, so this
+// needs no runtime check.
+//
+// Comparing bytes as signed values against 0x20 finds both control
+// characters (0x00-0x1F) and non-ASCII bytes (0x80-0xFF, which are
+// negative) with a single instruction.
+//----------------------------------------------------------------------
+
+static const char *
+findStopSse2(const char * ptr, const char * end, char stop1, char stop2)
+{
+	const __m128i		space = _mm_set1_epi8(0x20);
+	const __m128i		s1 = _mm_set1_epi8(stop1);
+	const __m128i		s2 = _mm_set1_epi8(stop2);
+	__m128i				bytes;
+	__m128i				hits;
+	unsigned int		mask;
+
+	while (end - ptr >= 16) {
+		bytes = _mm_loadu_si128((const __m128i *)ptr);
+		hits = _mm_or_si128(_mm_cmplt_epi8(bytes, space),
+		                    _mm_or_si128(_mm_cmpeq_epi8(bytes, s1),
+		                                 _mm_cmpeq_epi8(bytes, s2)));
+		mask = (unsigned int)_mm_movemask_epi8(hits);
+		if (mask != 0) {
+			return ptr + __builtin_ctz(mask);
+		}
+		ptr += 16;
+	}
+	return findStopPortable(ptr, end, stop1, stop2);
+}
+
+
+static const char *
+skipBlanksSse2(const char * ptr, const char * end)
+{
+	const __m128i		space = _mm_set1_epi8(' ');
+	const __m128i		tab = _mm_set1_epi8('\t');
+	__m128i				bytes;
+	__m128i				blanks;
+	unsigned int		mask;
+
+	while (end - ptr >= 16) {
+		bytes = _mm_loadu_si128((const __m128i *)ptr);
+		blanks = _mm_or_si128(_mm_cmpeq_epi8(bytes, space),
+		                      _mm_cmpeq_epi8(bytes, tab));
+		mask = ~(unsigned int)_mm_movemask_epi8(blanks) & 0xFFFF;
+		if (mask != 0) {
+			return ptr + __builtin_ctz(mask);
+		}
+		ptr += 16;
+	}
+	return skipBlanksPortable(ptr, end);
+}
+
+
+static const ScanFunctions sse2Functions = {
+	ByteScanner::IMPL_SSE2, "sse2",
+	findStopSse2, skipBlanksSse2
+};
+
+
+
+//----------------------------------------------------------------------
+// AVX2 implementation, used only if the CPU supports it.
+//----------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static const char *
+findStopAvx2(const char * ptr, const char * end, char stop1, char stop2)
+{
+	const __m256i		space = _mm256_set1_epi8(0x20);
+	const __m256i		s1 = _mm256_set1_epi8(stop1);
+	const __m256i		s2 = _mm256_set1_epi8(stop2);
+	__m256i				bytes;
+	__m256i				hits;
+	unsigned int		mask;
+
+	while (end - ptr >= 32) {
+		bytes = _mm256_loadu_si256((const __m256i *)ptr);
+		hits = _mm256_or_si256(_mm256_cmpgt_epi8(space, bytes),
+		                       _mm256_or_si256(_mm256_cmpeq_epi8(bytes, s1),
+		                                       _mm256_cmpeq_epi8(bytes, s2)));
+		mask = (unsigned int)_mm256_movemask_epi8(hits);
+		if (mask != 0) {
+			return ptr + __builtin_ctz(mask);
+		}
+		ptr += 32;
+	}
+	return findStopSse2(ptr, end, stop1, stop2);
+}
+
+
+__attribute__((target("avx2")))
+static const char *
+skipBlanksAvx2(const char * ptr, const char * end)
+{
+	const __m256i		space = _mm256_set1_epi8(' ');
+	const __m256i		tab = _mm256_set1_epi8('\t');
+	__m256i				bytes;
+	__m256i				blanks;
+	unsigned int		mask;
+
+	while (end - ptr >= 32) {
+		bytes = _mm256_loadu_si256((const __m256i *)ptr);
+		blanks = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, space),
+		                         _mm256_cmpeq_epi8(bytes, tab));
+		mask = ~(unsigned int)_mm256_movemask_epi8(blanks);
+		if (mask != 0) {
+			return ptr + __builtin_ctz(mask);
+		}
+		ptr += 32;
+	}
+	return skipBlanksSse2(ptr, end);
+}
+
+
+static const ScanFunctions avx2Functions = {
+	ByteScanner::IMPL_AVX2, "avx2",
+	findStopAvx2, skipBlanksAvx2
+};
+#endif
+
+
+
+//----------------------------------------------------------------------
+// Runtime selection of the implementation. s_current is null until
+// a scanning function is first called.
+//----------------------------------------------------------------------
+
+static std::atomic<const ScanFunctions *>	s_current(0);
+
+
+static const ScanFunctions *
+functionsFor(ByteScanner::Impl impl)
+{
+	switch (impl) {
+	case ByteScanner::IMPL_PORTABLE:
+		return &portableFunctions;
+#ifdef CONFIG4CPP_X86_SIMD
+	case ByteScanner::IMPL_SSE2:
+		return &sse2Functions;
+	case ByteScanner::IMPL_AVX2:
+		if (__builtin_cpu_supports("avx2")) {
+			return &avx2Functions;
+		}
+		return 0;
+	case ByteScanner::IMPL_BEST:
+		if (__builtin_cpu_supports("avx2")) {
+			return &avx2Functions;
+		}
+		return &sse2Functions;
+#else
+	case ByteScanner::IMPL_BEST:
+		return &portableFunctions;
+#endif
+	default:
+		return 0;
+	}
+}
+
+
+static inline const ScanFunctions *
+currentFunctions()
+{
+	const ScanFunctions *	result;
+
+	result = s_current.load(std::memory_order_relaxed);
+	if (result == 0) {
+		result = functionsFor(ByteScanner::IMPL_BEST);
+		s_current.store(result, std::memory_order_relaxed);
+	}
+	return result;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	findStop()
+//
+// Description:	See ByteScanner.h
+//----------------------------------------------------------------------
+
+const char *
+ByteScanner::findStop(
+	const char *	ptr,
+	const char *	end,
+	char			stop1,
+	char			stop2)
+{
+	return currentFunctions()->findStop(ptr, end, stop1, stop2);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	skipBlanks()
+//
+// Description:	See ByteScanner.h
+//----------------------------------------------------------------------
+
+const char *
+ByteScanner::skipBlanks(const char * ptr, const char * end)
+{
+	return currentFunctions()->skipBlanks(ptr, end);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	select()
+//
+// Description:	Force the use of an implementation.
+//----------------------------------------------------------------------
+
+bool
+ByteScanner::select(Impl impl)
+{
+	const ScanFunctions *	functions;
+
+	functions = functionsFor(impl);
+	if (functions == 0) {
+		return false;
+	}
+	s_current.store(functions, std::memory_order_relaxed);
+	return true;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	implName()
+//
+// Description:	Name of the implementation in use.
+//----------------------------------------------------------------------
+
+const char *
+ByteScanner::implName()
+{
+	return currentFunctions()->name;
+}
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
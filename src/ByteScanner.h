@@ -0,0 +1,96 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+#ifndef CONFIG4CPP_BYTE_SCANNER_H_
+#define CONFIG4CPP_BYTE_SCANNER_H_
+
+
+//--------
+// #include's and #define's
+//--------
+#include <config4cpp/namespace.h>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//----------------------------------------------------------------------
+// Class:	ByteScanner
+//
+// Description:	Helps the lexer skip over runs of bytes that need no
+//		individual attention, such as the body of a comment
+//		or of a string literal.
+//
+// Notes:	The scanning functions are implemented with SSE2 and
+//		AVX2 where the CPU supports them, and with a portable
+//		loop otherwise. The best implementation is chosen at
+//		runtime, the first time a scanning function is called.
+//----------------------------------------------------------------------
+
+class ByteScanner
+{
+public:
+	enum Impl {
+		IMPL_BEST,
+		IMPL_PORTABLE,
+		IMPL_SSE2,
+		IMPL_AVX2
+	};
+
+	//--------
+	// Returns a pointer to the first byte in [ptr, end) that is
+	// stop1, stop2, a control character (< 0x20, which includes
+	// '\n', '\r' and '\t') or a non-ASCII byte (>= 0x80). Returns
+	// end if there is no such byte.
+	//--------
+	static const char *	findStop(
+							const char *	ptr,
+							const char *	end,
+							char			stop1,
+							char			stop2);
+
+	//--------
+	// Returns a pointer to the first byte in [ptr, end) that is
+	// neither ' ' nor '\t', or end if there is no such byte.
+	//--------
+	static const char *	skipBlanks(const char * ptr, const char * end);
+
+	//--------
+	// Used by tests and benchmarks to force a particular
+	// implementation. Returns false (and changes nothing) if
+	// the implementation is not supported on this CPU.
+	//--------
+	static bool			select(Impl impl);
+	static const char *	implName();
+
+private:
+	//--------
+	// Not instantiable
+	//--------
+	ByteScanner();
+};
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
+#endif
@@ -35,6 +35,12 @@ namespace CONFIG4CPP_NAMESPACE {
 // Forward declarations of static functions
 //--------
 static char * stringConcat(const char* s1, const char* s2, const char* s3 = "");
+static std::string trim(const std::string & str);
+static std::string toIdentifier(const std::string & str);
+static void splitType(
+				const std::string &			type,
+				std::string &				baseType,
+				std::vector<std::string> &	args);
 
 
 
@@ -58,11 +64,13 @@ Config2Cpp::Config2Cpp(const char * progName)
 	m_schemaOverrideCfg   = 0;
 	m_schemaOverrideScope = stringCopy("");
 	m_className           = 0;
+	m_structName          = 0;
 	m_cppExt              = 0;
 	m_hExt                = 0;
 	m_outDir              = 0;
 	m_wantSingleton       = false;
 	m_wantSchema          = true;
+	m_wantCompiled        = false;
 	m_namespaceArraySize  = 0;
 	m_namespaceArray      = 0;
 }
@@ -84,6 +92,7 @@ Config2Cpp::~Config2Cpp()
 	delete [] m_schemaOverrideCfg;
 	delete [] m_schemaOverrideScope;
 	delete [] m_className;
+	delete [] m_structName;
 	delete [] m_cppExt;
 	delete [] m_hExt;
 	delete [] m_outDir;
@@ -169,6 +178,15 @@ Config2Cpp::parseCmdLineArgs(int argc, char ** argv)
 			i++;
 		} else if (strcmp(argv[i], "-singleton") == 0) {
 			m_wantSingleton = true;
+		} else if (strcmp(argv[i], "-compiled") == 0) {
+			m_wantCompiled = true;
+		} else if (strcmp(argv[i], "-struct") == 0) {
+			if (i == argc-1) {
+				usage("");
+				return false;
+			}
+			m_structName = stringCopy(argv[i+1]);
+			i++;
 		} else {
 			usage(argv[i]);
 			return false;
@@ -178,6 +196,12 @@ Config2Cpp::parseCmdLineArgs(int argc, char ** argv)
 		usage("");
 		return false;
 	}
+	if (m_structName != 0 && !m_wantSchema) {
+		fprintf(stderr, "\n-struct needs the schema, so it cannot be %s",
+				"used with -noschema\n");
+		usage("");
+		return false;
+	}
 
 	if (m_cppExt == 0) {
 		m_cppExt = stringCopy(".cpp");
@@ -197,12 +221,19 @@ Config2Cpp::parseCmdLineArgs(int argc, char ** argv)
 // Function:	generateFiles()
 //
 // Description:	
+//
+// Notes:	With -compiled, image is the precompiled configuration
+//		and the configuration file itself is not read. With
+//		-struct, the struct's members are worked out from the
+//		schema.
 //----------------------------------------------------------------------
 
 bool
 Config2Cpp::generateFiles(
 	const char * const *	schema,
-	int						schemaSize)
+	int						schemaSize,
+	const char *			image,
+	size_t					imageSize)
 {
 	char *					msg;
 	char *					cppFileName;
@@ -211,20 +242,36 @@ Config2Cpp::generateFiles(
 	FILE *					cppFile;
 	FILE *					hFile;
 
+	if (m_wantCompiled && image == 0) {
+		fprintf(stderr, "%s: -compiled is not supported, because %s\n",
+				m_progName, "it cannot parse the configuration");
+		return false;
+	}
+	if (m_structName != 0 && schema == 0) {
+		fprintf(stderr, "%s: -struct is not supported, because %s\n",
+				m_progName, "it does not calculate a schema");
+		return false;
+	}
+	if (m_structName != 0 && !parseSchemaFields(schema, schemaSize)) {
+		return false;
+	}
 	cppFileName = stringConcat(m_outDir, m_className, m_cppExt);
 	hFileName   = stringConcat(m_outDir, m_className, m_hExt);
 
 	//--------
 	// Open all the files
 	//--------
-	cfgFile = fopen(m_cfgFileName, "r");
-	if (cfgFile == 0) {
-		msg = stringConcat("cannot open '", m_cfgFileName, "'");
-		perror(msg);
-		delete [] msg;
-		delete [] cppFileName;
-		delete [] hFileName;
-		return false;
+	cfgFile = 0;
+	if (!m_wantCompiled) {
+		cfgFile = fopen(m_cfgFileName, "r");
+		if (cfgFile == 0) {
+			msg = stringConcat("cannot open '", m_cfgFileName, "'");
+			perror(msg);
+			delete [] msg;
+			delete [] cppFileName;
+			delete [] hFileName;
+			return false;
+		}
 	}
 	cppFile = fopen(cppFileName, "w");
 	if (cppFile == 0) {
@@ -233,7 +280,9 @@ Config2Cpp::generateFiles(
 		delete [] msg;
 		delete [] cppFileName;
 		delete [] hFileName;
-		fclose(cfgFile);
+		if (cfgFile != 0) {
+			fclose(cfgFile);
+		}
 		return false;
 	}
 	hFile = fopen(hFileName, "w");
@@ -243,7 +292,9 @@ Config2Cpp::generateFiles(
 		delete [] msg;
 		delete [] cppFileName;
 		delete [] hFileName;
-		fclose(cfgFile);
+		if (cfgFile != 0) {
+			fclose(cfgFile);
+		}
 		fclose(cppFile);
 		return false;
 	}
@@ -251,15 +302,23 @@ Config2Cpp::generateFiles(
 	//--------
 	// Generate the ".h" and ".cpp" files.
 	//--------
-	printToHeaderFile(hFile, schemaSize);
-	printToCppFile(cfgFile, cppFile, schema, schemaSize);
+	if (m_wantCompiled) {
+		printCompiledToHeaderFile(hFile, schemaSize, imageSize);
+		printCompiledToCppFile(cppFile, schema, schemaSize, image,
+							   imageSize);
+	} else {
+		printToHeaderFile(hFile, schemaSize);
+		printToCppFile(cfgFile, cppFile, schema, schemaSize);
+	}
 
 	//--------
 	// Tidy up
 	//--------
 	delete [] cppFileName;
 	delete [] hFileName;
-	fclose(cfgFile);
+	if (cfgFile != 0) {
+		fclose(cfgFile);
+	}
 	fclose(cppFile);
 	fclose(hFile);
 
@@ -397,6 +456,10 @@ Config2Cpp::usage(const char * unknownArg)
 	fprintf(stderr, "\t-h   <extension>     default is .h\n");
 	fprintf(stderr, "\t-namespace X::Y::Z   default is the global scope\n");
 	fprintf(stderr, "\t-singleton           generate a singleton class\n");
+	fprintf(stderr, "\t-compiled            embed the parsed configuration,%s",
+			"\n\t                     for Configuration::parseBinaryImage()\n");
+	fprintf(stderr, "\t-struct <name>       also generate a struct with a %s",
+			"typed\n\t                     member for each variable\n");
 }
 
 
@@ -428,6 +491,10 @@ Config2Cpp::printToHeaderFile(FILE * file, int schemaSize)
 	fprintf(file, "#define %s_h\n", m_className);
 	fprintf(file, "\n");
 	fprintf(file, "#include <config4cpp/Configuration.h>\n");
+	if (m_structName != 0) {
+		fprintf(file, "#include <chrono>\n");
+		fprintf(file, "#include <string>\n");
+	}
 	fprintf(file, "\n");
 	fprintf(file, "\n");
 	if (m_namespaceArraySize != 0) {
@@ -531,6 +598,9 @@ Config2Cpp::printToHeaderFile(FILE * file, int schemaSize)
 	fprintf(file, "};\n");
 	fprintf(file, "\n");
 	fprintf(file, "\n");
+	if (m_structName != 0) {
+		printStructToHeaderFile(file);
+	}
 	if (m_namespaceArraySize != 0) {
 		for (i = 0; i < m_namespaceArraySize; i++) {
 			fprintf(file, "}; // namespace %s\n",
@@ -560,6 +630,7 @@ Config2Cpp::printToCppFile(
 	int						i;
 	int						ch;
 	int						count;
+	const char *			str;
 
 	fprintf(file, "//%s%s\n",
 			"-----------------------------------",
@@ -591,8 +662,11 @@ Config2Cpp::printToCppFile(
 	fprintf(file, "{\n");
 	if (schemaSize > 0) {
 		for (i = 0; i < schemaSize; i++) {
-			fprintf(file, "\tm_schema[%d] = \"%s\";\n",
-				i, schema[i]);
+			fprintf(file, "\tm_schema[%d] = \"", i);
+			for (str = schema[i]; *str != '\0'; str++) {
+				output(file, (unsigned char)*str);
+			}
+			fprintf(file, "\";\n");
 		}
 		fprintf(file, "\tm_schema[%d] = 0;\n", i);
 		fprintf(file, "\n");
@@ -619,6 +693,9 @@ Config2Cpp::printToCppFile(
 	fprintf(file, "}\n");
 	fprintf(file, "\n");
 	fprintf(file, "\n");
+	if (m_structName != 0) {
+		printStructToCppFile(file);
+	}
 	if (m_namespaceArraySize != 0) {
 		for (i = 0; i < m_namespaceArraySize; i++) {
 			fprintf(file, "}; // namespace %s\n",
@@ -630,6 +707,555 @@ Config2Cpp::printToCppFile(
 
 
 
+//----------------------------------------------------------------------
+// Function:	printCompiledToHeaderFile()
+//
+// Description:	Prints contents of generated .h file for -compiled.
+//		The class has only static members, so -singleton
+//		makes no difference.
+//----------------------------------------------------------------------
+
+void
+Config2Cpp::printCompiledToHeaderFile(
+	FILE *					file,
+	int						schemaSize,
+	size_t					imageSize)
+{
+	int						i;
+
+	fprintf(file, "//%s%s\n",
+			"-----------------------------------",
+			"-----------------------------------");
+	fprintf(file, "// WARNING: This file was generated by %s. %s\n",
+			m_progName, "Do not edit.");
+	fprintf(file, "//\n");
+	fprintf(file, "// Description: a class providing %s\n",
+		      "access to an embedded, precompiled");
+	fprintf(file, "//              configuration.\n");
+	fprintf(file, "//%s%s\n",
+			"-----------------------------------",
+			"-----------------------------------");
+	fprintf(file, "#ifndef %s_h\n", m_className);
+	fprintf(file, "#define %s_h\n", m_className);
+	fprintf(file, "\n");
+	fprintf(file, "#include <config4cpp/Configuration.h>\n");
+	if (m_structName != 0) {
+		fprintf(file, "#include <chrono>\n");
+		fprintf(file, "#include <string>\n");
+	}
+	fprintf(file, "\n");
+	fprintf(file, "\n");
+	if (m_namespaceArraySize != 0) {
+		for (i = 0; i < m_namespaceArraySize; i++) {
+			fprintf(file, "namespace %s {\n", m_namespaceArray[i]);
+		}
+		fprintf(file, "\n");
+		fprintf(file, "\n");
+	}
+	fprintf(file, "class %s\n", m_className);
+	fprintf(file, "{\n");
+	fprintf(file, "public:\n");
+	fprintf(file, "\t//--------\n");
+	fprintf(file, "\t// Get the precompiled configuration, %s\n",
+		      "to be loaded with");
+	fprintf(file, "\t// Configuration::parseBinaryImage()\n");
+	fprintf(file, "\t//--------\n");
+	fprintf(file, "\tstatic const char * getImage()\n");
+	fprintf(file, "\t{\n");
+	fprintf(file, "\t\treturn (const char *)s_image;\n");
+	fprintf(file, "\t}\n");
+	fprintf(file, "\tstatic size_t getImageSize()\n");
+	fprintf(file, "\t{\n");
+	fprintf(file, "\t\treturn %lu;\n", (unsigned long)imageSize);
+	fprintf(file, "\t}\n");
+	if (schemaSize > 0) {
+		fprintf(file, "\n");
+		fprintf(file, "\t//--------\n");
+		fprintf(file, "\t// Get the configuration's schema\n");
+		fprintf(file, "\t//--------\n");
+		fprintf(file, "\tstatic void getSchema(%s, %s)\n",
+						"const char **& schema",
+						"int & schemaSize");
+		fprintf(file, "\t{\n");
+		fprintf(file, "\t\tschema = s_schema;\n");
+		fprintf(file, "\t\tschemaSize = %d;\n", schemaSize);
+		fprintf(file, "\t}\n");
+		fprintf(file, "\tstatic const char ** %s() // %s\n",
+		              "getSchema", "null terminated array");
+		fprintf(file, "\t{\n");
+		fprintf(file, "\t\treturn s_schema;\n");
+		fprintf(file, "\t}\n");
+	}
+	fprintf(file, "\n");
+	fprintf(file, "private:\n");
+	fprintf(file, "\t//--------\n");
+	fprintf(file, "\t// Variables. They are constant-initialized, %s\n",
+		      "so they need no");
+	fprintf(file, "\t// code to run at startup.\n");
+	fprintf(file, "\t//--------\n");
+	fprintf(file, "\tstatic const unsigned char s_image[%lu];\n",
+		      (unsigned long)imageSize);
+	if (schemaSize > 0) {
+		fprintf(file, "\tstatic const char *        s_schema[%d];\n",
+			schemaSize + 1);
+	}
+	fprintf(file, "\n");
+	fprintf(file, "\t//--------\n");
+	fprintf(file, "\t// The following are not implemented\n");
+	fprintf(file, "\t//--------\n");
+	fprintf(file, "\t%s();\n", m_className);
+	fprintf(file, "\t%s & operator=(const %s &);\n",
+		      m_className, m_className);
+	fprintf(file, "\t%s(const %s &);\n", m_className, m_className);
+	fprintf(file, "};\n");
+	fprintf(file, "\n");
+	fprintf(file, "\n");
+	if (m_structName != 0) {
+		printStructToHeaderFile(file);
+	}
+	if (m_namespaceArraySize != 0) {
+		for (i = 0; i < m_namespaceArraySize; i++) {
+			fprintf(file, "}; // namespace %s\n",
+			       m_namespaceArray[m_namespaceArraySize-(i+1)]);
+		}
+		fprintf(file, "\n");
+		fprintf(file, "\n");
+	}
+	fprintf(file, "#endif\n");
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	printCompiledToCppFile()
+//
+// Description:	Prints contents of generated .cpp file for -compiled.
+//
+// Notes:	The image is written as an array of bytes rather than
+//		a string literal, because some compilers limit the
+//		length of string literals.
+//----------------------------------------------------------------------
+
+void
+Config2Cpp::printCompiledToCppFile(
+	FILE *					file,
+	const char * const *	schema,
+	int						schemaSize,
+	const char *			image,
+	size_t					imageSize)
+{
+	int						i;
+	size_t					j;
+	const char *			str;
+
+	fprintf(file, "//%s%s\n",
+			"-----------------------------------",
+			"-----------------------------------");
+	fprintf(file, "// WARNING: This file was generated by %s. %s\n",
+			m_progName, "Do not edit.");
+	fprintf(file, "//%s%s\n",
+			"-----------------------------------",
+			"-----------------------------------");
+	fprintf(file, "\n");
+	fprintf(file, "#include \"%s%s\"\n", m_className, m_hExt);
+	fprintf(file, "\n\n\n\n\n");
+	if (m_namespaceArraySize != 0) {
+		for (i = 0; i < m_namespaceArraySize; i++) {
+			fprintf(file, "namespace %s {\n", m_namespaceArray[i]);
+		}
+		fprintf(file, "\n");
+		fprintf(file, "\n");
+	}
+	if (schemaSize > 0) {
+		fprintf(file, "const char * %s::s_schema[%d] = {\n",
+			m_className, schemaSize + 1);
+		for (i = 0; i < schemaSize; i++) {
+			fprintf(file, "\t\"");
+			for (str = schema[i]; *str != '\0'; str++) {
+				output(file, (unsigned char)*str);
+			}
+			fprintf(file, "\",\n");
+		}
+		fprintf(file, "\t0\n");
+		fprintf(file, "};\n");
+		fprintf(file, "\n\n");
+	}
+	fprintf(file, "const unsigned char %s::s_image[%lu] = {",
+		m_className, (unsigned long)imageSize);
+	for (j = 0; j < imageSize; j++) {
+		if (j % 16 == 0) {
+			fprintf(file, "\n\t");
+		}
+		fprintf(file, "%u,", (unsigned int)(unsigned char)image[j]);
+	}
+	fprintf(file, "\n");
+	fprintf(file, "};\n");
+	fprintf(file, "\n");
+	fprintf(file, "\n");
+	if (m_structName != 0) {
+		printStructToCppFile(file);
+	}
+	if (m_namespaceArraySize != 0) {
+		for (i = 0; i < m_namespaceArraySize; i++) {
+			fprintf(file, "}; // namespace %s\n",
+			       m_namespaceArray[m_namespaceArraySize-(i+1)]);
+		}
+		fprintf(file, "\n");
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	parseSchemaFields()
+//
+// Description:	Work out the members of the -struct struct from the
+//		rules of the schema, such as "@optional log.level = int".
+//
+// Notes:	Scopes, and names with wildcards or "uid-", have no
+//		member. Types defined with @typedef are resolved, and
+//		each enum gets a C++ enum, named after the typedef if
+//		there is one, or else after the member, plus "_enum" so
+//		that it cannot clash with a member. Returns false, after
+//		reporting an error, if the schema cannot be turned into
+//		a struct.
+//----------------------------------------------------------------------
+
+bool
+Config2Cpp::parseSchemaFields(const char * const * schema, int schemaSize)
+{
+	std::vector<std::string>	typedefNames;
+	std::vector<std::string>	typedefTypes;
+	std::vector<std::string>	args;
+	std::string					rule;
+	std::string					keyword;
+	std::string					name;
+	std::string					type;
+	std::string					typeName;
+	std::string					baseType;
+	Field						field;
+	Enum						enumInfo;
+	size_t						eqPos;
+	size_t						i;
+	size_t						j;
+
+	m_fields.clear();
+	m_enums.clear();
+	for (i = 0; i < (size_t)schemaSize; i++) {
+		rule = trim(schema[i]);
+		keyword = "";
+		if (rule[0] == '@') {
+			j = rule.find_first_of(" \t");
+			keyword = rule.substr(0, j);
+			rule = (j == std::string::npos) ? "" : trim(rule.substr(j));
+		}
+		eqPos = rule.find('=');
+		if (eqPos == std::string::npos) {
+			continue; // for example, "@ignoreEverythingIn x"
+		}
+		name = trim(rule.substr(0, eqPos));
+		type = trim(rule.substr(eqPos + 1));
+		if (keyword == "@typedef") {
+			typedefNames.push_back(name);
+			typedefTypes.push_back(type);
+			continue;
+		}
+		if (name.find_first_of("*?") != std::string::npos
+			|| name.find("uid-") != std::string::npos)
+		{
+			continue;
+		}
+
+		//--------
+		// Resolve typedefs. A typedef can only refer to a type
+		// defined before it, so this stops.
+		//--------
+		typeName = "";
+		splitType(type, baseType, args);
+		for (j = typedefNames.size(); j > 0; j--) {
+			if (typedefNames[j - 1] == baseType) {
+				if (typeName == "") {
+					typeName = baseType;
+				}
+				type = typedefTypes[j - 1];
+				splitType(type, baseType, args);
+			}
+		}
+		if (baseType == "scope") {
+			continue;
+		}
+
+		field.cfgName = name;
+		field.member = toIdentifier(name);
+		field.type = baseType;
+		field.enumIndex = -1;
+		field.isOptional = (keyword != "@required");
+		for (j = 0; j < m_fields.size(); j++) {
+			if (m_fields[j].member == field.member) {
+				field.member += "_"; // and check the new name again
+				j = (size_t)-1;
+			}
+		}
+		if (baseType == "enum") {
+			enumInfo.typeName = (typeName == "") ? "enum" : typeName;
+			enumInfo.cppName = (typeName == "")
+							   ? field.member + "_enum"
+							   : toIdentifier(typeName) + "_enum";
+			enumInfo.values = args;
+			for (j = 0; j < m_enums.size(); j++) {
+				if (m_enums[j].cppName == enumInfo.cppName) {
+					break;
+				}
+			}
+			if (j == m_enums.size()) {
+				if (!checkEnumValues(enumInfo)) {
+					return false;
+				}
+				m_enums.push_back(enumInfo);
+			}
+			field.enumIndex = (int)j;
+		}
+		m_fields.push_back(field);
+	}
+	return true;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	checkEnumValues()
+//
+// Description:	Report an error, and return false, if two values of
+//		an enum, such as "dark-blue" and "dark_blue", would
+//		have the same enumerator.
+//----------------------------------------------------------------------
+
+bool
+Config2Cpp::checkEnumValues(const Enum & enumInfo)
+{
+	std::string				id;
+	size_t					i;
+	size_t					j;
+
+	for (i = 0; i < enumInfo.values.size(); i++) {
+		id = toIdentifier(enumInfo.values[i]);
+		for (j = 0; j < i; j++) {
+			if (toIdentifier(enumInfo.values[j]) == id) {
+				fprintf(stderr, "%s: -struct cannot generate '%s': the "
+						"values '%s' and '%s' of %s would both be "
+						"the enumerator '%s'\n", m_progName,
+						enumInfo.cppName.c_str(),
+						enumInfo.values[j].c_str(),
+						enumInfo.values[i].c_str(),
+						enumInfo.typeName.c_str(), id.c_str());
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+
+//--------
+// How a member of each schema type is declared and looked up. Members
+// of other types, such as "units_with_int", hold the string value.
+//--------
+enum FieldForm {
+	FIELD_ASSIGN,		// member = cfg->lookupX(...)
+	FIELD_CONVERT,		// member = Type(cfg->lookupX(...))
+	FIELD_OUT_PARAM		// cfg->lookupX(..., member)
+};
+
+static const struct {
+	const char *	schemaType;
+	const char *	cppType;
+	const char *	lookupOp;
+	FieldForm		form;
+} fieldTypes[] = {
+	{"string", "std::string", "lookupString", FIELD_ASSIGN},
+	{"boolean", "bool", "lookupBoolean", FIELD_ASSIGN},
+	{"int", "int", "lookupInt", FIELD_ASSIGN},
+	{"float", "float", "lookupFloat", FIELD_ASSIGN},
+	{"durationMicroseconds", "std::chrono::microseconds",
+		"lookupDurationMicroseconds", FIELD_CONVERT},
+	{"durationMilliseconds", "std::chrono::milliseconds",
+		"lookupDurationMilliseconds", FIELD_CONVERT},
+	{"durationSeconds", "std::chrono::seconds",
+		"lookupDurationSeconds", FIELD_CONVERT},
+	{"memorySizeBytes", "int", "lookupMemorySizeBytes", FIELD_ASSIGN},
+	{"memorySizeKB", "int", "lookupMemorySizeKB", FIELD_ASSIGN},
+	{"memorySizeMB", "int", "lookupMemorySizeMB", FIELD_ASSIGN},
+	{"list", "CONFIG4CPP_NAMESPACE::StringVector", "lookupList",
+		FIELD_OUT_PARAM},
+	{"table", "CONFIG4CPP_NAMESPACE::StringVector", "lookupList",
+		FIELD_OUT_PARAM},
+	{"tuple", "CONFIG4CPP_NAMESPACE::StringVector", "lookupList",
+		FIELD_OUT_PARAM},
+	{0, "std::string", "lookupString", FIELD_ASSIGN}
+};
+
+static int
+findFieldType(const std::string & schemaType)
+{
+	int						i;
+
+	for (i = 0; fieldTypes[i].schemaType != 0; i++) {
+		if (schemaType == fieldTypes[i].schemaType) {
+			break;
+		}
+	}
+	return i;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	printStructToHeaderFile()
+//
+// Description:	Prints the -struct struct in the generated .h file
+//----------------------------------------------------------------------
+
+void
+Config2Cpp::printStructToHeaderFile(FILE * file)
+{
+	size_t					i;
+	size_t					j;
+	const char *			cppType;
+
+	fprintf(file, "//--------\n");
+	fprintf(file, "// The variables in the schema, %s\n",
+		      "as typed members. load() looks");
+	fprintf(file, "// them all up, typically after schema %s\n",
+		      "validation, so reading one");
+	fprintf(file, "// afterwards is a plain member access. %s\n",
+		      "An infinite duration is -1.");
+	fprintf(file, "// An optional variable that %s\n",
+		      "is not set keeps its value.");
+	fprintf(file, "//--------\n");
+	fprintf(file, "struct %s\n", m_structName);
+	fprintf(file, "{\n");
+	for (i = 0; i < m_enums.size(); i++) {
+		fprintf(file, "\tenum class %s {", m_enums[i].cppName.c_str());
+		for (j = 0; j < m_enums[i].values.size(); j++) {
+			fprintf(file, "%s %s", (j == 0) ? "" : ",",
+					toIdentifier(m_enums[i].values[j]).c_str());
+		}
+		fprintf(file, " };\n");
+	}
+	if (m_enums.size() != 0) {
+		fprintf(file, "\n");
+	}
+	for (i = 0; i < m_fields.size(); i++) {
+		if (m_fields[i].enumIndex != -1) {
+			cppType = m_enums[m_fields[i].enumIndex].cppName.c_str();
+		} else {
+			cppType = fieldTypes[findFieldType(m_fields[i].type)].cppType;
+		}
+		fprintf(file, "\t%-34s %s{};\n", cppType, m_fields[i].member.c_str());
+	}
+	fprintf(file, "\n");
+	fprintf(file, "\tvoid load(\n");
+	fprintf(file, "\t\tconst CONFIG4CPP_NAMESPACE::Configuration *\tcfg,\n");
+	fprintf(file, "\t\tconst char *\t\t\t\t\tscope = \"\");\n");
+	fprintf(file, "};\n");
+	fprintf(file, "\n");
+	fprintf(file, "\n");
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	printStructToCppFile()
+//
+// Description:	Prints the -struct struct's load() in the generated
+//		.cpp file
+//
+// Notes:	An optional variable is looked up only if it has a
+//		value, so one that is not set keeps the member's
+//		initial value rather than making load() throw.
+//----------------------------------------------------------------------
+
+void
+Config2Cpp::printStructToCppFile(FILE * file)
+{
+	size_t					i;
+	size_t					j;
+	int						t;
+	const char *			str;
+	const char *			indent;
+	const Field *			field;
+	const Enum *			enumInfo;
+
+	for (i = 0; i < m_enums.size(); i++) {
+		enumInfo = &m_enums[i];
+		fprintf(file, "static const CONFIG4CPP_NAMESPACE::EnumNameAndValue "
+				"%s_%s_info[] = {\n", m_structName, enumInfo->cppName.c_str());
+		for (j = 0; j < enumInfo->values.size(); j++) {
+			fprintf(file, "\t{\"");
+			for (str = enumInfo->values[j].c_str(); *str != '\0'; str++) {
+				output(file, (unsigned char)*str);
+			}
+			fprintf(file, "\", %lu},\n", (unsigned long)j);
+		}
+		fprintf(file, "};\n");
+		fprintf(file, "\n");
+	}
+	fprintf(file, "void\n");
+	fprintf(file, "%s::load(\n", m_structName);
+	fprintf(file, "\tconst CONFIG4CPP_NAMESPACE::Configuration *\tcfg,\n");
+	fprintf(file, "\tconst char *\t\t\t\t\tscope)\n");
+	fprintf(file, "{\n");
+	for (i = 0; i < m_fields.size(); i++) {
+		field = &m_fields[i];
+		indent = "\t";
+		if (field->isOptional) {
+			fprintf(file, "\tif (cfg->type(scope, \"%s\")\n",
+					field->cfgName.c_str());
+			fprintf(file, "\t    != CONFIG4CPP_NAMESPACE::Configuration::"
+					"CFG_NO_VALUE)\n");
+			fprintf(file, "\t{\n");
+			indent = "\t\t";
+		}
+		if (field->enumIndex != -1) {
+			enumInfo = &m_enums[field->enumIndex];
+			fprintf(file, "%s%s = (%s)cfg->lookupEnum(scope, \"%s\", \"%s\",\n",
+					indent, field->member.c_str(), enumInfo->cppName.c_str(),
+					field->cfgName.c_str(), enumInfo->typeName.c_str());
+			fprintf(file, "%s\t\t%s_%s_info, %lu);\n", indent, m_structName,
+					enumInfo->cppName.c_str(),
+					(unsigned long)enumInfo->values.size());
+		} else {
+			t = findFieldType(field->type);
+			switch (fieldTypes[t].form) {
+			case FIELD_ASSIGN:
+				fprintf(file, "%s%s = cfg->%s(scope, \"%s\");\n", indent,
+						field->member.c_str(), fieldTypes[t].lookupOp,
+						field->cfgName.c_str());
+				break;
+			case FIELD_CONVERT:
+				fprintf(file, "%s%s = %s(cfg->%s(scope, \"%s\"));\n", indent,
+						field->member.c_str(), fieldTypes[t].cppType,
+						fieldTypes[t].lookupOp, field->cfgName.c_str());
+				break;
+			case FIELD_OUT_PARAM:
+				fprintf(file, "%scfg->%s(scope, \"%s\", %s);\n", indent,
+						fieldTypes[t].lookupOp, field->cfgName.c_str(),
+						field->member.c_str());
+				break;
+			}
+		}
+		if (field->isOptional) {
+			fprintf(file, "\t}\n");
+		}
+	}
+	fprintf(file, "}\n");
+	fprintf(file, "\n");
+	fprintf(file, "\n");
+}
+
+
+
 //----------------------------------------------------------------------
 // Function:	output()
 //
@@ -679,4 +1305,126 @@ stringConcat(const char * s1, const char * s2, const char * s3)
 	return result;
 }
 
+
+//----------------------------------------------------------------------
+// Function:	trim()
+//
+// Description:	str without leading and trailing white space.
+//----------------------------------------------------------------------
+
+static std::string
+trim(const std::string & str)
+{
+	size_t			start;
+	size_t			end;
+
+	start = str.find_first_not_of(" \t\r\n");
+	if (start == std::string::npos) {
+		return "";
+	}
+	end = str.find_last_not_of(" \t\r\n");
+	return str.substr(start, end - start + 1);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	toIdentifier()
+//
+// Description:	A C++ identifier for str, such as "log_level" for
+//		"log.level". A keyword or "load" gets a trailing '_'.
+//----------------------------------------------------------------------
+
+static std::string
+toIdentifier(const std::string & str)
+{
+	static const char * const keywords[] = {
+		"alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand",
+		"bitor", "bool", "break", "case", "catch", "char", "char8_t",
+		"char16_t", "char32_t", "class", "compl", "concept", "const",
+		"consteval", "constexpr", "constinit", "const_cast", "continue",
+		"co_await", "co_return", "co_yield", "decltype", "default",
+		"delete", "do", "double", "dynamic_cast", "else", "enum",
+		"explicit", "export", "extern", "false", "float", "for", "friend",
+		"goto", "if", "inline", "int", "long", "mutable", "namespace",
+		"new", "noexcept", "not", "not_eq", "nullptr", "operator", "or",
+		"or_eq", "private", "protected", "public", "register",
+		"reinterpret_cast", "requires", "return", "short", "signed",
+		"sizeof", "static", "static_assert", "static_cast", "struct",
+		"switch", "template", "this", "thread_local", "throw", "true",
+		"try", "typedef", "typeid", "typename", "union", "unsigned",
+		"using", "virtual", "void", "volatile", "wchar_t", "while", "xor",
+		"xor_eq", "load", 0
+	};
+	std::string		result;
+	size_t			i;
+	char			ch;
+
+	for (i = 0; i < str.size(); i++) {
+		ch = str[i];
+		if ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z')
+			|| (ch >= '0' && ch <= '9') || ch == '_')
+		{
+			result += ch;
+		} else {
+			result += '_';
+		}
+	}
+	if (result == "" || (result[0] >= '0' && result[0] <= '9')) {
+		result = "_" + result;
+	}
+	for (i = 0; keywords[i] != 0; i++) {
+		if (result == keywords[i]) {
+			result += '_';
+			break;
+		}
+	}
+	return result;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	splitType()
+//
+// Description:	Split a schema type, such as "enum[red, green]", into
+//		its name and its arguments, without any quotes.
+//----------------------------------------------------------------------
+
+static void
+splitType(
+	const std::string &			type,
+	std::string &				baseType,
+	std::vector<std::string> &	args)
+{
+	std::string					arg;
+	size_t						start;
+	size_t						end;
+	size_t						comma;
+
+	args.clear();
+	start = type.find('[');
+	baseType = trim(type.substr(0, start));
+	if (start == std::string::npos) {
+		return;
+	}
+	end = type.rfind(']');
+	if (end == std::string::npos || end < start) {
+		end = type.size();
+	}
+	start++;
+	while (start < end) {
+		comma = type.find(',', start);
+		if (comma == std::string::npos || comma > end) {
+			comma = end;
+		}
+		arg = trim(type.substr(start, comma - start));
+		if (arg.size() >= 2 && arg[0] == '"' && arg[arg.size() - 1] == '"') {
+			arg = arg.substr(1, arg.size() - 2);
+		}
+		args.push_back(arg);
+		start = comma + 1;
+	}
+}
+
 }; // namespace CONFIG4CPP_NAMESPACE
@@ -29,7 +29,10 @@
 // #include's
 //--------
 #include <config4cpp/namespace.h>
+#include <stddef.h>
 #include <stdio.h>
+#include <string>
+#include <vector>
 
 namespace CONFIG4CPP_NAMESPACE {
 
@@ -43,18 +46,41 @@ public:
 	~Config2Cpp();
 
 	bool parseCmdLineArgs(int argc, char ** argv);
-	bool generateFiles(const char * const *	schema, int schemaSize);
+	bool generateFiles(
+				const char * const *	schema,
+				int						schemaSize,
+				const char *			image = 0,
+				size_t					imageSize = 0);
 
 	const char * cfgFileName()			{ return m_cfgFileName; }
 	const char * schemaOverrideCfg()	{ return m_schemaOverrideCfg; }
 	const char * schemaOverrideScope()	{ return m_schemaOverrideScope; }
 	const char * className()			{ return m_className; }
+	const char * structName()			{ return m_structName; }
 	const char * cppExt()				{ return m_cppExt; }
 	const char * hExt()					{ return m_hExt; }
 	const char * outDir()				{ return m_outDir; }
 	bool         wantSchema()			{ return m_wantSchema; }
+	bool         wantCompiled()			{ return m_wantCompiled; }
 
 private:
+	//--------
+	// A variable in the schema, and its member in the -struct
+	// struct
+	//--------
+	struct Field {
+		std::string					cfgName;	// as in the configuration
+		std::string					member;
+		std::string					type;		// with typedefs resolved
+		int							enumIndex;	// in m_enums, or -1
+		bool						isOptional;	// not @required
+	};
+	struct Enum {
+		std::string					typeName;	// as in the schema
+		std::string					cppName;
+		std::vector<std::string>	values;
+	};
+
 	//--------
 	// Helper functions
 	//--------
@@ -66,6 +92,20 @@ private:
 				FILE *					file,
 				const char * const *	namesArray,
 				int						namesArraySize);
+	void printCompiledToHeaderFile(
+				FILE *					file,
+				int						schemaSize,
+				size_t					imageSize);
+	void printCompiledToCppFile(
+				FILE *					file,
+				const char * const *	schema,
+				int						schemaSize,
+				const char *			image,
+				size_t					imageSize);
+	bool parseSchemaFields(const char * const * schema, int schemaSize);
+	bool checkEnumValues(const Enum & enumInfo);
+	void printStructToHeaderFile(FILE * file);
+	void printStructToCppFile(FILE * file);
 	void output(FILE * file, int ch);
 	void usage(const char * unknownArg);
 
@@ -77,13 +117,17 @@ private:
 	char *		m_schemaOverrideCfg;
 	char *		m_schemaOverrideScope;
 	char *		m_className;
+	char *		m_structName;
 	char *		m_cppExt;
 	char *		m_hExt;
         char *          m_outDir;
 	bool		m_wantSingleton;
 	bool		m_wantSchema;
+	bool		m_wantCompiled;
 	int			m_namespaceArraySize;
 	char **		m_namespaceArray;
+	std::vector<Field>	m_fields;
+	std::vector<Enum>	m_enums;
 };
 
 
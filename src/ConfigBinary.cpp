@@ -0,0 +1,686 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+//--------
+// #include's
+//--------
+#include "ConfigBinary.h"
+#include "ConfigItem.h"
+#include "SourceFileTable.h"
+#include "platform.h"
+#include <config4cpp/StringBuffer.h>
+#include <config4cpp/StringVector.h>
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// As in ConfigScope.h, the standard library is used only in the
+// implementation, not in the interface.
+#include <filesystem>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//--------
+// Offsets of the header's fields (see ConfigBinary.h).
+//--------
+enum {
+	HDR_MAGIC      = 0,
+	HDR_VERSION    = 8,
+	HDR_BYTE_ORDER = 12,
+	HDR_FILE_SIZE  = 16,
+	HDR_ROOT_SCOPE = 20,
+	HDR_UID_COUNT  = 24,
+	HDR_RESERVED   = 28,
+	HDR_SIZE       = 32
+};
+
+//--------
+// Size of a scope entry: name, type, value, file and line.
+//--------
+enum { ENTRY_SIZE = 20 };
+
+//--------
+// Scopes nested more deeply than this are taken as corruption,
+// rather than recursing until the stack overflows.
+//--------
+enum { MAX_SCOPE_DEPTH = 1000 };
+
+static const char		binaryMagic[8] = {'C','F','G','4','C','P','P','C'};
+static const uint32_t	binaryByteOrder = 0x01020304;
+
+
+
+//----------------------------------------------------------------------
+// Function:	storeWord() and loadWord()
+//
+// Description:	Words are little-endian whatever the byte order of
+//		the machine, so an image can be built on one machine
+//		and loaded on another.
+//----------------------------------------------------------------------
+
+static inline void
+storeWord(char * bytes, uint32_t word)
+{
+	bytes[0] = (char)(word & 0xFF);
+	bytes[1] = (char)((word >> 8) & 0xFF);
+	bytes[2] = (char)((word >> 16) & 0xFF);
+	bytes[3] = (char)((word >> 24) & 0xFF);
+}
+
+
+static inline uint32_t
+loadWord(const char * bytes)
+{
+	const unsigned char *	p = (const unsigned char *)bytes;
+
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8)
+		| ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+
+//----------------------------------------------------------------------
+// Class:	BinaryWriter
+//
+// Description:	Builds the image of a precompiled configuration in
+//		memory.
+//----------------------------------------------------------------------
+
+class BinaryWriter
+{
+public:
+	BinaryWriter(const char * fileName, const char * sourceFileName);
+
+	uint32_t addString(const char * str);
+	uint32_t addList(const char ** array, int size);
+	uint32_t addScope(const ConfigScope * scope);
+	void finish(uint32_t rootScope, long uidCount);
+
+	inline const char * data() const { return &m_buf[0]; }
+	inline size_t size() const { return m_buf.size(); }
+
+private:
+	uint32_t offset() const;
+	void appendWord(uint32_t word);
+	uint32_t addSourceFile(unsigned int fileIndex);
+
+	const char *					m_fileName;
+	std::filesystem::path			m_baseDir;
+	std::vector<char>				m_buf;
+	std::map<std::string, uint32_t>	m_strings;
+	std::unordered_map<unsigned int, uint32_t>	m_sourceFiles;
+};
+
+
+//--------
+// Source file names are written relative to the directory of the file
+// that the configuration was parsed from (or, if it was not parsed from
+// a file, the current directory), so that an image does not depend on
+// where it was built.
+//--------
+BinaryWriter::BinaryWriter(const char * fileName, const char * sourceFileName)
+	: m_fileName(fileName), m_buf(HDR_SIZE)
+{
+	std::error_code			ec;
+
+	if (std::filesystem::is_regular_file(sourceFileName, ec)) {
+		m_baseDir = std::filesystem::absolute(sourceFileName, ec)
+						.lexically_normal().parent_path();
+	} else {
+		m_baseDir = std::filesystem::current_path(ec);
+	}
+}
+
+
+uint32_t
+BinaryWriter::offset() const
+{
+	StringBuffer			msg;
+
+	if (m_buf.size() > 0xFFFFFFF0) {
+		msg << m_fileName << ": the configuration is too large to be "
+			<< "precompiled";
+		throw ConfigurationException(msg.c_str());
+	}
+	return (uint32_t)m_buf.size();
+}
+
+
+void
+BinaryWriter::appendWord(uint32_t word)
+{
+	char					bytes[4];
+
+	storeWord(bytes, word);
+	m_buf.insert(m_buf.end(), bytes, bytes + sizeof(bytes));
+}
+
+
+uint32_t
+BinaryWriter::addString(const char * str)
+{
+	std::map<std::string, uint32_t>::iterator	iter;
+	uint32_t				result;
+	size_t					len;
+
+	iter = m_strings.find(str);
+	if (iter != m_strings.end()) {
+		return iter->second;
+	}
+	result = offset();
+	len = strlen(str);
+	appendWord((uint32_t)len);
+	m_buf.insert(m_buf.end(), str, str + len + 1);
+	m_buf.resize((m_buf.size() + 3) & ~(size_t)3);
+	m_strings[str] = result;
+	return result;
+}
+
+
+//--------
+// A name that is not that of a file, such as "<string-based
+// configuration>", is written as it is.
+//--------
+uint32_t
+BinaryWriter::addSourceFile(unsigned int fileIndex)
+{
+	std::unordered_map<unsigned int, uint32_t>::iterator	iter;
+	std::filesystem::path	relative;
+	std::error_code			ec;
+	const char *			name;
+	uint32_t				result;
+
+	iter = m_sourceFiles.find(fileIndex);
+	if (iter != m_sourceFiles.end()) {
+		return iter->second;
+	}
+	name = SourceFileTable::fileName(fileIndex);
+	if (!m_baseDir.empty() && std::filesystem::is_regular_file(name, ec)) {
+		relative = std::filesystem::absolute(name, ec).lexically_normal()
+						.lexically_relative(m_baseDir);
+	}
+	if (relative.empty()) {
+		result = addString(name);
+	} else {
+		result = addString(relative.string().c_str());
+	}
+	m_sourceFiles[fileIndex] = result;
+	return result;
+}
+
+
+uint32_t
+BinaryWriter::addList(const char ** array, int size)
+{
+	std::vector<uint32_t>	strings;
+	uint32_t				result;
+	int						i;
+
+	for (i = 0; i < size; i++) {
+		strings.push_back(addString(array[i]));
+	}
+	result = offset();
+	appendWord((uint32_t)strings.size());
+	for (i = 0; i < (int)strings.size(); i++) {
+		appendWord(strings[i]);
+	}
+	return result;
+}
+
+
+uint32_t
+BinaryWriter::addScope(const ConfigScope * scope)
+{
+	std::vector<uint32_t>	entries;
+	ConfigItem *			item;
+	const char **			array;
+	int						size;
+	uint32_t				value;
+	uint32_t				result;
+	int						i;
+
+	//--------
+	// Write the contents first, so the scope record
+	// can refer to them.
+	//--------
+	for (i = 0; i < scope->numEntries(); i++) {
+		item = scope->itemAt(i);
+		switch (item->type()) {
+		case Configuration::CFG_STRING:
+			value = addString(item->stringVal());
+			break;
+		case Configuration::CFG_LIST:
+			item->listVal(array, size);
+			value = addList(array, size);
+			break;
+		case Configuration::CFG_SCOPE:
+			value = addScope(item->scopeVal());
+			break;
+		default:
+			assert(0); // Bug!
+			value = 0;
+			break;
+		}
+		entries.push_back(addString(item->name()));
+		entries.push_back((uint32_t)item->type());
+		entries.push_back(value);
+		if (item->lineNum() == 0) {
+			entries.push_back(0);
+		} else {
+			entries.push_back(addSourceFile(item->fileIndex()));
+		}
+		entries.push_back(item->lineNum());
+	}
+	result = offset();
+	appendWord((uint32_t)scope->numEntries());
+	for (i = 0; i < (int)entries.size(); i++) {
+		appendWord(entries[i]);
+	}
+	return result;
+}
+
+
+void
+BinaryWriter::finish(uint32_t rootScope, long uidCount)
+{
+	memcpy(&m_buf[HDR_MAGIC], binaryMagic, sizeof(binaryMagic));
+	storeWord(&m_buf[HDR_VERSION], ConfigBinary::VERSION);
+	storeWord(&m_buf[HDR_BYTE_ORDER], binaryByteOrder);
+	storeWord(&m_buf[HDR_FILE_SIZE], offset());
+	storeWord(&m_buf[HDR_ROOT_SCOPE], rootScope);
+	storeWord(&m_buf[HDR_UID_COUNT], (uint32_t)uidCount);
+	storeWord(&m_buf[HDR_RESERVED], 0);
+}
+
+
+
+//----------------------------------------------------------------------
+// Class:	BinaryImage
+//
+// Description:	Bounds-checked access to the image of a precompiled
+//		configuration. Any reference outside the image means
+//		the file is truncated or corrupt.
+//----------------------------------------------------------------------
+
+class BinaryImage
+{
+public:
+	BinaryImage(
+			const char *	fileName,
+			const char *	data,
+			size_t			size)
+		: m_fileName(fileName), m_data(data), m_size(size)
+	{
+	}
+
+	void checkRange(uint64_t offset, uint64_t len) const;
+	uint32_t word(uint64_t offset) const;
+	const char * string(uint32_t offset) const;
+	unsigned int fileIndex(uint32_t offset);
+	void readScope(uint32_t offset, ConfigScope * scope, int depth);
+	void corrupt() const;
+	void conflict(
+			const ConfigScope *		scope,
+			const char *			name,
+			const char *			kind,
+			const char *			previousKind) const;
+
+private:
+	const char *			m_fileName;
+	const char *			m_data;
+	size_t					m_size;
+
+	//--------
+	// SourceFileTable index of each file name read so far,
+	// keyed by its offset.
+	//--------
+	std::unordered_map<uint32_t, unsigned int>	m_fileIndices;
+
+	//--------
+	// Offsets of the scopes read so far. The writer never shares
+	// a scope, so a second reference to one means corruption.
+	//--------
+	std::unordered_set<uint32_t>	m_scopeOffsets;
+};
+
+
+void
+BinaryImage::corrupt() const
+{
+	StringBuffer			msg;
+
+	msg << m_fileName << ": truncated or corrupt precompiled configuration";
+	throw ConfigurationException(msg.c_str());
+}
+
+
+void
+BinaryImage::conflict(
+	const ConfigScope *		scope,
+	const char *			name,
+	const char *			kind,
+	const char *			previousKind) const
+{
+	StringBuffer			msg;
+
+	msg << m_fileName << ": " << kind << " '";
+	if (scope->scopedName()[0] != '\0') {
+		msg << scope->scopedName() << ".";
+	}
+	msg << name << "' was previously used as " << previousKind;
+	throw ConfigurationException(msg.c_str());
+}
+
+
+void
+BinaryImage::checkRange(uint64_t offset, uint64_t len) const
+{
+	if (offset > m_size || len > m_size - offset) {
+		corrupt();
+	}
+}
+
+
+uint32_t
+BinaryImage::word(uint64_t offset) const
+{
+	checkRange(offset, 4);
+	return loadWord(m_data + offset);
+}
+
+
+const char *
+BinaryImage::string(uint32_t offset) const
+{
+	uint32_t				len;
+
+	len = word(offset);
+	checkRange((uint64_t)offset + 4, (uint64_t)len + 1);
+	if (m_data[offset + 4 + len] != '\0') {
+		corrupt();
+	}
+	return m_data + offset + 4;
+}
+
+
+unsigned int
+BinaryImage::fileIndex(uint32_t offset)
+{
+	std::unordered_map<uint32_t, unsigned int>::iterator	iter;
+	unsigned int			result;
+
+	iter = m_fileIndices.find(offset);
+	if (iter != m_fileIndices.end()) {
+		return iter->second;
+	}
+	result = SourceFileTable::intern(string(offset));
+	m_fileIndices[offset] = result;
+	return result;
+}
+
+
+void
+BinaryImage::readScope(uint32_t offset, ConfigScope * scope, int depth)
+{
+	std::vector<const char *>	array;
+	uint32_t				count;
+	uint32_t				entry;
+	uint32_t				value;
+	uint32_t				len;
+	uint32_t				i;
+	uint32_t				j;
+	const char *			name;
+	ConfigScope *			childScope;
+	ConfigItem *			item;
+	ConfigItem *			replaced;
+	unsigned int			file;
+	unsigned int			line;
+
+	if (depth > MAX_SCOPE_DEPTH || !m_scopeOffsets.insert(offset).second) {
+		corrupt();
+	}
+	count = word(offset);
+	checkRange((uint64_t)offset + 4, (uint64_t)count * ENTRY_SIZE);
+	scope->reserve(scope->numEntries() + (int)count);
+	for (i = 0; i < count; i++) {
+		entry = offset + 4 + i * ENTRY_SIZE;
+		name  = string(word(entry));
+		value = word(entry + 8);
+		file  = 0;
+		line  = 0;
+		if (word(entry + 16) != 0) {
+			file = fileIndex(word(entry + 12));
+			line = word(entry + 16);
+		}
+		switch (word(entry + 4)) {
+		case Configuration::CFG_STRING:
+			item = scope->addOrReplaceString(name, string(value), &replaced);
+			if (item == 0) {
+				conflict(scope, name, "variable", "a scope");
+			}
+			item->setLocation(file, line);
+			if (replaced != 0) {
+				scope->releaseItem(replaced);
+			}
+			break;
+		case Configuration::CFG_LIST:
+			len = word(value);
+			checkRange((uint64_t)value + 4, (uint64_t)len * 4);
+			array.resize(len);
+			for (j = 0; j < len; j++) {
+				array[j] = string(word(value + 4 + j * 4));
+			}
+			item = scope->addOrReplaceList(name, len == 0 ? 0 : &array[0],
+			                               (int)len, &replaced);
+			if (item == 0) {
+				conflict(scope, name, "variable", "a scope");
+			}
+			item->setLocation(file, line);
+			if (replaced != 0) {
+				scope->releaseItem(replaced);
+			}
+			break;
+		case Configuration::CFG_SCOPE:
+			//--------
+			// A nested scope is always written before its parent.
+			// That, the check that no scope is read twice, and the
+			// depth limit keep a corrupt file from making us
+			// recurse forever or read a scope more than once.
+			//--------
+			if (value >= offset) {
+				corrupt();
+			}
+			if (!scope->ensureScopeExists(name, childScope)) {
+				conflict(scope, name, "scope", "a variable name");
+			}
+			readScope(value, childScope, depth + 1);
+			break;
+		default:
+			corrupt();
+			break;
+		}
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	write()
+//
+// Description:	Write the contents of rootScope, which was parsed
+//		from sourceFileName, to fileName.
+//
+// Notes:	The image is written to a temporary file that is then
+//		renamed, so a process that has the old file mapped, or
+//		that loads it concurrently, never sees a partial file.
+//----------------------------------------------------------------------
+
+void
+ConfigBinary::write(
+	const ConfigScope *				rootScope,
+	const UidIdentifierProcessor &	uidProcessor,
+	const char *					sourceFileName,
+	const char *					fileName)
+{
+	BinaryWriter			writer(fileName, sourceFileName);
+	StringBuffer			tmpFileName;
+	StringBuffer			msg;
+	FILE *					file;
+	bool					ok;
+
+	writer.finish(writer.addScope(rootScope), uidProcessor.count());
+
+	tmpFileName << fileName << ".tmp";
+	file = fopen(tmpFileName.c_str(), "wb");
+	if (file == 0) {
+		msg << "cannot create " << tmpFileName << ": " << strerror(errno);
+		throw ConfigurationException(msg.c_str());
+	}
+	ok = fwrite(writer.data(), 1, writer.size(), file) == writer.size();
+	ok = (fclose(file) == 0) && ok;
+#ifdef WIN32
+	if (ok) {
+		remove(fileName);
+	}
+#endif
+	if (!ok || rename(tmpFileName.c_str(), fileName) != 0) {
+		msg << "cannot write " << fileName << ": " << strerror(errno);
+		remove(tmpFileName.c_str());
+		throw ConfigurationException(msg.c_str());
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	write()
+//
+// Description:	Set image to the contents of rootScope, in the same
+//		format as a precompiled file. sourceFileName is as for
+//		the other write(), and description names the
+//		configuration in error messages.
+//----------------------------------------------------------------------
+
+void
+ConfigBinary::write(
+	const ConfigScope *				rootScope,
+	const UidIdentifierProcessor &	uidProcessor,
+	const char *					sourceFileName,
+	const char *					description,
+	std::string &					image)
+{
+	BinaryWriter			writer(description, sourceFileName);
+
+	writer.finish(writer.addScope(rootScope), uidProcessor.count());
+	image.assign(writer.data(), writer.size());
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	read()
+//
+// Description:	Add the contents of the precompiled configuration in
+//		fileName to rootScope.
+//----------------------------------------------------------------------
+
+void
+ConfigBinary::read(
+	const char *				fileName,
+	ConfigScope *				rootScope,
+	UidIdentifierProcessor &	uidProcessor)
+{
+	MappedFile				file;
+	StringBuffer			msg;
+
+	if (!file.open(fileName)) {
+		msg << "cannot open " << fileName << ": " << strerror(errno);
+		throw ConfigurationException(msg.c_str());
+	}
+	read(fileName, file.data(), file.size(), rootScope, uidProcessor);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	read()
+//
+// Description:	Add the contents of the precompiled configuration image
+//		in data to rootScope. description names the
+//		configuration in error messages.
+//----------------------------------------------------------------------
+
+void
+ConfigBinary::read(
+	const char *				description,
+	const char *				data,
+	size_t						size,
+	ConfigScope *				rootScope,
+	UidIdentifierProcessor &	uidProcessor)
+{
+	uint32_t				version;
+	StringBuffer			msg;
+
+	if (size < HDR_SIZE
+	    || memcmp(data, binaryMagic, sizeof(binaryMagic)) != 0)
+	{
+		msg << description << ": not a precompiled configuration";
+		throw ConfigurationException(msg.c_str());
+	}
+	//--------
+	// Words are always little-endian, so any other byte-order mark
+	// means the image was not written by ConfigBinary::write().
+	//--------
+	if (loadWord(data + HDR_BYTE_ORDER) != binaryByteOrder) {
+		msg << description << ": precompiled configuration has a bad "
+			<< "byte-order mark";
+		throw ConfigurationException(msg.c_str());
+	}
+	version = loadWord(data + HDR_VERSION);
+	if (version != VERSION) {
+		msg << description << ": unsupported precompiled configuration "
+			<< "version " << (int)version << " (expected "
+			<< (int)VERSION << ")";
+		throw ConfigurationException(msg.c_str());
+	}
+
+	BinaryImage image(description, data, size);
+	if (image.word(HDR_FILE_SIZE) != size) {
+		image.corrupt();
+	}
+	image.readScope(image.word(HDR_ROOT_SCOPE), rootScope, 0);
+	uidProcessor.ensureCountIsAtLeast((long)image.word(HDR_UID_COUNT));
+}
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
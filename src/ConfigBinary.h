@@ -0,0 +1,122 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+#ifndef CONFIG4CPP_CONFIG_BINARY_H_
+#define CONFIG4CPP_CONFIG_BINARY_H_
+
+
+//--------
+// #include's
+//--------
+#include "ConfigScope.h"
+#include "UidIdentifierProcessor.h"
+#include <string>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//----------------------------------------------------------------------
+// Class:	ConfigBinary
+//
+// Description:	Reads and writes precompiled (".cfgc") configuration
+//		files. A precompiled file holds the contents of a fully
+//		parsed configuration, so loading one needs no lexing or
+//		parsing, and does not re-evaluate @include, @if or
+//		exec().
+//
+// Notes:	The format is versioned and position independent.
+//		Every field is a 32-bit little-endian word, whatever
+//		the machine, and every reference is a byte offset from
+//		the start of the file. Records are 4-byte aligned.
+//
+//		Header (32 bytes):
+//			char[8]	"CFG4CPPC"
+//			word	version (VERSION)
+//			word	0x01020304, to detect the byte order
+//			word	size of the file
+//			word	offset of the root scope
+//			word	count of expanded "uid-" identifiers
+//			word	reserved (0)
+//
+//		String:	word length, then the bytes and a '\0'
+//		List:	word count, then count string offsets
+//		Scope:	word count, then count entries, each of
+//			which is five words: name (a string offset),
+//			type (a Configuration::Type), value (the
+//			offset of a string, list or scope), and the
+//			file (a string offset, or 0 if not known) and
+//			line at which the entry was defined. A file
+//			name is relative to the directory of the file
+//			that the configuration was parsed from.
+//
+//		Scopes are written after their contents, so a nested
+//		scope is always at a lower offset than its parent.
+//		Each scope is referred to once, and scopes nest at most
+//		1000 deep. Identical strings are written once.
+//
+//		The image can also be written to, and read from, memory;
+//		config2cpp -compiled embeds it in generated code.
+//----------------------------------------------------------------------
+
+class ConfigBinary
+{
+public:
+	enum { VERSION = 1 };
+
+	static void write(
+				const ConfigScope *				rootScope,
+				const UidIdentifierProcessor &	uidProcessor,
+				const char *					sourceFileName,
+				const char *					fileName);
+
+	static void write(
+				const ConfigScope *				rootScope,
+				const UidIdentifierProcessor &	uidProcessor,
+				const char *					sourceFileName,
+				const char *					description,
+				std::string &					image);
+
+	static void read(
+				const char *					fileName,
+				ConfigScope *					rootScope,
+				UidIdentifierProcessor &		uidProcessor);
+
+	static void read(
+				const char *					description,
+				const char *					data,
+				size_t							size,
+				ConfigScope *					rootScope,
+				UidIdentifierProcessor &		uidProcessor);
+
+private:
+	//--------
+	// Not instantiable
+	//--------
+	ConfigBinary();
+};
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
+#endif
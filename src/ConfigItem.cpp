@@ -28,6 +28,7 @@
 #include <config4cpp/Configuration.h>
 #include "ConfigItem.h"
 #include "ConfigScope.h"
+#include "SourceFileTable.h"
 #include "UidIdentifierProcessor.h"
 #include <string.h>
 #include <assert.h>
@@ -35,18 +36,6 @@
 
 namespace CONFIG4CPP_NAMESPACE {
 
-static char *
-copyString(const char * str)
-{
-	char *		result;
-
-	result = new char[strlen(str) + 1];
-	strcpy(result, str);
-	return result;
-}
-
-
-
 static char *
 escapeString(const char * str)
 {
@@ -109,40 +98,42 @@ printIndent(StringBuffer & buf, int indentLevel)
 // Description:
 //----------------------------------------------------------------------
 
-ConfigItem::ConfigItem(const char * name, const char * str)
+ConfigItem::ConfigItem(
+	StringPool &	strings,
+	const char *	name,
+	const char *	str)
 {
 	m_type      = Configuration::CFG_STRING;
-	m_name      = copyString(name);
-	m_stringVal = copyString(str);
-	m_listVal   = 0;
-	m_scope     = 0;
-}
-
-
-
-ConfigItem::ConfigItem(const char * name, const StringVector & list)
-{
-	m_type      = Configuration::CFG_LIST;
-	m_name      = copyString(name);
-	m_listVal   = new StringVector(list);
-	m_scope     = 0;
-	m_stringVal = 0;
+	m_name      = name;
+	m_stringVal = strings.intern(str);
+	m_cachedValue = VALUE_NONE;
+	m_fileIndex = 0;
+	m_lineNum   = 0;
+	m_listLength = 0;
 }
 
 
 
-ConfigItem::ConfigItem(const char * name, const char ** array, int size)
+ConfigItem::ConfigItem(
+	StringPool &	strings,
+	const char *	name,
+	const char **	array,
+	int				size)
 {
 	int				i;
 
 	m_type      = Configuration::CFG_LIST;
-	m_name      = copyString(name);
-	m_scope     = 0;
-	m_stringVal = 0;
-	m_listVal   = new StringVector(size);
+	m_name      = name;
+	m_cachedValue = VALUE_NONE;
+	m_fileIndex = 0;
+	m_lineNum   = 0;
+	m_listLength = size;
+	m_listVal   = (const char **)strings.arena().allocate(
+										sizeof(char *) * (size + 1));
 	for (i = 0; i < size; i++) {
-		m_listVal->add(array[i]);
+		m_listVal[i] = strings.intern(array[i]);
 	}
+	m_listVal[size] = 0;
 }
 
 
@@ -150,26 +141,48 @@ ConfigItem::ConfigItem(const char * name, const char ** array, int size)
 ConfigItem::ConfigItem(const char * name, ConfigScope * scope)
 {
 	m_type      = Configuration::CFG_SCOPE;
-	m_name      = copyString(name);
+	m_name      = name;
 	m_scope     = scope;
-	m_listVal   = 0;
-	m_stringVal = 0;
+	m_cachedValue = VALUE_NONE;
+	m_fileIndex = 0;
+	m_lineNum   = 0;
+	m_listLength = 0;
 }
 
 
 
 //----------------------------------------------------------------------
-// Function:	Destructor
+// Function:	releaseValue()
 //
-// Description:
+// Description:	Give back the large blocks of a string or list value
+//		that is no longer used.
+//
+// Notes:	Arena::deallocate() ignores a block too small to have
+//		a chunk of its own, so this costs a strlen() per string.
 //----------------------------------------------------------------------
 
-ConfigItem::~ConfigItem()
+void
+ConfigItem::releaseValue(Arena & arena)
 {
-	delete m_listVal;
-	delete m_scope;
-	delete [] m_stringVal;
-	delete [] m_name;
+	int							i;
+
+	switch (m_type) {
+	case Configuration::CFG_STRING:
+		arena.deallocate((void *)m_stringVal, strlen(m_stringVal) + 1);
+		m_stringVal = "";
+		break;
+	case Configuration::CFG_LIST:
+		for (i = 0; i < m_listLength; i++) {
+			arena.deallocate((void *)m_listVal[i], strlen(m_listVal[i]) + 1);
+		}
+		arena.deallocate(m_listVal, sizeof(char *) * (m_listLength + 1));
+		m_listVal = 0;
+		m_listLength = 0;
+		break;
+	default:
+		assert(0); // Bug!
+		break;
+	}
 }
 
 
@@ -185,6 +198,7 @@ ConfigItem::dump(
 	StringBuffer &				buf,
 	const char *				name,
 	bool						wantExpandedUidNames,
+	bool						wantLocations,
 	int							indentLevel) const
 {
 	int							i;
@@ -200,25 +214,30 @@ ConfigItem::dump(
 	switch (m_type) {
 	case Configuration::CFG_STRING:
 		escStr = escapeString(m_stringVal);
-		buf << name << " = \"" << escStr << "\";\n";
+		buf << name << " = \"" << escStr << "\";";
 		delete [] escStr;
+		dumpLocation(buf, wantLocations);
+		buf << "\n";
 		break;
 	case Configuration::CFG_LIST:
 		buf << name << " = [";
-		len = m_listVal->length();
+		len = m_listLength;
 		for (i = 0; i < len; i++) {
-			escStr = escapeString((*m_listVal)[i]);
+			escStr = escapeString(m_listVal[i]);
 			buf << "\"" << escStr << "\"";
 			delete [] escStr;
 			if (i < len-1) {
 				buf << ", ";
 			}
 		}
-		buf << "];\n";
+		buf << "];";
+		dumpLocation(buf, wantLocations);
+		buf << "\n";
 		break;
 	case Configuration::CFG_SCOPE:
 		buf << name << " {\n";
-		m_scope->dump(buf, wantExpandedUidNames, indentLevel + 1);
+		m_scope->dump(buf, wantExpandedUidNames, wantLocations,
+					  indentLevel + 1);
 		printIndent(buf, indentLevel);
 		buf << "}\n";
 		break;
@@ -228,4 +247,22 @@ ConfigItem::dump(
 	};
 }
 
+
+
+//----------------------------------------------------------------------
+// Function:	dumpLocation()
+//
+// Description:	Append the item's location, as a comment so the output
+//		can still be parsed, if it is wanted and known.
+//----------------------------------------------------------------------
+
+void
+ConfigItem::dumpLocation(StringBuffer & buf, bool wantLocations) const
+{
+	if (wantLocations && m_lineNum != 0) {
+		buf << " # " << SourceFileTable::fileName(m_fileIndex) << ":"
+			<< (int)m_lineNum;
+	}
+}
+
 }; // namespace CONFIG4CPP_NAMESPACE
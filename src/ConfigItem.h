@@ -30,8 +30,12 @@
 // #include's
 //--------
 #include <config4cpp/Configuration.h>
+#include "StringPool.h"
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
+#include <stdint.h>
+#include <atomic>
 
 
 namespace CONFIG4CPP_NAMESPACE {
@@ -46,6 +50,15 @@ class ConfigScope;
 //		"name <scope>" statements. This class is used to store
 //		name plus the the <value> part, (which can be a string
 //		or a sequence of string) or a <scope>.
+//
+//		A ConfigItem, its name and its value are allocated from
+//		the Arena of the configuration that holds it, and are
+//		never destroyed individually. The name and the strings
+//		of the value are interned in the configuration's
+//		StringPool, so they may be shared with other items;
+//		strings too long to intern are not shared, though, so
+//		releaseValue() can give back those, and a list's array,
+//		that are large enough to have an arena chunk of their own.
 //--------------------------------------------------------------
 
 class ConfigItem
@@ -53,22 +66,61 @@ class ConfigItem
 public:
 
 	//--------
-	// Ctor and dtor
+	// Ctors. The name must already be in the arena (the scope
+	// interns it); the strings of the value are interned here.
 	//--------
-	ConfigItem(const char * name, const char *         str);
-	ConfigItem(const char * name, const StringVector & list);
-	ConfigItem(const char * name, const char ** array, int size);
-	ConfigItem(const char * name, ConfigScope *        scope);
-	virtual ~ConfigItem();
+	ConfigItem(StringPool & strings, const char * name, const char *  str);
+	ConfigItem(StringPool & strings, const char * name,
+			   const char ** array, int size);
+	ConfigItem(const char * name, ConfigScope * scope);
+
+	inline static void * operator new(size_t size, Arena & arena);
+	inline static void operator delete(void * ptr, Arena & arena);
 
 	//--------
 	// Public operations
 	//--------
-	inline Configuration::Type type();
+	inline Configuration::Type type() const;
 	inline const char * name() const;
 	inline const char * stringVal() const;
-	inline StringVector & listVal() const;
+	inline void listVal(const char **& array, int & size) const;
 	inline ConfigScope * scopeVal() const;
+	void releaseValue(Arena & arena);
+
+	//--------
+	// Where the item was defined: an index into SourceFileTable and
+	// a line number. Both are 0 if the item was not parsed from a
+	// file, for example if it was added with insertString().
+	//--------
+	inline unsigned int fileIndex() const;
+	inline unsigned int lineNum() const;
+	inline void setLocation(unsigned int fileIndex, unsigned int lineNum);
+
+	//--------
+	// Memo of the result of converting stringVal() to a typed value,
+	// so that repeated lookup<Type>() calls do not parse it again.
+	// A ConfigItem's string never changes (insertString() replaces
+	// the whole item and remove() deletes it), so the memo never
+	// has to be invalidated explicitly. Only one conversion is
+	// remembered at a time. The memo is updated by const lookups,
+	// possibly from several threads, so it is a single atomic word.
+	//--------
+	enum ValueKind {
+		VALUE_NONE = 0,
+		VALUE_INT,
+		VALUE_FLOAT,
+		VALUE_ENUM_INDEX,
+		VALUE_DURATION_MICROSECONDS,
+		VALUE_DURATION_MILLISECONDS,
+		VALUE_DURATION_SECONDS,
+		VALUE_MEMORY_SIZE_BYTES,
+		VALUE_MEMORY_SIZE_KB,
+		VALUE_MEMORY_SIZE_MB
+	};
+	inline bool cachedValue(ValueKind kind, int & val) const;
+	inline bool cachedValue(ValueKind kind, float & val) const;
+	inline void cacheValue(ValueKind kind, int val) const;
+	inline void cacheValue(ValueKind kind, float val) const;
 
 	//--------
 	// Debugging aid
@@ -77,17 +129,30 @@ public:
 				StringBuffer &	buf,
 				 const char *	name,
 				 bool			wantExpandedUidNames,
+				 bool			wantLocations,
 				 int			indentLevel = 0) const;
 
 protected:
+	void dumpLocation(StringBuffer & buf, bool wantLocations) const;
+
 	//--------
-	// Instance variables
+	// Instance variables. m_type says which member of the union is
+	// in use. The location words sit where there would otherwise be
+	// padding, so an item is still smaller than it was when the
+	// three value pointers were separate members. A list is a
+	// null-terminated array of m_listLength strings.
 	//--------
 	Configuration::Type		m_type;
-	char *					m_name;
-	char *					m_stringVal;
-	StringVector *			m_listVal;
-	ConfigScope *			m_scope;
+	uint32_t				m_fileIndex;
+	const char *			m_name;
+	union {
+		const char *		m_stringVal;
+		const char **		m_listVal;
+		ConfigScope *		m_scope;
+	};
+	mutable std::atomic<unsigned long long>	m_cachedValue; // kind:value
+	uint32_t				m_lineNum;
+	int						m_listLength;
 
 private:
 	//--------
@@ -103,8 +168,25 @@ private:
 // Inline implementation of operations
 //--------
 
+inline void *
+ConfigItem::operator new(size_t size, Arena & arena)
+{
+	return arena.allocate(size);
+}
+
+
+inline void
+ConfigItem::operator delete(void *, Arena &)
+{
+	//--------
+	// Called only if a constructor throws. The memory stays in
+	// the arena until the arena is released.
+	//--------
+}
+
+
 inline Configuration::Type
-ConfigItem::type()
+ConfigItem::type() const
 {
 	return m_type;
 }
@@ -125,12 +207,13 @@ ConfigItem::stringVal() const
 }
 
 
-inline StringVector &
-ConfigItem::listVal() const
+inline void
+ConfigItem::listVal(const char **& array, int & size) const
 {
 	assert(m_type == Configuration::CFG_LIST);
 	assert(m_listVal != 0);
-	return *m_listVal;
+	array = m_listVal;
+	size = m_listLength;
 }
 
 
@@ -143,5 +226,73 @@ ConfigItem::scopeVal() const
 }
 
 
+inline unsigned int
+ConfigItem::fileIndex() const
+{
+	return m_fileIndex;
+}
+
+
+inline unsigned int
+ConfigItem::lineNum() const
+{
+	return m_lineNum;
+}
+
+
+inline void
+ConfigItem::setLocation(unsigned int fileIndex, unsigned int lineNum)
+{
+	m_fileIndex = fileIndex;
+	m_lineNum = lineNum;
+}
+
+
+inline bool
+ConfigItem::cachedValue(ValueKind kind, int & val) const
+{
+	unsigned long long	word;
+
+	word = m_cachedValue.load(std::memory_order_relaxed);
+	if ((ValueKind)(word >> 32) != kind) {
+		return false;
+	}
+	val = (int)(unsigned int)word;
+	return true;
+}
+
+
+inline bool
+ConfigItem::cachedValue(ValueKind kind, float & val) const
+{
+	int					bits;
+
+	if (!cachedValue(kind, bits)) {
+		return false;
+	}
+	memcpy(&val, &bits, sizeof(val));
+	return true;
+}
+
+
+inline void
+ConfigItem::cacheValue(ValueKind kind, int val) const
+{
+	assert(m_type == Configuration::CFG_STRING);
+	m_cachedValue.store(((unsigned long long)kind << 32) | (unsigned int)val,
+	                    std::memory_order_relaxed);
+}
+
+
+inline void
+ConfigItem::cacheValue(ValueKind kind, float val) const
+{
+	int					bits;
+
+	memcpy(&bits, &val, sizeof(bits));
+	cacheValue(kind, bits);
+}
+
+
 }; // namespace CONFIG4CPP_NAMESPACE
 #endif
@@ -82,6 +82,8 @@
 // #include's
 //--------
 #include "ConfigParser.h"
+#include "SourceFileTable.h"
+#include "util.h"
 #include "platform.h"
 #include "platform.h"
 #include <assert.h>
@@ -120,6 +122,8 @@ ConfigParser::ConfigParser(
 	bool						ifExistsIsSpecified)
 {
 	StringBuffer				msg;
+	long long					mtime;
+	long long					size;
 
 	//--------
 	// Initialise instance variables
@@ -130,6 +134,7 @@ ConfigParser::ConfigParser(
 	switch (sourceType) {
 	case Configuration::INPUT_FILE:
 		m_fileName = source;
+		m_config->m_journal.addDependency(source);
 		break;
 	case Configuration::INPUT_STRING:
 		if (strcmp(sourceDescription, "") == 0) {
@@ -151,6 +156,7 @@ ConfigParser::ConfigParser(
 		assert(0); // Bug!
 		break;
 	}
+	m_fileIndex = SourceFileTable::intern(m_fileName.c_str());
 
 	//--------
 	// Initialise the lexical analyser.
@@ -159,18 +165,33 @@ ConfigParser::ConfigParser(
 	// command. If such an exception is thrown and if
 	// "ifExistsIsSpecified" is true then we return without doing
 	// any work.
+	//
+	// The timestamp of a file is taken before it is read, so that
+	// a change made while it is being read is not missed later.
 	//--------
+	if (sourceType != Configuration::INPUT_FILE
+	    || !getFileStamp(source, mtime, size))
+	{
+		mtime = size = 0;
+	}
 	try {
 		m_lex = new ConfigLex(sourceType, source,
 							  &m_config->m_uidIdentifierProcessor);
 	} catch (const ConfigurationException &) {
 		m_lex = 0;
 		if (ifExistsIsSpecified) {
+			if (sourceType == Configuration::INPUT_FILE) {
+				m_config->m_journal.addMissingFile(source);
+			}
 			return;
 		} else {
 			throw;
 		}
 	}
+	if (sourceType == Configuration::INPUT_FILE) {
+		m_config->m_journal.beginFile(source, mtime, size,
+									  m_lex->fileHash());
+	}
 	m_lex->nextToken(m_token);
 
 	//--------
@@ -189,6 +210,9 @@ ConfigParser::ConfigParser(
 		delete m_lex;
 		m_lex = 0;
 		m_config->popIncludedFilename(m_fileName.c_str());
+		if (sourceType == Configuration::INPUT_FILE) {
+			m_config->m_journal.endFile();
+		}
 		if (m_errorInIncludedFile) {
 			throw;
 		} else {
@@ -205,6 +229,9 @@ ConfigParser::ConfigParser(
 	// Pop our file from the the stack of (include'd) files.
 	//--------
 	m_config->popIncludedFilename(m_fileName.c_str());
+	if (sourceType == Configuration::INPUT_FILE) {
+		m_config->m_journal.endFile();
+	}
 }
 
 
@@ -284,6 +311,12 @@ ConfigParser::parseStmt()
 		return;
 	}
 	accept(ConfigLex::LEX_IDENT_SYM, "expecting identifier or 'include'");
+	if (strstr(identName.spelling(), "uid-") != 0) {
+		//--------
+		// The expansion depends on how many uid- names came before.
+		//--------
+		m_config->m_journal.markNotStandalone();
+	}
 
 	switch(m_token.type()) {
 	case ConfigLex::LEX_EQUALS_SYM:
@@ -352,12 +385,15 @@ ConfigParser::parseIncludeStmt(
 	// some additional text to indicate that the error was in an
 	// included file.
 	//--------
+	m_config->m_journal.markNotStandalone();
 	try {
 		if (startsWith(source.c_str(), "exec#")) {
+			m_config->m_journal.markStateDependent();
 			ConfigParser tmp(Configuration::INPUT_EXEC, execSource,
 							 trustedCmdLine.c_str(), "", m_config,
 							 ifExistsIsSpecified);
 		} else if (startsWith(source.c_str(), "str#")) {
+			m_config->m_journal.markStateDependent();
 			ConfigParser tmp(Configuration::INPUT_STRING,
 							 source.c_str() + strlen("str#"),
 							 trustedCmdLine.c_str(), "", m_config,
@@ -367,29 +403,19 @@ ConfigParser::parseIncludeStmt(
 			if (startsWith(src, "file#")) {
 				src += strlen("file#");
 			}
-#if defined (CONFIG4CPP_GLOB)
-			struct Glob
-			{
-				glob_t glob{};
-				Glob(char const * src) { ::glob(src, GLOB_MARK, nullptr, &glob); }
-				~Glob() { globfree(&glob); }
-			} g(src);
-			if (g.glob.gl_matchc == 0) {
-				ConfigParser tmp(Configuration::INPUT_FILE, src,
+			StringVector fileNames;
+			expandIncludePattern(src, fileNames);
+			m_config->m_journal.addInclude(src, fileNames);
+			if (strpbrk(src, "*?[") != 0) {
+				StringBuffer dirName;
+				getDirName(src, dirName);
+				m_config->m_journal.addDirectory(dirName.c_str());
+			}
+			for (int i = 0; i < fileNames.length(); ++i) {
+				ConfigParser tmp(Configuration::INPUT_FILE, fileNames[i],
 								 trustedCmdLine.c_str(), "", m_config,
 								 ifExistsIsSpecified);
-			} else {
-				for (int i = 0; i < g.glob.gl_matchc; ++i) {
-					ConfigParser tmp(Configuration::INPUT_FILE, g.glob.gl_pathv[i],
-									 trustedCmdLine.c_str(), "", m_config,
-									 ifExistsIsSpecified);
-				}
 			}
-#else
-			ConfigParser tmp(Configuration::INPUT_FILE, src,
-							 trustedCmdLine.c_str(), "", m_config,
-							 ifExistsIsSpecified);
-#endif
 		}
 	} catch(const ConfigurationException & ex) {
 		m_errorInIncludedFile = true;
@@ -399,6 +425,36 @@ ConfigParser::parseIncludeStmt(
 	}
 }
 
+//----------------------------------------------------------------------
+// Function:	expandIncludePattern()
+//
+// Description:	The files that "@include pattern" reads.
+//----------------------------------------------------------------------
+
+void
+ConfigParser::expandIncludePattern(
+	const char *		pattern,
+	StringVector &		fileNames)
+{
+	fileNames.empty();
+#if defined (CONFIG4CPP_GLOB)
+	struct Glob
+	{
+		glob_t glob{};
+		Glob(char const * src) { ::glob(src, GLOB_MARK, nullptr, &glob); }
+		~Glob() { globfree(&glob); }
+	} g(pattern);
+	for (size_t i = 0; i < g.glob.gl_pathc; ++i) {
+		fileNames.add(g.glob.gl_pathv[i]);
+	}
+#endif
+	if (fileNames.length() == 0) {
+		fileNames.add(pattern);
+	}
+}
+
+
+
 void
 ConfigParser::parseIncludeStmt()
 {
@@ -488,6 +544,7 @@ ConfigParser::parseIfStmt()
 	// Parse the "if ( Condition ) { StmtList }" clause
 	//--------
 	accept(ConfigLex::LEX_IF_SYM, "expecting 'if'");
+	m_config->m_journal.markStateDependent();
 	accept(ConfigLex::LEX_OPEN_PAREN_SYM, "expecting '('");
 	condition = parseCondition();
 	accept(ConfigLex::LEX_CLOSE_PAREN_SYM, "expecting ')'");
@@ -739,12 +796,15 @@ ConfigParser::parseCopyStmt()
 	ConfigScope *		fromScope;
 	ConfigScope *		dummyScope;
 	const char *		newName;
+	const char **		array;
+	int					arraySize;
 	int					i;
 	int					len;
 	int					fromScopeNameLen;
 	bool				ifExistsIsSpecified;
 
 	accept(ConfigLex::LEX_COPY_FROM_SYM, "expecting '@copyFrom'");
+	m_config->m_journal.markStateDependent();
 	parseStringExpr(fromScopeName);
 	fromScopeNameLen = fromScopeName.length();
 
@@ -811,10 +871,13 @@ ConfigParser::parseCopyStmt()
 		assert(item != 0);
 		switch (item->type()) {
 		case Configuration::CFG_STRING:
-			m_config->insertString("", newName, item->stringVal());
+			m_config->insertString(newName, item->stringVal(),
+								   item->fileIndex(), item->lineNum());
 			break;
 		case Configuration::CFG_LIST:
-			m_config->insertList(newName, item->listVal());
+			item->listVal(array, arraySize);
+			m_config->insertList(newName, array, arraySize,
+								 item->fileIndex(), item->lineNum());
 			break;
 		case Configuration::CFG_SCOPE:
 			m_config->ensureScopeExists(newName, dummyScope);
@@ -843,10 +906,12 @@ void
 ConfigParser::parseRemoveStmt()
 {
 	ConfigScope *		currScope;
+	ConfigItem *		removed;
 	StringBuffer		identName;
 	StringBuffer		msg;
 
 	accept(ConfigLex::LEX_REMOVE_SYM, "expecting 'remove'");
+	m_config->m_journal.markStateDependent();
 	identName = m_token.spelling();
 	accept(ConfigLex::LEX_IDENT_SYM, "expecting an identifier");
 	if (strchr(identName.c_str(), '.') != 0) {
@@ -855,11 +920,12 @@ ConfigParser::parseRemoveStmt()
 		throw ConfigurationException(msg.c_str());
 	}
 	currScope = m_config->getCurrScope();
-	if (!currScope->removeItem(identName.c_str())) {
+	if (!currScope->removeItem(identName.c_str(), &removed)) {
 		msg << m_fileName << ": '" << identName
 			<< "' does not exist in the current scope";
 		throw ConfigurationException(msg.c_str());
 	}
+	m_config->releaseItem(currScope, removed);
 	accept(ConfigLex::LEX_SEMICOLON_SYM, "expecting ';'");
 }
 
@@ -902,6 +968,7 @@ ConfigParser::parseScope(LexToken & scopeName)
 	//--------
 	oldScope = m_config->getCurrScope();
 	m_config->ensureScopeExists(scopeName.spelling(), newScope);
+	m_config->m_journal.addScope(newScope);
 	m_config->setCurrScope(newScope);
 
 	//--------
@@ -940,8 +1007,13 @@ ConfigParser::parseRhsAssignStmt(
 	Configuration::Type		dummyType;
 	StringBuffer			msg;
 	const char * 			constStr;
+	const char **			array;
+	int						arraySize;
 	bool					doAssign;
 
+	if (assignmentType != ConfigLex::LEX_EQUALS_SYM) {
+		m_config->m_journal.markStateDependent();
+	}
 	varType = m_config->type(varName.spelling(), "", false);
 	switch(varType) {
 	case Configuration::CFG_STRING:
@@ -1036,11 +1108,13 @@ ConfigParser::parseRhsAssignStmt(
 										  constStr,
 										  dummyType);
 					appendedStringExpr << constStr << stringExpr;
-					m_config->insertString("", varName.spelling(),
-										   appendedStringExpr.c_str());
+					m_config->insertString(varName.spelling(),
+										   appendedStringExpr.c_str(),
+										   m_fileIndex, varName.lineNum());
 				} else {
-					m_config->insertString("", varName.spelling(),
-										   stringExpr.c_str());
+					m_config->insertString(varName.spelling(),
+										   stringExpr.c_str(),
+										   m_fileIndex, varName.lineNum());
 				}
 			}
 			break;
@@ -1052,10 +1126,12 @@ ConfigParser::parseRhsAssignStmt(
 										appendedListExpr,
 										dummyType);
 					appendedListExpr.add(listExpr);
-					m_config->insertList(varName.spelling(), appendedListExpr);
+					appendedListExpr.c_array(array, arraySize);
 				} else {
-					m_config->insertList(varName.spelling(), listExpr);
+					listExpr.c_array(array, arraySize);
 				}
+				m_config->insertList(varName.spelling(), array, arraySize,
+									 m_fileIndex, varName.lineNum());
 			}
 			break;
 		default:
@@ -1122,21 +1198,25 @@ ConfigParser::parseString(StringBuffer & str)
 		}
 		break;
 	case ConfigLex::LEX_FUNC_SIBLING_SCOPE_SYM:
+		m_config->m_journal.markStateDependent();
 		parseSiblingScope(str);
 		break;
 	case ConfigLex::LEX_FUNC_GETENV_SYM:
 		parseEnv(str);
 		break;
 	case ConfigLex::LEX_FUNC_EXEC_SYM:
+		m_config->m_journal.markNotStandalone();
 		parseExec(str);
 		break;
 	case ConfigLex::LEX_FUNC_JOIN_SYM:
 		parseJoin(str);
 		break;
 	case ConfigLex::LEX_FUNC_CALL_SYM:
+		m_config->m_journal.markNotStandalone();
 		parseCall(str);
 		break;
 	case ConfigLex::LEX_FUNC_READ_FILE_SYM:
+		m_config->m_journal.markNotStandalone();
 		parseReadFile(str);
 		break;
 	case ConfigLex::LEX_FUNC_REPLACE_SYM:
@@ -1169,6 +1249,7 @@ ConfigParser::parseString(StringBuffer & str)
 		str = m_fileName;
 		break;
 	case ConfigLex::LEX_FUNC_CONFIG_TYPE_SYM:
+		m_config->m_journal.markStateDependent();
 		m_lex->nextToken(m_token);
 		parseStringExpr(name);
 		accept(ConfigLex::LEX_CLOSE_PAREN_SYM, "expecting ')'");
@@ -1201,6 +1282,7 @@ ConfigParser::parseString(StringBuffer & str)
 		m_lex->nextToken(m_token);
 		break;
 	case ConfigLex::LEX_IDENT_SYM:
+		m_config->m_journal.markStateDependent();
 		m_config->stringValue(m_token.spelling(), m_token.spelling(),
 				      constStr, type);
 		switch (type) {
@@ -1319,6 +1401,8 @@ ConfigParser::parseReadFile(StringBuffer & str)
 	parseStringExpr(fileName);
 	accept(ConfigLex::LEX_CLOSE_PAREN_SYM, "expecting ')'");
 	str.empty();
+	m_config->m_journal.addDependency(fileName.c_str());
+	m_config->m_journal.addReadFile(fileName.c_str());
 	if (!file.open(fileName.c_str())) {
 		msg << "error reading " << fileName << ": "
 		    << strerror(errno);
@@ -1666,6 +1750,7 @@ ConfigParser::parseList(StringVector & expr)
 		//--------
 		// ident_sym: make sure the identifier is a list
 		//--------
+		m_config->m_journal.markStateDependent();
 		m_config->listValue(m_token.spelling(), m_token.spelling(),
 				    expr, type);
 		if (type != Configuration::CFG_LIST) {
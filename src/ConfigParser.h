@@ -109,7 +109,14 @@ public:
 
 	//--------
 	// Public operations: None. All the work is done in the ctor!
+	//
+	// expandIncludePattern() gives the files that an @include of
+	// pattern reads: the files it matches, if @include supports
+	// globbing and it matches any, or else pattern itself.
 	//--------
+	static void expandIncludePattern(
+					const char *		pattern,
+					StringVector &		fileNames);
 
 protected:
 	//--------
@@ -158,6 +165,7 @@ protected:
 	ConfigurationImpl *		m_config;
 	bool					m_errorInIncludedFile;
 	StringBuffer			m_fileName;
+	unsigned int			m_fileIndex; // m_fileName in SourceFileTable
 	char const *			m_arg;
 };
 
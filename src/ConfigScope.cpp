@@ -27,38 +27,157 @@
 // #include's
 //--------
 #include "ConfigScope.h"
+#include "PatternSet.h"
 #include "UidIdentifierProcessor.h"
 #include <string.h>
 #include <assert.h>
 #include <stdlib.h>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CONFIG4CPP_SCOPE_SSE2
+#endif
 
 
 namespace CONFIG4CPP_NAMESPACE {
 
 //----------------------------------------------------------------------
-// Function:	Constructor
+// Group probing helpers.
+//
+// Control bytes are examined GROUP_WIDTH at a time.  Each helper returns
+// a bitmask with bit i set if the i'th control byte of the group matches.
+// EMPTY and DELETED both have the high bit set, and the tag of an
+// occupied slot never does.
+//----------------------------------------------------------------------
+
+enum { GROUP_WIDTH = 16 };
+
+#if defined(CONFIG4CPP_SCOPE_SSE2)
+
+static inline unsigned int
+groupMatch(const unsigned char * ctrl, unsigned char tag)
+{
+	__m128i		group;
+
+	group = _mm_loadu_si128((const __m128i *)ctrl);
+	return (unsigned int)_mm_movemask_epi8(
+				_mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)));
+}
+
+
+static inline unsigned int
+groupMatchEmptyOrDeleted(const unsigned char * ctrl)
+{
+	return (unsigned int)_mm_movemask_epi8(
+				_mm_loadu_si128((const __m128i *)ctrl));
+}
+
+#else
+
+static inline unsigned int
+groupMatch(const unsigned char * ctrl, unsigned char tag)
+{
+	unsigned int	result;
+	int				i;
+
+	result = 0;
+	for (i = 0; i < GROUP_WIDTH; i++) {
+		result |= (unsigned int)(ctrl[i] == tag) << i;
+	}
+	return result;
+}
+
+
+static inline unsigned int
+groupMatchEmptyOrDeleted(const unsigned char * ctrl)
+{
+	unsigned int	result;
+	int				i;
+
+	result = 0;
+	for (i = 0; i < GROUP_WIDTH; i++) {
+		result |= (unsigned int)(ctrl[i] >> 7) << i;
+	}
+	return result;
+}
+
+#endif
+
+
+static inline int
+lowestBit(unsigned int mask)
+{
+	assert(mask != 0);
+#if defined(__GNUC__)
+	return __builtin_ctz(mask);
+#else
+	int				i;
+
+	for (i = 0; (mask & 1) == 0; i++) {
+		mask >>= 1;
+	}
+	return i;
+#endif
+}
+
+//----------------------------------------------------------------------
+// Function:	Constructors
 //
 // Description:	
 //----------------------------------------------------------------------
 
 ConfigScope::ConfigScope(ConfigScope * parentScope, const char * name)
 {
+	if (parentScope == 0) {
+		m_arena = new Arena();
+		m_strings = new StringPool(*m_arena);
+		m_ownsArena = true;
+	} else {
+		m_arena = parentScope->m_arena;
+		m_strings = parentScope->m_strings;
+		m_ownsArena = false;
+	}
+	init(parentScope, name);
+}
+
+
+
+ConfigScope::ConfigScope(StringPool * strings)
+{
+	m_arena = &strings->arena();
+	m_strings = strings;
+	m_ownsArena = false;
+	init(0, "");
+}
+
+
+
+void
+ConfigScope::init(ConfigScope * parentScope, const char * name)
+{
+	StringBuffer			scopedName;
+
 	m_parentScope = parentScope;
 	m_tableSize   = 16;
-	m_table       = new ConfigScopeEntry[m_tableSize];
+	m_ctrl        = (unsigned char *)m_arena->allocate(
+											m_tableSize + GROUP_WIDTH);
+	m_slots       = (Slot *)m_arena->allocate(sizeof(Slot) * m_tableSize);
 	m_numEntries  = 0;
+	m_numDeleted  = 0;
+	m_orderedEntries  = 0;
+	m_orderedCapacity = 0;
+	memset(m_ctrl, CTRL_EMPTY, m_tableSize + GROUP_WIDTH);
 
 	if (m_parentScope == 0) {
 		assert(name[0] == '\0');
 		m_scopedName = "";
 	} else {
-		m_scopedName = m_parentScope->m_scopedName;
+		scopedName = m_parentScope->m_scopedName;
 		if (m_parentScope->m_parentScope != 0) {
-			m_scopedName.append(".");
+			scopedName.append(".");
 		}
-		m_scopedName.append(name);
+		scopedName.append(name);
+		m_scopedName = m_arena->copyString(scopedName.c_str());
 	}
-	m_localName = name;
 }
 
 
@@ -66,12 +185,16 @@ ConfigScope::ConfigScope(ConfigScope * parentScope, const char * name)
 //----------------------------------------------------------------------
 // Function:	Destructor
 //
-// Description:	
+// Description:	Nothing a scope holds needs to be destroyed, so there
+//		is nothing to do unless the scope owns the arena.
 //----------------------------------------------------------------------
 
 ConfigScope::~ConfigScope()
 {
-	delete [] m_table;
+	if (m_ownsArena) {
+		delete m_strings;
+		delete m_arena;
+	}
 }
 
 
@@ -102,49 +225,54 @@ ConfigScope::rootScope() const
 // Description:	Add an entry to the hash table.
 //
 // Notes:	Replaces the previous entry with the same name, if any.
+//		Returns 0 if there is a scope with the same name.
 //----------------------------------------------------------------------
 
-bool
+ConfigItem *
 ConfigScope::addOrReplaceString(
 	const char *			name,
-	const char *			str)
+	const char *			str,
+	ConfigItem **			replaced)
 {
 	int						index;
+	unsigned int			hashVal;
 	ConfigScopeEntry *		entry;
-	ConfigScopeEntry *		nextEntry;
-	ConfigScopeEntry *		newEntry;
+	ConfigItem *			item;
 
-	entry = findEntry(name, index);
+	name = m_strings->intern(name);
+	hashVal = hash(name);
+	entry = findEntry(name, hashVal, index);
+	if (replaced != 0) {
+		*replaced = 0;
+	}
 
 	if (entry != 0 && entry->type() == Configuration::CFG_SCOPE) {
 		//--------
 		// Fail because there is a scope with the same name.
 		//--------
-		return false;
+		return 0;
 	} else if (entry != 0) {
 		//--------
 		// It already exists.
 		// Replace the existing item
 		//--------
-		delete entry->m_item;
-		entry->m_item = new ConfigItem(name, str);
+		if (replaced != 0) {
+			*replaced = entry->m_item;
+		}
+		entry->m_item = new (*m_arena) ConfigItem(*m_strings, name, str);
+		m_slots[index].item = entry->m_item;
+		return entry->m_item;
 
 	} else {
 		//--------
 		// It doesn't already exist.
-		// Add a new entry into the list.
+		// Add a new entry into the table.
 		//--------
-		m_numEntries ++;
-		growIfTooFull();
-		index = hash(name);
-		entry = &m_table[index];
-		nextEntry = entry->m_next;
-		newEntry = new ConfigScopeEntry(name, new ConfigItem(name, str),
-										nextEntry);
-		entry->m_next = newEntry;
-		m_orderedEntries.push_back(newEntry);
+		item = new (*m_arena) ConfigItem(*m_strings, name, str);
+		insertEntry(name, hashVal,
+					new (*m_arena) ConfigScopeEntry(name, item));
+		return item;
 	}
-	return true;
 }
 
 
@@ -155,97 +283,140 @@ ConfigScope::addOrReplaceString(
 // Description:	Add an entry to the hash table.
 //
 // Notes:	Replaces the previous entry with the same name, if any.
+//		Returns 0 if there is a scope with the same name.
 //----------------------------------------------------------------------
 
-bool
+ConfigItem *
 ConfigScope::addOrReplaceList(
 	const char *			name,
-	const StringVector &	list)
+	const StringVector &	list,
+	ConfigItem **			replaced)
+{
+	const char **			array;
+	int						size;
+
+	list.c_array(array, size);
+	return addOrReplaceList(name, array, size, replaced);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	addOrReplaceList()
+//
+// Description:	Add an entry to the hash table.
+//
+// Notes:	Replaces the previous entry with the same name, if any.
+//		Returns 0 if there is a scope with the same name.
+//----------------------------------------------------------------------
+
+ConfigItem *
+ConfigScope::addOrReplaceList(
+	const char *			name,
+	const char**			array,
+	int						size,
+	ConfigItem **			replaced)
 {
 	int						index;
+	unsigned int			hashVal;
 	ConfigScopeEntry *		entry;
-	ConfigScopeEntry *		nextEntry;
-	ConfigScopeEntry *		newEntry;
+	ConfigItem *			item;
 
-	entry = findEntry(name, index);
+	name = m_strings->intern(name);
+	hashVal = hash(name);
+	entry = findEntry(name, hashVal, index);
+	if (replaced != 0) {
+		*replaced = 0;
+	}
 	if (entry && entry->type() == Configuration::CFG_SCOPE) {
 		//--------
 		// Fail because there is a scope with the same name.
 		//--------
-		return false;
+		return 0;
 	} else if (entry) {
 		//--------
 		// It already exists. Replace the existing item
 		//--------
-		delete entry->m_item;
-		entry->m_item = new ConfigItem(name, list);
+		if (replaced != 0) {
+			*replaced = entry->m_item;
+		}
+		entry->m_item = new (*m_arena) ConfigItem(*m_strings, name, array,
+												  size);
+		m_slots[index].item = entry->m_item;
+		return entry->m_item;
 
 	} else {
 		//--------
-		// It doesn't already exist. Add a new entry into the list.
+		// It doesn't already exist. Add a new entry into the table.
 		//--------
-		m_numEntries ++;
-		growIfTooFull();
-		index = hash(name);
-		entry = &m_table[index];
-		nextEntry = entry->m_next;
-		newEntry = new ConfigScopeEntry(name, new ConfigItem(name, list),
-		                                 nextEntry);
-		entry->m_next = newEntry;
-		m_orderedEntries.push_back(newEntry);
+		item = new (*m_arena) ConfigItem(*m_strings, name, array, size);
+		insertEntry(name, hashVal,
+					new (*m_arena) ConfigScopeEntry(name, item));
+		return item;
 	}
-	return true;
 }
 
 
 
 //----------------------------------------------------------------------
-// Function:	addOrReplaceList()
+// Function:	copyItem()
 //
-// Description:	Add an entry to the hash table.
+// Description:	Copy a string or list item into this scope's arena.
+//
+// Notes:	The copy is not in the table; see addOrReplaceItem().
+//----------------------------------------------------------------------
+
+ConfigItem *
+ConfigScope::copyItem(const ConfigItem * item)
+{
+	const char *			name;
+	const char **			array;
+	int						size;
+	ConfigItem *			result;
+
+	name = m_strings->intern(item->name());
+	if (item->type() == Configuration::CFG_STRING) {
+		result = new (*m_arena) ConfigItem(*m_strings, name,
+										   item->stringVal());
+	} else {
+		assert(item->type() == Configuration::CFG_LIST);
+		item->listVal(array, size);
+		result = new (*m_arena) ConfigItem(*m_strings, name, array, size);
+	}
+	result->setLocation(item->fileIndex(), item->lineNum());
+	return result;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	addOrReplaceItem()
+//
+// Description:	Add an item made by copyItem() to the hash table.
 //
 // Notes:	Replaces the previous entry with the same name, if any.
+//		Returns 0 if there is a scope with the same name.
 //----------------------------------------------------------------------
 
-bool
-ConfigScope::addOrReplaceList(
-	const char *			name,
-	const char**			array,
-	int						size)
+ConfigItem *
+ConfigScope::addOrReplaceItem(ConfigItem * item)
 {
 	int						index;
+	unsigned int			hashVal;
 	ConfigScopeEntry *		entry;
-	ConfigScopeEntry *		nextEntry;
-	ConfigScopeEntry *		newEntry;
 
-	entry = findEntry(name, index);
+	hashVal = hash(item->name());
+	entry = findEntry(item->name(), hashVal, index);
 	if (entry && entry->type() == Configuration::CFG_SCOPE) {
-		//--------
-		// Fail because there is a scope with the same name.
-		//--------
-		return false;
+		return 0;
 	} else if (entry) {
-		//--------
-		// It already exists. Replace the existing item
-		//--------
-		delete entry->m_item;
-		entry->m_item = new ConfigItem(name, array, size);
-
+		entry->m_item = item;
+		m_slots[index].item = item;
 	} else {
-		//--------
-		// It doesn't already exist. Add a new entry into the list.
-		//--------
-		m_numEntries ++;
-		growIfTooFull();
-		index = hash(name);
-		entry = &m_table[index];
-		nextEntry = entry->m_next;
-		newEntry = new ConfigScopeEntry(name, new ConfigItem(name, array,size),
-										nextEntry);
-		entry->m_next = newEntry;
-		m_orderedEntries.push_back(newEntry);
+		insertEntry(item->name(), hashVal,
+					new (*m_arena) ConfigScopeEntry(item->name(), item));
 	}
-	return true;
+	return item;
 }
 
 
@@ -262,11 +433,11 @@ ConfigScope::ensureScopeExists(
 	ConfigScope *&			scope)
 {
 	int						index;
+	unsigned int			hashVal;
 	ConfigScopeEntry *		entry;
-	ConfigScopeEntry *		nextEntry;
-	ConfigScopeEntry *		newEntry;
 
-	entry = findEntry(name, index);
+	hashVal = hash(name);
+	entry = findEntry(name, hashVal, index);
 	if (entry && entry->type() != Configuration::CFG_SCOPE) {
 		//--------
 		// Fail because it already exists, but not as a scope
@@ -281,18 +452,13 @@ ConfigScope::ensureScopeExists(
 		return true;
 	} else {
 		//--------
-		// It doesn't already exist. Add a new entry into the list.
+		// It doesn't already exist. Add a new entry into the table.
 		//--------
-		m_numEntries ++;
-		growIfTooFull();
-		index = hash(name);
-		entry = &m_table[index];
-		nextEntry = entry->m_next;
-		scope = new ConfigScope(this, name);
-		newEntry = new ConfigScopeEntry(name, new ConfigItem(name, scope),
-										nextEntry);
-		entry->m_next = newEntry;
-		m_orderedEntries.push_back(newEntry);
+		name = m_strings->intern(name);
+		scope = new (*m_arena) ConfigScope(this, name);
+		insertEntry(name, hashVal,
+					new (*m_arena) ConfigScopeEntry(name,
+						new (*m_arena) ConfigItem(name, scope)));
 	}
 	return true;
 }
@@ -309,13 +475,20 @@ ConfigScope::ensureScopeExists(
 
 ConfigItem *
 ConfigScope::findItem(const char * name) const
+{
+	return findItem(name, hash(name));
+}
+
+
+ConfigItem *
+ConfigScope::findItem(const char * name, unsigned int hashVal) const
 {
 	int					index;
 	ConfigScopeEntry *	entry;
 	ConfigItem *		result;
 
 	result = 0;
-	entry = findEntry(name, index);
+	entry = findEntry(name, hashVal, index);
 	if (entry != 0) {
 		result = entry->m_item;
 	}
@@ -331,74 +504,352 @@ ConfigScope::findItem(const char * name) const
 //
 // Notes:	Returns a nil pointer on failure.
 //		Always returns the index (both on success and failure).
+//		On failure, the index is the slot into which the name
+//		would be inserted.
 //----------------------------------------------------------------------
 
 ConfigScopeEntry *
 ConfigScope::findEntry(const char * name, int & index) const
 {
-	ConfigScopeEntry *		entry;
+	return findEntry(name, hash(name), index);
+}
 
-	index = hash(name);
-	entry = m_table[index].m_next;
+
+ConfigScopeEntry *
+ConfigScope::findEntry(
+	const char *			name,
+	unsigned int			hashVal,
+	int &					index) const
+{
+	int						mask;
+	int						pos;
+	int						i;
+	int						firstFree;
+	unsigned int			matches;
+	unsigned int			free;
+	unsigned char			tag;
+	const Slot *			slot;
+
+	mask = m_tableSize - 1;
+	tag = (unsigned char)(hashVal >> 25);
+	firstFree = -1;
+	pos = (int)(hashVal & (unsigned int)mask);
 
 	//--------
-	// Iterate over singly linked list,
-	// searching for the named entry.
+	// Probe a group at a time until we find the name or a group
+	// that contains an empty slot. The table is never allowed to
+	// fill up, so this terminates.
 	//--------
-	while (entry) {
-		if (!strcmp(name, entry->name())) {
-			//--------
-			// Found it!
-			//--------
-			return entry;
+	for (;;) {
+		matches = groupMatch(&m_ctrl[pos], tag);
+		while (matches != 0) {
+			i = (pos + lowestBit(matches)) & mask;
+			slot = &m_slots[i];
+			if (slot->hash == hashVal
+			    && (name == slot->item->name()
+			        || !strcmp(name, slot->item->name())))
+			{
+				//--------
+				// Found it!
+				//--------
+				index = i;
+				return slot->entry;
+			}
+			matches &= matches - 1;
+		}
+		if (firstFree < 0) {
+			free = groupMatchEmptyOrDeleted(&m_ctrl[pos]);
+			if (free != 0) {
+				firstFree = (pos + lowestBit(free)) & mask;
+			}
 		}
-		entry = entry->m_next;
+		if (groupMatch(&m_ctrl[pos], CTRL_EMPTY) != 0) {
+			break;
+		}
+		pos = (pos + GROUP_WIDTH) & mask;
 	}
 	//--------
 	// Not found.
 	//--------
+	index = firstFree;
 	return 0;
 }
 
 
 
 bool
-ConfigScope::removeItem(const char * name)
+ConfigScope::removeItem(const char * name, ConfigItem ** removed)
 {
-	ConfigScopeEntry *		entry;
 	ConfigScopeEntry *		victim;
 	int						index;
+	int						i;
 
-	index = hash(name);
-	entry = &m_table[index];
-	//--------
-	// Iterate over singly linked list,
-	// searching for the named entry.
-	//--------
-	while (entry->m_next != 0) {
-		if (!strcmp(name, entry->m_next->name())) {
-			//--------
-			// Found it!
-			//--------
-			victim = entry->m_next;
-			entry->m_next = victim->m_next;
-			victim->m_next = 0;
-			m_orderedEntries.erase(
-				std::remove(
-					m_orderedEntries.begin(),
-					m_orderedEntries.end(),
-					victim),
-				m_orderedEntries.end());
-			delete victim;
-			m_numEntries --;
-			return true;
+	if (removed != 0) {
+		*removed = 0;
+	}
+	victim = findEntry(name, index);
+	if (victim == 0) {
+		//--------
+		// Not found.
+		//--------
+		return false;
+	}
+	if (removed != 0) {
+		*removed = victim->m_item;
+	}
+
+	setCtrl(index, CTRL_DELETED);
+	m_numDeleted ++;
+	m_slots[index].item = 0;
+	m_slots[index].entry = 0;
+	for (i = 0; m_orderedEntries[i] != victim; i++) {
+	}
+	memmove(&m_orderedEntries[i], &m_orderedEntries[i + 1],
+			sizeof(ConfigScopeEntry *) * (m_numEntries - i - 1));
+	m_numEntries --;
+	return true;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	releaseItem()
+//
+// Description:	Give back the large blocks of an item that has been
+//		replaced or removed.
+//----------------------------------------------------------------------
+
+void
+ConfigScope::releaseItem(ConfigItem * item)
+{
+	if (item->type() == Configuration::CFG_SCOPE) {
+		item->scopeVal()->releaseContents();
+	} else {
+		item->releaseValue(*m_arena);
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	releaseContents()
+//
+// Description:	Give back the large blocks of everything in a scope
+//		that has been removed, including its own table.
+//----------------------------------------------------------------------
+
+void
+ConfigScope::releaseContents()
+{
+	int						i;
+
+	for (i = 0; i < m_numEntries; i++) {
+		releaseItem(m_orderedEntries[i]->m_item);
+	}
+	m_arena->deallocate(m_ctrl, m_tableSize + GROUP_WIDTH);
+	m_arena->deallocate(m_slots, sizeof(Slot) * m_tableSize);
+	m_arena->deallocate(m_orderedEntries,
+						sizeof(ConfigScopeEntry *) * m_orderedCapacity);
+	m_ctrl = 0;
+	m_slots = 0;
+	m_orderedEntries = 0;
+	m_tableSize = 0;
+	m_numEntries = 0;
+	m_orderedCapacity = 0;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	copyContents()
+//
+// Description:	Add deep copies of all of other's entries, in order.
+//
+// Notes:	Used to build a frozen configuration, so the table is
+//		sized once, as tightly as the load factor allows, rather
+//		than being grown while the entries are added.
+//----------------------------------------------------------------------
+
+void
+ConfigScope::copyContents(const ConfigScope & other)
+{
+	int						i;
+	ConfigItem *			item;
+	ConfigItem *			copy;
+	ConfigScope *			scope;
+	const char **			array;
+	int						size;
+	bool					ok;
+
+	reserve(m_numEntries + other.m_numEntries);
+	for (i = 0; i < other.m_numEntries; i++) {
+		item = other.m_orderedEntries[i]->m_item;
+		switch (item->type()) {
+		case Configuration::CFG_STRING:
+			copy = addOrReplaceString(item->name(), item->stringVal());
+			ok = (copy != 0);
+			if (ok) {
+				copy->setLocation(item->fileIndex(), item->lineNum());
+			}
+			break;
+		case Configuration::CFG_LIST:
+			item->listVal(array, size);
+			copy = addOrReplaceList(item->name(), array, size);
+			ok = (copy != 0);
+			if (ok) {
+				copy->setLocation(item->fileIndex(), item->lineNum());
+			}
+			break;
+		case Configuration::CFG_SCOPE:
+			ok = ensureScopeExists(item->name(), scope);
+			if (ok) {
+				scope->copyContents(*item->scopeVal());
+			}
+			break;
+		default:
+			assert(0);	// Bug
+			ok = false;
+			break;
 		}
-		entry = entry->m_next;
+		(void)ok;
+		assert(ok);
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	setStringPool()
+//
+// Description:	Use strings, and its arena, from now on.
+//----------------------------------------------------------------------
+
+void
+ConfigScope::setStringPool(StringPool * strings)
+{
+	int						i;
+	ConfigScopeEntry *		entry;
+
+	assert(!m_ownsArena);
+	m_arena = &strings->arena();
+	m_strings = strings;
+	for (i = 0; i < m_numEntries; i++) {
+		entry = m_orderedEntries[i];
+		if (entry->type() == Configuration::CFG_SCOPE) {
+			entry->item()->scopeVal()->setStringPool(strings);
+		}
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	reserve()
+//
+// Description:	Size the table so it can hold count entries without
+//		growing.
+//----------------------------------------------------------------------
+
+void
+ConfigScope::reserve(int count)
+{
+	int						newTableSize;
+
+	newTableSize = m_tableSize;
+	while (count * 8 >= newTableSize * 7) {
+		newTableSize *= 2;
+	}
+	if (newTableSize != m_tableSize) {
+		rehash(newTableSize);
+	}
+	reserveOrderedEntries(count);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	reserveOrderedEntries()
+//
+// Description:	Make room in m_orderedEntries for count entries.
+//----------------------------------------------------------------------
+
+void
+ConfigScope::reserveOrderedEntries(int count)
+{
+	ConfigScopeEntry **		entries;
+	int						capacity;
+
+	if (count <= m_orderedCapacity) {
+		return;
+	}
+	capacity = m_orderedCapacity == 0 ? 8 : m_orderedCapacity;
+	while (capacity < count) {
+		capacity *= 2;
+	}
+	entries = (ConfigScopeEntry **)m_arena->allocate(
+									sizeof(ConfigScopeEntry *) * capacity);
+	if (m_numEntries > 0) {
+		memcpy(entries, m_orderedEntries,
+			   sizeof(ConfigScopeEntry *) * m_numEntries);
+	}
+	m_arena->deallocate(m_orderedEntries,
+						sizeof(ConfigScopeEntry *) * m_orderedCapacity);
+	m_orderedEntries = entries;
+	m_orderedCapacity = capacity;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	insertEntry()
+//
+// Description:	Add a new entry, known not to be in the table already.
+//----------------------------------------------------------------------
+
+void
+ConfigScope::insertEntry(
+	const char *			name,
+	unsigned int			hashVal,
+	ConfigScopeEntry *		entry)
+{
+	int						index;
+	ConfigScopeEntry *		existing;
+
+	reserveOrderedEntries(m_numEntries + 1);
+	m_numEntries ++;
+	growIfTooFull();
+	existing = findEntry(name, hashVal, index);
+	(void)existing;
+	assert(existing == 0);
+	if (m_ctrl[index] == CTRL_DELETED) {
+		m_numDeleted --;
+	}
+	setCtrl(index, (unsigned char)(hashVal >> 25));
+	m_slots[index].hash = hashVal;
+	m_slots[index].item = entry->m_item;
+	m_slots[index].entry = entry;
+	m_orderedEntries[m_numEntries - 1] = entry;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	setCtrl()
+//
+// Description:	Set a control byte.
+//
+// Notes:	The first GROUP_WIDTH control bytes are mirrored after
+//		the end of the table so that a group can be loaded from
+//		any position without wrapping around.
+//----------------------------------------------------------------------
+
+void
+ConfigScope::setCtrl(int index, unsigned char ctrl)
+{
+	m_ctrl[index] = ctrl;
+	if (index < GROUP_WIDTH) {
+		m_ctrl[m_tableSize + index] = ctrl;
 	}
-	//--------
-	// Not found.
-	//--------
-	return false;
 }
 
 
@@ -444,7 +895,7 @@ ConfigScope::listLocalNames(
 	vec.ensureCapacity(m_numEntries);
 	countWanted = 0;
 	countUnwanted = 0;
-	for (i = 0; i < int(m_orderedEntries.size()); i++) {
+	for (i = 0; i < m_numEntries; i++) {
 		entry = m_orderedEntries[i];
 		if (entry->type() & typeMask) {
 			vec.add(entry->name());
@@ -464,6 +915,9 @@ ConfigScope::listLocalNames(
 // Function:	listScopedNamesHelper()
 //
 // Description:	
+//
+// Notes:	The filter patterns are compiled into a PatternSet once,
+//		rather than being matched one at a time for every name.
 //----------------------------------------------------------------------
 
 void
@@ -473,6 +927,21 @@ ConfigScope::listScopedNamesHelper(
 	bool						recursive,
 	const StringVector &		filterPatterns,
 	StringVector &				vec) const
+{
+	PatternSet					filter(filterPatterns);
+
+	listScopedNamesHelper(prefix, typeMask, recursive, filter, vec);
+}
+
+
+
+void
+ConfigScope::listScopedNamesHelper(
+	const char *				prefix,
+	Configuration::Type			typeMask,
+	bool						recursive,
+	const PatternSet &			filter,
+	StringVector &				vec) const
 {
 	int							i;
 	ConfigScopeEntry *			entry;
@@ -483,7 +952,7 @@ ConfigScope::listScopedNamesHelper(
 	// their locally-scoped names into the StringVector
 	//--------
 	vec.ensureCapacity(vec.length() + m_numEntries);
-	for (i = 0; i < int(m_orderedEntries.size()); i++) {
+	for (i = 0; i < m_numEntries; i++) {
 		entry = m_orderedEntries[i];
 		scopedName = prefix;
 		if (prefix[0] != '\0') {
@@ -491,15 +960,146 @@ ConfigScope::listScopedNamesHelper(
 		}
 		scopedName.append(entry->name());
 		if ((entry->type() & typeMask)
-		    && listFilter(scopedName.c_str(), filterPatterns))
+		    && listFilter(scopedName.c_str(), filter))
 		{
 			vec.add(scopedName);
 		}
 		if (recursive && entry->type() == Configuration::CFG_SCOPE) {
 			entry->item()->scopeVal()->listScopedNamesHelper(
 											scopedName.c_str(), typeMask,
-											true, filterPatterns, vec);
+											true, filter, vec);
+		}
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	listScopedItemsHelper()
+//
+// Description:	As listScopedNamesHelper(), but without filter patterns,
+//		and also listing the item for each name and the name with
+//		its "uid-" identifiers unexpanded.
+//
+// Notes:	Each local name is unexpanded once and appended to the
+//		unexpanded prefix, rather than the whole scoped name being
+//		split and unexpanded again at every level.
+//----------------------------------------------------------------------
+
+void
+ConfigScope::listScopedItemsHelper(
+	const char *				prefix,
+	const char *				unexpandedPrefix,
+	Configuration::Type			typeMask,
+	bool						recursive,
+	StringVector &				names,
+	StringVector &				unexpandedNames,
+	std::vector<const ConfigItem *> &	items) const
+{
+	int							i;
+	ConfigScopeEntry *			entry;
+	StringBuffer				scopedName;
+	StringBuffer				unexpandedScopedName;
+	StringBuffer				buf;
+	UidIdentifierProcessor		uidProc;
+
+	names.ensureCapacity(names.length() + m_numEntries);
+	unexpandedNames.ensureCapacity(unexpandedNames.length() + m_numEntries);
+	items.reserve(items.size() + m_numEntries);
+	for (i = 0; i < m_numEntries; i++) {
+		entry = m_orderedEntries[i];
+		scopedName = prefix;
+		unexpandedScopedName = unexpandedPrefix;
+		if (prefix[0] != '\0') {
+			scopedName.append(".");
+			unexpandedScopedName.append(".");
+		}
+		scopedName.append(entry->name());
+		unexpandedScopedName.append(uidProc.unexpand(entry->name(), buf));
+		if (entry->type() & typeMask) {
+			names.add(scopedName);
+			unexpandedNames.add(unexpandedScopedName);
+			items.push_back(entry->item());
+		}
+		if (recursive && entry->type() == Configuration::CFG_SCOPE) {
+			entry->item()->scopeVal()->listScopedItemsHelper(
+								scopedName.c_str(),
+								unexpandedScopedName.c_str(), typeMask,
+								true, names, unexpandedNames, items);
+		}
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	forEach()
+//
+// Description:	Call visitor for each entry, in the order of
+//		listScopedNamesHelper().
+//
+// Notes:	Each scoped name is built in one buffer that is cut back
+//		after each entry, so nothing is allocated per entry.
+//----------------------------------------------------------------------
+
+void
+ConfigScope::forEach(
+	Configuration::Type				typeMask,
+	bool							recursive,
+	const Configuration::Visitor &	visitor) const
+{
+	std::string						scopedName;
+
+	scopedName.reserve(256);
+	scopedName = m_scopedName;
+	forEachHelper(scopedName, typeMask, recursive, visitor);
+}
+
+
+
+void
+ConfigScope::forEachHelper(
+	std::string &					scopedName,
+	Configuration::Type				typeMask,
+	bool							recursive,
+	const Configuration::Visitor &	visitor) const
+{
+	int								i;
+	size_t							prefixLen;
+	ConfigScopeEntry *				entry;
+	const ConfigItem *				item;
+	Configuration::Entry			visited;
+	const char **					array;
+
+	prefixLen = scopedName.size();
+	for (i = 0; i < m_numEntries; i++) {
+		entry = m_orderedEntries[i];
+		item = entry->item();
+		if (prefixLen != 0) {
+			scopedName += '.';
 		}
+		scopedName += entry->name();
+		if (entry->type() & typeMask) {
+			visited.scopedName = scopedName.c_str();
+			visited.scopedNameLength = (int)scopedName.size();
+			visited.localName = entry->name();
+			visited.type = entry->type();
+			visited.stringValue = 0;
+			visited.listValue = 0;
+			visited.listLength = 0;
+			if (visited.type == Configuration::CFG_STRING) {
+				visited.stringValue = item->stringVal();
+			} else if (visited.type == Configuration::CFG_LIST) {
+				item->listVal(array, visited.listLength);
+				visited.listValue = array;
+			}
+			visitor(visited);
+		}
+		if (recursive && entry->type() == Configuration::CFG_SCOPE) {
+			item->scopeVal()->forEachHelper(scopedName, typeMask, true,
+											visitor);
+		}
+		scopedName.resize(prefixLen);
 	}
 }
 
@@ -514,28 +1114,18 @@ ConfigScope::listScopedNamesHelper(
 bool
 ConfigScope::listFilter(
 	const char *				name,
-	const StringVector &		filterPatterns) const
+	const PatternSet &			filter) const
 {
-	int							i;
-	int							len;
 	const char *				unexpandedName;
-	const char *				pattern;
 	StringBuffer				buf;
 	UidIdentifierProcessor		uidProc;
 
-	len = filterPatterns.length();
-	if (len == 0) {
+	if (filter.isEmpty()) {
 		return true;
 	}
 
 	unexpandedName = uidProc.unexpand(name, buf);
-	for (i = 0; i < len; i++) {
-		pattern = filterPatterns[i];
-		if (Configuration::patternMatch(unexpandedName, pattern)) {
-			return true;
-		}
-	}
-	return false;
+	return filter.matches(unexpandedName);
 }
 
 
@@ -552,6 +1142,7 @@ void
 ConfigScope::dump(
 	StringBuffer &			buf,
 	bool					wantExpandedUidNames,
+	bool					wantLocations,
 	int						indentLevel) const
 {
 	int						i;
@@ -568,7 +1159,8 @@ ConfigScope::dump(
 	for (i = 0; i < len; i++) {
 		item = findItem(nameVec[i]);
 		assert(item->type() & Configuration::CFG_VARIABLES);
-		item->dump(buf, item->name(), wantExpandedUidNames, indentLevel);
+		item->dump(buf, item->name(), wantExpandedUidNames, wantLocations,
+				   indentLevel);
 	}
 
 	//--------
@@ -580,7 +1172,8 @@ ConfigScope::dump(
 	for (i = 0; i < len; i++) {
 		item = findItem(nameVec[i]);
 		assert(item->type() == Configuration::CFG_SCOPE);
-		item->dump(buf, item->name(), wantExpandedUidNames, indentLevel);
+		item->dump(buf, item->name(), wantExpandedUidNames, wantLocations,
+				   indentLevel);
 	}
 }
 
@@ -590,10 +1183,14 @@ ConfigScope::dump(
 // Function:	hash()
 //
 // Description:	Hashes the name to provide an integer value.
+//
+// Notes:	The classic djb2 loop, followed by a final avalanche step
+//		so that both the low bits (used to pick a slot) and the top
+//		bits (used as the control code) are well mixed.
 //----------------------------------------------------------------------
 
-int
-ConfigScope::hash(const char *name) const
+unsigned int
+ConfigScope::hash(const char * name)
 {
 	unsigned int	result;
 	const char *	p;
@@ -602,9 +1199,10 @@ ConfigScope::hash(const char *name) const
 	for (p = name; *p != '\0'; p++) {
 		result = ((result << 5) + result) + (unsigned int)(*p);
 	}
-	result = result % m_tableSize;
+	result *= 0x9e3779b1u;
+	result ^= result >> 15;
 
-	return (int)result;
+	return result;
 }
 
 
@@ -612,40 +1210,72 @@ ConfigScope::hash(const char *name) const
 //----------------------------------------------------------------------
 // Function:	growIfTooFull()
 //
-// Description:	
+// Description:	Keep the table (including tombstones) at most 7/8 full.
+//
+// Notes:	If most of the used slots are tombstones then the table
+//		is rebuilt at the same size rather than doubled.
 //----------------------------------------------------------------------
 
 void
 ConfigScope::growIfTooFull()
 {
-	int						origTableSize;
-	int						i;
-	int						index;
-	ConfigScopeEntry *		origTable;
-	ConfigScopeEntry *		entry;
-	ConfigScopeEntry *		nextEntry;
+	int						newTableSize;
 
-	if (m_numEntries * 2 < m_tableSize) {
+	if ((m_numEntries + m_numDeleted) * 8 < m_tableSize * 7) {
 		return;
 	}
+	newTableSize = m_tableSize;
+	if (m_numEntries * 2 >= m_tableSize) {
+		newTableSize = m_tableSize * 2;
+	}
+	rehash(newTableSize);
+}
 
-	origTable     = m_table;
-	origTableSize = m_tableSize;
-	m_tableSize   = m_tableSize * 2;
-	m_table       = new ConfigScopeEntry[m_tableSize];
 
+
+//----------------------------------------------------------------------
+// Function:	rehash()
+//
+// Description:	Move every entry into a fresh table, dropping tombstones.
+//----------------------------------------------------------------------
+
+void
+ConfigScope::rehash(int newTableSize)
+{
+	int						origTableSize;
+	int						i;
+	int						index;
+	int						mask;
+	unsigned char *			origCtrl;
+	Slot *					origSlots;
+
+	origCtrl      = m_ctrl;
+	origSlots     = m_slots;
+	origTableSize = m_tableSize;
+	m_tableSize   = newTableSize;
+	m_ctrl        = (unsigned char *)m_arena->allocate(
+											m_tableSize + GROUP_WIDTH);
+	m_slots       = (Slot *)m_arena->allocate(sizeof(Slot) * m_tableSize);
+	m_numDeleted  = 0;
+	memset(m_ctrl, CTRL_EMPTY, m_tableSize + GROUP_WIDTH);
+
+	mask = m_tableSize - 1;
 	for (i = 0; i < origTableSize; i++) {
-		entry = origTable[i].m_next;
-		while (entry) {
-			index = hash(entry->name());
-			nextEntry = entry->m_next;
-			entry->m_next = m_table[index].m_next;
-			m_table[index].m_next = entry;
-			entry = nextEntry;
+		if (origCtrl[i] & 0x80) {
+			//--------
+			// Empty or deleted.
+			//--------
+			continue;
+		}
+		index = (int)(origSlots[i].hash & (unsigned int)mask);
+		while (m_ctrl[index] != CTRL_EMPTY) {
+			index = (index + 1) & mask;
 		}
-		origTable[i].m_next = 0;
+		setCtrl(index, origCtrl[i]);
+		m_slots[index] = origSlots[i];
 	}
-	delete [] origTable;
+	m_arena->deallocate(origCtrl, origTableSize + GROUP_WIDTH);
+	m_arena->deallocate(origSlots, sizeof(Slot) * origTableSize);
 }
 
 }; // namespace CONFIG4CPP_NAMESPACE
@@ -36,14 +36,38 @@
 // reasons.  I think that is mostly in the interface itself, so this should
 // not be a big problemas it is an imlpementation-only header.  But, I'm
 // going to use it anyway because I'm not going to write a class for this.
+#include <string>
 #include <vector>
 
 namespace CONFIG4CPP_NAMESPACE {
 
+class PatternSet;
+
 //----------------------------------------------------------------------
 // Class:	ConfigScope
 //
 // Description:	A hash table for storing (name, item) pairs.
+//
+// Notes:	The table uses open addressing, in the style of a "Swiss
+//		table".  Each slot has a one-byte control code, which is
+//		either CTRL_EMPTY, CTRL_DELETED or (for an occupied slot)
+//		the top 7 bits of the name's hash.  The control codes are
+//		stored contiguously and probed 16 at a time (with SSE2, when
+//		available), and the full hash and item are kept in the slot
+//		so strcmp() is called only for a name that is almost
+//		certainly a match (and not at all when the name is the
+//		interned copy held by the item).
+//
+//		Everything a scope holds, including its table, its nested
+//		scopes and their items, is allocated from one Arena, which
+//		a root scope shares with (or, if it is given none, owns
+//		on behalf of) all the scopes nested in it. Names and values
+//		are interned in a StringPool that is shared the same way.
+//		Nested scopes are never destroyed individually; the arena
+//		is released as a whole. Replacing or removing an entry
+//		gives back only its large blocks (see releaseItem()), so
+//		a configuration that is updated for ever still grows by
+//		the size of the small items it replaces.
 //----------------------------------------------------------------------
 
 class ConfigScope
@@ -51,36 +75,92 @@ class ConfigScope
 
 public:
 	//--------
-	// Ctors & dtor
+	// Ctors & dtor. A root scope (one with no parent) that is not
+	// given a string pool creates one, and its arena, of its own.
 	//--------
 	ConfigScope(ConfigScope * parentScope, const char * name);
+	ConfigScope(StringPool * strings);
 	~ConfigScope();
 
+	inline static void * operator new(size_t size, Arena & arena);
+	inline static void operator delete(void * ptr, Arena & arena);
+
 	//--------
 	// Operations.
 	//--------
 	inline const char *	scopedName() const;
 
-	bool addOrReplaceString(
+	//--------
+	// If replaced is given, it is set to the item that was replaced
+	// or removed, or to 0. That item stays in the arena, so anything
+	// that still refers to it (such as a ParseJournal) is safe, until
+	// releaseItem() gives back its large blocks.
+	//--------
+	ConfigItem * addOrReplaceString(
 					const char *			name,
-					const char *			str);
+					const char *			str,
+					ConfigItem **			replaced = 0);
 
-	bool addOrReplaceList(
+	ConfigItem * addOrReplaceList(
 					const char *			name,
 					const char**			array,
-					int						size);
-	bool addOrReplaceList(
+					int						size,
+					ConfigItem **			replaced = 0);
+	ConfigItem * addOrReplaceList(
 					const char *			name,
-					const StringVector &	list);
+					const StringVector &	list,
+					ConfigItem **			replaced = 0);
+
+	//--------
+	// copyItem() copies a string or list item, and its location,
+	// into this scope's arena without adding it to the table;
+	// addOrReplaceItem() adds such an item, replacing any entry
+	// of the same name. Like the operations above, it returns 0
+	// if there is a scope with the same name.
+	//--------
+	ConfigItem * copyItem(const ConfigItem * item);
+	ConfigItem * addOrReplaceItem(ConfigItem * item);
 
 	bool ensureScopeExists(
 					const char *			name,
 					ConfigScope *&			scope);
 
-	bool removeItem(const char * name);
+	bool removeItem(const char * name, ConfigItem ** removed = 0);
+
+	//--------
+	// releaseItem() gives back to the arena the large blocks (see
+	// Arena) of an item that is no longer in any table: a long
+	// string or list, or, for a scope, its table and everything in
+	// it. The item must not be used afterwards.
+	//--------
+	void releaseItem(ConfigItem * item);
+	void releaseContents();
+
+	void copyContents(const ConfigScope & other);
+
+	//--------
+	// setStringPool() makes this scope, and those nested in it,
+	// use another pool and its arena, after their contents have
+	// been swapped with those of the ones the scopes used.
+	//--------
+	void setStringPool(StringPool * strings);
+	void reserve(int count);
+
+	//--------
+	// The entries, in the order in which they were added.
+	//--------
+	inline int numEntries() const;
+	inline ConfigItem * itemAt(int index) const;
 
 	ConfigItem * findItem(const char * name) const;
+	ConfigItem * findItem(const char * name, unsigned int hashVal) const;
 	ConfigScopeEntry * findEntry(const char * name, int & index) const;
+	ConfigScopeEntry * findEntry(
+					const char *			name,
+					unsigned int			hashVal,
+					int &					index) const;
+
+	static unsigned int hash(const char * name);
 
 	bool is_in_table(const char * name) const;
 
@@ -101,6 +181,18 @@ public:
 					const StringVector &	filterPatterns,
 					StringVector &			vec) const;
 
+	inline void listLocallyScopedItems(
+					Configuration::Type		typeMask,
+					bool					recursive,
+					StringVector &			names,
+					StringVector &			unexpandedNames,
+					std::vector<const ConfigItem *> &	items) const;
+
+	void forEach(
+					Configuration::Type		typeMask,
+					bool					recursive,
+					const Configuration::Visitor &	visitor) const;
+
 	inline ConfigScope * parentScope() const;
 	ConfigScope * rootScope() const;
 
@@ -110,15 +202,23 @@ public:
 	void dump(
 				StringBuffer &		buf,
 				bool				wantExpandedUidNames,
+				bool				wantLocations,
 				int					indentLevel = 0) const;
 
 protected:
 	//--------
 	// Helper operations
 	//--------
-	int hash(const char *name) const;
+	void insertEntry(
+					const char *			name,
+					unsigned int			hashVal,
+					ConfigScopeEntry *		entry);
 
+	void init(ConfigScope * parentScope, const char * name);
+	void reserveOrderedEntries(int count);
+	void setCtrl(int index, unsigned char ctrl);
 	void growIfTooFull();
+	void rehash(int newTableSize);
 
 	void listLocalNames(
 					Configuration::Type		typeMask,
@@ -131,30 +231,82 @@ protected:
 					const StringVector &	filterPatterns,
 					StringVector &			vec) const;
 
+	void listScopedNamesHelper(
+					const char *			prefix,
+					Configuration::Type		typeMask,
+					bool					recursive,
+					const PatternSet &		filter,
+					StringVector &			vec) const;
+
 	bool listFilter(
 					const char *			name,
-					const StringVector &	filterPatterns) const;
+					const PatternSet &		filter) const;
+
+	void forEachHelper(
+					std::string &			scopedName,
+					Configuration::Type		typeMask,
+					bool					recursive,
+					const Configuration::Visitor &	visitor) const;
+
+	void listScopedItemsHelper(
+					const char *			prefix,
+					const char *			unexpandedPrefix,
+					Configuration::Type		typeMask,
+					bool					recursive,
+					StringVector &			names,
+					StringVector &			unexpandedNames,
+					std::vector<const ConfigItem *> &	items) const;
 
 protected:
 	//--------
 	// Instance variables
 	//--------
+	Arena *				m_arena;
+	StringPool *		m_strings;
+	bool				m_ownsArena;
 	ConfigScope *		m_parentScope;
-	StringBuffer		m_scopedName;
-	StringBuffer		m_localName;
-	ConfigScopeEntry *	m_table;
-	int					m_tableSize;
+	const char *		m_scopedName;
+	enum {
+		CTRL_EMPTY   = 0x80,
+		CTRL_DELETED = 0xFE
+	};
+
+	struct Slot {
+		unsigned int		hash;
+		ConfigItem *		item;
+		ConfigScopeEntry *	entry;
+	};
+
+	unsigned char *		m_ctrl;
+	Slot *				m_slots;
+	int					m_tableSize;	// always a power of two
 	int					m_numEntries;
-	std::vector<ConfigScopeEntry *> m_orderedEntries;
+	int					m_numDeleted;
+	ConfigScopeEntry **	m_orderedEntries;	// m_numEntries of them
+	int					m_orderedCapacity;
 
 	//--------
 	// Not implemented.
 	//--------
 	ConfigScope();
+	ConfigScope(const ConfigScope &);
 	ConfigScope & operator=(const ConfigScope &);
 };
 
 
+inline void *
+ConfigScope::operator new(size_t size, Arena & arena)
+{
+	return arena.allocate(size);
+}
+
+
+inline void
+ConfigScope::operator delete(void *, Arena &)
+{
+}
+
+
 inline ConfigScope *
 ConfigScope::parentScope() const
 {
@@ -165,7 +317,21 @@ ConfigScope::parentScope() const
 inline const char *
 ConfigScope::scopedName() const
 {
-	return m_scopedName.c_str();
+	return m_scopedName;
+}
+
+
+inline int
+ConfigScope::numEntries() const
+{
+	return m_numEntries;
+}
+
+
+inline ConfigItem *
+ConfigScope::itemAt(int index) const
+{
+	return m_orderedEntries[index]->m_item;
 }
 
 
@@ -177,7 +343,7 @@ ConfigScope::listFullyScopedNames(
 {
 	StringVector				filterPatterns;
 
-	listScopedNamesHelper(m_scopedName.c_str(), typeMask, recursive,
+	listScopedNamesHelper(m_scopedName, typeMask, recursive,
 				filterPatterns, vec);
 }
 
@@ -190,7 +356,7 @@ ConfigScope::listFullyScopedNames(
 	StringVector &				vec) const
 {
 	vec.empty();
-	listScopedNamesHelper(m_scopedName.c_str(), typeMask, recursive,
+	listScopedNamesHelper(m_scopedName, typeMask, recursive,
 				filterPatterns, vec);
 }
 
@@ -207,5 +373,21 @@ ConfigScope::listLocallyScopedNames(
 }
 
 
+inline void
+ConfigScope::listLocallyScopedItems(
+	Configuration::Type			typeMask,
+	bool						recursive,
+	StringVector &				names,
+	StringVector &				unexpandedNames,
+	std::vector<const ConfigItem *> &	items) const
+{
+	names.empty();
+	unexpandedNames.empty();
+	items.clear();
+	listScopedItemsHelper("", "", typeMask, recursive, names,
+				unexpandedNames, items);
+}
+
+
 }; // namespace CONFIG4CPP_NAMESPACE
 #endif
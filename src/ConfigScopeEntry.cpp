@@ -38,34 +38,11 @@ namespace CONFIG4CPP_NAMESPACE {
 // Description:	
 //----------------------------------------------------------------------
 
-ConfigScopeEntry::ConfigScopeEntry()
-{
-	m_item	= 0;
-	m_next	= 0;
-}
-
-
 ConfigScopeEntry::ConfigScopeEntry(
 		const char *,
-		ConfigItem *		item,
-		ConfigScopeEntry *	next)
+		ConfigItem *		item)
 {
 	m_item	= item;
-	m_next	= next;
-}
-
-
-
-//----------------------------------------------------------------------
-// Function:	Destructor
-//
-// Description:	
-//----------------------------------------------------------------------
-
-ConfigScopeEntry::~ConfigScopeEntry ()
-{
-	delete m_item;
-	delete m_next;
 }
 
 
@@ -73,7 +50,6 @@ ConfigScopeEntry::~ConfigScopeEntry ()
 void
 ConfigScopeEntry::setItem(ConfigItem * item)
 {
-	delete m_item;
 	m_item = item;
 }
 
@@ -41,14 +41,15 @@ class ConfigScopeEntry
 {
 public:
 	//--------
-	// Ctors & dtor
+	// Ctor. Entries, like their items, are allocated from an
+	// Arena and are never destroyed individually.
 	//--------
-	ConfigScopeEntry();
 	ConfigScopeEntry(
 			const char *		name,
-			ConfigItem *		item,
-			ConfigScopeEntry *	next);
-	~ConfigScopeEntry ();
+			ConfigItem *		item);
+
+	inline static void * operator new(size_t size, Arena & arena);
+	inline static void operator delete(void * ptr, Arena & arena);
 
 	inline const char * name();
 	inline const ConfigItem * item();
@@ -62,12 +63,12 @@ protected:
 	// Instance variables
 	//--------
 	ConfigItem *			m_item;
-	ConfigScopeEntry *		m_next;
 
 private:
 	//--------
 	// Constructors and operators that are not suported
 	//--------
+	ConfigScopeEntry();
 	ConfigScopeEntry & operator=(const ConfigScopeEntry &);
 
 };
@@ -77,6 +78,19 @@ private:
 // Inline implementation of operations
 //--------
 
+inline void *
+ConfigScopeEntry::operator new(size_t size, Arena & arena)
+{
+	return arena.allocate(size);
+}
+
+
+inline void
+ConfigScopeEntry::operator delete(void *, Arena &)
+{
+}
+
+
 inline const char *
 ConfigScopeEntry::name()
 {
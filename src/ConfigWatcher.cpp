@@ -0,0 +1,421 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+
+//--------
+// #include's
+//--------
+#include <config4cpp/ConfigWatcher.h>
+#include "platform.h"
+#include "util.h"
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+#if defined(__linux__)
+//--------
+// A change to the contents of a watched file, or to the entries of a
+// globbed directory, or to a watched directory itself.
+//--------
+static const unsigned int CONTENT_EVENTS = IN_CLOSE_WRITE | IN_MODIFY
+										 | IN_MOVED_TO | IN_MOVED_FROM
+										 | IN_CREATE | IN_DELETE;
+static const unsigned int ENTRY_EVENTS = IN_MOVED_TO | IN_MOVED_FROM
+									   | IN_CREATE | IN_DELETE;
+static const unsigned int SELF_EVENTS = IN_DELETE_SELF | IN_MOVE_SELF
+									  | IN_IGNORED;
+#endif
+
+
+//----------------------------------------------------------------------
+// Function:	Constructors
+//
+// Description:	Start watching the dependencies of cfg.
+//----------------------------------------------------------------------
+
+ConfigWatcher::ConfigWatcher(Configuration * cfg, int debounceMillis)
+{
+	m_cfg = cfg;
+	m_debounceMillis = debounceMillis;
+#if defined(__linux__)
+	m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#else
+	m_fd = -1;
+#endif
+	rewatch();
+}
+
+
+ConfigWatcher::ConfigWatcher(
+	Configuration *			cfg,
+	Callback				callback,
+	int						debounceMillis)
+	: m_callback(callback)
+{
+	m_cfg = cfg;
+	m_debounceMillis = debounceMillis;
+#if defined(__linux__)
+	m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#else
+	m_fd = -1;
+#endif
+	rewatch();
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	Destructor
+//----------------------------------------------------------------------
+
+ConfigWatcher::~ConfigWatcher()
+{
+	if (m_fd != -1) {
+		close(m_fd);
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	fileDescriptor()
+//
+// Description:	Readable when a change may be pending, or -1 if
+//		polling.
+//----------------------------------------------------------------------
+
+int
+ConfigWatcher::fileDescriptor() const
+{
+	return m_fd;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	rewatch()
+//
+// Description:	Watch the directory of each dependency, and each
+//		globbed directory, once.
+//
+// Notes:	A directory that is still needed keeps its inotify
+//		watch, so no change to it is missed while reloading. A
+//		directory that cannot be watched keeps a wd of -1, and
+//		the stamps of what it holds are polled instead.
+//----------------------------------------------------------------------
+
+void
+ConfigWatcher::rewatch()
+{
+	StringVector			fileNames;
+	StringVector			dirNames;
+	StringBuffer			dirName;
+	Stamp					stamp;
+	Watch *					watch;
+	std::vector<Watch>		oldWatches;
+	const char *			baseName;
+	int						i;
+	size_t					j;
+	size_t					k;
+
+	oldWatches.swap(m_watches);
+	m_stamps.clear();
+	m_cfg->listDependencies(fileNames, dirNames);
+	for (i = 0; i < fileNames.length() + dirNames.length(); i++) {
+		if (i < fileNames.length()) {
+			getDirName(fileNames[i], dirName);
+		} else {
+			dirName = dirNames[i - fileNames.length()];
+		}
+		watch = 0;
+		for (j = 0; j < m_watches.size(); j++) {
+			if (m_watches[j].dirName == dirName.c_str()) {
+				watch = &m_watches[j];
+				break;
+			}
+		}
+		if (watch == 0) {
+			m_watches.push_back(Watch());
+			watch = &m_watches.back();
+			watch->wd = -1;
+			watch->dirName = dirName.c_str();
+			watch->isGlobbed = false;
+		}
+		if (i < fileNames.length()) {
+			baseName = fileNames[i] + strlen(fileNames[i]);
+			while (baseName > fileNames[i]
+				   && baseName[-1] != CONFIG4CPP_DIR_SEP[0]
+				   && baseName[-1] != '/')
+			{
+				baseName--;
+			}
+			watch->baseNames.push_back(baseName);
+			stamp.fileName = fileNames[i];
+		} else {
+			watch->isGlobbed = true;
+			stamp.fileName = watch->dirName;
+		}
+		stamp.watch = watch - &m_watches[0];
+		stamp.exists = getFileStamp(stamp.fileName.c_str(), stamp.mtime,
+									stamp.size);
+		m_stamps.push_back(stamp);
+	}
+	m_isPolling = (m_fd == -1);
+#if defined(__linux__)
+	if (m_fd != -1) {
+		for (j = 0; j < m_watches.size(); j++) {
+			m_watches[j].wd = inotify_add_watch(m_fd,
+							m_watches[j].dirName.c_str(),
+							CONTENT_EVENTS | IN_DELETE_SELF | IN_MOVE_SELF);
+			if (m_watches[j].wd == -1) {
+				m_isPolling = true;
+			}
+		}
+		for (k = 0; k < oldWatches.size(); k++) {
+			for (j = 0; j < m_watches.size(); j++) {
+				if (m_watches[j].wd == oldWatches[k].wd) {
+					break;
+				}
+			}
+			if (oldWatches[k].wd != -1 && j == m_watches.size()) {
+				inotify_rm_watch(m_fd, oldWatches[k].wd);
+			}
+		}
+	}
+#endif
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	reloadIfChanged()
+//
+// Description:	Wait for a change, wait for the edits to stop, and
+//		then reload.
+//----------------------------------------------------------------------
+
+bool
+ConfigWatcher::reloadIfChanged(int timeoutMillis)
+{
+	bool					result;
+
+	if (!waitForChange(timeoutMillis)) {
+		return false;
+	}
+	while (waitForChange(m_debounceMillis)) {
+		// a burst of edits is still going on
+	}
+	try {
+		if (m_callback) {
+			m_callback(m_cfg);
+			result = true;
+		} else {
+			result = m_cfg->reparseChanged();
+		}
+	} catch (const ConfigurationException &) {
+		rewatch();
+		throw;
+	}
+	rewatch();
+	return result;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	waitForChange()
+//
+// Description:	Wait up to timeoutMillis (for ever if -1) for a change
+//		that might affect the configuration.
+//----------------------------------------------------------------------
+
+bool
+ConfigWatcher::waitForChange(int timeoutMillis)
+{
+	typedef std::chrono::steady_clock	Clock;
+	Clock::time_point		deadline;
+	int						waitMillis;
+
+	deadline = Clock::now() + std::chrono::milliseconds(timeoutMillis);
+	for (;;) {
+		waitMillis = timeoutMillis;
+		if (timeoutMillis != -1) {
+			waitMillis = (int)std::chrono::duration_cast<
+								std::chrono::milliseconds>(
+									deadline - Clock::now()).count();
+			if (waitMillis < 0) {
+				waitMillis = 0;
+			}
+		}
+#if defined(__linux__)
+		if (m_fd != -1) {
+			struct pollfd	pfd;
+			int				pollMillis;
+
+			pfd.fd = m_fd;
+			pfd.events = POLLIN;
+			pfd.revents = 0;
+			pollMillis = waitMillis;
+			if (m_isPolling
+				&& (pollMillis == -1 || pollMillis > m_debounceMillis))
+			{
+				pollMillis = m_debounceMillis;
+			}
+			if (poll(&pfd, 1, pollMillis) > 0 && readEvents()) {
+				return true;
+			}
+			if (m_isPolling && stampsChanged()) {
+				return true;
+			}
+			if (waitMillis == 0) {
+				return false;
+			}
+			continue;
+		}
+#endif
+		if (stampsChanged()) {
+			return true;
+		}
+		if (waitMillis == 0) {
+			return false;
+		}
+		if (waitMillis == -1 || waitMillis > m_debounceMillis) {
+			waitMillis = m_debounceMillis;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(waitMillis));
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	readEvents()
+//
+// Description:	Read the pending inotify events, and return true if
+//		any of them is for a file or directory being watched.
+//----------------------------------------------------------------------
+
+bool
+ConfigWatcher::readEvents()
+{
+#if defined(__linux__)
+	char					buf[4096]
+						__attribute__ ((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event * event;
+	const Watch *			watch;
+	ssize_t					len;
+	ssize_t					i;
+	size_t					j;
+	bool					result;
+
+	result = false;
+	while ((len = read(m_fd, buf, sizeof(buf))) > 0) {
+		for (i = 0; i < len; i += sizeof(struct inotify_event) + event->len) {
+			event = (const struct inotify_event *)(buf + i);
+			if (event->mask & IN_Q_OVERFLOW) {
+				result = true;
+				continue;
+			}
+			watch = 0;
+			for (j = 0; j < m_watches.size(); j++) {
+				if (m_watches[j].wd == event->wd) {
+					watch = &m_watches[j];
+					break;
+				}
+			}
+			if (watch == 0) {
+				continue; // a watch that rewatch() removed
+			}
+			if (event->mask & SELF_EVENTS) {
+				result = true;
+				continue;
+			}
+			if (event->len == 0) {
+				continue;
+			}
+			if (watch->isGlobbed && (event->mask & ENTRY_EVENTS)) {
+				result = true;
+			} else if (std::find(watch->baseNames.begin(),
+								 watch->baseNames.end(), event->name)
+					   != watch->baseNames.end())
+			{
+				result = true;
+			}
+		}
+	}
+	return result;
+#else
+	return false;
+#endif
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	stampsChanged()
+//
+// Description:	Check whether any polled file or globbed directory
+//		has changed, and remember its new timestamp if so.
+//		What is in a directory that inotify watches is not
+//		polled.
+//----------------------------------------------------------------------
+
+bool
+ConfigWatcher::stampsChanged()
+{
+	Stamp					stamp;
+	size_t					i;
+	bool					result;
+
+	result = false;
+	for (i = 0; i < m_stamps.size(); i++) {
+		if (m_watches[m_stamps[i].watch].wd != -1) {
+			continue;
+		}
+		stamp.exists = getFileStamp(m_stamps[i].fileName.c_str(),
+									stamp.mtime, stamp.size);
+		if (stamp.exists != m_stamps[i].exists
+			|| (stamp.exists && (stamp.mtime != m_stamps[i].mtime
+								 || stamp.size != m_stamps[i].size)))
+		{
+			m_stamps[i].exists = stamp.exists;
+			m_stamps[i].mtime = stamp.mtime;
+			m_stamps[i].size = stamp.size;
+			result = true;
+		}
+	}
+	return result;
+}
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
@@ -33,6 +33,7 @@
 #include <string.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <wchar.h>
 
 
 namespace CONFIG4CPP_NAMESPACE {
@@ -76,6 +77,60 @@ Configuration::mergeNames(
 
 
 
+//----------------------------------------------------------------------
+// Function:	Key::Key()
+//
+// Description:	Merge scope and localName, split the result at each
+//		"." and hash each segment, so that lookups using the Key
+//		do not have to.
+//
+// Notes:	A leading "." restricts the lookup to the root scope,
+//		in the same way as it does for a fully-scoped name.
+//----------------------------------------------------------------------
+
+Configuration::Key::Key()
+	: m_isAbsolute(false)
+{
+}
+
+
+
+Configuration::Key::Key(const char * scope, const char * localName)
+	: m_scope(scope), m_localName(localName), m_isAbsolute(false)
+{
+	StringBuffer		fullyScopedName;
+	const char *		name;
+	int					len;
+	int					i;
+	int					start;
+
+	mergeNames(scope, localName, fullyScopedName);
+	m_fullyScopedName = fullyScopedName.c_str();
+	name = m_fullyScopedName.c_str();
+	if (name[0] == '\0') {
+		return;
+	}
+	if (name[0] == '.') {
+		m_isAbsolute = true;
+		name ++;
+	}
+
+	m_segmentChars = name;
+	len = (int)m_segmentChars.length();
+	start = 0;
+	for (i = 0; i <= len; i++) {
+		if (i == len || m_segmentChars[i] == '.') {
+			m_segmentChars[i] = '\0';
+			m_segmentOffsets.push_back(start);
+			m_segmentHashes.push_back(
+					ConfigScope::hash(m_segmentChars.c_str() + start));
+			start = i + 1;
+		}
+	}
+}
+
+
+
 int
 Configuration::mbstrlen(const char * str)
 {
@@ -174,11 +229,6 @@ isAsciiPattern(const char * str, int & numWildcards, int & len)
 bool
 Configuration::patternMatch(const char * str, const char * pattern)
 {
-	wchar_t *				wStr;
-	int						wStrLen;
-	wchar_t *				wPattern;
-	int						wPatternLen;
-	bool					result;
 	int						strLen;
 	int						patternLen;
 	int						numWildcards;
@@ -206,14 +256,14 @@ Configuration::patternMatch(const char * str, const char * pattern)
 				// str ends in "foo".
 				//--------
 				suffix = str + (strLen - (patternLen - 1));
-				return (strLen >= patternLen)
+				return (strLen >= patternLen - 1)
 					&& (strcmp(suffix, pattern+1) == 0);
 			} else if (pattern[patternLen-1] == '*') {
 				//--------
 				// The pattern is of the form "foo*". We have a match if
 				// str starts with "foo".
 				//--------
-				return (strLen >= patternLen)
+				return (strLen >= patternLen - 1)
 					&& (strncmp(str, pattern, patternLen-1) == 0);
 			} else {
 				return asciiPatternMatchInternal(str, 0, strLen,
@@ -230,7 +280,7 @@ Configuration::patternMatch(const char * str, const char * pattern)
 
 				buf << (pattern+1);
 				buf.deleteLastChar();
-				return (strLen >= patternLen)
+				return (strLen >= patternLen - 2)
 					&& (strstr(str, buf.c_str()) != 0);
 			} else {
 				return asciiPatternMatchInternal(str, 0, strLen,
@@ -243,65 +293,240 @@ Configuration::patternMatch(const char * str, const char * pattern)
 		}
 	} else {
 		//--------
-		// We have non-ASCII characters, so we need to convert str and pattern
-		// into wide characters and pattern-match them.
+		// We have non-ASCII characters, so we need to pattern-match
+		// the (wide) characters that str and pattern decode to.
 		//--------
-		wStr = new wchar_t[strLen + 1];
-		wStrLen = mbstowcs(wStr, str, strLen + 1);
-		assert(wStrLen != -1);
-
-		wPattern = new wchar_t[patternLen + 1];
-		wPatternLen = mbstowcs(wPattern, pattern, patternLen + 1);
-		assert(wPatternLen != -1);
-
-		result = patternMatchInternal(wStr, 0, wStrLen,
-							wPattern, 0, wPatternLen);
-		delete [] wStr;
-		delete [] wPattern;
-		return result;
+		return patternMatchInternal(str, pattern);
 	}
 }
 
 
+
 bool
-Configuration::patternMatchInternal(
-	const wchar_t *			wStr,
-	int						wStrIndex,
-	int						wStrLen,
-	const wchar_t *			wPattern,
-	int						wPatternIndex,
-	int						wPatternLen)
+Configuration::patternMatch(const char * str, const Pattern & pattern)
 {
-	while (wPatternIndex < wPatternLen) {
-		if (wPattern[wPatternIndex] != '*') {
-			if (wPattern[wPatternIndex] != wStr[wStrIndex]) {
-				return false;
-			}
-			wPatternIndex++;
-			if (wStrIndex < wStrLen) {
-				wStrIndex++;
-			}
-		} else {
-			wPatternIndex++;
-			while (wPattern[wPatternIndex] == '*') {
-				wPatternIndex++;
-			}
-			if (wPatternIndex == wPatternLen) {
-				return true;
+	return pattern.matches(str);
+}
+
+
+
+//----------------------------------------------------------------------
+// Class:	MBCursor
+//
+// Description:	Decodes a nul-terminated multi-byte string one wide
+//		character at a time, so that it can be pattern-matched
+//		without first being copied into a wide-character buffer.
+//		A cursor can be copied to remember a position, along with
+//		the shift state at that position.
+//
+// Notes:	An invalid byte sequence is decoded as the value of its
+//		first byte, and so can be matched only by the same bytes.
+//----------------------------------------------------------------------
+
+class MBCursor
+{
+public:
+	MBCursor(const char * str)
+		: m_ptr(str)
+	{
+		memset(&m_mbtowcState, 0, sizeof(m_mbtowcState));
+	}
+
+	bool atEnd() const { return *m_ptr == '\0'; }
+
+	wchar_t next()
+	{
+		wchar_t				wChar;
+		size_t				status;
+
+		status = mbrtowc(&wChar, m_ptr, MB_CUR_MAX, &m_mbtowcState);
+		if (status == (size_t)-1 || status == (size_t)-2 || status == 0) {
+			wChar = (unsigned char)*m_ptr;
+			status = 1;
+			memset(&m_mbtowcState, 0, sizeof(m_mbtowcState));
+		}
+		m_ptr += status;
+		return wChar;
+	}
+
+private:
+	const char *		m_ptr;
+	mbstate_t			m_mbtowcState;
+};
+
+
+
+//----------------------------------------------------------------------
+// Function:	patternMatchInternal()
+//
+// Description:	Match a multi-byte str against a multi-byte pattern.
+//
+// Notes:	After a mismatch, the match resumes just after the most
+//		recent "*", which is made to cover one more character of
+//		str.  Earlier "*"s never need to be revisited, so the
+//		worst case is proportional to the length of str times the
+//		length of pattern.
+//----------------------------------------------------------------------
+
+bool
+Configuration::patternMatchInternal(const char * str, const char * pattern)
+{
+	MBCursor				s(str);
+	MBCursor				p(pattern);
+	MBCursor				sNext(str);
+	MBCursor				pNext(pattern);
+	MBCursor				starS(str);
+	MBCursor				starP(pattern);
+	bool					haveStar;
+	wchar_t					patternChar;
+
+	haveStar = false;
+	while (!s.atEnd()) {
+		pNext = p;
+		patternChar = p.atEnd() ? L'\0' : pNext.next();
+		if (patternChar == L'*') {
+			p = pNext;
+			haveStar = true;
+			starP = p;
+			starS = s;
+			continue;
+		}
+		sNext = s;
+		if (!p.atEnd() && patternChar == sNext.next()) {
+			p = pNext;
+			s = sNext;
+			continue;
+		}
+		if (!haveStar) {
+			return false;
+		}
+		starS.next();
+		s = starS;
+		p = starP;
+	}
+	while (!p.atEnd()) {
+		if (p.next() != L'*') {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	Pattern::Pattern()
+//
+// Description:	Split an ASCII pattern into the literal text between
+//		its "*" wildcards.  Adjacent wildcards are treated as one.
+//----------------------------------------------------------------------
+
+Configuration::Pattern::Pattern()
+	: m_numWildcards(0), m_isAscii(true)
+{
+	m_literalOffsets.push_back(0);
+	m_literalLengths.push_back(0);
+	m_literalChars.push_back('\0');
+}
+
+
+
+Configuration::Pattern::Pattern(const char * pattern)
+	: m_pattern(pattern), m_numWildcards(0), m_isAscii(true)
+{
+	int					len;
+	int					i;
+	int					start;
+
+	m_isAscii = isAsciiPattern(pattern, m_numWildcards, len);
+	if (!m_isAscii) {
+		MBCursor		cursor(pattern);
+
+		m_numWildcards = 0;
+		while (!cursor.atEnd()) {
+			if (cursor.next() == L'*') {
+				m_numWildcards ++;
 			}
-			for (; wStrIndex < wStrLen; wStrIndex++) {
-				if (patternMatchInternal(wStr, wStrIndex,
-					wStrLen, wPattern, wPatternIndex,
-					wPatternLen))
-				{
-					return true;
-				}
+		}
+		return;
+	}
+
+	start = 0;
+	for (i = 0; i <= len; i++) {
+		if (i == len || pattern[i] == '*') {
+			m_literalOffsets.push_back((int)m_literalChars.length());
+			m_literalLengths.push_back(i - start);
+			m_literalChars.append(pattern + start, i - start);
+			m_literalChars.push_back('\0');
+			while (i + 1 < len && pattern[i + 1] == '*') {
+				i ++;
 			}
+			start = i + 1;
 		}
 	}
-	if (wPattern[wPatternIndex] != wStr[wStrIndex]) {
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	Pattern::matches()
+//
+// Description:	Returns true if the pattern matches str.
+//
+// Notes:	For ASCII, the first literal must be a prefix of str
+//		and the last one a suffix.  Each literal in between is
+//		matched at the earliest position after the previous one:
+//		if there is any match, there is one that uses the
+//		earliest positions.
+//----------------------------------------------------------------------
+
+bool
+Configuration::Pattern::matches(const char * str) const
+{
+	int					strLen;
+	int					numLiterals;
+	int					firstLen;
+	int					lastLen;
+	int					len;
+	int					i;
+	const char *		literal;
+	const char *		pos;
+	const char *		end;
+
+	if (!m_isAscii || !isAsciiStr(str, strLen)) {
+		return patternMatchInternal(str, m_pattern.c_str());
+	}
+
+	numLiterals = (int)m_literalOffsets.size();
+	firstLen = m_literalLengths[0];
+	if (numLiterals == 1) {
+		return strLen == firstLen && strcmp(str, m_literalChars.c_str()) == 0;
+	}
+	lastLen = m_literalLengths[numLiterals - 1];
+	if (strLen < firstLen + lastLen
+		|| memcmp(str, m_literalChars.c_str(), firstLen) != 0
+		|| memcmp(str + strLen - lastLen,
+				  m_literalChars.c_str() + m_literalOffsets[numLiterals - 1],
+				  lastLen) != 0)
+	{
 		return false;
 	}
+
+	pos = str + firstLen;
+	end = str + strLen - lastLen;
+	for (i = 1; i < numLiterals - 1; i++) {
+		literal = m_literalChars.c_str() + m_literalOffsets[i];
+		len = m_literalLengths[i];
+		for (; pos + len <= end; pos++) {
+			if (*pos == *literal && memcmp(pos, literal, len) == 0) {
+				break;
+			}
+		}
+		if (pos + len > end) {
+			return false;
+		}
+		pos += len;
+	}
 	return true;
 }
 
@@ -31,14 +31,25 @@
 #include "platform.h"
 #include "DefaultSecurityConfiguration.h"
 #include "ConfigParser.h"
+#include "ConfigBinary.h"
+#include "SourceFileTable.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <ctype.h>
+#include <atomic>
+#include <utility>
 
 
 namespace CONFIG4CPP_NAMESPACE {
 
+//--------
+// The source of generation numbers, shared by every configuration, so
+// that a number is never reused even when a fallback or override
+// configuration is replaced by one with a lower count of changes.
+//--------
+static std::atomic<unsigned long> g_lastGeneration(0);
+
 //----------------------------------------------------------------------
 // Function:	Constructor
 //
@@ -46,15 +57,18 @@ namespace CONFIG4CPP_NAMESPACE {
 //----------------------------------------------------------------------
 
 ConfigurationImpl::ConfigurationImpl()
+	: m_strings(m_arena)
 {
 	m_fileName             = "<no file>";
-	m_rootScope            = new ConfigScope(0, "");
+	m_rootScope            = new (m_arena) ConfigScope(&m_strings);
 	m_currScope            = m_rootScope;
 	m_fallbackCfg          = 0;
 	m_overrideCfg          = 0;
 	m_amOwnerOfFallbackCfg = false;
 	m_amOwnerOfOverrideCfg = false;
 	m_amOwnerOfSecurityCfg = false;
+	m_isFrozen             = false;
+	m_generation           = 0;
 	m_securityCfg          = &DefaultSecurityConfiguration::singleton;
 }
 
@@ -68,7 +82,9 @@ ConfigurationImpl::ConfigurationImpl()
 
 ConfigurationImpl::~ConfigurationImpl()
 {
-	delete m_rootScope;
+	//--------
+	// m_rootScope and everything in it are freed with m_arena.
+	//--------
 	if (m_amOwnerOfSecurityCfg) {
 		m_securityCfg->destroy();
 	}
@@ -85,11 +101,13 @@ ConfigurationImpl::~ConfigurationImpl()
 void
 ConfigurationImpl::setFallbackConfiguration(Configuration * cfg)
 {
+	checkNotFrozen("setFallbackConfiguration");
 	if (m_amOwnerOfFallbackCfg) {
 		m_fallbackCfg->destroy();
 	}
 	m_fallbackCfg = static_cast<ConfigurationImpl *>(cfg);
 	m_amOwnerOfFallbackCfg = false;
+	noteChange();
 }
 
 
@@ -97,11 +115,13 @@ ConfigurationImpl::setFallbackConfiguration(Configuration * cfg)
 void
 ConfigurationImpl::setOverrideConfiguration(Configuration * cfg)
 {
+	checkNotFrozen("setOverrideConfiguration");
 	if (m_amOwnerOfOverrideCfg) {
 		m_overrideCfg->destroy();
 	}
 	m_overrideCfg = static_cast<ConfigurationImpl *>(cfg);
 	m_amOwnerOfOverrideCfg = false;
+	noteChange();
 }
 
 
@@ -115,6 +135,8 @@ ConfigurationImpl::setFallbackConfiguration(
 	Configuration *				cfg;
 	StringBuffer				msg;
 
+	checkNotFrozen("setFallbackConfiguration");
+
 	cfg = Configuration::create();
 	try {
 		cfg->parse(sourceType, source, sourceDescription);
@@ -129,6 +151,7 @@ ConfigurationImpl::setFallbackConfiguration(
 	}
 	m_fallbackCfg = static_cast<ConfigurationImpl *>(cfg);
 	m_amOwnerOfFallbackCfg = true;
+	noteChange();
 }
 
 
@@ -142,6 +165,8 @@ ConfigurationImpl::setOverrideConfiguration(
 	Configuration *				cfg;
 	StringBuffer				msg;
 
+	checkNotFrozen("setOverrideConfiguration");
+
 	cfg = Configuration::create();
 	try {
 		cfg->parse(sourceType, source, sourceDescription);
@@ -156,6 +181,7 @@ ConfigurationImpl::setOverrideConfiguration(
 	}
 	m_overrideCfg = static_cast<ConfigurationImpl *>(cfg);
 	m_amOwnerOfOverrideCfg = true;
+	noteChange();
 }
 
 
@@ -176,6 +202,81 @@ ConfigurationImpl::getOverrideConfiguration()
 
 
 
+//----------------------------------------------------------------------
+// Function:	freeze()
+//
+// Description:	Return a deep copy that cannot be updated.
+//
+// Notes:	The fallback and override configurations are frozen
+//		too, and owned by the copy, so later changes to them do
+//		not show through. A security configuration that this
+//		object does not own is shared, as it is by this object.
+//----------------------------------------------------------------------
+
+Configuration *
+ConfigurationImpl::freeze() const
+{
+	ConfigurationImpl *		result;
+	StringVector			fileNames;
+	StringVector			dirNames;
+	int						i;
+
+	result = new ConfigurationImpl();
+	result->m_fileName = m_fileName;
+	result->m_rootScope->copyContents(*m_rootScope);
+	result->m_call = m_call;
+	m_journal.getDependencies(fileNames, dirNames);
+	for (i = 0; i < fileNames.length(); i++) {
+		result->m_journal.addDependency(fileNames[i]);
+	}
+	for (i = 0; i < dirNames.length(); i++) {
+		result->m_journal.addDirectory(dirNames[i]);
+	}
+	if (m_fallbackCfg != 0) {
+		result->m_fallbackCfg =
+				static_cast<ConfigurationImpl *>(m_fallbackCfg->freeze());
+		result->m_amOwnerOfFallbackCfg = true;
+	}
+	if (m_overrideCfg != 0) {
+		result->m_overrideCfg =
+				static_cast<ConfigurationImpl *>(m_overrideCfg->freeze());
+		result->m_amOwnerOfOverrideCfg = true;
+	}
+	if (m_amOwnerOfSecurityCfg) {
+		result->m_securityCfg = m_securityCfg->freeze();
+		result->m_amOwnerOfSecurityCfg = true;
+	} else {
+		result->m_securityCfg = m_securityCfg;
+	}
+	result->m_securityCfgScope = m_securityCfgScope;
+	result->m_isFrozen = true;
+	return result;
+}
+
+
+
+bool
+ConfigurationImpl::isFrozen() const
+{
+	return m_isFrozen;
+}
+
+
+
+void
+ConfigurationImpl::checkNotFrozen(const char * operationName) const
+{
+	StringBuffer			msg;
+
+	if (m_isFrozen) {
+		msg << fileName() << ": " << operationName
+			<< "() cannot be used on a frozen configuration";
+		throw ConfigurationException(msg.c_str());
+	}
+}
+
+
+
 void
 ConfigurationImpl::setSecurityConfiguration(
 	Configuration *			cfg,
@@ -185,6 +286,8 @@ ConfigurationImpl::setSecurityConfiguration(
 	StringVector			dummyList;
 	StringBuffer			msg;
 
+	checkNotFrozen("setSecurityConfiguration");
+
 	try {
 		cfg->lookupList(scope, "allow_patterns", dummyList);
 		cfg->lookupList(scope, "deny_patterns", dummyList);
@@ -211,6 +314,8 @@ ConfigurationImpl::setSecurityConfiguration(
 	StringVector			dummyList;
 	StringBuffer			msg;
 
+	checkNotFrozen("setSecurityConfiguration");
+
 	cfg = Configuration::create();
 	try {
 		cfg->parse(cfgInput);
@@ -260,11 +365,16 @@ ConfigurationImpl::parse(
 	StringBuffer				trustedCmdLine;
 	StringBuffer				msg;
 
+	checkNotFrozen("parse");
+	noteChange();
+
 	switch (sourceType) {
 	case Configuration::INPUT_FILE:
 		m_fileName = source;
+		m_journal.addTopLevelFile(source);
 		break;
 	case Configuration::INPUT_STRING:
+		m_journal.invalidate();
 		if (strcmp(sourceDescription, "") == 0) {
 			m_fileName = "<string-based configuration>";
 		} else {
@@ -272,6 +382,7 @@ ConfigurationImpl::parse(
 		}
 		break;
 	case Configuration::INPUT_EXEC:
+		m_journal.invalidate();
 		if (strcmp(sourceDescription, "") == 0) {
 			m_fileName.empty();
 			m_fileName << "exec#" << source;
@@ -284,12 +395,293 @@ ConfigurationImpl::parse(
 			throw ConfigurationException(msg.c_str());
 		}
 		break;
+	case Configuration::INPUT_BINARY:
+		//--------
+		// A precompiled configuration holds already-parsed
+		// entries, so add them directly.
+		//--------
+		m_journal.invalidate();
+		m_journal.addDependency(source);
+		m_fileName = source;
+		ConfigBinary::read(source, m_rootScope, m_uidIdentifierProcessor);
+		return;
 	default:
 		assert(0); // Bug!
 		break;
 	}
-	ConfigParser parser(sourceType, source, trustedCmdLine.c_str(),
-	                    m_fileName.c_str(), this);
+	try {
+		ConfigParser parser(sourceType, source, trustedCmdLine.c_str(),
+		                    m_fileName.c_str(), this);
+	} catch (const ConfigurationException &) {
+		m_journal.markIncomplete();
+		throw;
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	reparseChanged()
+//
+// Description:	Bring the configuration up to date with the files
+//		that parse() read. Returns false if none has changed.
+//
+// Notes:	If the set of files is the same, no file depends on
+//		what others assigned, and each changed file is
+//		standalone, then only the changed files are parsed
+//		again. Otherwise, every file is.
+//----------------------------------------------------------------------
+
+bool
+ConfigurationImpl::reparseChanged()
+{
+	std::vector<int>			changed;
+	StringBuffer				msg;
+
+	checkNotFrozen("reparseChanged");
+	if (!m_journal.isValid() || m_journal.topLevelFiles().length() == 0) {
+		msg << fileName() << ": reparseChanged() can be used only on a "
+			<< "configuration built entirely by parsing files";
+		throw ConfigurationException(msg.c_str());
+	}
+	if (!m_journal.isComplete() || !m_journal.findChangedFiles(changed)) {
+		noteChange();
+		reparseAll();
+		return true;
+	}
+	if (changed.empty()) {
+		return false;
+	}
+	noteChange();
+	if (!replayChangedFiles(changed)) {
+		reparseAll();
+	}
+	return true;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	listDependencies()
+//
+// Description:	The files that parse() read, and the directories in
+//		which @include matched files with a glob pattern.
+//----------------------------------------------------------------------
+
+void
+ConfigurationImpl::listDependencies(
+	StringVector &				fileNames,
+	StringVector &				dirNames) const
+{
+	m_journal.getDependencies(fileNames, dirNames);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	reparseAll()
+//
+// Description:	Parse the configuration's files again, from scratch.
+//
+// Notes:	The files are parsed into a scratch configuration,
+//		which borrows the security, fallback and override
+//		configurations without owning them, so "?=" and
+//		references see what the first parse saw. It replaces
+//		the contents of this one only if every file parses.
+//		Otherwise, the exception leaves this one as it was,
+//		so a bad edit does not lose a working configuration,
+//		and the files are tried again next time.
+//----------------------------------------------------------------------
+
+void
+ConfigurationImpl::reparseAll()
+{
+	ConfigurationImpl			scratch;
+	StringVector				files;
+	int							i;
+
+	scratch.m_securityCfg = m_securityCfg;
+	scratch.m_securityCfgScope = m_securityCfgScope;
+	scratch.m_call = m_call;
+	scratch.m_fallbackCfg = m_fallbackCfg;
+	scratch.m_overrideCfg = m_overrideCfg;
+	files = m_journal.topLevelFiles();
+	for (i = 0; i < files.length(); i++) {
+		scratch.parse(Configuration::INPUT_FILE, files[i]);
+	}
+	swapContents(scratch);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	swapContents()
+//
+// Description:	Exchange entries, and the journal that describes
+//		them, with other.
+//
+// Notes:	The entries stay where they are in memory; only the
+//		arenas that own them are swapped, so each scope must
+//		be told which pool and arena it now belongs to. The
+//		"uid-" count must cover the names in both sets of
+//		entries, so later parses do not reuse one.
+//----------------------------------------------------------------------
+
+void
+ConfigurationImpl::swapContents(ConfigurationImpl & other)
+{
+	StringBuffer				fileName;
+
+	m_arena.swap(other.m_arena);
+	m_strings.swap(other.m_strings);
+	std::swap(m_rootScope, other.m_rootScope);
+	m_rootScope->setStringPool(&m_strings);
+	other.m_rootScope->setStringPool(&other.m_strings);
+	m_currScope = m_rootScope;
+	other.m_currScope = other.m_rootScope;
+	m_journal.swap(other.m_journal);
+	m_uidIdentifierProcessor.ensureCountIsAtLeast(
+					other.m_uidIdentifierProcessor.count());
+	fileName = m_fileName;
+	m_fileName = other.m_fileName;
+	other.m_fileName = fileName;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	replayChangedFiles()
+//
+// Description:	Apply the new contents of the changed files in place.
+//		Returns false if a full parse is needed instead.
+//
+// Notes:	A file can be replayed on its own only if what it
+//		assigns does not depend on anything else, and nothing
+//		else depends on what it assigns.
+//----------------------------------------------------------------------
+
+bool
+ConfigurationImpl::replayChangedFiles(const std::vector<int> & changed)
+{
+	size_t						i;
+
+	if (m_journal.isStateDependent()) {
+		return false;
+	}
+	for (i = 0; i < changed.size(); i++) {
+		if (!m_journal.isStandalone(changed[i])) {
+			return false;
+		}
+	}
+	for (i = 0; i < changed.size(); i++) {
+		if (!replayFile(changed[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	replayFile()
+//
+// Description:	Replace the assignments made by the specified file
+//		with those in its new contents. Returns false if a
+//		full parse is needed instead.
+//
+// Notes:	The new assignments are spliced in at the file's
+//		position, so files parsed after it still override it,
+//		and a name it no longer assigns reverts to the value
+//		given by an earlier file, if any.
+//----------------------------------------------------------------------
+
+bool
+ConfigurationImpl::replayFile(int index)
+{
+	ConfigurationImpl						scratch;
+	std::vector<ParseJournal::Assignment>	assignments;
+	std::vector<ParseJournal::Assignment>	block;
+	std::vector<ParseJournal::Assignment>	oldBlock;
+	std::vector<ParseJournal::Change>		changes;
+	std::vector<std::string>				oldScopes;
+	std::vector<std::string>				newScopes;
+	ParseJournal::Assignment				assignment;
+	ConfigItem *							existing;
+	ConfigItem *							item;
+	ConfigScope *							scope;
+	const char *							scopedName;
+	size_t									i;
+
+	//--------
+	// Parse the new contents on their own. That gives the same
+	// assignments as parsing them in place if they are standalone,
+	// use no state, and include nothing.
+	//--------
+	try {
+		scratch.parse(Configuration::INPUT_FILE, m_journal.fileName(index));
+	} catch (const ConfigurationException &) {
+		return false;
+	}
+	if (scratch.m_journal.numFiles() != 1
+		|| !scratch.m_journal.isStandalone(0)
+		|| scratch.m_journal.isStateDependent())
+	{
+		return false;
+	}
+
+	//--------
+	// A file that now opens different scopes might create or
+	// orphan some, which only a full parse gets right.
+	//--------
+	m_journal.getScopeNames(index, oldScopes);
+	scratch.m_journal.getScopeNames(0, newScopes);
+	if (oldScopes != newScopes) {
+		return false;
+	}
+
+	//--------
+	// Copy the new assignments into the corresponding scopes. All
+	// of these scopes exist already, since the file opened them.
+	//--------
+	scratch.m_journal.getAssignments(0, assignments);
+	for (i = 0; i < assignments.size(); i++) {
+		scopedName = assignments[i].scope->scopedName();
+		if (scopedName[0] == '\0') {
+			scope = m_rootScope;
+		} else {
+			ensureScopeExists(scopedName, scope);
+		}
+		item = assignments[i].item;
+		existing = scope->findItem(item->name());
+		if (existing != 0 && existing->type() == Configuration::CFG_SCOPE) {
+			return false;
+		}
+		assignment.scope = scope;
+		assignment.item = scope->copyItem(item);
+		block.push_back(assignment);
+	}
+
+	//--------
+	// Splice them into the journal, and make each affected name
+	// refer to its last assignment, if it still has one. The
+	// file's old assignments are then referred to by nothing, so
+	// their large blocks can be given back.
+	//--------
+	m_journal.getAssignments(index, oldBlock);
+	m_journal.replaceFile(index, scratch.m_journal, block, changes);
+	for (i = 0; i < changes.size(); i++) {
+		scope = changes[i].scope;
+		if (changes[i].item == 0) {
+			scope->removeItem(changes[i].name);
+		} else if (scope->findItem(changes[i].name) != changes[i].item) {
+			scope->addOrReplaceItem(changes[i].item);
+		}
+	}
+	for (i = 0; i < oldBlock.size(); i++) {
+		oldBlock[i].scope->releaseItem(oldBlock[i].item);
+	}
+	return true;
 }
 
 
@@ -385,6 +777,9 @@ ConfigurationImpl::listValue(
 		Configuration::Type &	type) const
 {
 	ConfigItem *				item;
+	const char **				array;
+	int							arraySize;
+	int							i;
 	
 	item = lookup(fullyScopedName, localName, false, true);
 	if (item == 0) {
@@ -393,7 +788,12 @@ ConfigurationImpl::listValue(
 	} else {
 		type = item->type();
 		if (type == Configuration::CFG_LIST) {
-			list = item->listVal();
+			item->listVal(array, arraySize);
+			list.empty();
+			list.ensureCapacity(arraySize);
+			for (i = 0; i < arraySize; i++) {
+				list.add(array[i]);
+			}
 		} else {
 			list.empty();
 		}
@@ -417,7 +817,6 @@ ConfigurationImpl::listValue(
 	Configuration::Type &	type) const
 {
 	ConfigItem *			item;
-	StringVector *			list;
 	
 	item = lookup(fullyScopedName, localName, false, true);
 	if (item == 0) {
@@ -427,8 +826,7 @@ ConfigurationImpl::listValue(
 	} else {
 		type = item->type();
 		if (type == Configuration::CFG_LIST) {
-			list = &item->listVal();
-			list->c_array(array, arraySize);
+			item->listVal(array, arraySize);
 		} else {
 			array = 0;
 			arraySize  = 0;
@@ -438,6 +836,66 @@ ConfigurationImpl::listValue(
 
 
 
+//----------------------------------------------------------------------
+// Function:	stringItem()
+//
+// Description:	Return the item that holds the named string, or 0 if
+//		there is no such item and isRequired is false. Throw an
+//		exception if the name refers to something other than a
+//		string, or is missing and isRequired is true.
+//----------------------------------------------------------------------
+
+ConfigItem *
+ConfigurationImpl::stringItem(
+	const char *			scope,
+	const char *			localName,
+	bool					isRequired) const
+{
+	ConfigItem *			item;
+	StringBuffer			fullyScopedName;
+
+	mergeNames(scope, localName, fullyScopedName);
+	item = lookup(fullyScopedName.c_str(), localName, false, true);
+	checkStringItem(item, fullyScopedName.c_str(), isRequired);
+	return item;
+}
+
+
+
+void
+ConfigurationImpl::checkStringItem(
+	ConfigItem *			item,
+	const char *			fullyScopedName,
+	bool					isRequired) const
+{
+	StringBuffer			msg;
+
+	if (item == 0) {
+		if (isRequired) {
+			msg << fileName() << ": no value specified for '"
+				<< fullyScopedName << "'";
+			throw ConfigurationException(msg.c_str());
+		}
+		return;
+	}
+	switch (item->type()) {
+	case Configuration::CFG_STRING:
+		break;
+	case Configuration::CFG_SCOPE:
+		msg << fileName() << ": '" << fullyScopedName
+			<< "' is a scope instead of a string";
+		throw ConfigurationException(msg.c_str());
+	case Configuration::CFG_LIST:
+		msg << fileName() << ": '" << fullyScopedName
+			<< "' is a list instead of a string";
+		throw ConfigurationException(msg.c_str());
+	default:
+		assert(0);	// Bug
+	}
+}
+
+
+
 //----------------------------------------------------------------------
 // Function:	insertString()
 //
@@ -455,20 +913,26 @@ ConfigurationImpl::insertString(
 	StringVector			vec;
 	int						len;
 	ConfigScope *			scopeObj;
+	ConfigItem *			replaced;
 	StringBuffer			msg;
 	StringBuffer			fullyScopedName;
+
+	checkNotFrozen("insertString");
+	noteChange();
+	m_journal.invalidate();
 	
 	mergeNames(scope, localName, fullyScopedName);
 	splitScopedNameIntoVector(fullyScopedName.c_str(), vec);
 	len = vec.length();
 	ensureScopeExists(vec, 0, len-2, scopeObj);
-	if (!scopeObj->addOrReplaceString(vec[len-1], str)) {
+	if (!scopeObj->addOrReplaceString(vec[len-1], str, &replaced)) {
 		msg << fileName() << ": "
 		    << "variable '"
 		    << fullyScopedName
 		    << "' was previously used as a scope";
 		throw ConfigurationException(msg.c_str());
 	}
+	releaseItem(scopeObj, replaced);
 }
 
 
@@ -486,6 +950,10 @@ ConfigurationImpl::ensureScopeExists(
 {
 	StringBuffer			fullyScopedName;
 	ConfigScope *			dummyScope;
+
+	checkNotFrozen("ensureScopeExists");
+	noteChange();
+	m_journal.invalidate();
 	
 	mergeNames(scope, localName, fullyScopedName);
 	ensureScopeExists(fullyScopedName.c_str(), dummyScope);
@@ -511,18 +979,26 @@ ConfigurationImpl::insertList(
 	StringVector			vec;
 	int						len;
 	ConfigScope *			scopeObj;
+	ConfigItem *			replaced;
 	StringBuffer			msg;
 	StringBuffer			fullyScopedName;
+
+	checkNotFrozen("insertList");
+	noteChange();
+	m_journal.invalidate();
 	
 	mergeNames(scope, localName, fullyScopedName);
 	splitScopedNameIntoVector(fullyScopedName.c_str(), vec);
 	len = vec.length();
 	ensureScopeExists(vec, 0, len-2, scopeObj);
-	if (!scopeObj->addOrReplaceList(vec[len-1], array, arraySize)) {
+	if (!scopeObj->addOrReplaceList(vec[len-1], array, arraySize,
+									&replaced))
+	{
 		msg << fileName() << ": " << "variable '" << fullyScopedName
 			<< "' was previously used as a scope";
 		throw ConfigurationException(msg.c_str());
 	}
+	releaseItem(scopeObj, replaced);
 }
 
 
@@ -575,10 +1051,50 @@ ConfigurationImpl::insertList(
 
 
 
+//----------------------------------------------------------------------
+// Function:	insertString()
+//
+// Description:	Insert a named string, parsed from the given location,
+//		into the symbol table.
+//
+// Notes:	Overwrites an existing entry of the same name.
+//----------------------------------------------------------------------
+
+void
+ConfigurationImpl::insertString(
+	const char *				name,
+	const char *				str,
+	unsigned int				fileIndex,
+	unsigned int				lineNum)
+{
+	StringVector				vec;
+	int							len;
+	ConfigScope *				scope;
+	ConfigItem *				item;
+	ConfigItem *				replaced;
+	StringBuffer				msg;
+	
+	splitScopedNameIntoVector(name, vec);
+	len = vec.length();
+	ensureScopeExists(vec, 0, len-2, scope);
+	item = scope->addOrReplaceString(vec[len-1], str, &replaced);
+	if (item == 0) {
+		msg << fileName() << ": " << "variable '" << name
+			<< "' was previously used as a scope";
+		throw ConfigurationException(msg.c_str());
+	}
+	item->setLocation(fileIndex, lineNum);
+	m_journal.addAssignment(scope, item);
+	releaseItem(scope, replaced);
+}
+
+
+
 //----------------------------------------------------------------------
 // Function:	insertList()
 //
-// Description:	Insert a named list into the symbol table.
+// Description:	Insert a named list, parsed from the given location,
+//		into the symbol table.
 //
 // Notes:	Overwrites an existing entry of the same name.
 //----------------------------------------------------------------------
@@ -586,21 +1102,30 @@ ConfigurationImpl::insertList(
 void
 ConfigurationImpl::insertList(
 	const char *				name,
-	const StringVector &		list)
+	const char **				array,
+	int							arraySize,
+	unsigned int				fileIndex,
+	unsigned int				lineNum)
 {
 	StringVector				vec;
 	int							len;
 	ConfigScope *				scope;
+	ConfigItem *				item;
+	ConfigItem *				replaced;
 	StringBuffer				msg;
 	
 	splitScopedNameIntoVector(name, vec);
 	len = vec.length();
 	ensureScopeExists(vec, 0, len-2, scope);
-	if (!scope->addOrReplaceList(vec[len-1], list)) {
+	item = scope->addOrReplaceList(vec[len-1], array, arraySize, &replaced);
+	if (item == 0) {
 		msg << fileName() << ": " << "variable '" << name
 			<< "' was previously used as a scope";
 		throw ConfigurationException(msg.c_str());
 	}
+	item->setLocation(fileIndex, lineNum);
+	m_journal.addAssignment(scope, item);
+	releaseItem(scope, replaced);
 }
 
 
@@ -618,9 +1143,14 @@ ConfigurationImpl::remove(const char * scope, const char * localName)
 	StringBuffer			msg;
 	ConfigScope *			scopeObj;
 	ConfigItem *			item;
+	ConfigItem *			removed;
 	StringVector			vec;
 	int						i;
 	int						len;
+
+	checkNotFrozen("remove");
+	noteChange();
+	m_journal.invalidate();
 	
 	scopeObj = m_currScope;
 	mergeNames(scope, localName, fullyScopedName);
@@ -638,27 +1168,94 @@ ConfigurationImpl::remove(const char * scope, const char * localName)
 	}
 	assert(i == len - 1);
 	assert(scopeObj != 0);
-	if (!scopeObj->removeItem(vec[i])) {
+	if (!scopeObj->removeItem(vec[i], &removed)) {
 		msg << fileName() << ": '" << fullyScopedName << "' does not exist'";
 		throw ConfigurationException(msg.c_str());
 	}
+	releaseItem(scopeObj, removed);
 }
 
 
 
 //----------------------------------------------------------------------
-// Function:	empty()
+// Function:	releaseItem()
 //
-// Description:	Re-initialize the configuration object
+// Description:	Give back the large blocks of an item that scope no
+//		longer holds.
+//
+// Notes:	While the journal is valid, reparseChanged() may put a
+//		replaced item back, so it is kept until the journal is
+//		invalidated or the configuration is emptied.
 //----------------------------------------------------------------------
 
 void
-ConfigurationImpl::empty()
+ConfigurationImpl::releaseItem(ConfigScope * scope, ConfigItem * item)
 {
-	delete m_rootScope;
-	m_fileName  = "<no file>";
-	m_rootScope = new ConfigScope(0, "");
-	m_currScope = m_rootScope;
+	if (item != 0 && !m_journal.isValid()) {
+		scope->releaseItem(item);
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	noteChange() and generation()
+//
+// Description:	Every change takes a new number from g_lastGeneration,
+//		so the largest of the numbers of this configuration and
+//		of its fallback and override configurations grows
+//		whenever any of them changes.
+//----------------------------------------------------------------------
+
+void
+ConfigurationImpl::noteChange()
+{
+	m_generation = ++g_lastGeneration;
+}
+
+
+
+unsigned long
+ConfigurationImpl::generation() const
+{
+	unsigned long			result;
+	unsigned long			other;
+
+	result = m_generation;
+	if (m_fallbackCfg != 0) {
+		other = m_fallbackCfg->generation();
+		if (other > result) {
+			result = other;
+		}
+	}
+	if (m_overrideCfg != 0) {
+		other = m_overrideCfg->generation();
+		if (other > result) {
+			result = other;
+		}
+	}
+	return result;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	empty()
+//
+// Description:	Re-initialize the configuration object
+//----------------------------------------------------------------------
+
+void
+ConfigurationImpl::empty()
+{
+	checkNotFrozen("empty");
+	noteChange();
+	m_strings.release();
+	m_arena.release();
+	m_fileName  = "<no file>";
+	m_rootScope = new (m_arena) ConfigScope(&m_strings);
+	m_currScope = m_rootScope;
+	m_journal.reset();
 }
 
 
@@ -675,6 +1272,7 @@ ConfigurationImpl::addCallable(
     int num_args,
     std::function<void(StringBuffer &, StringVector const &)> callable)
 {
+    checkNotFrozen("addCallable");
     m_call[name] = std::make_pair(num_args, std::move(callable));
 }
 
@@ -753,7 +1351,8 @@ ConfigurationImpl::lookup(
 		}
 	}
 	if (m_overrideCfg != 0) {
-		item = m_overrideCfg->lookup(absoluteName.c_str(), localName, true, searchOutwards);
+		item = m_overrideCfg->lookup(absoluteName.c_str(), localName, true,
+		                             searchOutwards);
 		if (item) {
 			return item;
 		}
@@ -766,7 +1365,8 @@ ConfigurationImpl::lookup(
 		scope = scope->parentScope();
 	}
 	if (item == 0 && m_fallbackCfg != 0) {
-		item = m_fallbackCfg->lookup(absoluteName.c_str(), localName, true, searchOutwards);
+		item = m_fallbackCfg->lookup(absoluteName.c_str(), localName, true,
+		                             searchOutwards);
 	}
 	return item;
 }
@@ -799,6 +1399,87 @@ ConfigurationImpl::lookupHelper(
 
 
 
+//----------------------------------------------------------------------
+// Function:	lookup()
+//
+// Description:	As above, but using the segments and hash values that
+//		were computed when the Key was constructed.
+//
+// Notes:	While parsing, m_currScope may be a nested scope, and
+//		lookups in the override or fallback configuration then
+//		need an absolute name that the Key cannot supply. That
+//		rare case is handed to the string-based lookup().
+//----------------------------------------------------------------------
+
+ConfigItem *
+ConfigurationImpl::lookup(
+	const Key &				key,
+	bool					startInRoot,
+	bool					searchOutwards) const
+{
+	ConfigScope *			scope;
+	ConfigItem *			item;
+
+	if (key.numSegments() == 0) {
+		return 0;
+	}
+	if (key.isAbsolute() || startInRoot) {
+		scope = m_rootScope;
+	} else {
+		scope = m_currScope;
+	}
+	if ((m_overrideCfg || m_fallbackCfg) && scope != m_rootScope) {
+		return lookup(key.fullyScopedName(), key.localName(), startInRoot,
+		              searchOutwards);
+	}
+	item = 0;
+	if (m_overrideCfg != 0) {
+		item = m_overrideCfg->lookup(key, true, searchOutwards);
+		if (item) {
+			return item;
+		}
+	}
+	while (scope != 0) {
+		item = lookupHelper(scope, key);
+		if (item != 0 || !searchOutwards) {
+			break;
+		}
+		scope = scope->parentScope();
+	}
+	if (item == 0 && m_fallbackCfg != 0) {
+		item = m_fallbackCfg->lookup(key, true, searchOutwards);
+	}
+	return item;
+}
+
+
+
+ConfigItem *
+ConfigurationImpl::lookupHelper(
+	ConfigScope *			scope,
+	const Key &				key) const
+{
+	int						len;
+	int						i;
+	ConfigItem *			item;
+
+	len = key.numSegments();
+	for (i = 0; i < len - 1; i++) {
+		item = scope->findItem(key.segment(i), key.segmentHash(i));
+		if (item == 0 || item->type() != Configuration::CFG_SCOPE) {
+			return 0;
+		}
+		scope = item->scopeVal();
+		assert(scope != 0);
+	}
+	assert(i == len - 1);
+	assert(scope != 0);
+	item = scope->findItem(key.segment(i), key.segmentHash(i));
+	return item;
+}
+
+
+
 //----------------------------------------------------------------------
 // Function:	dump()
 //
@@ -808,8 +1489,7 @@ ConfigurationImpl::lookupHelper(
 void
 ConfigurationImpl::dump(StringBuffer & buf, bool wantExpandedUidNames) const
 {
-	buf = "";
-	m_rootScope->dump(buf, wantExpandedUidNames);
+	dump(buf, wantExpandedUidNames, false, "", "");
 }
 
 
@@ -826,6 +1506,26 @@ ConfigurationImpl::dump(
 	bool					wantExpandedUidNames,
 	const char *			scope,
 	const char *			localName) const
+{
+	dump(buf, wantExpandedUidNames, false, scope, localName);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	dump()
+//
+// Description:	Generate a "printout" of the specified entry,
+//		optionally noting where each variable was defined.
+//----------------------------------------------------------------------
+
+void
+ConfigurationImpl::dump(
+	StringBuffer &			buf,
+	bool					wantExpandedUidNames,
+	bool					wantLocations,
+	const char *			scope,
+	const char *			localName) const
 {
 	ConfigItem *			item;
 	StringBuffer			msg;
@@ -834,7 +1534,7 @@ ConfigurationImpl::dump(
 	buf = "";
 	mergeNames(scope, localName, fullyScopedName);
 	if (strcmp(fullyScopedName.c_str(), "") == 0) {
-		m_rootScope->dump(buf, wantExpandedUidNames);
+		m_rootScope->dump(buf, wantExpandedUidNames, wantLocations);
 	} else {
 		item = lookup(fullyScopedName.c_str(), localName, true, false);
 		if (item == 0) {
@@ -842,8 +1542,107 @@ ConfigurationImpl::dump(
 				<< "' is not an entry";
 			throw ConfigurationException(msg.c_str());
 		}
-		item->dump(buf, fullyScopedName.c_str(), wantExpandedUidNames);
+		item->dump(buf, fullyScopedName.c_str(), wantExpandedUidNames,
+				   wantLocations);
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	lookupLocation()
+//
+// Description:	Find where the specified variable was last assigned.
+//
+// Notes:	Returns false if that is not known.
+//----------------------------------------------------------------------
+
+bool
+ConfigurationImpl::lookupLocation(
+	const char *			scope,
+	const char *			localName,
+	const char *&			fileName,
+	int &					lineNumber) const
+{
+	ConfigItem *			item;
+	StringBuffer			msg;
+	StringBuffer			fullyScopedName;
+
+	mergeNames(scope, localName, fullyScopedName);
+	item = lookup(fullyScopedName.c_str(), localName, true, false);
+	if (item == 0) {
+		msg << this->fileName() << ": " << "'" << fullyScopedName
+			<< "' is not an entry";
+		throw ConfigurationException(msg.c_str());
+	}
+	if (item->lineNum() == 0) {
+		fileName = "";
+		lineNumber = -1;
+		return false;
+	}
+	fileName = SourceFileTable::fileName(item->fileIndex());
+	lineNumber = (int)item->lineNum();
+	return true;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	writeBinary()
+//
+// Description:	Save the entire contents as a precompiled
+//		configuration.
+//----------------------------------------------------------------------
+
+void
+ConfigurationImpl::writeBinary(const char * fileName) const
+{
+	ConfigBinary::write(m_rootScope, m_uidIdentifierProcessor,
+						m_fileName.c_str(), fileName);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	writeBinaryImage()
+//
+// Description:	Set image to the entire contents, in the precompiled
+//		format.
+//----------------------------------------------------------------------
+
+void
+ConfigurationImpl::writeBinaryImage(std::string & image) const
+{
+	ConfigBinary::write(m_rootScope, m_uidIdentifierProcessor,
+						m_fileName.c_str(), m_fileName.c_str(), image);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	parseBinaryImage()
+//
+// Description:	Add the contents of a precompiled configuration
+//		image, as parse(INPUT_BINARY, ...) does for a file.
+//----------------------------------------------------------------------
+
+void
+ConfigurationImpl::parseBinaryImage(
+	const char *				image,
+	size_t						size,
+	const char *				sourceDescription)
+{
+	checkNotFrozen("parseBinaryImage");
+	noteChange();
+
+	m_journal.invalidate();
+	if (strcmp(sourceDescription, "") == 0) {
+		m_fileName = "<precompiled configuration>";
+	} else {
+		m_fileName = sourceDescription;
 	}
+	ConfigBinary::read(m_fileName.c_str(), image, size, m_rootScope,
+					   m_uidIdentifierProcessor);
 }
 
 
@@ -986,37 +1785,101 @@ ConfigurationImpl::listLocallyScopedNames(
 }
 
 
+
+//----------------------------------------------------------------------
+// Function:	listLocallyScopedItems()
+//
+// Description:	As listLocallyScopedNames(), but also list the item
+//		that each name refers to, and the name with its "uid-"
+//		identifiers unexpanded. Used by SchemaValidator, so
+//		that it need not look up each name again.
+//----------------------------------------------------------------------
+
+void
+ConfigurationImpl::listLocallyScopedItems(
+	const char *				scope,
+	const char *				localName,
+	Type						typeMask,
+	bool						recursive,
+	StringVector &				names,
+	StringVector &				unexpandedNames,
+	std::vector<const ConfigItem *> &	items) const
+{
+	StringBuffer				fullyScopedName;
+	StringBuffer				msg;
+	ConfigItem *				item;
+	ConfigScope *				scopeObj;
+
+	mergeNames(scope, localName, fullyScopedName);
+	if (strcmp(fullyScopedName.c_str(), "") == 0) {
+		scopeObj = m_rootScope;
+	} else {
+		item = lookup(fullyScopedName.c_str(), localName, true, false);
+		if (item == 0 || item->type() != Configuration::CFG_SCOPE) {
+			msg << fileName() << ": " << "'" << fullyScopedName
+				<< "' is not a scope";
+			throw ConfigurationException(msg.c_str());
+		}
+		scopeObj = item->scopeVal();
+	}
+	scopeObj->listLocallyScopedItems(typeMask, recursive, names,
+									 unexpandedNames, items);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	forEach()
+//
+// Description:	Call visitor for each entry, as listFullyScopedNames()
+//		would list it.
+//
+// Notes:	Only this configuration's own entries are visited;
+//		m_fallbackCfg and m_overrideCfg are not consulted.
+//----------------------------------------------------------------------
+
+void
+ConfigurationImpl::forEach(
+	const char *				scope,
+	const char *				localName,
+	Type						typeMask,
+	bool						recursive,
+	const Visitor &				visitor) const
+{
+	StringBuffer				fullyScopedName;
+	StringBuffer				msg;
+	ConfigItem *				item;
+	ConfigScope *				scopeObj;
+
+	mergeNames(scope, localName, fullyScopedName);
+	if (strcmp(fullyScopedName.c_str(), "") == 0) {
+		scopeObj = m_rootScope;
+	} else {
+		item = lookup(fullyScopedName.c_str(), localName, true, false);
+		if (item == 0 || item->type() != Configuration::CFG_SCOPE) {
+			msg << fileName() << ": " << "'" << fullyScopedName
+				<< "' is not a scope";
+			throw ConfigurationException(msg.c_str());
+		}
+		scopeObj = item->scopeVal();
+	}
+	scopeObj->forEach(typeMask, recursive, visitor);
+}
+
+
 const char *
 ConfigurationImpl::lookupString(
 	const char *			scope,
 	const char *			localName,
 	const char *			defaultVal) const
 {
-	Configuration::Type	 	type;
-	StringBuffer			msg;
-	const char *			str;
-	StringBuffer			fullyScopedName;
-	
-	mergeNames(scope, localName, fullyScopedName);
-	stringValue(fullyScopedName.c_str(), localName, str, type);
-	switch (type) {
-	case Configuration::CFG_STRING:
-		break;
-	case Configuration::CFG_NO_VALUE:
-		str = defaultVal;
-		break;
-	case Configuration::CFG_SCOPE:
-		msg << fileName() << ": '" << fullyScopedName
-			<< "' is a scope instead of a string";
-		throw ConfigurationException(msg.c_str());
-	case Configuration::CFG_LIST:
-		msg << fileName() << ": '" << fullyScopedName
-			<< "' is a list instead of a string";
-		throw ConfigurationException(msg.c_str());
-	default:
-		assert(0);	// Bug
+	ConfigItem *			item;
+
+	item = stringItem(scope, localName, false);
+	if (item == 0) {
+		return defaultVal;
 	}
-	return str;
+	return item->stringVal();
 }
 
 
@@ -1026,32 +1889,7 @@ ConfigurationImpl::lookupString(
 	const char *			scope,
 	const char *			localName) const
 {
-	Configuration::Type	 	type;
-	StringBuffer			msg;
-	const char *			str;
-	StringBuffer			fullyScopedName;
-	
-	mergeNames(scope, localName, fullyScopedName);
-	stringValue(fullyScopedName.c_str(), localName, str, type);
-	switch (type) {
-	case Configuration::CFG_STRING:
-		break;
-	case Configuration::CFG_NO_VALUE:
-		msg << fileName() << ": no value specified for '" << fullyScopedName
-			<< "'";
-		throw ConfigurationException(msg.c_str());
-	case Configuration::CFG_SCOPE:
-		msg << fileName() << ": '" << fullyScopedName
-			<< "' is a scope instead of a string";
-		throw ConfigurationException(msg.c_str());
-	case Configuration::CFG_LIST:
-		msg << fileName() << ": " << "'" << fullyScopedName
-			<< "' is a list instead of a string";
-		throw ConfigurationException(msg.c_str());
-	default:
-		assert(0);	// Bug
-	}
-	return str;
+	return stringItem(scope, localName, true)->stringVal();
 }
 
 
@@ -1220,32 +2058,16 @@ ConfigurationImpl::lookupEnum(
 	int 						numEnums,
 	const char *				defaultVal) const
 {
-	const char *				strValue;
-	StringBuffer				msg;
-	int							result;
-	StringBuffer				fullyScopedName;
-	int							i;
-	
-	strValue = lookupString(scope, localName, defaultVal);
+	ConfigItem *				item;
+	int							index;
 
-	//--------
-	// Check if the value matches anything in the enumInfo list.
-	//--------
-	if (!enumVal(strValue, enumInfo, numEnums, result)) {
-		mergeNames(scope, localName, fullyScopedName);
-		msg << fileName() << ": bad " << typeName << " value ('" << strValue
-			<< "') specified for '" << fullyScopedName
-			<< "'; should be one of:";
-		for (i = 0; i < numEnums; i++) {
-			if (i < numEnums-1) {
-				msg << " '" << enumInfo[i].name << "',";
-			} else {
-				msg << " '" << enumInfo[i].name << "'";
-			}
-		}
-		throw ConfigurationException(msg.c_str());
+	item = stringItem(scope, localName, false);
+	if (item == 0) {
+		index = enumIndex(scope, localName, typeName, defaultVal, enumInfo,
+		                  numEnums);
+		return enumInfo[index].value;
 	}
-	return result;
+	return enumValue(item, scope, localName, typeName, enumInfo, numEnums);
 }
 
 
@@ -1259,74 +2081,105 @@ ConfigurationImpl::lookupEnum(
 	int 						numEnums,
 	int							defaultVal) const
 {
-	const char *				strValue;
-	StringBuffer				msg;
-	int							result;
-	int							i;
-	StringBuffer				fullyScopedName;
-	
-	if (type(scope, localName) == Configuration::CFG_NO_VALUE) {
+	ConfigItem *				item;
+
+	item = stringItem(scope, localName, false);
+	if (item == 0) {
 		return defaultVal;
 	}
+	return enumValue(item, scope, localName, typeName, enumInfo, numEnums);
+}
 
-	strValue = lookupString(scope, localName);
 
-	//--------
-	// Check if the value matches anything in the enumInfo list.
-	//--------
-	if (!enumVal(strValue, enumInfo, numEnums, result)) {
-		mergeNames(scope, localName, fullyScopedName);
-		msg << fileName() << ": bad " << typeName << " value ('" << strValue
-			<< "') specified for '" << fullyScopedName
-			<< "'; should be one of:";
-		for (i = 0; i < numEnums; i++) {
-			if (i < numEnums-1) {
-				msg << " '" << enumInfo[i].name << "',";
-			} else {
-				msg << " '" << enumInfo[i].name << "'";
-			}
-		}
-		throw ConfigurationException(msg.c_str());
-	}
-	return result;
+
+int
+ConfigurationImpl::lookupEnum(
+	const char *				scope,
+	const char *				localName,
+	const char *				typeName,
+	const EnumNameAndValue *	enumInfo,
+	int 						numEnums) const
+{
+	ConfigItem *				item;
+
+	item = stringItem(scope, localName, true);
+	return enumValue(item, scope, localName, typeName, enumInfo, numEnums);
 }
 
 
 
+//----------------------------------------------------------------------
+// Function:	enumIndex()
+//
+// Description:	Return the index of str in enumInfo, or throw an
+//		exception if it is not there.
+//----------------------------------------------------------------------
+
 int
-ConfigurationImpl::lookupEnum(
+ConfigurationImpl::enumIndex(
 	const char *				scope,
 	const char *				localName,
 	const char *				typeName,
+	const char *				str,
 	const EnumNameAndValue *	enumInfo,
 	int 						numEnums) const
 {
-	const char *				strValue;
 	StringBuffer				msg;
-	int							result;
 	StringBuffer				fullyScopedName;
 	int							i;
-	
-	strValue = lookupString(scope, localName);
 
-	//--------
-	// Check if the value matches anything in the enumInfo list.
-	//--------
-	if (!enumVal(strValue, enumInfo, numEnums, result)) {
-		mergeNames(scope, localName, fullyScopedName);
-		msg << fileName() << ": bad " << typeName << " value ('" << strValue
-			<< "') specified for '" << fullyScopedName
-			<< "'; should be one of:";
-		for (i = 0; i < numEnums; i++) {
-			if (i < numEnums-1) {
-				msg << " '" << enumInfo[i].name << "',";
-			} else {
-				msg << " '" << enumInfo[i].name << "'";
-			}
+	for (i = 0; i < numEnums; i++) {
+		if (!strcmp(str, enumInfo[i].name)) {
+			return i;
 		}
-		throw ConfigurationException(msg.c_str());
 	}
-	return result;
+	mergeNames(scope, localName, fullyScopedName);
+	msg << fileName() << ": bad " << typeName << " value ('" << str
+		<< "') specified for '" << fullyScopedName
+		<< "'; should be one of:";
+	for (i = 0; i < numEnums; i++) {
+		if (i < numEnums-1) {
+			msg << " '" << enumInfo[i].name << "',";
+		} else {
+			msg << " '" << enumInfo[i].name << "'";
+		}
+	}
+	throw ConfigurationException(msg.c_str());
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	enumValue()
+//
+// Description:	Convert the string in item to an enum value.
+//
+// Notes:	The item remembers the index of its string in the
+//		enumInfo array. The index is re-checked against the name
+//		at that index, because the item does not know which
+//		enumInfo array was used last time.
+//----------------------------------------------------------------------
+
+int
+ConfigurationImpl::enumValue(
+	ConfigItem *				item,
+	const char *				scope,
+	const char *				localName,
+	const char *				typeName,
+	const EnumNameAndValue *	enumInfo,
+	int 						numEnums) const
+{
+	int							index;
+
+	if (!item->cachedValue(ConfigItem::VALUE_ENUM_INDEX, index)
+	    || index >= numEnums
+	    || strcmp(enumInfo[index].name, item->stringVal()) != 0)
+	{
+		index = enumIndex(scope, localName, typeName, item->stringVal(),
+		                  enumInfo, numEnums);
+		item->cacheValue(ConfigItem::VALUE_ENUM_INDEX, index);
+	}
+	return enumInfo[index].value;
 }
 
 
@@ -1415,14 +2268,15 @@ ConfigurationImpl::lookupInt(
 	const char *		localName,
 	int					defaultVal) const
 {
-	const char *		strValue;
-	int					result;
-	char				defaultStrVal[64]; // Big enough
+	ConfigItem *		item;
 
-	snprintf(defaultStrVal, sizeof(defaultStrVal), "%d", defaultVal);
-	strValue = lookupString(scope, localName, defaultStrVal);
-	result = stringToInt(scope, localName, strValue);
-	return result;
+	item = stringItem(scope, localName, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return intValue(item, ConfigItem::VALUE_INT,
+	                &ConfigurationImpl::stringToInt,
+	                scope, localName);
 }
 
 
@@ -1432,12 +2286,12 @@ ConfigurationImpl::lookupInt(
 	const char *			scope,
 	const char *			localName) const
 {
-	const char *			strValue;
-	int						result;
+	ConfigItem *		item;
 
-	strValue = lookupString(scope, localName);
-	result = stringToInt(scope, localName, strValue);
-	return result;
+	item = stringItem(scope, localName, true);
+	return intValue(item, ConfigItem::VALUE_INT,
+	                &ConfigurationImpl::stringToInt,
+	                scope, localName);
 }
 
 
@@ -2572,18 +3426,15 @@ ConfigurationImpl::lookupDurationMicroseconds(
 	const char *		localName,
 	int					defaultVal) const
 {
-	char				defaultStrValue[128]; // big enough
-	const char *		strValue;
-	int					result;
+	ConfigItem *		item;
 
-	if (defaultVal == -1) {
-		snprintf(defaultStrValue, sizeof(defaultStrValue), "infinite");
-	} else {
-		snprintf(defaultStrValue, sizeof(defaultStrValue), "%d microseconds", defaultVal);
+	item = stringItem(scope, localName, false);
+	if (item == 0) {
+		return defaultVal;
 	}
-	strValue = lookupString(scope, localName, defaultStrValue);
-	result = stringToDurationMicroseconds(scope, localName, strValue);
-	return result;
+	return intValue(item, ConfigItem::VALUE_DURATION_MICROSECONDS,
+	                &ConfigurationImpl::stringToDurationMicroseconds,
+	                scope, localName);
 }
 
 
@@ -2593,12 +3444,12 @@ ConfigurationImpl::lookupDurationMicroseconds(
 	const char *		scope,
 	const char *		localName) const
 {
-	const char *		strValue;
-	int					result;
+	ConfigItem *		item;
 
-	strValue = lookupString(scope, localName);
-	result = stringToDurationMicroseconds(scope, localName, strValue);
-	return result;
+	item = stringItem(scope, localName, true);
+	return intValue(item, ConfigItem::VALUE_DURATION_MICROSECONDS,
+	                &ConfigurationImpl::stringToDurationMicroseconds,
+	                scope, localName);
 }
 
 
@@ -2609,18 +3460,15 @@ ConfigurationImpl::lookupDurationMilliseconds(
 	const char *		localName,
 	int					defaultVal) const
 {
-	char				defaultStrValue[128]; // big enough
-	const char *		strValue;
-	int					result;
+	ConfigItem *		item;
 
-	if (defaultVal == -1) {
-		snprintf(defaultStrValue, sizeof(defaultStrValue), "infinite");
-	} else {
-		snprintf(defaultStrValue, sizeof(defaultStrValue), "%d milliseconds", defaultVal);
+	item = stringItem(scope, localName, false);
+	if (item == 0) {
+		return defaultVal;
 	}
-	strValue = lookupString(scope, localName, defaultStrValue);
-	result = stringToDurationMilliseconds(scope, localName, strValue);
-	return result;
+	return intValue(item, ConfigItem::VALUE_DURATION_MILLISECONDS,
+	                &ConfigurationImpl::stringToDurationMilliseconds,
+	                scope, localName);
 }
 
 
@@ -2630,12 +3478,12 @@ ConfigurationImpl::lookupDurationMilliseconds(
 	const char *		scope,
 	const char *		localName) const
 {
-	const char *		strValue;
-	int					result;
+	ConfigItem *		item;
 
-	strValue = lookupString(scope, localName);
-	result = stringToDurationMilliseconds(scope, localName, strValue);
-	return result;
+	item = stringItem(scope, localName, true);
+	return intValue(item, ConfigItem::VALUE_DURATION_MILLISECONDS,
+	                &ConfigurationImpl::stringToDurationMilliseconds,
+	                scope, localName);
 }
 
 
@@ -2646,18 +3494,15 @@ ConfigurationImpl::lookupDurationSeconds(
 	const char *		localName,
 	int					defaultVal) const
 {
-	char				defaultStrValue[128]; // big enough
-	const char *		strValue;
-	int					result;
+	ConfigItem *		item;
 
-	if (defaultVal == -1) {
-		snprintf(defaultStrValue, sizeof(defaultStrValue), "infinite");
-	} else {
-		snprintf(defaultStrValue, sizeof(defaultStrValue), "%d seconds", defaultVal);
+	item = stringItem(scope, localName, false);
+	if (item == 0) {
+		return defaultVal;
 	}
-	strValue = lookupString(scope, localName, defaultStrValue);
-	result = stringToDurationSeconds(scope, localName, strValue);
-	return result;
+	return intValue(item, ConfigItem::VALUE_DURATION_SECONDS,
+	                &ConfigurationImpl::stringToDurationSeconds,
+	                scope, localName);
 }
 
 
@@ -2667,12 +3512,12 @@ ConfigurationImpl::lookupDurationSeconds(
 	const char *		scope,
 	const char *		localName) const
 {
-	const char *		strValue;
-	int					result;
+	ConfigItem *		item;
 
-	strValue = lookupString(scope, localName);
-	result = stringToDurationSeconds(scope, localName, strValue);
-	return result;
+	item = stringItem(scope, localName, true);
+	return intValue(item, ConfigItem::VALUE_DURATION_SECONDS,
+	                &ConfigurationImpl::stringToDurationSeconds,
+	                scope, localName);
 }
 
 
@@ -2756,14 +3601,15 @@ ConfigurationImpl::lookupMemorySizeBytes(
 	const char *		localName,
 	int					defaultVal) const
 {
-	char				defaultStrValue[64]; // big enough
-	const char *		strValue;
-	int					result;
+	ConfigItem *		item;
 
-	snprintf(defaultStrValue, sizeof(defaultStrValue), "%d milliseconds", defaultVal);
-	strValue = lookupString(scope, localName, defaultStrValue);
-	result = stringToMemorySizeBytes(scope, localName, strValue);
-	return result;
+	item = stringItem(scope, localName, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return intValue(item, ConfigItem::VALUE_MEMORY_SIZE_BYTES,
+	                &ConfigurationImpl::stringToMemorySizeBytes,
+	                scope, localName);
 }
 
 
@@ -2773,12 +3619,12 @@ ConfigurationImpl::lookupMemorySizeBytes(
 	const char *		scope,
 	const char *		localName) const
 {
-	const char *		strValue;
-	int					result;
+	ConfigItem *		item;
 
-	strValue = lookupString(scope, localName);
-	result = stringToMemorySizeBytes(scope, localName, strValue);
-	return result;
+	item = stringItem(scope, localName, true);
+	return intValue(item, ConfigItem::VALUE_MEMORY_SIZE_BYTES,
+	                &ConfigurationImpl::stringToMemorySizeBytes,
+	                scope, localName);
 }
 
 
@@ -2789,14 +3635,15 @@ ConfigurationImpl::lookupMemorySizeKB(
 	const char *		localName,
 	int					defaultVal) const
 {
-	char				defaultStrValue[64]; // big enough
-	const char *		strValue;
-	int					result;
+	ConfigItem *		item;
 
-	snprintf(defaultStrValue, sizeof(defaultStrValue), "%d KB", defaultVal);
-	strValue = lookupString(scope, localName, defaultStrValue);
-	result = stringToMemorySizeKB(scope, localName, strValue);
-	return result;
+	item = stringItem(scope, localName, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return intValue(item, ConfigItem::VALUE_MEMORY_SIZE_KB,
+	                &ConfigurationImpl::stringToMemorySizeKB,
+	                scope, localName);
 }
 
 
@@ -2806,12 +3653,12 @@ ConfigurationImpl::lookupMemorySizeKB(
 	const char *		scope,
 	const char *		localName) const
 {
-	const char *		strValue;
-	int					result;
+	ConfigItem *		item;
 
-	strValue = lookupString(scope, localName);
-	result = stringToMemorySizeKB(scope, localName, strValue);
-	return result;
+	item = stringItem(scope, localName, true);
+	return intValue(item, ConfigItem::VALUE_MEMORY_SIZE_KB,
+	                &ConfigurationImpl::stringToMemorySizeKB,
+	                scope, localName);
 }
 
 
@@ -2822,14 +3669,15 @@ ConfigurationImpl::lookupMemorySizeMB(
 	const char *		localName,
 	int					defaultVal) const
 {
-	char				defaultStrValue[64]; // big enough
-	const char *		strValue;
-	int					result;
+	ConfigItem *		item;
 
-	snprintf(defaultStrValue, sizeof(defaultStrValue), "%d MB", defaultVal);
-	strValue = lookupString(scope, localName, defaultStrValue);
-	result = stringToMemorySizeMB(scope, localName, strValue);
-	return result;
+	item = stringItem(scope, localName, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return intValue(item, ConfigItem::VALUE_MEMORY_SIZE_MB,
+	                &ConfigurationImpl::stringToMemorySizeMB,
+	                scope, localName);
 }
 
 
@@ -2839,12 +3687,12 @@ ConfigurationImpl::lookupMemorySizeMB(
 	const char *		scope,
 	const char *		localName) const
 {
-	const char *		strValue;
-	int					result;
+	ConfigItem *		item;
 
-	strValue = lookupString(scope, localName);
-	result = stringToMemorySizeMB(scope, localName, strValue);
-	return result;
+	item = stringItem(scope, localName, true);
+	return intValue(item, ConfigItem::VALUE_MEMORY_SIZE_MB,
+	                &ConfigurationImpl::stringToMemorySizeMB,
+	                scope, localName);
 }
 
 
@@ -2855,14 +3703,13 @@ ConfigurationImpl::lookupFloat(
 	const char *		localName,
 	float				defaultVal) const
 {
-	const char *		strValue;
-	float				result;
-	char				defaultStrVal[64]; // Big enough
+	ConfigItem *		item;
 
-	snprintf(defaultStrVal, sizeof(defaultStrVal), "%f", defaultVal);
-	strValue = lookupString(scope, localName, defaultStrVal);
-	result = stringToFloat(scope, localName, strValue);
-	return result;
+	item = stringItem(scope, localName, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return floatValue(item, scope, localName);
 }
 
 
@@ -2872,11 +3719,50 @@ ConfigurationImpl::lookupFloat(
 	const char *		scope,
 	const char *		localName) const
 {
-	const char *		strValue;
-	float				result;
+	return floatValue(stringItem(scope, localName, true), scope, localName);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	intValue()
+//
+// Description:	Convert the string in item to an int with the
+//		stringToValue() operation, unless item remembers having
+//		done that conversion already.
+//----------------------------------------------------------------------
+
+int
+ConfigurationImpl::intValue(
+	ConfigItem *			item,
+	ConfigItem::ValueKind	kind,
+	StringToIntFn			stringToValue,
+	const char *			scope,
+	const char *			localName) const
+{
+	int						result;
+
+	if (!item->cachedValue(kind, result)) {
+		result = (this->*stringToValue)(scope, localName, item->stringVal());
+		item->cacheValue(kind, result);
+	}
+	return result;
+}
+
+
 
-	strValue = lookupString(scope, localName);
-	result = stringToFloat(scope, localName, strValue);
+float
+ConfigurationImpl::floatValue(
+	ConfigItem *			item,
+	const char *			scope,
+	const char *			localName) const
+{
+	float					result;
+
+	if (!item->cachedValue(ConfigItem::VALUE_FLOAT, result)) {
+		result = stringToFloat(scope, localName, item->stringVal());
+		item->cacheValue(ConfigItem::VALUE_FLOAT, result);
+	}
 	return result;
 }
 
@@ -2914,6 +3800,399 @@ ConfigurationImpl::lookupScope(
 
 
 
+//----------------------------------------------------------------------
+// The lookup<Type>() operations below take a pre-compiled Key.
+// Their behaviour and error messages match the (scope, localName)
+// versions.
+//----------------------------------------------------------------------
+
+Configuration::Type
+ConfigurationImpl::type(const Key & key) const
+{
+	ConfigItem *			item;
+
+	item = lookup(key, false, true);
+	if (item == 0) {
+		return Configuration::CFG_NO_VALUE;
+	}
+	return item->type();
+}
+
+
+
+ConfigItem *
+ConfigurationImpl::stringItem(const Key & key, bool isRequired) const
+{
+	ConfigItem *			item;
+
+	item = lookup(key, false, true);
+	checkStringItem(item, key.fullyScopedName(), isRequired);
+	return item;
+}
+
+
+
+const char *
+ConfigurationImpl::lookupString(
+	const Key &				key,
+	const char *			defaultVal) const
+{
+	ConfigItem *			item;
+
+	item = stringItem(key, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return item->stringVal();
+}
+
+
+
+const char *
+ConfigurationImpl::lookupString(const Key & key) const
+{
+	return stringItem(key, true)->stringVal();
+}
+
+
+
+void
+ConfigurationImpl::lookupList(
+	const Key &				key,
+	const char **&			array,
+	int &					arraySize,
+	const char **			defaultArray,
+	int						defaultArraySize) const
+{
+	ConfigItem *			item;
+	StringBuffer			msg;
+
+	item = lookup(key, false, true);
+	if (item == 0) {
+		array = defaultArray;
+		arraySize = defaultArraySize;
+		return;
+	}
+	switch (item->type()) {
+	case Configuration::CFG_LIST:
+		item->listVal(array, arraySize);
+		break;
+	case Configuration::CFG_SCOPE:
+		msg << fileName() << ": '" << key.fullyScopedName()
+			<< "' is a scope instead of a list";
+		throw ConfigurationException(msg.c_str());
+	case Configuration::CFG_STRING:
+		msg << fileName() << ": '" << key.fullyScopedName()
+			<< "' is a string instead of a list";
+		throw ConfigurationException(msg.c_str());
+	default:
+		assert(0);	// Bug
+	}
+}
+
+
+
+void
+ConfigurationImpl::lookupList(
+	const Key &				key,
+	const char **&			array,
+	int &					arraySize) const
+{
+	StringBuffer			msg;
+
+	if (type(key) == Configuration::CFG_NO_VALUE) {
+		msg << fileName() << ": no value specified for '"
+			<< key.fullyScopedName() << "'";
+		throw ConfigurationException(msg.c_str());
+	}
+	lookupList(key, array, arraySize, 0, 0);
+}
+
+
+
+float
+ConfigurationImpl::lookupFloat(const Key & key, float defaultVal) const
+{
+	ConfigItem *			item;
+
+	item = stringItem(key, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return floatValue(item, key.scope(), key.localName());
+}
+
+
+
+float
+ConfigurationImpl::lookupFloat(const Key & key) const
+{
+	return floatValue(stringItem(key, true), key.scope(), key.localName());
+}
+
+
+
+int
+ConfigurationImpl::lookupEnum(
+	const Key &					key,
+	const char *				typeName,
+	const EnumNameAndValue *	enumInfo,
+	int 						numEnums,
+	const char *				defaultVal) const
+{
+	ConfigItem *				item;
+	int							index;
+
+	item = stringItem(key, false);
+	if (item == 0) {
+		index = enumIndex(key.scope(), key.localName(), typeName, defaultVal,
+		                  enumInfo, numEnums);
+		return enumInfo[index].value;
+	}
+	return enumValue(item, key.scope(), key.localName(), typeName,
+	                 enumInfo, numEnums);
+}
+
+
+
+int
+ConfigurationImpl::lookupEnum(
+	const Key &					key,
+	const char *				typeName,
+	const EnumNameAndValue *	enumInfo,
+	int 						numEnums,
+	int							defaultVal) const
+{
+	ConfigItem *				item;
+
+	item = stringItem(key, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return enumValue(item, key.scope(), key.localName(), typeName,
+	                 enumInfo, numEnums);
+}
+
+
+
+int
+ConfigurationImpl::lookupEnum(
+	const Key &					key,
+	const char *				typeName,
+	const EnumNameAndValue *	enumInfo,
+	int 						numEnums) const
+{
+	return enumValue(stringItem(key, true), key.scope(), key.localName(),
+	                 typeName, enumInfo, numEnums);
+}
+
+
+
+bool
+ConfigurationImpl::lookupBoolean(const Key & key, bool defaultVal) const
+{
+	return lookupEnum(key, "boolean", boolInfo, countBoolInfo,
+	                  (int)defaultVal) != 0;
+}
+
+
+
+bool
+ConfigurationImpl::lookupBoolean(const Key & key) const
+{
+	return lookupEnum(key, "boolean", boolInfo, countBoolInfo) != 0;
+}
+
+
+
+int
+ConfigurationImpl::lookupInt(const Key & key, int defaultVal) const
+{
+	ConfigItem *			item;
+
+	item = stringItem(key, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return intValue(item, ConfigItem::VALUE_INT,
+	                &ConfigurationImpl::stringToInt,
+	                key.scope(), key.localName());
+}
+
+
+
+int
+ConfigurationImpl::lookupInt(const Key & key) const
+{
+	return intValue(stringItem(key, true), ConfigItem::VALUE_INT,
+	                &ConfigurationImpl::stringToInt,
+	                key.scope(), key.localName());
+}
+
+
+
+int
+ConfigurationImpl::lookupDurationMicroseconds(
+	const Key &				key,
+	int						defaultVal) const
+{
+	ConfigItem *			item;
+
+	item = stringItem(key, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return intValue(item, ConfigItem::VALUE_DURATION_MICROSECONDS,
+	                &ConfigurationImpl::stringToDurationMicroseconds,
+	                key.scope(), key.localName());
+}
+
+
+
+int
+ConfigurationImpl::lookupDurationMicroseconds(const Key & key) const
+{
+	return intValue(stringItem(key, true),
+	                ConfigItem::VALUE_DURATION_MICROSECONDS,
+	                &ConfigurationImpl::stringToDurationMicroseconds,
+	                key.scope(), key.localName());
+}
+
+
+
+int
+ConfigurationImpl::lookupDurationMilliseconds(
+	const Key &				key,
+	int						defaultVal) const
+{
+	ConfigItem *			item;
+
+	item = stringItem(key, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return intValue(item, ConfigItem::VALUE_DURATION_MILLISECONDS,
+	                &ConfigurationImpl::stringToDurationMilliseconds,
+	                key.scope(), key.localName());
+}
+
+
+
+int
+ConfigurationImpl::lookupDurationMilliseconds(const Key & key) const
+{
+	return intValue(stringItem(key, true),
+	                ConfigItem::VALUE_DURATION_MILLISECONDS,
+	                &ConfigurationImpl::stringToDurationMilliseconds,
+	                key.scope(), key.localName());
+}
+
+
+
+int
+ConfigurationImpl::lookupDurationSeconds(const Key & key, int defaultVal) const
+{
+	ConfigItem *			item;
+
+	item = stringItem(key, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return intValue(item, ConfigItem::VALUE_DURATION_SECONDS,
+	                &ConfigurationImpl::stringToDurationSeconds,
+	                key.scope(), key.localName());
+}
+
+
+
+int
+ConfigurationImpl::lookupDurationSeconds(const Key & key) const
+{
+	return intValue(stringItem(key, true), ConfigItem::VALUE_DURATION_SECONDS,
+	                &ConfigurationImpl::stringToDurationSeconds,
+	                key.scope(), key.localName());
+}
+
+
+
+int
+ConfigurationImpl::lookupMemorySizeBytes(const Key & key, int defaultVal) const
+{
+	ConfigItem *			item;
+
+	item = stringItem(key, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return intValue(item, ConfigItem::VALUE_MEMORY_SIZE_BYTES,
+	                &ConfigurationImpl::stringToMemorySizeBytes,
+	                key.scope(), key.localName());
+}
+
+
+
+int
+ConfigurationImpl::lookupMemorySizeBytes(const Key & key) const
+{
+	return intValue(stringItem(key, true), ConfigItem::VALUE_MEMORY_SIZE_BYTES,
+	                &ConfigurationImpl::stringToMemorySizeBytes,
+	                key.scope(), key.localName());
+}
+
+
+
+int
+ConfigurationImpl::lookupMemorySizeKB(const Key & key, int defaultVal) const
+{
+	ConfigItem *			item;
+
+	item = stringItem(key, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return intValue(item, ConfigItem::VALUE_MEMORY_SIZE_KB,
+	                &ConfigurationImpl::stringToMemorySizeKB,
+	                key.scope(), key.localName());
+}
+
+
+
+int
+ConfigurationImpl::lookupMemorySizeKB(const Key & key) const
+{
+	return intValue(stringItem(key, true), ConfigItem::VALUE_MEMORY_SIZE_KB,
+	                &ConfigurationImpl::stringToMemorySizeKB,
+	                key.scope(), key.localName());
+}
+
+
+
+int
+ConfigurationImpl::lookupMemorySizeMB(const Key & key, int defaultVal) const
+{
+	ConfigItem *			item;
+
+	item = stringItem(key, false);
+	if (item == 0) {
+		return defaultVal;
+	}
+	return intValue(item, ConfigItem::VALUE_MEMORY_SIZE_MB,
+	                &ConfigurationImpl::stringToMemorySizeMB,
+	                key.scope(), key.localName());
+}
+
+
+
+int
+ConfigurationImpl::lookupMemorySizeMB(const Key & key) const
+{
+	return intValue(stringItem(key, true), ConfigItem::VALUE_MEMORY_SIZE_MB,
+	                &ConfigurationImpl::stringToMemorySizeMB,
+	                key.scope(), key.localName());
+}
+
+
+
 void
 ConfigurationImpl::pushIncludedFilename(const char * fileName)
 {
@@ -2929,6 +4208,7 @@ ConfigurationImpl::popIncludedFilename(const char * fileName)
 
 	size = m_fileNameStack.length();
         (void)size;
+        (void)fileName;
 	assert(size > 0);
 	assert (strcmp(m_fileNameStack[size-1], fileName) == 0);
 	m_fileNameStack.removeLast();
@@ -31,6 +31,7 @@
 //--------
 #include <config4cpp/Configuration.h>
 #include "ConfigScope.h"
+#include "ParseJournal.h"
 #include "UidIdentifierProcessor.h"
 
 #include <string>
@@ -78,6 +79,9 @@ public:
 					const char *					sourceDescription = "");
 	virtual const Configuration * getOverrideConfiguration();
 
+	virtual Configuration * freeze() const;
+	virtual bool isFrozen() const;
+
 	virtual void setSecurityConfiguration(
 					Configuration *					cfg,
 					bool							takeOwnership,
@@ -93,6 +97,11 @@ public:
 					Configuration::SourceType	sourceType,
 					const char *				source,
 					const char *				sourceDescription = "");
+	virtual bool reparseChanged();
+	virtual void listDependencies(
+					StringVector &			fileNames,
+					StringVector &			dirNames) const;
+	virtual unsigned long generation() const;
 	virtual const char * fileName() const;
 	virtual Type type(const char* scope, const char* localName) const;
 	Type type(
@@ -141,6 +150,21 @@ public:
 					bool					recursive,
 					const StringVector &	filterPatterns,
 					StringVector &			names) const;
+	void listLocallyScopedItems(
+					const char *			scope,
+					const char *			localName,
+					Type					typeMask,
+					bool					recursive,
+					StringVector &			names,
+					StringVector &			unexpandedNames,
+					std::vector<const ConfigItem *> &	items) const;
+
+	virtual void forEach(
+					const char *			scope,
+					const char *			localName,
+					Type					typeMask,
+					bool					recursive,
+					const Visitor &			visitor) const;
 
 	virtual bool uidEquals(const char * s1, const char * s2) const;
 	virtual void expandUid(StringBuffer & spelling);
@@ -157,6 +181,25 @@ public:
 					bool					wantExpandedUidNames,
 					const char *			scope,
 					const char *			localName) const;
+	virtual void dump(
+					StringBuffer &			buf,
+					bool					wantExpandedUidNames,
+					bool					wantLocations,
+					const char *			scope,
+					const char *			localName) const;
+
+	virtual bool lookupLocation(
+					const char *			scope,
+					const char *			localName,
+					const char *&			fileName,
+					int &					lineNumber) const;
+
+	virtual void writeBinary(const char * fileName) const;
+	virtual void writeBinaryImage(std::string & image) const;
+	virtual void parseBinaryImage(
+					const char *			image,
+					size_t					size,
+					const char *			sourceDescription = "");
 
 	virtual bool isBoolean(const char * str) const;
 	virtual bool isInt(const char * str) const;
@@ -471,6 +514,80 @@ public:
 					const char *			scope,
 					const char *			localName) const;
 
+	//--------
+	// lookup<Type>() operations that take a pre-compiled Key
+	//--------
+	virtual Type type(const Key & key) const;
+
+	virtual const char * lookupString(
+					const Key &				key,
+					const char *			defaultVal) const;
+	virtual const char * lookupString(const Key & key) const;
+
+	virtual void lookupList(
+					const Key &				key,
+					const char **&			array,
+					int &					arraySize,
+					const char **			defaultArray,
+					int						defaultArraySize) const;
+	virtual void lookupList(
+					const Key &				key,
+					const char **&			array,
+					int &					arraySize) const;
+
+	virtual int lookupInt(const Key & key, int defaultVal) const;
+	virtual int lookupInt(const Key & key) const;
+
+	virtual float lookupFloat(const Key & key, float defaultVal) const;
+	virtual float lookupFloat(const Key & key) const;
+
+	virtual int lookupEnum(
+					const Key &					key,
+					const char *				typeName,
+					const EnumNameAndValue *	enumInfo,
+					int 						numEnums,
+					const char *				defaultVal) const;
+	virtual int lookupEnum(
+					const Key &					key,
+					const char *				typeName,
+					const EnumNameAndValue *	enumInfo,
+					int 						numEnums,
+					int							defaultVal) const;
+	virtual int lookupEnum(
+					const Key &					key,
+					const char *				typeName,
+					const EnumNameAndValue *	enumInfo,
+					int 						numEnums) const;
+
+	virtual bool lookupBoolean(const Key & key, bool defaultVal) const;
+	virtual bool lookupBoolean(const Key & key) const;
+
+	virtual int lookupDurationMicroseconds(
+					const Key &				key,
+					int						defaultVal) const;
+	virtual int lookupDurationMicroseconds(const Key & key) const;
+	virtual int lookupDurationMilliseconds(
+					const Key &				key,
+					int						defaultVal) const;
+	virtual int lookupDurationMilliseconds(const Key & key) const;
+	virtual int lookupDurationSeconds(
+					const Key &				key,
+					int						defaultVal) const;
+	virtual int lookupDurationSeconds(const Key & key) const;
+
+	virtual int lookupMemorySizeBytes(
+					const Key &				key,
+					int						defaultVal) const;
+	virtual int lookupMemorySizeBytes(const Key & key) const;
+	virtual int lookupMemorySizeKB(
+					const Key &				key,
+					int						defaultVal) const;
+	virtual int lookupMemorySizeKB(const Key & key) const;
+	virtual int lookupMemorySizeMB(
+					const Key &				key,
+					int						defaultVal) const;
+	virtual int lookupMemorySizeMB(const Key & key) const;
+
 	//--------
 	// Update operations.
 	//--------
@@ -518,11 +635,20 @@ protected:
 	friend class ConfigParser;
 
 	//--------
-	// Operations called by ConfigParser
+	// Operations called by ConfigParser. The location of the new
+	// entry is given as an index into SourceFileTable and a line.
 	//--------
-	virtual void insertList(
+	void insertString(
 					const char *			name,
-					const StringVector &	list);
+					const char *			str,
+					unsigned int			fileIndex,
+					unsigned int			lineNum);
+	void insertList(
+					const char *			name,
+					const char **			array,
+					int						arraySize,
+					unsigned int			fileIndex,
+					unsigned int			lineNum);
 	inline ConfigScope * rootScope();
 	inline ConfigScope * getCurrScope();
 	inline void	 setCurrScope(ConfigScope * scope);
@@ -541,6 +667,18 @@ protected:
 					const char *			cmdLine,
 					StringBuffer &			trustedCmdLine);
 
+	void checkNotFrozen(const char * operationName) const;
+	void releaseItem(ConfigScope * scope, ConfigItem * item);
+	void noteChange();
+
+	//--------
+	// Helpers for reparseChanged()
+	//--------
+	void reparseAll();
+	void swapContents(ConfigurationImpl & other);
+	bool replayChangedFiles(const std::vector<int> & changed);
+	bool replayFile(int index);
+
 	//--------
 	// Helper operations
 	//--------
@@ -552,6 +690,53 @@ protected:
 	ConfigItem * lookupHelper(
 					ConfigScope *			scope,
 					const StringVector &	vec) const;
+	ConfigItem * lookup(
+					const Key &				key,
+					bool					startInRoot,
+					bool					searchOutwards) const;
+	ConfigItem * lookupHelper(
+					ConfigScope *			scope,
+					const Key &				key) const;
+	ConfigItem * stringItem(
+					const char *			scope,
+					const char *			localName,
+					bool					isRequired) const;
+	ConfigItem * stringItem(
+					const Key &				key,
+					bool					isRequired) const;
+	void checkStringItem(
+					ConfigItem *			item,
+					const char *			fullyScopedName,
+					bool					isRequired) const;
+
+	typedef int (ConfigurationImpl::*StringToIntFn)(
+					const char *			scope,
+					const char *			localName,
+					const char *			str) const;
+	int intValue(
+					ConfigItem *			item,
+					ConfigItem::ValueKind	kind,
+					StringToIntFn			stringToValue,
+					const char *			scope,
+					const char *			localName) const;
+	float floatValue(
+					ConfigItem *			item,
+					const char *			scope,
+					const char *			localName) const;
+	int enumIndex(
+					const char *				scope,
+					const char *				localName,
+					const char *				typeName,
+					const char *				str,
+					const EnumNameAndValue *	enumInfo,
+					int 						numEnums) const;
+	int enumValue(
+					ConfigItem *				item,
+					const char *				scope,
+					const char *				localName,
+					const char *				typeName,
+					const EnumNameAndValue *	enumInfo,
+					int 						numEnums) const;
 	void stringValue(
 					const char *			fullyScopedName,
 					const char *			localName,
@@ -597,14 +782,19 @@ protected:
 	Configuration *				m_securityCfg;
 	StringBuffer				m_securityCfgScope;
 	StringBuffer				m_fileName;
+	Arena						m_arena;	// holds m_rootScope's contents
+	StringPool					m_strings;	// names and values in m_arena
 	ConfigScope *				m_rootScope;
 	ConfigScope *				m_currScope;
 	StringVector				m_fileNameStack;
+	ParseJournal				m_journal;	// what parse() read, and made
 	ConfigurationImpl *			m_fallbackCfg;
 	ConfigurationImpl *			m_overrideCfg;
 	bool						m_amOwnerOfSecurityCfg;
 	bool						m_amOwnerOfFallbackCfg;
 	bool						m_amOwnerOfOverrideCfg;
+	bool						m_isFrozen;
+	unsigned long				m_generation;	// see noteChange()
         std::unordered_map<
             std::string,
             std::pair<
@@ -28,6 +28,8 @@
 //--------
 #include "LexBase.h"
 #include "UidIdentifierDummyProcessor.h"
+#include "ByteScanner.h"
+#include "util.h"
 #include <assert.h>
 #include <stdlib.h>
 #include <errno.h>
@@ -140,6 +142,7 @@ LexBase::LexBase(
 	// Initialize state for the multi-byte functions in the C library.
 	//--------
 	memset(&m_mbtowcState, 0, sizeof(mbstate_t));
+	m_asciiFastPath = localeMapsAsciiToItself();
 
 	m_keywordInfoArray     = 0;
 	m_keywordInfoArraySize = 0;
@@ -152,6 +155,7 @@ LexBase::LexBase(
 	m_source = source;
 	m_lineNum = 1;
 	m_ptr = 0;
+	m_end = 0;
 	m_atEOF = false;
 	switch (sourceType) {
 	case Configuration::INPUT_FILE:
@@ -159,9 +163,12 @@ LexBase::LexBase(
 			msg << "cannot open " << source << ": " << strerror(errno);
 			throw ConfigurationException(msg.c_str());
 		}
+		m_ptr = m_file.data();
+		m_end = m_ptr + m_file.size();
 		break;
 	case Configuration::INPUT_STRING:
 		m_ptr = m_source;
+		m_end = m_ptr + strlen(m_ptr);
 		break;
 	case Configuration::INPUT_EXEC:
 		if (!execCmd(source, m_execOutput)) {
@@ -170,6 +177,7 @@ LexBase::LexBase(
 			throw ConfigurationException(msg.c_str());
 		}
 		m_ptr = m_execOutput.c_str();
+		m_end = m_ptr + strlen(m_ptr);
 		break;
 	default:
 		assert(0); // Bug!
@@ -195,6 +203,7 @@ LexBase::LexBase(const char * str)
 	// Initialize state for the multi-byte functions in the C library.
 	//--------
 	memset(&m_mbtowcState, 0, sizeof(mbstate_t));
+	m_asciiFastPath = localeMapsAsciiToItself();
 
 	m_keywordInfoArray     = 0;
 	m_keywordInfoArraySize = 0;
@@ -207,6 +216,7 @@ LexBase::LexBase(const char * str)
 	m_source = str;
 	m_lineNum = 1;
 	m_ptr = m_source;
+	m_end = m_ptr + strlen(m_ptr);
 	m_atEOF = false;
 	nextChar(); // initialize m_ch
 }
@@ -228,36 +238,84 @@ LexBase::~LexBase()
 
 
 
+//----------------------------------------------------------------------
+// Function:	fileHash()
+//
+// Description:	A hash of the entire file being read, or 0 if the
+//		input is not a file.
+//----------------------------------------------------------------------
+
+unsigned long long
+LexBase::fileHash() const
+{
+	if (m_sourceType != Configuration::INPUT_FILE) {
+		return 0;
+	}
+	return hashBytes(m_file.data(), m_file.size());
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	localeMapsAsciiToItself()
+//
+// Description:	Returns true if, in the current locale, every 7-bit
+//		byte is a complete character whose wide-character value
+//		is the byte itself, and decoding it leaves the conversion
+//		state in its initial state.
+//
+// Notes:	This is true of UTF-8, ISO-8859-* and the "C" locale,
+//		but not of stateful encodings such as ISO-2022-JP. When
+//		it is true, nextChar() can decode 7-bit bytes without
+//		calling mbrtowc().
+//----------------------------------------------------------------------
+
+bool
+LexBase::localeMapsAsciiToItself()
+{
+	int					i;
+	char				ch;
+	wchar_t				wChar;
+	mbstate_t			state;
+	size_t				status;
+
+	for (i = 0; i < 0x80; i++) {
+		memset(&state, 0, sizeof(mbstate_t));
+		ch = (char)i;
+		wChar = 0;
+		status = mbrtowc(&wChar, &ch, 1, &state);
+		if (status != (i == 0 ? 0 : 1) || wChar != (wchar_t)i
+		    || !mbsinit(&state))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
 //----------------------------------------------------------------------
 // Function:	nextByte()
 //
-// Description:	Read the next byte from the input source
+// Description:	Read the next byte from the input source, skipping
+//		any '\r' characters.
 //----------------------------------------------------------------------
 
 char
 LexBase::nextByte()
 {
-	int				ch;
+	char			ch;
 
-	if (m_sourceType == Configuration::INPUT_FILE) {
-		do {
-			ch = m_file.getChar();
-		} while (ch == '\r');
-	} else {
-		do {
-			ch = *m_ptr;
-			if (ch == '\0') {
-				ch = EOF;
-			} else {
-				m_ptr ++;
-			}
-		} while (ch == '\r');
-	}
-	m_atEOF = (ch == EOF);
-	if (m_atEOF) {
-		ch = 0;
-	}
-	return (char)ch;
+	do {
+		if (m_ptr == m_end) {
+			m_atEOF = true;
+			return 0;
+		}
+		ch = *m_ptr;
+		m_ptr ++;
+	} while (ch == '\r');
+	return ch;
 }
 
 
@@ -275,6 +333,27 @@ LexBase::nextChar()
 	int					status;
 	wchar_t				wChar;
 
+	//--------
+	// Fast path: a 7-bit byte at a character boundary is a complete
+	// character, so there is no need to call mbrtowc(). Anything
+	// else, including '\r', EOF and bytes that follow an incomplete
+	// multi-byte sequence, is handled by the general code below.
+	//--------
+	if (m_asciiFastPath && m_ptr != m_end) {
+		ch = *m_ptr;
+		if ((unsigned char)ch < 0x80 && ch != '\r'
+		    && mbsinit(&m_mbtowcState))
+		{
+			m_ptr ++;
+			m_ch = ch;
+			m_ch.setWChar((wchar_t)ch);
+			if (ch == '\n') {
+				m_lineNum ++;
+			}
+			return;
+		}
+	}
+
 	m_ch.reset();
 	status = -1;
 	while (status == -1) {
@@ -330,6 +409,9 @@ LexBase::nextToken(LexToken &token)
 	// Skip leading white space
 	//--------
 	while (m_ch.isSpace()) {
+		if (canScanAscii()) {
+			m_ptr = ByteScanner::skipBlanks(m_ptr, m_end);
+		}
 		nextChar();
 	}
 
@@ -478,6 +560,9 @@ LexBase::nextToken(LexToken &token)
 			// Skip to the end of line
 			//--------
 			while (!m_atEOF && m_ch != '\n') {
+				if (canScanAscii()) {
+					m_ptr = ByteScanner::findStop(m_ptr, m_end, '\n', '\n');
+				}
 				nextChar();
 			}
 			if (m_ch == '\n') {
@@ -487,6 +572,9 @@ LexBase::nextToken(LexToken &token)
 			// Skip leading white space on the next line
 			//--------
 			while (m_ch.isSpace()) {
+				if (canScanAscii()) {
+					m_ptr = ByteScanner::skipBlanks(m_ptr, m_end);
+				}
 				nextChar();
 			}
 			//--------
@@ -576,6 +664,7 @@ LexBase::consumeBlockString(LexToken &token)
 	StringBuffer		spelling;
 	MBChar				prevCh;
 	int					lineNum;
+	const char *		stop;
 
 	//--------
 	// Note the line number at the start of the string
@@ -594,6 +683,19 @@ LexBase::consumeBlockString(LexToken &token)
 		}
 		spelling << m_ch.c_str();
 		prevCh = m_ch;
+		//--------
+		// Append the run of plain 7-bit bytes that follows,
+		// if any, in one go. Scanning stops at control chars,
+		// so m_lineNum is still maintained by nextChar().
+		//--------
+		if (m_ch != '%' && canScanAscii()) {
+			stop = ByteScanner::findStop(m_ptr, m_end, '%', '%');
+			if (stop != m_ptr) {
+				spelling.append(m_ptr, (int)(stop - m_ptr));
+				prevCh = stop[-1];
+				m_ptr = stop;
+			}
+		}
 		nextChar();
 	}
 
@@ -625,6 +727,7 @@ LexBase::consumeString(LexToken &token)
 {
 	StringBuffer			spelling;
 	StringBuffer			msg;
+	const char *			stop;
 
 	assert(m_ch == '"');
 
@@ -682,9 +785,15 @@ LexBase::consumeString(LexToken &token)
 			break;
 		default:
 			//--------
-			// Typical char in string
+			// Typical char in string. Append the run of plain
+			// 7-bit bytes that follows, if any, in one go.
 			//--------
 			spelling << m_ch.c_str();
+			if (canScanAscii()) {
+				stop = ByteScanner::findStop(m_ptr, m_end, '"', '%');
+				spelling.append(m_ptr, (int)(stop - m_ptr));
+				m_ptr = stop;
+			}
 			break;
 		}
 		nextChar();
@@ -734,6 +843,9 @@ LexBase::isIdentifierChar(const MBChar & mbCh)
 	bool				result;
 
 	wCh = mbCh.getWChar();
+	if ((unsigned long)wCh < 0x80) {
+		return isAsciiIdentifierChar((char)wCh);
+	}
 	result =   (::iswalpha(wCh) != 0) // letter
 		|| (::iswdigit(wCh) != 0) // digit
 		|| mbCh == '-'   // dash
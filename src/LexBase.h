@@ -46,6 +46,7 @@ public:
 	// Public operations
 	//--------
 	void nextToken(LexToken &token);
+	unsigned long long fileHash() const; // 0 unless reading a file
 
 	//--------
 	// Constants for the type of a function.
@@ -142,10 +143,13 @@ private:
 
 	void nextChar();
 	char nextByte();
+	static bool localeMapsAsciiToItself();
+	inline bool canScanAscii() const;
 	void consumeString(LexToken & token);
 	void consumeBlockString(LexToken &token);
 	bool isKeywordChar(const MBChar & ch);
 	bool isIdentifierChar(const MBChar & ch);
+	inline static bool isAsciiIdentifierChar(char ch);
 
 	//--------
 	// Instance variables
@@ -158,14 +162,17 @@ private:
 	const char *				m_source;
 	bool						m_atEOF;
 	mbstate_t					m_mbtowcState;
+	bool						m_asciiFastPath;
 
 	//--------
-	// CFG_INPUT_FILE   uses m_file
-	// CFG_INPUT_STRING uses m_ptr and m_source
-	// CFG_INPUT_EXEC   uses m_ptr and m_execOutput
+	// The input is scanned from m_ptr up to (but not including) m_end.
+	// CFG_INPUT_FILE   points them into m_file
+	// CFG_INPUT_STRING points them into m_source
+	// CFG_INPUT_EXEC   points them into m_execOutput
 	//--------
-	BufferedFileReader			m_file;
+	MappedFile					m_file;
 	const char *				m_ptr;
+	const char *				m_end;
 	StringBuffer				m_execOutput;
 
 	//--------
@@ -177,5 +184,37 @@ private:
 };
 
 
+//--------
+// Inline implementation of operations.
+//--------
+
+//----------------------------------------------------------------------
+// Function:	canScanAscii()
+//
+// Description:	True if the bytes at m_ptr can be skipped over with a
+//		ByteScanner instead of being decoded by nextChar().
+//		Each 7-bit byte must be a character by itself, and
+//		m_ptr must be at a character boundary.
+//----------------------------------------------------------------------
+
+inline bool
+LexBase::canScanAscii() const
+{
+	return m_asciiFastPath && mbsinit(&m_mbtowcState);
+}
+
+
+inline bool
+LexBase::isAsciiIdentifierChar(char ch)
+{
+	return ('a' <= ch && ch <= 'z')
+		|| ('A' <= ch && ch <= 'Z')
+		|| ('0' <= ch && ch <= '9')
+		|| ch == '-' || ch == '_' || ch == '.' || ch == ':'
+		|| ch == '$' || ch == '?' || ch == '/' || ch == '\\'
+		;
+}
+
+
 }; // namespace CONFIG4CPP_NAMESPACE
 #endif
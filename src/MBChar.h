@@ -146,6 +146,9 @@ MBChar::getWChar() const
 inline bool
 MBChar::isSpace() const
 {
+	if ((unsigned long)m_wChar < 0x80) {
+		return m_wChar == ' ' || ('\t' <= m_wChar && m_wChar <= '\r');
+	}
 	return ::iswspace(m_wChar) != 0;
 }
 
@@ -0,0 +1,675 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+
+//--------
+// #include's
+//--------
+#include "ParseJournal.h"
+#include "ConfigParser.h"
+#include "platform.h"
+#include "util.h"
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//--------
+// An entry of a scope, for finding the last assignment to each.
+//--------
+struct EntryKey {
+	ConfigScope *		scope;
+	const char *		name;
+};
+
+struct EntryKeyHash {
+	size_t operator()(const EntryKey & key) const
+	{
+		return (size_t)key.scope ^ ConfigScope::hash(key.name);
+	}
+};
+
+struct EntryKeyEqual {
+	bool operator()(const EntryKey & a, const EntryKey & b) const
+	{
+		return a.scope == b.scope
+		       && (a.name == b.name || strcmp(a.name, b.name) == 0);
+	}
+};
+
+typedef std::unordered_map<EntryKey, ConfigItem *, EntryKeyHash,
+						   EntryKeyEqual> LastAssignmentMap;
+
+
+static void
+addKey(
+	const ParseJournal::Assignment &	assignment,
+	LastAssignmentMap &					lastAssignment,
+	std::vector<EntryKey> &				keys)
+{
+	EntryKey							key;
+
+	key.scope = assignment.scope;
+	key.name = assignment.item->name();
+	if (lastAssignment.find(key) == lastAssignment.end()) {
+		lastAssignment[key] = 0;
+		keys.push_back(key);
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	Constructor
+//
+// Description:
+//----------------------------------------------------------------------
+
+ParseJournal::ParseJournal()
+{
+	reset();
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	reset()
+//
+// Description:	Start again, for an empty configuration.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::reset()
+{
+	clearRecord();
+	m_isValid = true;
+	m_dependencies.clear();
+	m_directories.clear();
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	clearRecord()
+//
+// Description:	Forget everything but the dependencies.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::clearRecord()
+{
+	m_isComplete = true;
+	m_isStateDependent = false;
+	m_topLevelFiles.empty();
+	m_files.clear();
+	m_includes.clear();
+	m_missingFiles.clear();
+	m_readFiles.clear();
+	m_assignments.clear();
+	m_stack.clear();
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	swap()
+//
+// Description:	Exchange records with another journal, when the
+//		configurations that they describe swap contents.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::swap(ParseJournal & other)
+{
+	StringVector			topLevelFiles;
+
+	std::swap(m_isValid, other.m_isValid);
+	std::swap(m_isComplete, other.m_isComplete);
+	std::swap(m_isStateDependent, other.m_isStateDependent);
+	topLevelFiles = m_topLevelFiles;
+	m_topLevelFiles = other.m_topLevelFiles;
+	other.m_topLevelFiles = topLevelFiles;
+	m_files.swap(other.m_files);
+	m_includes.swap(other.m_includes);
+	m_missingFiles.swap(other.m_missingFiles);
+	m_readFiles.swap(other.m_readFiles);
+	m_assignments.swap(other.m_assignments);
+	m_stack.swap(other.m_stack);
+	m_dependencies.swap(other.m_dependencies);
+	m_directories.swap(other.m_directories);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	invalidate()
+//
+// Description:	The configuration now holds something other than what
+//		was parsed from files, so stop recording.
+//
+// Notes:	The dependencies are still kept: whatever else it
+//		holds, the configuration still depends on those files.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::invalidate()
+{
+	clearRecord();
+	m_isValid = false;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	markIncomplete()
+//
+// Description:	A parse failed part way through, so only a full parse
+//		can bring the configuration up to date.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::markIncomplete()
+{
+	m_isComplete = false;
+	m_stack.clear();
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	addTopLevelFile()
+//
+// Description:	Record a file given to parse().
+//----------------------------------------------------------------------
+
+void
+ParseJournal::addTopLevelFile(const char * fileName)
+{
+	if (m_isValid) {
+		m_topLevelFiles.add(fileName);
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	beginFile() and endFile()
+//
+// Description:	Bracket the parsing of a file.
+//
+// Notes:	A file that is read more than once cannot be replayed
+//		as a single block.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::beginFile(
+	const char *			fileName,
+	long long				mtime,
+	long long				size,
+	unsigned long long		hash)
+{
+	File					file;
+	size_t					i;
+
+	if (!m_isValid) {
+		return;
+	}
+	file.fileName = fileName;
+	file.mtime = mtime;
+	file.size = size;
+	file.hash = hash;
+	file.isStandalone = true;
+	file.first = m_assignments.size();
+	file.last = file.first;
+	for (i = 0; i < m_files.size(); i++) {
+		if (m_files[i].fileName == file.fileName) {
+			m_files[i].isStandalone = false;
+			file.isStandalone = false;
+		}
+	}
+	m_stack.push_back((int)m_files.size());
+	m_files.push_back(file);
+}
+
+
+
+void
+ParseJournal::endFile()
+{
+	if (!isRecording()) {
+		return;
+	}
+	m_files[m_stack.back()].last = m_assignments.size();
+	m_stack.pop_back();
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	addMissingFile()
+//
+// Description:	Record a file that "@include ... @ifExists" skipped.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::addMissingFile(const char * fileName)
+{
+	if (m_isValid) {
+		m_missingFiles.push_back(fileName);
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	addReadFile()
+//
+// Description:	Record a file read by readFile(), so that a change to
+//		it is noticed.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::addReadFile(const char * fileName)
+{
+	File					file;
+
+	if (!isRecording()) {
+		return;
+	}
+	file.fileName = fileName;
+	if (!getFileStamp(fileName, file.mtime, file.size)) {
+		file.mtime = file.size = -1;
+	}
+	m_readFiles.push_back(file);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	addDependency() and addDirectory()
+//
+// Description:	Record a file whose contents, or a directory whose
+//		listing, the configuration depends on.
+//
+// Notes:	Unlike the rest of the record, these are kept for any
+//		parse(), so that a ConfigWatcher can watch them.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::addDependency(const char * fileName)
+{
+	if (std::find(m_dependencies.begin(), m_dependencies.end(), fileName)
+		== m_dependencies.end())
+	{
+		m_dependencies.push_back(fileName);
+	}
+}
+
+
+void
+ParseJournal::addDirectory(const char * dirName)
+{
+	if (std::find(m_directories.begin(), m_directories.end(), dirName)
+		== m_directories.end())
+	{
+		m_directories.push_back(dirName);
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	getDependencies()
+//
+// Description:	The files and directories that the configuration
+//		depends on, in the order they were first read.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::getDependencies(
+	StringVector &			fileNames,
+	StringVector &			dirNames) const
+{
+	size_t					i;
+
+	fileNames.empty();
+	dirNames.empty();
+	for (i = 0; i < m_dependencies.size(); i++) {
+		fileNames.add(m_dependencies[i].c_str());
+	}
+	for (i = 0; i < m_directories.size(); i++) {
+		dirNames.add(m_directories[i].c_str());
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	addInclude()
+//
+// Description:	Record the files an @include pattern matched.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::addInclude(
+	const char *			pattern,
+	const StringVector &	fileNames)
+{
+	Include					include;
+	int						i;
+
+	if (!isRecording()) {
+		return;
+	}
+	include.pattern = pattern;
+	for (i = 0; i < fileNames.length(); i++) {
+		include.fileNames.push_back(fileNames[i]);
+	}
+	m_includes.push_back(include);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	addAssignment() and addScope()
+//
+// Description:	Record an item that the current file assigned, or a
+//		scope that it opened.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::addAssignment(ConfigScope * scope, ConfigItem * item)
+{
+	Assignment				assignment;
+
+	if (!isRecording()) {
+		return;
+	}
+	assignment.scope = scope;
+	assignment.item = item;
+	m_assignments.push_back(assignment);
+	addScope(scope);
+}
+
+
+
+void
+ParseJournal::addScope(ConfigScope * scope)
+{
+	File *					file;
+
+	if (!isRecording()) {
+		return;
+	}
+	file = &m_files[m_stack.back()];
+	if (file->scopes.empty() || file->scopes.back() != scope) {
+		file->scopes.push_back(scope);
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	markNotStandalone() and markStateDependent()
+//
+// Description:	See the class comment.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::markNotStandalone()
+{
+	if (isRecording()) {
+		m_files[m_stack.back()].isStandalone = false;
+	}
+}
+
+
+
+void
+ParseJournal::markStateDependent()
+{
+	if (isRecording()) {
+		m_isStateDependent = true;
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	findChangedFiles()
+//
+// Description:	Set changed to the indices of the files whose contents
+//		differ from when they were parsed.
+//
+// Notes:	A file whose timestamp or size has changed is read and
+//		hashed; if its contents are the same after all, its new
+//		timestamp is recorded and it does not count as changed.
+//		Returns false, without finding the changed files, if the
+//		set of files itself has changed: an @include pattern
+//		matches different files, a skipped file has appeared, a
+//		file has gone, or a file read by readFile() has changed.
+//----------------------------------------------------------------------
+
+bool
+ParseJournal::findChangedFiles(std::vector<int> & changed)
+{
+	StringVector			fileNames;
+	MappedFile				contents;
+	long long				mtime;
+	long long				size;
+	unsigned long long		hash;
+	size_t					i;
+	size_t					j;
+
+	changed.clear();
+	for (i = 0; i < m_includes.size(); i++) {
+		ConfigParser::expandIncludePattern(m_includes[i].pattern.c_str(),
+										   fileNames);
+		if ((size_t)fileNames.length() != m_includes[i].fileNames.size()) {
+			return false;
+		}
+		for (j = 0; j < m_includes[i].fileNames.size(); j++) {
+			if (m_includes[i].fileNames[j] != fileNames[(int)j]) {
+				return false;
+			}
+		}
+	}
+	for (i = 0; i < m_missingFiles.size(); i++) {
+		if (getFileStamp(m_missingFiles[i].c_str(), mtime, size)) {
+			return false;
+		}
+	}
+	for (i = 0; i < m_readFiles.size(); i++) {
+		if (!getFileStamp(m_readFiles[i].fileName.c_str(), mtime, size)) {
+			mtime = size = -1;
+		}
+		if (mtime != m_readFiles[i].mtime || size != m_readFiles[i].size) {
+			return false;
+		}
+	}
+	for (i = 0; i < m_files.size(); i++) {
+		File & file = m_files[i];
+		if (!getFileStamp(file.fileName.c_str(), mtime, size)) {
+			return false;
+		}
+		if (mtime == file.mtime && size == file.size) {
+			continue;
+		}
+		if (!contents.open(file.fileName.c_str())) {
+			return false;
+		}
+		hash = hashBytes(contents.data(), contents.size());
+		contents.close();
+		if (hash == file.hash) {
+			file.mtime = mtime;
+			file.size = size;
+		} else {
+			changed.push_back((int)i);
+		}
+	}
+	return true;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	getAssignments()
+//
+// Description:	The assignments of a standalone file, in order.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::getAssignments(
+	int							index,
+	std::vector<Assignment> &	assignments) const
+{
+	const File &				file = m_files[index];
+
+	assert(file.isStandalone);
+	assignments.assign(m_assignments.begin() + file.first,
+					   m_assignments.begin() + file.last);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	getScopeNames()
+//
+// Description:	The sorted, fully-scoped names of the scopes that a file
+//		assigned variables in or opened.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::getScopeNames(
+	int							index,
+	std::vector<std::string> &	names) const
+{
+	const File &				file = m_files[index];
+	size_t						i;
+
+	names.clear();
+	for (i = 0; i < file.scopes.size(); i++) {
+		names.push_back(file.scopes[i]->scopedName());
+	}
+	std::sort(names.begin(), names.end());
+	names.erase(std::unique(names.begin(), names.end()), names.end());
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	replaceFile()
+//
+// Description:	Replace the assignments of a standalone file with
+//		newAssignments, which were made by parsing its new
+//		contents (recorded in newJournal) on its own.
+//
+// Notes:	Sets changes to what the configuration must do to look
+//		as if it had been parsed afresh: for each entry that the
+//		old or new contents assign, the last assignment to it in
+//		any file, or nothing if no file assigns it any longer.
+//		Later files therefore still override the new contents,
+//		and the new contents still override earlier files.
+//----------------------------------------------------------------------
+
+void
+ParseJournal::replaceFile(
+	int								index,
+	const ParseJournal &			newJournal,
+	const std::vector<Assignment> &	newAssignments,
+	std::vector<Change> &			changes)
+{
+	File &							file = m_files[index];
+	LastAssignmentMap				lastAssignment;
+	LastAssignmentMap::iterator		iter;
+	std::vector<EntryKey>			keys;
+	std::vector<Assignment>			assignments;
+	EntryKey						key;
+	Change							change;
+	size_t							i;
+	size_t							oldSize;
+
+	assert(file.isStandalone);
+	assert(newJournal.m_files.size() == 1);
+
+	//--------
+	// Find the entries that are affected...
+	//--------
+	for (i = file.first; i < file.last; i++) {
+		addKey(m_assignments[i], lastAssignment, keys);
+	}
+	for (i = 0; i < newAssignments.size(); i++) {
+		addKey(newAssignments[i], lastAssignment, keys);
+	}
+
+	//--------
+	// ... splice in the new assignments...
+	//--------
+	oldSize = file.last - file.first;
+	assignments.reserve(m_assignments.size() - oldSize
+						+ newAssignments.size());
+	assignments.insert(assignments.end(), m_assignments.begin(),
+					   m_assignments.begin() + file.first);
+	assignments.insert(assignments.end(), newAssignments.begin(),
+					   newAssignments.end());
+	assignments.insert(assignments.end(),
+					   m_assignments.begin() + file.last,
+					   m_assignments.end());
+	m_assignments.swap(assignments);
+	for (i = index + 1; i < m_files.size(); i++) {
+		m_files[i].first = m_files[i].first - oldSize + newAssignments.size();
+		m_files[i].last = m_files[i].last - oldSize + newAssignments.size();
+	}
+	file.last = file.first + newAssignments.size();
+	file.mtime = newJournal.m_files[0].mtime;
+	file.size = newJournal.m_files[0].size;
+	file.hash = newJournal.m_files[0].hash;
+
+	//--------
+	// ... and find the last assignment to each of them.
+	//--------
+	for (i = 0; i < m_assignments.size(); i++) {
+		key.scope = m_assignments[i].scope;
+		key.name = m_assignments[i].item->name();
+		iter = lastAssignment.find(key);
+		if (iter != lastAssignment.end()) {
+			iter->second = m_assignments[i].item;
+		}
+	}
+	changes.clear();
+	for (i = 0; i < keys.size(); i++) {
+		change.scope = keys[i].scope;
+		change.name = keys[i].name;
+		change.item = lastAssignment[keys[i]];
+		changes.push_back(change);
+	}
+}
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
@@ -0,0 +1,242 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+
+
+#ifndef CONFIG4CPP_PARSE_JOURNAL_H_
+#define CONFIG4CPP_PARSE_JOURNAL_H_
+
+
+//--------
+// #include's and #define's
+//--------
+#include "ConfigScope.h"
+#include <string>
+#include <vector>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//----------------------------------------------------------------------
+// Class:	ParseJournal
+//
+// Description:	A record, kept by ConfigurationImpl while it parses
+//		files, of every file that was read (with its timestamp,
+//		size and content hash), the @include patterns and what
+//		they matched, and, in the order they were made, the
+//		assignments that each file made. reparseChanged() uses
+//		it to find the files that have changed since, and to
+//		replay just those. It also keeps, for any parse(), the
+//		files and globbed directories that the configuration
+//		depends on, for ConfigWatcher.
+//
+// Notes:	A file is "standalone" if it includes nothing and its
+//		assignments depend on nothing outside the file: no
+//		references to other variables, "+=", "?=", uid- names,
+//		exec() or readFile(). Its assignments are contiguous
+//		in the record, so they can be replaced as a block.
+//		If any file reads the configuration being built (with
+//		@if, @copyFrom, @remove, a variable reference, "+=",
+//		"?=" or an "exec#" or "str#" @include), then the whole
+//		record is "state dependent" and nothing can be replayed
+//		in isolation.
+//----------------------------------------------------------------------
+
+class ParseJournal
+{
+public:
+	struct Assignment {
+		ConfigScope *		scope;
+		ConfigItem *		item;
+	};
+
+	//--------
+	// A change to make to the configuration: item is the new
+	// entry for name in scope, or 0 if the entry is to be removed.
+	//--------
+	struct Change {
+		ConfigScope *		scope;
+		const char *		name;
+		ConfigItem *		item;
+	};
+
+	ParseJournal();
+
+	//--------
+	// Recording, called while parsing
+	//--------
+	void		reset();
+	void		swap(ParseJournal & other);
+	void		invalidate();
+	void		markIncomplete();
+	void		addTopLevelFile(const char * fileName);
+	void		beginFile(
+					const char *		fileName,
+					long long			mtime,
+					long long			size,
+					unsigned long long	hash);
+	void		endFile();
+	void		addMissingFile(const char * fileName);
+	void		addReadFile(const char * fileName);
+	void		addDependency(const char * fileName);
+	void		addDirectory(const char * dirName);
+	void		addInclude(
+					const char *			pattern,
+					const StringVector &	fileNames);
+	void		addAssignment(ConfigScope * scope, ConfigItem * item);
+	void		addScope(ConfigScope * scope);
+	void		markNotStandalone();
+	void		markStateDependent();
+	inline bool	isRecording() const;
+
+	//--------
+	// Queries and updates used by reparseChanged()
+	//--------
+	inline bool	isValid() const;
+	inline bool	isComplete() const;
+	inline bool	isStateDependent() const;
+	inline int	numFiles() const;
+	inline const char * fileName(int index) const;
+	inline bool	isStandalone(int index) const;
+	inline const StringVector & topLevelFiles() const;
+
+	bool		findChangedFiles(std::vector<int> & changed);
+	void		getAssignments(
+					int							index,
+					std::vector<Assignment> &	assignments) const;
+	void		getScopeNames(int index, std::vector<std::string> & names) const;
+	void		getDependencies(
+					StringVector &		fileNames,
+					StringVector &		dirNames) const;
+	void		replaceFile(
+					int								index,
+					const ParseJournal &			newJournal,
+					const std::vector<Assignment> &	newAssignments,
+					std::vector<Change> &			changes);
+
+private:
+	struct File {
+		std::string					fileName;
+		long long					mtime;
+		long long					size;
+		unsigned long long			hash;
+		bool						isStandalone;
+		size_t						first;	// its assignments, if
+		size_t						last;	// it is standalone
+		std::vector<ConfigScope *>	scopes;	// those it used
+	};
+	struct Include {
+		std::string					pattern;
+		std::vector<std::string>	fileNames;	// what it matched
+	};
+
+	//--------
+	// Instance variables
+	//--------
+	bool						m_isValid;
+	bool						m_isComplete;
+	bool						m_isStateDependent;
+	StringVector				m_topLevelFiles;
+	std::vector<File>			m_files;
+	std::vector<Include>		m_includes;
+	std::vector<std::string>	m_missingFiles;	// skipped by @ifExists
+	std::vector<File>			m_readFiles;	// by readFile()
+	std::vector<Assignment>		m_assignments;
+	std::vector<int>			m_stack;	// files being parsed
+	std::vector<std::string>	m_dependencies;	// every file read
+	std::vector<std::string>	m_directories;	// those globbed
+
+	void		clearRecord();
+
+	//--------
+	// Not implemented
+	//--------
+	ParseJournal(const ParseJournal &);
+	ParseJournal & operator=(const ParseJournal &);
+};
+
+
+//--------
+// Inline implementation of operations
+//--------
+
+inline bool
+ParseJournal::isRecording() const
+{
+	return m_isValid && !m_stack.empty();
+}
+
+
+inline bool
+ParseJournal::isValid() const
+{
+	return m_isValid;
+}
+
+
+inline bool
+ParseJournal::isComplete() const
+{
+	return m_isComplete;
+}
+
+
+inline bool
+ParseJournal::isStateDependent() const
+{
+	return m_isStateDependent;
+}
+
+
+inline int
+ParseJournal::numFiles() const
+{
+	return (int)m_files.size();
+}
+
+
+inline const char *
+ParseJournal::fileName(int index) const
+{
+	return m_files[index].fileName.c_str();
+}
+
+
+inline bool
+ParseJournal::isStandalone(int index) const
+{
+	return m_files[index].isStandalone;
+}
+
+
+inline const StringVector &
+ParseJournal::topLevelFiles() const
+{
+	return m_topLevelFiles;
+}
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
+#endif
@@ -0,0 +1,256 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+//--------
+// #include's
+//--------
+#include "PatternSet.h"
+#include <string.h>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+
+
+//----------------------------------------------------------------------
+// Function:	Constructors
+//
+// Description:	Sort each pattern into the structure that matches it.
+//
+// Notes:	Matching a prefix byte-by-byte gives the same result as
+//		matching it character-by-character, because decoding
+//		starts at the beginning of the name. That is not true
+//		of a suffix in every multi-byte encoding, so a suffix
+//		pattern is kept as a compiled pattern too, for names
+//		that contain non-ASCII bytes.
+//----------------------------------------------------------------------
+
+PatternSet::PatternSet()
+	: m_isEmpty(true)
+{
+}
+
+
+
+PatternSet::PatternSet(const StringVector & patterns)
+	: m_isEmpty(patterns.length() == 0)
+{
+	int						i;
+	int						len;
+	int						numWildcards;
+	const char *			pattern;
+
+	m_prefixTrie.push_back(TrieNode{-1, -1, '\0', false});
+	m_suffixTrie.push_back(TrieNode{-1, -1, '\0', false});
+	for (i = 0; i < patterns.length(); i++) {
+		pattern = patterns[i];
+		Configuration::Pattern	compiled(pattern);
+
+		len = (int)strlen(pattern);
+		numWildcards = compiled.numWildcards();
+		if (numWildcards == 0) {
+			m_exactStrings.push_back(pattern);
+		} else if (numWildcards == 1 && pattern[len - 1] == '*') {
+			addToTrie(m_prefixTrie, pattern, len - 1, false);
+		} else if (numWildcards == 1 && pattern[0] == '*') {
+			addToTrie(m_suffixTrie, pattern + 1, len - 1, true);
+			m_suffixPatterns.push_back(compiled);
+		} else {
+			m_otherPatterns.push_back(compiled);
+		}
+	}
+
+	//--------
+	// m_exact refers to the strings in m_exactStrings, so it can
+	// be built only after they have all been added.
+	//--------
+	m_exact.reserve(m_exactStrings.size());
+	for (i = 0; i < (int)m_exactStrings.size(); i++) {
+		m_exact.insert(m_exactStrings[i]);
+	}
+}
+
+
+
+PatternSet::~PatternSet()
+{
+	// Nothing to do
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	addToTrie()
+//
+// Description:	Add the len bytes of str, in reverse order if
+//		reversed is true, to trie, and mark the last node as
+//		the end of a pattern.
+//----------------------------------------------------------------------
+
+void
+PatternSet::addToTrie(
+	std::vector<TrieNode> &	trie,
+	const char *			str,
+	int						len,
+	bool					reversed)
+{
+	int						i;
+	int						node;
+	int						child;
+	char					ch;
+
+	node = 0;
+	for (i = 0; i < len; i++) {
+		ch = reversed ? str[len - 1 - i] : str[i];
+		child = findChild(trie, node, ch);
+		if (child == -1) {
+			child = (int)trie.size();
+			trie.push_back(TrieNode{-1, trie[node].firstChild, ch, false});
+			trie[node].firstChild = child;
+		}
+		node = child;
+	}
+	trie[node].isTerminal = true;
+}
+
+
+
+int
+PatternSet::findChild(
+	const std::vector<TrieNode> &	trie,
+	int								node,
+	char							ch)
+{
+	int								child;
+
+	for (child = trie[node].firstChild;
+		 child != -1;
+		 child = trie[child].nextSibling)
+	{
+		if (trie[child].ch == ch) {
+			return child;
+		}
+	}
+	return -1;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	matches()
+//
+// Description:	Returns true if str matches any of the patterns, or
+//		if there are no patterns.
+//----------------------------------------------------------------------
+
+bool
+PatternSet::matches(const char * str) const
+{
+	int						i;
+	int						len;
+	bool					isAscii;
+
+	if (m_isEmpty) {
+		return true;
+	}
+	isAscii = true;
+	for (len = 0; str[len] != '\0'; len++) {
+		if ((unsigned char)str[len] >= 0x80) {
+			isAscii = false;
+		}
+	}
+
+	if (!m_exact.empty()
+		&& m_exact.find(std::string_view(str, len)) != m_exact.end())
+	{
+		return true;
+	}
+	if (matchesPrefix(str)) {
+		return true;
+	}
+	if (isAscii) {
+		if (matchesSuffix(str, len)) {
+			return true;
+		}
+	} else {
+		for (i = 0; i < (int)m_suffixPatterns.size(); i++) {
+			if (m_suffixPatterns[i].matches(str)) {
+				return true;
+			}
+		}
+	}
+	for (i = 0; i < (int)m_otherPatterns.size(); i++) {
+		if (m_otherPatterns[i].matches(str)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+bool
+PatternSet::matchesPrefix(const char * str) const
+{
+	int						node;
+
+	node = 0;
+	while (!m_prefixTrie[node].isTerminal) {
+		if (*str == '\0') {
+			return false;
+		}
+		node = findChild(m_prefixTrie, node, *str);
+		if (node == -1) {
+			return false;
+		}
+		str++;
+	}
+	return true;
+}
+
+
+
+bool
+PatternSet::matchesSuffix(const char * str, int len) const
+{
+	int						node;
+
+	node = 0;
+	while (!m_suffixTrie[node].isTerminal) {
+		if (len == 0) {
+			return false;
+		}
+		len--;
+		node = findChild(m_suffixTrie, node, str[len]);
+		if (node == -1) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
@@ -0,0 +1,120 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+#ifndef CONFIG4CPP_PATTERN_SET_H_
+#define CONFIG4CPP_PATTERN_SET_H_
+
+
+//--------
+// #include's and #define's
+//--------
+#include <config4cpp/Configuration.h>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//----------------------------------------------------------------------
+// Class:	PatternSet
+//
+// Description:	A list of patterns, as used to filter the names
+//		returned by listFullyScopedNames(), compiled once so
+//		that each name can be tested against all of them in
+//		one pass.
+//
+// Notes:	Each pattern is put in the cheapest structure that can
+//		match it:
+//			- "foo" in a hash set;
+//			- "foo*" in a trie of prefixes;
+//			- "*foo" in a trie of reversed suffixes;
+//			- anything else in a list of compiled patterns.
+//		A name matches the set if it matches any pattern. An
+//		empty set matches every name.
+//----------------------------------------------------------------------
+
+class PatternSet
+{
+public:
+	PatternSet();
+	PatternSet(const StringVector & patterns);
+	~PatternSet();
+
+	inline bool		isEmpty() const;
+	bool			matches(const char * str) const;
+
+private:
+	struct TrieNode {
+		int			firstChild;
+		int			nextSibling;
+		char		ch;
+		bool		isTerminal;
+	};
+
+	//--------
+	// Helper operations.
+	//--------
+	static void addToTrie(
+					std::vector<TrieNode> &	trie,
+					const char *			str,
+					int						len,
+					bool					reversed);
+	static int findChild(
+					const std::vector<TrieNode> &	trie,
+					int								node,
+					char							ch);
+	bool matchesPrefix(const char * str) const;
+	bool matchesSuffix(const char * str, int len) const;
+
+	//--------
+	// Instance variables
+	//--------
+	bool								m_isEmpty;
+	std::vector<std::string>			m_exactStrings;
+	std::unordered_set<std::string_view>	m_exact;
+	std::vector<TrieNode>				m_prefixTrie;
+	std::vector<TrieNode>				m_suffixTrie;
+	std::vector<Configuration::Pattern>	m_suffixPatterns;
+	std::vector<Configuration::Pattern>	m_otherPatterns;
+
+	//--------
+	// Not implemented.
+	//--------
+	PatternSet(const PatternSet &);
+	PatternSet & operator=(const PatternSet &);
+};
+
+
+inline bool
+PatternSet::isEmpty() const
+{
+	return m_isEmpty;
+}
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
+#endif
@@ -0,0 +1,263 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+//--------
+// #include's
+//--------
+#include <config4cpp/Configuration.h>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//--------
+// The rows found for strings, split into shards by hash value, so
+// that threads looking up different strings seldom share a lock.
+// Lookups are by string_view, so a hit does not allocate memory.
+// Every lookup holds tableMutex shared, and a rebuild holds it
+// exclusively, so the rows do not change under a lookup.
+//--------
+struct StringViewHash {
+	typedef void is_transparent;
+	size_t operator()(std::string_view str) const
+	{
+		return std::hash<std::string_view>()(str);
+	}
+};
+
+struct Configuration::PatternTable::Cache {
+	static const int NUM_SHARDS = 16;
+
+	struct Shard {
+		std::shared_mutex						mutex;
+		std::unordered_map<std::string, int, StringViewHash,
+						   std::equal_to<> >	rows;
+	};
+
+	std::shared_mutex	tableMutex;
+	Shard				shards[NUM_SHARDS];
+
+	Shard & shardFor(size_t hashVal)
+	{
+		return shards[(hashVal >> 7) % NUM_SHARDS];
+	}
+};
+
+
+
+//----------------------------------------------------------------------
+// Function:	Constructors and destructor
+//----------------------------------------------------------------------
+
+Configuration::PatternTable::PatternTable()
+	: m_cfg(0), m_generation(0), m_numColumns(2), m_cache(new Cache())
+{
+}
+
+
+
+Configuration::PatternTable::PatternTable(
+	const Configuration *	cfg,
+	const char *			scope,
+	const char *			localName,
+	int						numColumns)
+	: m_cfg(0), m_generation(0), m_numColumns(2), m_cache(new Cache())
+{
+	reload(cfg, scope, localName, numColumns);
+}
+
+
+
+Configuration::PatternTable::~PatternTable()
+{
+	delete m_cache;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	reload()
+//
+// Description:	Rebuild the table from the list scope.localName,
+//		and forget the rows found so far.
+//
+// Notes:	The list must have numColumns entries per row, as
+//		SchemaTypeTable requires.
+//----------------------------------------------------------------------
+
+void
+Configuration::PatternTable::reload(
+	const Configuration *	cfg,
+	const char *			scope,
+	const char *			localName,
+	int						numColumns)
+{
+	std::unique_lock<std::shared_mutex>	lock(m_cache->tableMutex);
+
+	m_cfg = cfg;
+	m_scope = scope;
+	m_localName = localName;
+	m_numColumns = numColumns;
+	rebuild();
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	refresh()
+//
+// Description:	Rebuild the table if the configuration has changed
+//		since it was last built.
+//
+// Notes:	Several threads may find the table out of date at
+//		once; the first to get the lock rebuilds it, and the
+//		others then find it up to date.
+//----------------------------------------------------------------------
+
+void
+Configuration::PatternTable::refresh() const
+{
+	std::unique_lock<std::shared_mutex>	lock(m_cache->tableMutex);
+
+	if (m_cfg->generation() != m_generation) {
+		rebuild();
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	rebuild()
+//
+// Description:	Read the rows from the configuration again. The
+//		caller holds tableMutex exclusively.
+//
+// Notes:	The generation is recorded first, so a table that
+//		cannot be built stays empty, rather than throwing from
+//		every findRow(), until the configuration changes again.
+//----------------------------------------------------------------------
+
+void
+Configuration::PatternTable::rebuild() const
+{
+	StringBuffer			msg;
+	StringBuffer			fullyScopedName;
+	int						i;
+
+	m_generation = m_cfg->generation();
+	for (i = 0; i < Cache::NUM_SHARDS; i++) {
+		m_cache->shards[i].rows.clear();
+	}
+	m_cells.empty();
+	m_patterns.clear();
+	m_cfg->lookupList(m_scope.c_str(), m_localName.c_str(), m_cells);
+	if (m_numColumns < 1 || m_cells.length() % m_numColumns != 0) {
+		mergeNames(m_scope.c_str(), m_localName.c_str(), fullyScopedName);
+		msg << m_cfg->fileName() << ": the number of entries in the '"
+			<< fullyScopedName << "' table is not a multiple of "
+			<< m_numColumns;
+		m_cells.empty();
+		throw ConfigurationException(msg.c_str());
+	}
+	m_patterns.reserve(m_cells.length() / m_numColumns);
+	for (i = 0; i < m_cells.length(); i += m_numColumns) {
+		m_patterns.push_back(Pattern(m_cells[i]));
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	findRow()
+//
+// Description:	The first row whose pattern matches str, or -1.
+//
+// Notes:	The result for each distinct str is remembered, up to
+//		MAX_CACHED strings in all, until the configuration
+//		changes and the table is rebuilt.
+//----------------------------------------------------------------------
+
+int
+Configuration::PatternTable::findRow(const char * str) const
+{
+	std::string_view		key(str);
+	size_t					hashVal;
+	int						row;
+
+	std::shared_lock<std::shared_mutex>	tableLock(m_cache->tableMutex);
+
+	if (m_cfg != 0 && m_cfg->generation() != m_generation) {
+		tableLock.unlock();
+		refresh();
+		tableLock.lock();
+	}
+	hashVal = StringViewHash()(key);
+	Cache::Shard &			shard = m_cache->shardFor(hashVal);
+	{
+		std::shared_lock<std::shared_mutex>	lock(shard.mutex);
+		auto				iter = shard.rows.find(key);
+
+		if (iter != shard.rows.end()) {
+			return iter->second;
+		}
+	}
+	row = matchRow(str);
+	{
+		std::unique_lock<std::shared_mutex>	lock(shard.mutex);
+
+		if (shard.rows.size() < MAX_CACHED / Cache::NUM_SHARDS) {
+			shard.rows.emplace(key, row);
+		}
+	}
+	return row;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	matchRow()
+//
+// Description:	findRow() without the cache.
+//----------------------------------------------------------------------
+
+int
+Configuration::PatternTable::matchRow(const char * str) const
+{
+	int						i;
+
+	for (i = 0; i < (int)m_patterns.size(); i++) {
+		if (m_patterns[i].matches(str)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
@@ -211,6 +211,7 @@ SchemaParser::parseIdRule(
 		break;
 	}
 
+	ruleInfo->m_rule = rule;
 	ruleInfo->m_isOptional = isOptional;
 	ruleInfo->m_locallyScopedName = m_token.spelling();
 	accept(SchemaLex::LEX_IDENT_SYM, rule, "expecting an identifier");
@@ -0,0 +1,210 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+
+//--------
+// #include's
+//--------
+#include "SchemaRuleIndex.h"
+#include "SchemaLex.h"
+#include <string.h>
+#include <assert.h>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+
+
+//----------------------------------------------------------------------
+// Function:	Constructor
+//
+// Description:	Index the rules. Only the "@ignore<something>" keyword
+//		of each ignore rule is recorded in the trie, as that is
+//		all shouldIgnore() needs.
+//----------------------------------------------------------------------
+
+SchemaRuleIndex::SchemaRuleIndex(
+	SchemaIdRuleInfo **			idRules,
+	int							numIdRules,
+	SchemaIgnoreRuleInfo **		ignoreRules,
+	int							numIgnoreRules)
+{
+	int							i;
+	int							node;
+	int							child;
+	const char *				name;
+
+	m_idRules.reserve(numIdRules);
+	for (i = 0; i < numIdRules; i++) {
+		m_idRules[idRules[i]->m_locallyScopedName.c_str()] = idRules[i];
+	}
+
+	m_ignoreTrie.push_back(TrieNode{-1, -1, '\0', {}});
+	for (i = 0; i < numIgnoreRules; i++) {
+		node = 0;
+		for (name = ignoreRules[i]->m_locallyScopedName.c_str();
+			 *name != '\0';
+			 name++)
+		{
+			child = findChild(node, *name);
+			if (child == -1) {
+				child = (int)m_ignoreTrie.size();
+				m_ignoreTrie.push_back(TrieNode{
+					-1, m_ignoreTrie[node].firstChild, *name, {}});
+				m_ignoreTrie[node].firstChild = child;
+			}
+			node = child;
+		}
+		m_ignoreTrie[node].symbols.push_back(ignoreRules[i]->m_symbol);
+	}
+}
+
+
+
+SchemaRuleIndex::~SchemaRuleIndex()
+{
+	// Nothing to do
+}
+
+
+
+int
+SchemaRuleIndex::findChild(int node, char ch) const
+{
+	int							child;
+
+	for (child = m_ignoreTrie[node].firstChild;
+		 child != -1;
+		 child = m_ignoreTrie[child].nextSibling)
+	{
+		if (m_ignoreTrie[child].ch == ch) {
+			return child;
+		}
+	}
+	return -1;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	findIdRule()
+//
+// Description:	Returns the id rule for unexpandedName, or 0 if there
+//		is none.
+//----------------------------------------------------------------------
+
+SchemaIdRuleInfo *
+SchemaRuleIndex::findIdRule(const char * unexpandedName) const
+{
+	std::unordered_map<std::string_view, SchemaIdRuleInfo *>
+									::const_iterator	iter;
+
+	iter = m_idRules.find(unexpandedName);
+	if (iter == m_idRules.end()) {
+		return 0;
+	}
+	return iter->second;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	shouldIgnore()
+//
+// Description:	Returns true if an ignore rule applies to the item
+//		called unexpandedName, whose type is cfgType.
+//
+// Notes:	A rule for "foo" applies only to names that start with
+//		"foo.", so the rules at a trie node are considered only
+//		when the walk reaches a "." in unexpandedName.
+//----------------------------------------------------------------------
+
+bool
+SchemaRuleIndex::shouldIgnore(
+	const char *				unexpandedName,
+	Configuration::Type			cfgType) const
+{
+	int							i;
+	int							j;
+	int							node;
+	const char *				lastDot;
+	bool						hasDotAfterPrefix;
+
+	lastDot = strrchr(unexpandedName, '.');
+	if (lastDot == 0) {
+		return false;
+	}
+	node = 0;
+	for (i = 0; unexpandedName + i < lastDot + 1; i++) {
+		if (unexpandedName[i] == '.') {
+			hasDotAfterPrefix = (unexpandedName + i != lastDot);
+			for (j = 0; j < (int)m_ignoreTrie[node].symbols.size(); j++) {
+				if (ruleApplies(m_ignoreTrie[node].symbols[j],
+								hasDotAfterPrefix, cfgType))
+				{
+					return true;
+				}
+			}
+		}
+		node = findChild(node, unexpandedName[i]);
+		if (node == -1) {
+			return false;
+		}
+	}
+	return false;
+}
+
+
+
+bool
+SchemaRuleIndex::ruleApplies(
+	short						symbol,
+	bool						hasDotAfterPrefix,
+	Configuration::Type			cfgType)
+{
+	switch (symbol) {
+	case SchemaLex::LEX_IGNORE_EVERYTHING_IN_SYM:
+		return true;
+	case SchemaLex::LEX_IGNORE_VARIABLES_IN_SYM:
+		//--------
+		// The rule applies only to a variable directly in the scope.
+		//--------
+		return !hasDotAfterPrefix
+			&& (cfgType & Configuration::CFG_VARIABLES) != 0;
+	case SchemaLex::LEX_IGNORE_SCOPES_IN_SYM:
+		//--------
+		// The rule applies to a scope directly in the scope, and
+		// to everything in a nested scope.
+		//--------
+		return hasDotAfterPrefix || cfgType == Configuration::CFG_SCOPE;
+	default:
+		assert(0); // Bug!
+		return false;
+	}
+}
+
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
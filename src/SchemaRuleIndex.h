@@ -0,0 +1,104 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+
+#ifndef CONFIG4CPP_SCHEMA_RULE_INDEX_H_
+#define CONFIG4CPP_SCHEMA_RULE_INDEX_H_
+
+
+//--------
+// #include's and #define's
+//--------
+#include <config4cpp/Configuration.h>
+#include "SchemaRuleInfo.h"
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//----------------------------------------------------------------------
+// Class:	SchemaRuleIndex
+//
+// Description:	Indexes the id rules and ignore rules of a schema, so
+//		that SchemaValidator can find the rules that apply to an
+//		item without scanning all of them.
+//
+// Notes:	Id rules are kept in a hash table, keyed by their
+//		locally-scoped names. Ignore rules are kept in a trie of
+//		their locally-scoped names, so one walk along an item's
+//		name finds every rule whose name is a prefix of it.
+//		The index refers to, but does not own, the rules.
+//----------------------------------------------------------------------
+
+class SchemaRuleIndex
+{
+public:
+	SchemaRuleIndex(
+		SchemaIdRuleInfo **			idRules,
+		int							numIdRules,
+		SchemaIgnoreRuleInfo **		ignoreRules,
+		int							numIgnoreRules);
+	~SchemaRuleIndex();
+
+	SchemaIdRuleInfo * findIdRule(const char * unexpandedName) const;
+	bool shouldIgnore(
+		const char *				unexpandedName,
+		Configuration::Type			cfgType) const;
+
+private:
+	struct TrieNode {
+		int								firstChild;
+		int								nextSibling;
+		char							ch;
+		std::vector<short>				symbols;
+	};
+
+	//--------
+	// Helper operations.
+	//--------
+	int findChild(int node, char ch) const;
+	static bool ruleApplies(
+		short						symbol,
+		bool						hasDotAfterPrefix,
+		Configuration::Type			cfgType);
+
+	//--------
+	// Instance variables
+	//--------
+	std::unordered_map<std::string_view, SchemaIdRuleInfo *>	m_idRules;
+	std::vector<TrieNode>		m_ignoreTrie;
+
+	//--------
+	// Not implemented.
+	//--------
+	SchemaRuleIndex(const SchemaRuleIndex &);
+	SchemaRuleIndex & operator=(const SchemaRuleIndex &);
+};
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
+#endif
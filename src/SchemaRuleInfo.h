@@ -36,6 +36,7 @@ namespace CONFIG4CPP_NAMESPACE {
 
 class SchemaIdRuleInfo {
 public:
+	StringBuffer		m_rule;
 	StringBuffer		m_locallyScopedName;
 	StringBuffer		m_typeName;
 	StringVector		m_args;
@@ -61,6 +61,7 @@ SchemaTypeTypedef::validate(
 	SchemaType *				baseTypeDef;
 	const char *				baseTypeName;
 
+        (void)typeArgs;
 	assert(typeArgs.length() == 0);
 	baseTypeName = m_baseTypeName.c_str();
 	baseTypeDef = findType(sv, baseTypeName);
@@ -85,6 +86,7 @@ SchemaTypeTypedef::isA(
 	const char *				baseTypeName;
 	bool						result;
 
+        (void)typeArgs;
 	assert(typeArgs.length() == 0);
 	baseTypeName = m_baseTypeName.c_str();
 	baseTypeDef = findType(sv, baseTypeName);
@@ -26,7 +26,9 @@
 // #include's
 //--------
 #include <config4cpp/SchemaValidator.h>
+#include "ConfigurationImpl.h"
 #include "SchemaParser.h"
+#include "SchemaRuleIndex.h"
 #include "SchemaRuleInfo.h"
 #include "SchemaTypeBoolean.h"
 #include "SchemaTypeDurationMicroseconds.h"
@@ -53,6 +55,10 @@
 #include <ctype.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <atomic>
+#include <exception>
+#include <system_error>
+#include <thread>
 
 
 namespace CONFIG4CPP_NAMESPACE {
@@ -109,20 +115,10 @@ CONFIG4CPP_C_PREFIX(compareSchemaType_c)(const void * p1, const void * p2)
 SchemaIdRuleInfo *
 SchemaValidator::findIdRule(const char * name) const
 {
-	SchemaIdRuleInfo		search;
-	SchemaIdRuleInfo *		searchPtr;
-	SchemaIdRuleInfo **		result;
-
-	search.m_locallyScopedName = name;
-	searchPtr = &search;
-	result = (SchemaIdRuleInfo **)
-		bsearch(&searchPtr, m_idRules, m_idRulesCurrSize,
-				sizeof(SchemaIdRuleInfo*),
-				CONFIG4CPP_C_PREFIX(compareSchemaIdRuleInfo_c));
-	if (result == 0) {
+	if (m_ruleIndex == 0) {
 		return 0;
 	}
-	return *result;
+	return m_ruleIndex->findIdRule(name);
 }
 
 
@@ -180,12 +176,14 @@ SchemaValidator::SchemaValidator()
 {
 	try {
 		m_wantDiagnostics     = false;
+		m_numThreads          = 1;
 		m_idRulesCurrSize     = 0;
 		m_idRulesMaxSize      = 0;
 		m_idRules             = 0;
 		m_ignoreRulesCurrSize = 0;
 		m_ignoreRulesMaxSize  = 0;
 		m_ignoreRules         = 0;
+		m_ruleIndex           = 0;
 		m_typesMaxSize        = 25; // can grow bigger, if necessary
 		m_types               = new SchemaType*[m_typesMaxSize];
 		m_typesCurrSize       = 0;
@@ -215,6 +213,9 @@ SchemaValidator::reset(bool inDelete)
 {
 	int				i;
 
+	delete m_ruleIndex;
+	m_ruleIndex = 0;
+
 	for (i = 0; i < m_idRulesCurrSize; i++) {
 		delete m_idRules[i];
 	}
@@ -372,6 +373,8 @@ SchemaValidator::parseSchema(
 		}
 		throw;
 	}
+	m_ruleIndex = new SchemaRuleIndex(m_idRules, m_idRulesCurrSize,
+									  m_ignoreRules, m_ignoreRulesCurrSize);
 	if (m_wantDiagnostics) {
 		printf("\n%s: end\n\n", prefix);
 	}
@@ -390,18 +393,59 @@ SchemaValidator::validate(
 {
 	StringBuffer				fullyScopedName;
 	StringVector				itemNames;
+	StringVector				unexpandedItemNames;
+	std::vector<const ConfigItem *>	items;
 
 	//--------
-	// Get a list of the entries in the scope.
+	// Get a list of the entries in the scope, along with their
+	// unexpanded names and items, so that validating them does
+	// not need to look each one up again.
 	//--------
 	cfg->mergeNames(scope, localName, fullyScopedName);
-	cfg->listLocallyScopedNames(scope, localName, typeMask,
-								recurseIntoSubscopes, itemNames);
+	static_cast<const ConfigurationImpl *>(cfg)->listLocallyScopedItems(
+								scope, localName, typeMask,
+								recurseIntoSubscopes, itemNames,
+								unexpandedItemNames, items);
 
 	//--------
 	// Now validte those names
 	//--------
-	validate(cfg, scope, localName, itemNames, forceMode);
+	validate(cfg, scope, localName, itemNames, unexpandedItemNames, items,
+			 forceMode, 0);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	validate()
+//
+// Description:	As above, but rather than throwing an exception for
+//		the first error, carry on and put every error in errors.
+//		An exception thrown by a SchemaType that is not a
+//		ConfigurationException still stops validation.
+//----------------------------------------------------------------------
+
+void
+SchemaValidator::validate(
+	const Configuration *		cfg,
+	const char *				scope,
+	const char *				localName,
+	bool						recurseIntoSubscopes,
+	Configuration::Type			typeMask,
+	ForceMode					forceMode,
+	std::vector<Error> &		errors) const
+{
+	StringVector				itemNames;
+	StringVector				unexpandedItemNames;
+	std::vector<const ConfigItem *>	items;
+
+	errors.clear();
+	static_cast<const ConfigurationImpl *>(cfg)->listLocallyScopedItems(
+								scope, localName, typeMask,
+								recurseIntoSubscopes, itemNames,
+								unexpandedItemNames, items);
+	validate(cfg, scope, localName, itemNames, unexpandedItemNames, items,
+			 forceMode, &errors);
 }
 
 
@@ -412,19 +456,12 @@ SchemaValidator::validate(
 	const char *			scope,
 	const char *			localName,
 	const StringVector &	itemNames,
-	ForceMode				forceMode) const
+	const StringVector &	unexpandedItemNames,
+	const std::vector<const ConfigItem *> &	items,
+	ForceMode				forceMode,
+	std::vector<Error> *	errors) const
 {
 	StringBuffer			fullyScopedName;
-	StringBuffer			unlistedName;
-	StringBuffer			msg;
-	StringBuffer			buf;
-	const char *			unexpandedName;
-	const char *			typeName;
-	const char *			iName;
-	int						i;
-	int						len;
-	SchemaIdRuleInfo *		idRule;
-	SchemaType *			typeDef;
 	const char *			prefix = "---- " CONFIG4CPP_NAMESPACE_STR
 									 "::SchemaValidator::validate()";
 
@@ -436,66 +473,296 @@ SchemaValidator::validate(
 	//--------
 	// Compare every name in itemNames with m_ignoreRules and m_idRules.
 	//--------
+	if (m_numThreads > 1 && !m_wantDiagnostics) {
+		validateItemsInParallel(cfg, fullyScopedName.c_str(), itemNames,
+								unexpandedItemNames, items, errors);
+	} else {
+		validateItems(cfg, fullyScopedName.c_str(), itemNames,
+					  unexpandedItemNames, items, errors);
+	}
+
+	validateForceMode(cfg, scope, localName, forceMode, errors);
+
+	if (m_wantDiagnostics) {
+		printf("\n%s: end\n\n", prefix);
+	}
+}
+
+
+
+void
+SchemaValidator::validateItems(
+	const Configuration *	cfg,
+	const char *			fullyScopedName,
+	const StringVector &	itemNames,
+	const StringVector &	unexpandedItemNames,
+	const std::vector<const ConfigItem *> &	items,
+	std::vector<Error> *	errors) const
+{
+	int						i;
+	int						len;
+
+	len = itemNames.length();
+	for (i = 0; i < len; i++) {
+		validateItem(cfg, fullyScopedName, itemNames[i],
+					 unexpandedItemNames[i], items[i], errors);
+	}
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	validateItemsInParallel()
+//
+// Description:	As validateItems(), but on up to m_numThreads threads.
+//
+// Notes:	The items of one top-level scope are listed together,
+//		so the list is cut into chunks only where the top-level
+//		scope changes.  Threads take chunks in turn until none are
+//		left.  Each chunk stops at its first invalid item, and
+//		chunks after the first invalid item found so far are
+//		skipped.  The error rethrown is from the invalid item
+//		that comes first in the list, which is the one the serial
+//		path would have reported.
+//
+//		When collecting errors, each chunk collects its own, and
+//		they are appended to errors in chunk order, so they are
+//		in the same order as on the serial path.
+//----------------------------------------------------------------------
+
+void
+SchemaValidator::validateItemsInParallel(
+	const Configuration *	cfg,
+	const char *			fullyScopedName,
+	const StringVector &	itemNames,
+	const StringVector &	unexpandedItemNames,
+	const std::vector<const ConfigItem *> &	items,
+	std::vector<Error> *	errors) const
+{
+	int						i;
+	int						len;
+	int						chunkSize;
+	int						numThreads;
+	int						firstChunk;
+	int						prevTopLen;
+	int						topLen;
+	const char *			dot;
+	std::vector<int>		chunkStarts;
+	std::vector<std::thread>	threads;
+	std::atomic<int>		nextChunk(0);
+	std::atomic<int>		firstFailure;
+	std::vector<int>		failures;
+	std::vector<std::exception_ptr>	exceptions;
+	std::vector<std::vector<Error> >	chunkErrors;
+
+	//--------
+	// Cut the list into about four chunks per thread, for balance.
+	//--------
 	len = itemNames.length();
+	chunkSize = len / (m_numThreads * 4) + 1;
+	prevTopLen = 0;
 	for (i = 0; i < len; i++) {
-		iName = itemNames[i];
-		unexpandedName = cfg->unexpandUid(iName, buf);
-		if (shouldIgnore(cfg, scope, iName, unexpandedName)) {
-			if (m_wantDiagnostics) {
-				printf("\n  ignoring '%s'\n", iName);
-			}
-			continue;
+		dot = strchr(itemNames[i], '.');
+		topLen = (dot == 0) ? (int)strlen(itemNames[i])
+							: (int)(dot - itemNames[i]);
+		if (chunkStarts.empty()
+			|| (i - chunkStarts.back() >= chunkSize
+				&& (topLen != prevTopLen
+					|| strncmp(itemNames[i], itemNames[i-1], topLen) != 0)))
+		{
+			chunkStarts.push_back(i);
 		}
-		idRule = findIdRule(unexpandedName);
-		if (idRule == 0) {
-			//--------
-			// Can't find an idRule for the entry
-			//--------
-			cfg->mergeNames(fullyScopedName.c_str(),
-						iName, unlistedName);
-			switch (cfg->type(unlistedName.c_str(), "")) {
-			case Configuration::CFG_SCOPE:
-				msg << cfg->fileName() << ": " << "the '" << unlistedName
-					<< "' scope is unknown.";
-				break;
-			case Configuration::CFG_LIST:
-			case Configuration::CFG_STRING:
-				msg << cfg->fileName() << ": " << "the '" << unlistedName
-					<< "' variable is unknown.";
-				break;
-			default:
-				assert(0); // Bug!
-			}
-			if (m_wantDiagnostics) {
-				printf("\n%s: error: %s\n",
-					prefix, msg.c_str());
+		prevTopLen = topLen;
+	}
+	chunkStarts.push_back(len);
+
+	failures.assign(chunkStarts.size() - 1, len);
+	exceptions.resize(chunkStarts.size() - 1);
+	chunkErrors.resize(chunkStarts.size() - 1);
+	firstFailure = len;
+	auto worker = [&]() {
+		int			chunk;
+		int			failure;
+		int			j;
+
+		while ((chunk = nextChunk++) < (int)chunkStarts.size() - 1) {
+			for (j = chunkStarts[chunk]; j < chunkStarts[chunk + 1]; j++) {
+				if (j > firstFailure.load(std::memory_order_relaxed)) {
+					break;
+				}
+				try {
+					validateItem(cfg, fullyScopedName, itemNames[j],
+								 unexpandedItemNames[j], items[j],
+								 errors ? &chunkErrors[chunk] : 0);
+				} catch (...) {
+					exceptions[chunk] = std::current_exception();
+					failures[chunk] = j;
+					failure = firstFailure.load();
+					while (j < failure
+						   && !firstFailure.compare_exchange_weak(failure, j))
+					{
+					}
+					break;
+				}
 			}
-			throw ConfigurationException(msg.c_str());
 		}
+	};
 
+	//--------
+	// This thread validates chunks too, so it needs one fewer
+	// helper.  If a thread cannot be started, the threads that
+	// did start (and this one) validate the remaining chunks.
+	//--------
+	numThreads = m_numThreads;
+	if (numThreads > (int)chunkStarts.size() - 1) {
+		numThreads = (int)chunkStarts.size() - 1;
+	}
+	try {
+		for (i = 1; i < numThreads; i++) {
+			threads.push_back(std::thread(worker));
+		}
+	} catch (const std::system_error &) {
+	}
+	worker();
+	for (i = 0; i < (int)threads.size(); i++) {
+		threads[i].join();
+	}
+
+	firstChunk = -1;
+	for (i = 0; i < (int)failures.size(); i++) {
+		if (failures[i] < len
+			&& (firstChunk == -1 || failures[i] < failures[firstChunk]))
+		{
+			firstChunk = i;
+		}
+	}
+	if (firstChunk != -1) {
+		std::rethrow_exception(exceptions[firstChunk]);
+	}
+	if (errors != 0) {
+		for (i = 0; i < (int)chunkErrors.size(); i++) {
+			errors->insert(errors->end(), chunkErrors[i].begin(),
+						   chunkErrors[i].end());
+		}
+	}
+}
+
+
+
+void
+SchemaValidator::validateItem(
+	const Configuration *	cfg,
+	const char *			fullyScopedName,
+	const char *			iName,
+	const char *			unexpandedName,
+	const ConfigItem *		item,
+	std::vector<Error> *	errors) const
+{
+	StringBuffer			unlistedName;
+	StringBuffer			msg;
+	const char *			typeName;
+	SchemaIdRuleInfo *		idRule;
+	SchemaType *			typeDef;
+	const char *			prefix = "---- " CONFIG4CPP_NAMESPACE_STR
+									 "::SchemaValidator::validate()";
+
+	if (shouldIgnore(unexpandedName, item->type())) {
+		if (m_wantDiagnostics) {
+			printf("\n  ignoring '%s'\n", iName);
+		}
+		return;
+	}
+	idRule = findIdRule(unexpandedName);
+	if (idRule == 0) {
 		//--------
-		// There is an idRule for the entry. Look up the idRule's
-		// type, and invoke its validate() operation.
+		// Can't find an idRule for the entry
 		//--------
-		typeName = idRule->m_typeName.c_str();
-		typeDef = findType(typeName);
-		assert(typeDef != 0);
-		try { 
-			callValidate(typeDef, cfg, fullyScopedName.c_str(), iName,
-						 typeName, typeName, idRule->m_args, 1);
-		} catch (const ConfigurationException & ex) {
+		cfg->mergeNames(fullyScopedName, iName, unlistedName);
+		switch (item->type()) {
+		case Configuration::CFG_SCOPE:
+			msg << cfg->fileName() << ": " << "the '" << unlistedName
+				<< "' scope is unknown.";
+			break;
+		case Configuration::CFG_LIST:
+		case Configuration::CFG_STRING:
+			msg << cfg->fileName() << ": " << "the '" << unlistedName
+				<< "' variable is unknown.";
+			break;
+		default:
+			assert(0); // Bug!
+		}
+		if (m_wantDiagnostics) {
+			printf("\n%s: error: %s\n",
+				prefix, msg.c_str());
+		}
+		reportError(cfg, unlistedName.c_str(), 0, msg.c_str(), errors);
+		return;
+	}
+
+	//--------
+	// There is an idRule for the entry. Look up the idRule's
+	// type, and invoke its validate() operation.
+	//--------
+	typeName = idRule->m_typeName.c_str();
+	typeDef = findType(typeName);
+	assert(typeDef != 0);
+	try { 
+		callValidate(typeDef, cfg, fullyScopedName, iName,
+					 typeName, typeName, idRule->m_args, 1);
+	} catch (const ConfigurationException & ex) {
+		if (errors == 0) {
 			if (m_wantDiagnostics) {
 				printf("\n%s: end\n\n", prefix);
 			}
 			throw;
 		}
+		cfg->mergeNames(fullyScopedName, iName, unlistedName);
+		reportError(cfg, unlistedName.c_str(), idRule, ex.c_str(), errors);
 	}
+}
 
-	validateForceMode(cfg, scope, localName, forceMode);
 
-	if (m_wantDiagnostics) {
-		printf("\n%s: end\n\n", prefix);
+
+//----------------------------------------------------------------------
+// Function:	reportError()
+//
+// Description:	Throw an exception for the error or, if errors is not
+//		null, add a record of it to errors.
+//
+// Notes:	The record gives the file and line at which the entry
+//		was defined if they are known, and otherwise the
+//		configuration's file name and a line number of -1.
+//----------------------------------------------------------------------
+
+void
+SchemaValidator::reportError(
+	const Configuration *		cfg,
+	const char *				fullyScopedName,
+	const SchemaIdRuleInfo *	idRule,
+	const char *				message,
+	std::vector<Error> *		errors) const
+{
+	Error						error;
+	const char *				fileName;
+
+	if (errors == 0) {
+		throw ConfigurationException(message);
 	}
+	error.fullyScopedName = fullyScopedName;
+	if (idRule != 0) {
+		error.rule = idRule->m_rule;
+		error.typeName = idRule->m_typeName;
+	}
+	error.message = message;
+	if ((cfg->type(fullyScopedName, "") & Configuration::CFG_VARIABLES) == 0
+		|| !cfg->lookupLocation(fullyScopedName, "", fileName,
+								error.lineNumber))
+	{
+		fileName = cfg->fileName();
+		error.lineNumber = -1;
+	}
+	error.fileName = fileName;
+	errors->push_back(error);
 }
 
 
@@ -505,7 +772,8 @@ SchemaValidator::validateForceMode(
 	const Configuration *	cfg,
 	const char *			scope,
 	const char *			localName,
-	ForceMode				forceMode) const
+	ForceMode				forceMode,
+	std::vector<Error> *	errors) const
 {
 	int						i;
 	bool					isOptional;
@@ -530,7 +798,7 @@ SchemaValidator::validateForceMode(
 		nameInRule = idRule->m_locallyScopedName.c_str();
 		if (strstr(nameInRule, "uid-") != 0) {
 			validateRequiredUidEntry(cfg, fullyScopedName.c_str(),
-						  idRule);
+						  idRule, errors);
 		} else {
 			if (cfg->type(fullyScopedName.c_str(), nameInRule)
 		           == Configuration::CFG_NO_VALUE)
@@ -538,9 +806,11 @@ SchemaValidator::validateForceMode(
 				cfg->mergeNames(fullyScopedName.c_str(),
 						nameInRule, nameOfMissingEntry);
 				typeName = idRule->m_typeName.c_str();
+				msg.empty();
 				msg << cfg->fileName() << ": the " << typeName << " '"
 					<< nameOfMissingEntry << "' does not exist";
-				throw ConfigurationException(msg.c_str());
+				reportError(cfg, nameOfMissingEntry.c_str(), idRule,
+							msg.c_str(), errors);
 			}
 		}
 	}
@@ -552,7 +822,8 @@ void
 SchemaValidator::validateRequiredUidEntry(
 	const Configuration *	cfg,
 	const char *			fullScope,
-	SchemaIdRuleInfo *		idRule) const
+	SchemaIdRuleInfo *		idRule,
+	std::vector<Error> *	errors) const
 {
 	const char *			nameInRule;
 	const char *			lastDot;
@@ -587,9 +858,11 @@ SchemaValidator::validateRequiredUidEntry(
 		{
 			cfg->mergeNames(parentScopes[i], lastDot+1, nameOfMissingEntry);
 			typeName = idRule->m_typeName.c_str();
+			msg.empty();
 			msg << cfg->fileName() << ": the " << typeName << " '"
 				<< nameOfMissingEntry << "' does not exist";
-			throw ConfigurationException(msg.c_str());
+			reportError(cfg, nameOfMissingEntry.c_str(), idRule,
+						msg.c_str(), errors);
 		}
 	}
 }
@@ -598,93 +871,13 @@ SchemaValidator::validateRequiredUidEntry(
 
 bool
 SchemaValidator::shouldIgnore(
-	const Configuration *	cfg,
-	const char *			scope,
-	const char *			expandedName,
-	const char *			unexpandedName) const
+	const char *			unexpandedName,
+	Configuration::Type		cfgType) const
 {
-	int						i;
-	int						len;
-	short					symbol;
-	const char *			name;
-	const char *			nameAfterPrefix;
-	bool					hasDotAfterPrefix;
-	Configuration::Type		cfgType;
-
-	for (i = 0; i < m_ignoreRulesCurrSize; i++) {
-		//--------
-		// Does unexpandedName start with rule.m_locallyScopedName
-		// followed by "."?
-		//--------
-		name = m_ignoreRules[i]->m_locallyScopedName.c_str();
-		len = strlen(name);
-		if (strncmp(unexpandedName, name, len) != 0) {
-			continue;
-		}
-		if (unexpandedName[len] != '.') {
-			continue;
-		}
-
-		//--------
-		// It does. Whether we ignore the item depends on the
-		// "@ignore<something>" keyword used.
-		//--------
-		symbol = m_ignoreRules[i]->m_symbol;
-		switch (symbol) {
-		case SchemaLex::LEX_IGNORE_EVERYTHING_IN_SYM:
-			return true;
-		case SchemaLex::LEX_IGNORE_SCOPES_IN_SYM:
-		case SchemaLex::LEX_IGNORE_VARIABLES_IN_SYM:
-			break;
-		default:
-			assert(0); // Bug!
-			break;
-		}
-		nameAfterPrefix = unexpandedName + len + 1;
-		hasDotAfterPrefix = (strchr(nameAfterPrefix, '.') != 0);
-		try {
-			cfgType = cfg->type(scope, expandedName);
-		} catch(const ConfigurationException & ex) {
-			assert(0); // Bug!
-		}
-		if (symbol == SchemaLex::LEX_IGNORE_VARIABLES_IN_SYM) {
-			if (hasDotAfterPrefix) {
-				//--------
-				// The item is a variable in a nested scope so
-				// the "@ignoreVariablesIn" rule does not apply.
-				//--------
-				continue;
-			}
-			//--------
-			// The item is directly in the scope, so the
-			// "@ignoreVariablesIn" rule applies if the item
-			// is a variable.
-			//--------
-			if ((cfgType & Configuration::CFG_VARIABLES) != 0) {
-				return true;
-			} else {
-				continue;
-			}
-		}
-
-		assert(symbol == SchemaLex::LEX_IGNORE_SCOPES_IN_SYM);
-		if (hasDotAfterPrefix) {
-			//--------
-			// The item is in a *nested* scope, so we ignore it.
-			//--------
-			return true;
-		}
-		//--------
-		// The item is directly in the ignore-able scope,
-		// so we ignore it only if the item is a scope.
-		//--------
-		if (cfgType == Configuration::CFG_SCOPE) {
-			return true;
-		} else {
-			continue;
-		}
+	if (m_ruleIndex == 0) {
+		return false;
 	}
-	return false;
+	return m_ruleIndex->shouldIgnore(unexpandedName, cfgType);
 }
 
 
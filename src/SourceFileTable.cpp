@@ -0,0 +1,168 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+
+//--------
+// #include's
+//--------
+#include "SourceFileTable.h"
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//--------
+// The names are kept in chunks that are never moved or freed, each
+// twice the size of the one before, so that fileName() can read the
+// table without a lock: intern() fills in a slot, and the chunk if it
+// is new, before it publishes the new size with a release store, and
+// fileName() reads the size with an acquire load before it reads a
+// slot below it. Only intern() takes the mutex.
+//
+// The table is built on first use, so it does not depend on the
+// order in which static objects are initialised.
+//--------
+enum {
+	FIRST_CHUNK_SIZE	= 16,
+	MAX_CHUNKS			= 27	// enough for 2^31 names
+};
+
+struct SourceFileTableData {
+	std::mutex										mutex;
+	std::atomic<unsigned int>						size;
+	const char **									chunks[MAX_CHUNKS];
+	std::unordered_map<std::string, unsigned int>	indices;
+
+	SourceFileTableData()
+	{
+		memset(chunks, 0, sizeof(chunks));
+		chunks[0] = new const char *[FIRST_CHUNK_SIZE];
+		chunks[0][0] = "";
+		size.store(1, std::memory_order_relaxed);
+	}
+};
+
+
+static SourceFileTableData &
+sourceFileTableData()
+{
+	static SourceFileTableData *	data = new SourceFileTableData();
+
+	return *data;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	findSlot()
+//
+// Description:	Find the chunk that holds the given index, and the
+//		slot within it.
+//----------------------------------------------------------------------
+
+static void
+findSlot(unsigned int index, int & chunk, unsigned int & offset)
+{
+	unsigned int			chunkSize;
+
+	chunk = 0;
+	chunkSize = FIRST_CHUNK_SIZE;
+	while (index >= chunkSize) {
+		index -= chunkSize;
+		chunkSize *= 2;
+		chunk++;
+	}
+	offset = index;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	intern()
+//
+// Description:	Return the index of fileName, adding it to the table
+//		if it is not there already.
+//----------------------------------------------------------------------
+
+unsigned int
+SourceFileTable::intern(const char * fileName)
+{
+	SourceFileTableData &			data = sourceFileTableData();
+	std::unordered_map<std::string, unsigned int>::iterator	iter;
+	unsigned int					result;
+	unsigned int					offset;
+	int								chunk;
+	char *							copy;
+
+	if (fileName[0] == '\0') {
+		return 0;
+	}
+	std::lock_guard<std::mutex>		lock(data.mutex);
+	iter = data.indices.find(fileName);
+	if (iter != data.indices.end()) {
+		return iter->second;
+	}
+	result = data.size.load(std::memory_order_relaxed);
+	findSlot(result, chunk, offset);
+	if (offset == 0) {
+		data.chunks[chunk] = new const char *[FIRST_CHUNK_SIZE << chunk];
+	}
+	copy = new char[strlen(fileName) + 1];
+	strcpy(copy, fileName);
+	data.chunks[chunk][offset] = copy;
+	data.indices[fileName] = result;
+	data.size.store(result + 1, std::memory_order_release);
+	return result;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	fileName()
+//
+// Description:	Return the name with the given index, or "" if the
+//		index is 0 or out of range.
+//----------------------------------------------------------------------
+
+const char *
+SourceFileTable::fileName(unsigned int index)
+{
+	SourceFileTableData &			data = sourceFileTableData();
+	unsigned int					offset;
+	int								chunk;
+
+	if (index >= data.size.load(std::memory_order_acquire)) {
+		return "";
+	}
+	findSlot(index, chunk, offset);
+	return data.chunks[chunk][offset];
+}
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
@@ -0,0 +1,74 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+
+#ifndef CONFIG4CPP_SOURCE_FILE_TABLE_H_
+#define CONFIG4CPP_SOURCE_FILE_TABLE_H_
+
+
+//--------
+// #include's and #define's
+//--------
+#include <config4cpp/Configuration.h>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//----------------------------------------------------------------------
+// Class:	SourceFileTable
+//
+// Description:	A process-wide table of the names of the files that
+//		configurations were parsed from. A ConfigItem records
+//		the file it was defined in as a small index into this
+//		table instead of a copy of the name, so a million items
+//		parsed from a handful of files cost one 32-bit word each.
+//
+// Notes:	Index 0 means "unknown" and maps to "". Names are never
+//		removed, so a pointer returned by fileName() stays valid
+//		for the life of the process, and the table grows with
+//		the number of distinct file names parsed by the process,
+//		not with the number of configurations or items. Both
+//		operations are safe to call from several threads;
+//		fileName() does not take a lock, so looking up a
+//		location costs a few loads, and only intern(), once per
+//		file parsed, does.
+//----------------------------------------------------------------------
+
+class SourceFileTable
+{
+public:
+	static unsigned int		intern(const char * fileName);
+	static const char *		fileName(unsigned int index);
+
+private:
+	//--------
+	// Not instantiable
+	//--------
+	SourceFileTable();
+};
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
+#endif
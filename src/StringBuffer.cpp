@@ -110,6 +110,18 @@ StringBuffer::append(const char *str)
 
 
 
+StringBuffer &
+StringBuffer::append(const char * str, int len)
+{
+	growIfNeeded(len);
+	memcpy(&m_buf[m_currSize-1], str, len);
+	m_buf[m_currSize-1+len] = '\0';
+	m_currSize += len;
+	return *this;
+}
+
+
+
 StringBuffer &
 StringBuffer::append(const StringBuffer & other)
 {
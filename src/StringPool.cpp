@@ -0,0 +1,189 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+
+//--------
+// #include's
+//--------
+#include "StringPool.h"
+#include <string.h>
+#include <utility>
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//--------
+// The table is kept at most three-quarters full.
+//--------
+enum {
+	INITIAL_TABLE_SIZE = 64
+};
+
+
+
+//----------------------------------------------------------------------
+// Function:	Constructor
+//
+// Description:	The table is not allocated until the first string is
+//		interned.
+//----------------------------------------------------------------------
+
+StringPool::StringPool(Arena & arena)
+	: m_arena(arena)
+{
+	m_slots      = 0;
+	m_tableSize  = 0;
+	m_numStrings = 0;
+	m_bytesSaved = 0;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	intern()
+//
+// Description:	Return the pooled copy of str, adding one if needed.
+//
+// Notes:	The hash (the same djb2 loop and avalanche step that
+//		ConfigScope uses) also finds the length, and stops once
+//		the string is known to be too long to intern.
+//----------------------------------------------------------------------
+
+const char *
+StringPool::intern(const char * str)
+{
+	unsigned int		hashVal;
+	const char *		p;
+	int					mask;
+	int					pos;
+	Slot *				slot;
+	char *				copy;
+
+	hashVal = 5381;
+	for (p = str; *p != '\0'; p++) {
+		if (p - str == MAX_LENGTH) {
+			return m_arena.copyString(str);
+		}
+		hashVal = ((hashVal << 5) + hashVal) + (unsigned int)(*p);
+	}
+	hashVal *= 0x9e3779b1u;
+	hashVal ^= hashVal >> 15;
+
+	if ((m_numStrings + 1) * 4 > m_tableSize * 3) {
+		grow();
+	}
+	mask = m_tableSize - 1;
+	pos = (int)(hashVal & (unsigned int)mask);
+	while ((slot = &m_slots[pos])->str != 0) {
+		if (slot->hash == hashVal
+		    && (slot->str == str || !strcmp(slot->str, str)))
+		{
+			m_bytesSaved += (p - str) + 1;
+			return slot->str;
+		}
+		pos = (pos + 1) & mask;
+	}
+	copy = m_arena.copyString(str);
+	slot->str = copy;
+	slot->hash = hashVal;
+	m_numStrings++;
+	return copy;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	grow()
+//
+// Description:	Double the size of the table (linear probing).
+//----------------------------------------------------------------------
+
+void
+StringPool::grow()
+{
+	Slot *				origSlots;
+	int					origTableSize;
+	int					mask;
+	int					pos;
+	int					i;
+
+	origSlots = m_slots;
+	origTableSize = m_tableSize;
+	m_tableSize = (m_tableSize == 0) ? INITIAL_TABLE_SIZE : m_tableSize * 2;
+	m_slots = (Slot *)m_arena.allocate(sizeof(Slot) * m_tableSize);
+	memset(m_slots, 0, sizeof(Slot) * m_tableSize);
+	mask = m_tableSize - 1;
+	for (i = 0; i < origTableSize; i++) {
+		if (origSlots[i].str == 0) {
+			continue;
+		}
+		pos = (int)(origSlots[i].hash & (unsigned int)mask);
+		while (m_slots[pos].str != 0) {
+			pos = (pos + 1) & mask;
+		}
+		m_slots[pos] = origSlots[i];
+	}
+	m_arena.deallocate(origSlots, sizeof(Slot) * origTableSize);
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	release()
+//
+// Description:	Forget every string. The memory itself belongs to the
+//		arena, which is being released too.
+//----------------------------------------------------------------------
+
+void
+StringPool::release()
+{
+	m_slots      = 0;
+	m_tableSize  = 0;
+	m_numStrings = 0;
+	m_bytesSaved = 0;
+}
+
+
+
+//----------------------------------------------------------------------
+// Function:	swap()
+//
+// Description:	Exchange strings with another pool. The two arenas
+//		must be swapped as well, since each holds its pool's
+//		table and strings.
+//----------------------------------------------------------------------
+
+void
+StringPool::swap(StringPool & other)
+{
+	std::swap(m_slots, other.m_slots);
+	std::swap(m_tableSize, other.m_tableSize);
+	std::swap(m_numStrings, other.m_numStrings);
+	std::swap(m_bytesSaved, other.m_bytesSaved);
+}
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
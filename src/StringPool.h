@@ -0,0 +1,124 @@
+//-----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+
+
+#ifndef CONFIG4CPP_STRING_POOL_H_
+#define CONFIG4CPP_STRING_POOL_H_
+
+
+//--------
+// #include's and #define's
+//--------
+#include "Arena.h"
+
+
+namespace CONFIG4CPP_NAMESPACE {
+
+//----------------------------------------------------------------------
+// Class:	StringPool
+//
+// Description:	Interns strings in an Arena, so that equal strings share
+//		one copy. Generated configurations repeat the same names
+//		("host", "port", "timeout") and often the same values
+//		in thousands of scopes; each is stored only once.
+//
+// Notes:	Two interned strings are equal if and only if their
+//		pointers are equal, but only strings of at most MAX_LENGTH
+//		characters are interned: longer ones are rarely repeated,
+//		so intern() simply copies them into the arena.
+//		The table lives in the arena too. release() must be
+//		called whenever the arena is released.
+//----------------------------------------------------------------------
+
+class StringPool
+{
+public:
+	enum {
+		MAX_LENGTH = 128
+	};
+
+	StringPool(Arena & arena);
+
+	const char *		intern(const char * str);
+	void				release();
+	void				swap(StringPool & other);
+
+	inline Arena &		arena();
+	inline int			numStrings() const;
+	inline size_t		bytesSaved() const;
+
+private:
+	struct Slot {
+		const char *	str;	// 0 if the slot is empty
+		unsigned int	hash;
+	};
+
+	void				grow();
+
+	//--------
+	// Instance variables
+	//--------
+	Arena &				m_arena;
+	Slot *				m_slots;
+	int					m_tableSize;
+	int					m_numStrings;
+	size_t				m_bytesSaved;
+
+	//--------
+	// Not implemented
+	//--------
+	StringPool(const StringPool &);
+	StringPool & operator=(const StringPool &);
+};
+
+
+//--------
+// Inline implementation of operations
+//--------
+
+inline Arena &
+StringPool::arena()
+{
+	return m_arena;
+}
+
+
+inline int
+StringPool::numStrings() const
+{
+	return m_numStrings;
+}
+
+
+inline size_t
+StringPool::bytesSaved() const
+{
+	return m_bytesSaved;
+}
+
+
+}; // namespace CONFIG4CPP_NAMESPACE
+#endif
@@ -78,9 +78,12 @@ StringVector::operator=(const StringVector & o)
 {
 	int				i;
 
+	if (this == &o) {
+		return *this;
+	}
 	ensureCapacity(o.m_currSize);
 	for (i = 0; i < m_currSize; i++) {
-		delete m_array[i];
+		delete [] m_array[i];
 		m_array[i] = 0;
 	}
 
@@ -88,6 +91,7 @@ StringVector::operator=(const StringVector & o)
 	for (i = 0; i < m_currSize; i++) {
 		m_array[i] = copyString(o[i]);
 	}
+	m_array[m_currSize] = 0;
 	return *this;
 }
 
@@ -50,6 +50,14 @@ public:
 				const char *		spelling,
 				StringBuffer &		buf) const;
 
+	//--------
+	// The number of "uid-" identifiers expanded so far. A precompiled
+	// configuration records this, so that loading one and then parsing
+	// more input does not reuse the numbers already in it.
+	//--------
+	inline long count() const;
+	inline void ensureCountIsAtLeast(long count);
+
 private:
 	//--------
 	// Instance variables
@@ -75,5 +83,21 @@ private:
 };
 
 
+inline long
+UidIdentifierProcessor::count() const
+{
+	return m_count;
+}
+
+
+inline void
+UidIdentifierProcessor::ensureCountIsAtLeast(long count)
+{
+	if (m_count < count) {
+		m_count = count;
+	}
+}
+
+
 }; // namespace CONFIG4CPP_NAMESPACE
 #endif
@@ -227,6 +227,7 @@ main(int argc, char ** argv)
 	StringVector			unmatchedPatterns;
 	StringVector			schema;
 	SchemaValidator			sv;
+	std::string				image;
 	const char *			scope;
 	int						i;
 	int						len;
@@ -278,11 +279,31 @@ main(int argc, char ** argv)
 		}
 	}
 
-	if (ok) {
+	//--------
+	// With -compiled, the parsed configuration is embedded in the
+	// generated code, so the program does not have to parse it.
+	//--------
+	if (ok && util.wantCompiled()) {
+		try {
+			if (!util.wantSchema()) {
+				cfg->parse(util.cfgFileName());
+			}
+			cfg->writeBinaryImage(image);
+		} catch(const ConfigurationException & ex) {
+			fprintf(stderr, "%s\n", ex.c_str());
+			ok = false;
+		}
+	}
+
+	if (ok && util.wantCompiled()) {
+		ok = util.generateFiles(schema.c_array(), schema.length(),
+								image.data(), image.size());
+	} else if (ok) {
 		ok = util.generateFiles(schema.c_array(), schema.length());
 	}
 
 	cfg->destroy();
+	schemaCfg->destroy();
 	if (ok) {
 		return 0;
 	} else {
@@ -59,6 +59,7 @@ static void parseCmdLineArgs(
 	const char *&					secScope,
 	const char *&					schemaSource,
 	const char *&					schemaName,
+	const char *&					outFile,
 	SchemaValidator::ForceMode &	forceMode,
 	bool &							wantDiagnostics,
 	Configuration::Type &			types,
@@ -82,6 +83,7 @@ main(int argc, char ** argv)
 	const char *				secScope;
 	const char *				schemaSource;
 	const char *				schemaName;
+	const char *				outFile;
 	bool						wantDiagnostics;
 	const char *				str;
 	Configuration *				cfg;
@@ -109,7 +111,7 @@ main(int argc, char ** argv)
 
 	parseCmdLineArgs(argc, argv, cmd, isRecursive, wantExpandedUidNames,
                      filterPatterns, scope, name, cfgSource, secSource,
-	                 secScope, schemaSource, schemaName, forceMode,
+	                 secScope, schemaSource, schemaName, outFile, forceMode,
 	                 wantDiagnostics, types, cfg);
 
 	try {
@@ -138,6 +140,13 @@ main(int argc, char ** argv)
 		} catch (ConfigurationException & ex) {
 			fprintf(stderr, "%s\n", ex.c_str());
 		}
+	} else if (strcmp(cmd, "compile") == 0) {
+		try {
+			cfg->writeBinary(outFile);
+		} catch (const ConfigurationException & ex) {
+			fprintf(stderr, "%s\n", ex.c_str());
+			exit(1);
+		}
 	} else if (strcmp(cmd, "slist") == 0) {
 		try {
 			cfg->listFullyScopedNames(scope, name, types, isRecursive,
@@ -258,6 +267,7 @@ parseCmdLineArgs(
 	const char *&					secScope,
 	const char *&					schemaSource,
 	const char *&					schemaName,
+	const char *&					outFile,
 	SchemaValidator::ForceMode &	forceMode,
 	bool &							wantDiagnostics,
 	Configuration::Type &			types,
@@ -275,6 +285,7 @@ parseCmdLineArgs(
 	secScope  = "";
 	schemaSource = 0;
 	schemaName = 0;
+	outFile = 0;
 	wantDiagnostics = false;
 	forceMode = SchemaValidator::DO_NOT_FORCE;
 	isRecursive = true;
@@ -308,6 +319,10 @@ parseCmdLineArgs(
 			if (i == argc-1) { usage(""); }
 			schemaName = argv[i+1];
 			i++;
+		} else if (strcmp(argv[i], "-out") == 0) {
+			if (i == argc-1) { usage(""); }
+			outFile = argv[i+1];
+			i++;
 		} else if (strcmp(argv[i], "-diagnostics") == 0) {
 			wantDiagnostics = true;
 		} else if (strcmp(argv[i], "-force_optional") == 0) {
@@ -339,6 +354,8 @@ parseCmdLineArgs(
 			cmd = argv[i];
 		} else if (strcmp(argv[i], "validate") == 0) {
 			cmd = argv[i];
+		} else if (strcmp(argv[i], "compile") == 0) {
+			cmd = argv[i];
 		//--------
 		// Arguments to commands
 		//--------
@@ -386,6 +403,10 @@ parseCmdLineArgs(
 			usage("");
 		}
 	}
+	if (strcmp(cmd, "compile") == 0 && outFile == 0) {
+		fprintf(stderr, "\nThe compile command requires -out <file.cfgc>\n\n");
+		usage("");
+	}
 }
 
 
@@ -430,6 +451,8 @@ usage(const char * optMsg)
 	    << "  type                Print type of the <scope>.<name> entry\n"
 	    << "  slist               List scoped names in <scope>.<name>\n"
 	    << "  llist               List local names in <scope>.<name>\n"
+	    << "  compile             Write a precompiled configuration to "
+	    <<								"-out <file>\n"
 	    << "\n"
 	    << "<options> can be:\n"
 	    << "  -h                  Print this usage statement\n"
@@ -459,6 +482,8 @@ usage(const char * optMsg)
 	    << "  -expandUid          For dump (default)\n"
 	    << "  -unexpandUid        For dump\n"
 	    << "\n"
+	    << "  -out <file.cfgc>    Output file for compile\n"
+	    << "\n"
 	    << "<types> can be one of the following:\n"
 	    << "  string, list, scope, variables, scope_and_vars (default)\n"
 	    << "\n"
@@ -466,6 +491,7 @@ usage(const char * optMsg)
 	    << "  file.cfg       A configuration file\n"
 	    << "  file#file.cfg  A configuration file\n"
 	    << "  exec#<command> Output from executing the specified command\n"
+	    << "  bin#file.cfgc  A precompiled configuration file\n"
 	;
 	fprintf(stderr, "%s", msg.c_str());
 	exit(1);
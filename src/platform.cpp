@@ -24,7 +24,21 @@
 
 #include "platform.h"
 #include <assert.h>
+#include <errno.h>
 #include <stdlib.h>
+#include <string.h>
+#ifdef WIN32
+#	include <io.h>
+#	include <fcntl.h>
+#	include <sys/types.h>
+#	include <sys/stat.h>
+#else
+#	include <sys/types.h>
+#	include <sys/stat.h>
+#	include <sys/mman.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
 #include <config4cpp/StringBuffer.h>
 #ifdef P_STDIO_HAS_LIMITED_FDS
 #	ifdef WIN32
@@ -138,6 +152,35 @@ isCmdInDir(const char * cmd, const char * dir)
 
 
 
+bool
+getFileStamp(const char * fileName, long long & mtime, long long & size)
+{
+#ifdef WIN32
+	struct _stat64		sb;
+
+	if (_stat64(fileName, &sb) != 0) {
+		return false;
+	}
+	mtime = (long long)sb.st_mtime * 1000000000LL;
+#else
+	struct stat			sb;
+
+	if (stat(fileName, &sb) != 0) {
+		return false;
+	}
+#	if defined(__APPLE__)
+	mtime = (long long)sb.st_mtimespec.tv_sec * 1000000000LL
+	        + sb.st_mtimespec.tv_nsec;
+#	else
+	mtime = (long long)sb.st_mtim.tv_sec * 1000000000LL + sb.st_mtim.tv_nsec;
+#	endif
+#endif
+	size = (long long)sb.st_size;
+	return true;
+}
+
+
+
 #ifdef P_STDIO_HAS_LIMITED_FDS
 
 BufferedFileReader::BufferedFileReader()
@@ -236,4 +279,136 @@ BufferedFileReader::getChar()
 }
 
 #endif
+
+
+
+//----------------------------------------------------------------------
+// Class MappedFile
+//----------------------------------------------------------------------
+
+MappedFile::MappedFile()
+{
+	m_data     = 0;
+	m_size     = 0;
+	m_isMapped = false;
+}
+
+
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+
+
+bool
+MappedFile::open(const char * fileName)
+{
+	int					fd;
+	bool				ok;
+	int					savedErrno;
+#ifndef WIN32
+	struct stat			sb;
+	void *				addr;
+#endif
+
+	assert(m_data == 0);
+#ifdef WIN32
+	fd = ::_open(fileName, _O_RDONLY | _O_BINARY);
+#else
+	fd = ::open(fileName, O_RDONLY);
+#endif
+	if (fd == -1) {
+		return false;
+	}
+
+#ifndef WIN32
+	if (fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+		addr = mmap(0, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+			madvise(addr, (size_t)sb.st_size, MADV_SEQUENTIAL);
+#endif
+			m_data     = (char *)addr;
+			m_size     = (size_t)sb.st_size;
+			m_isMapped = true;
+			::close(fd);
+			return true;
+		}
+	}
+#endif
+
+	//--------
+	// Fall back to reading the whole file.
+	//--------
+	ok = readAll(fd);
+	savedErrno = errno;
+#ifdef WIN32
+	::_close(fd);
+#else
+	::close(fd);
+#endif
+	errno = savedErrno;
+	return ok;
+}
+
+
+
+bool
+MappedFile::readAll(int fd)
+{
+	size_t				capacity;
+	char *				newData;
+	int					count;
+
+	capacity = 0;
+	for (;;) {
+		if (m_size == capacity) {
+			capacity = (capacity == 0) ? 8192 : capacity * 2;
+			newData = new char[capacity];
+			if (m_size > 0) {
+				memcpy(newData, m_data, m_size);
+			}
+			delete [] m_data;
+			m_data = newData;
+		}
+#ifdef WIN32
+		count = ::_read(fd, m_data + m_size, (unsigned)(capacity - m_size));
+#else
+		count = (int)::read(fd, m_data + m_size, capacity - m_size);
+#endif
+		if (count == -1 && errno == EINTR) {
+			continue;
+		}
+		if (count == -1) {
+			close();
+			return false;
+		}
+		if (count == 0) {
+			return true;
+		}
+		m_size += count;
+	}
+}
+
+
+
+void
+MappedFile::close()
+{
+#ifndef WIN32
+	if (m_isMapped) {
+		munmap(m_data, m_size);
+	} else {
+		delete [] m_data;
+	}
+#else
+	delete [] m_data;
+#endif
+	m_data     = 0;
+	m_size     = 0;
+	m_isMapped = false;
+}
+
 }; // namespace CONFIG4CPP_NAMESPACE
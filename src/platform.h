@@ -63,6 +63,16 @@ namespace CONFIG4CPP_NAMESPACE {
 extern bool execCmd(const char * cmd, StringBuffer & output);
 extern bool isCmdInDir(const char * cmd, const char * dir);
 
+//--------
+// getFileStamp() gets the modification time (in nanoseconds, where the
+// file system records them) and the size of a file. It returns false
+// if the file cannot be examined.
+//--------
+extern bool getFileStamp(
+				const char *		fileName,
+				long long &			mtime,
+				long long &			size);
+
 //----------------------------------------------------------------------
 // Some operating systems, such as Solaris
 // (see http://developers.sun.com/solaris/articles/stdio_256.html),
@@ -112,5 +122,68 @@ private:
 };
 
 
+//----------------------------------------------------------------------
+// Class MappedFile gives read-only access to the entire contents of a
+// file as one contiguous array of bytes, so the Lex class can scan it
+// with a pointer instead of calling a function for each byte. On UNIX,
+// a regular file is mapped into memory with mmap(). Anything that
+// cannot be mapped (a pipe, a FIFO, an empty file, or a file on a
+// system without mmap()) is read into a heap buffer instead.
+//----------------------------------------------------------------------
+
+class MappedFile
+{
+public:
+	//--------
+	// Constructors and destructor
+	//--------
+	MappedFile();
+	~MappedFile();
+
+	bool open(const char * fileName); // sets errno on failure
+	void close();
+	inline const char * data() const;
+	inline size_t size() const;
+	inline bool isMapped() const;
+
+private:
+	bool readAll(int fd);
+
+	//--------
+	// Instance variables
+	//--------
+	char *		m_data;
+	size_t		m_size;
+	bool		m_isMapped;
+
+	//--------
+	// The following are not implemented
+	//--------
+	MappedFile(const MappedFile &);
+	MappedFile& operator=(const MappedFile &);
+};
+
+
+inline const char *
+MappedFile::data() const
+{
+	return m_data;
+}
+
+
+inline size_t
+MappedFile::size() const
+{
+	return m_size;
+}
+
+
+inline bool
+MappedFile::isMapped() const
+{
+	return m_isMapped;
+}
+
+
 }; // namespace CONFIG4CPP_NAMESPACE
 #endif
@@ -27,6 +27,8 @@
 //--------
 #include <config4cpp/StringBuffer.h>
 #include "util.h"
+#include "platform.h"
+#include <string.h>
 
 
 namespace CONFIG4CPP_NAMESPACE {
@@ -53,4 +55,74 @@ splitScopedNameIntoVector(const char * str, StringVector & vec)
 	vec.add(startOfStr);
 }
 
+
+
+void
+getDirName(const char * fileName, StringBuffer & dirName)
+{
+	const char *		sep;
+
+	sep = strrchr(fileName, CONFIG4CPP_DIR_SEP[0]);
+#if defined(WIN32)
+	if (strrchr(fileName, '/') > sep) {
+		sep = strrchr(fileName, '/');
+	}
+#endif
+	dirName.empty();
+	if (sep == 0) {
+		dirName = ".";
+	} else if (sep == fileName) {
+		dirName = CONFIG4CPP_DIR_SEP;
+	} else {
+		while (fileName < sep) {
+			dirName.append(*fileName);
+			fileName++;
+		}
+	}
+}
+
+
+
+//--------
+// hashBytes() takes eight bytes at a time in four independent lanes,
+// so hashing a large file costs little more than reading it.
+//--------
+static inline unsigned long long
+mixWord(unsigned long long h, unsigned long long word)
+{
+	h ^= word;
+	h *= 0x9E3779B97F4A7C15ULL;
+	return h ^ (h >> 29);
+}
+
+
+
+unsigned long long
+hashBytes(const char * data, size_t size)
+{
+	unsigned long long	lane[4];
+	unsigned long long	word;
+	unsigned long long	result;
+	size_t				i;
+	int					j;
+
+	for (j = 0; j < 4; j++) {
+		lane[j] = 14695981039346656037ULL + j;
+	}
+	for (i = 0; i + 32 <= size; i += 32) {
+		for (j = 0; j < 4; j++) {
+			memcpy(&word, data + i + j * 8, 8);
+			lane[j] = mixWord(lane[j], word);
+		}
+	}
+	result = size;
+	for (j = 0; j < 4; j++) {
+		result = mixWord(result, lane[j]);
+	}
+	for (; i < size; i++) {
+		result = mixWord(result, (unsigned char)data[i]);
+	}
+	return result;
+}
+
 }; // namespace CONFIG4CPP_NAMESPACE
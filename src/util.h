@@ -26,11 +26,24 @@
 //--------
 // #include's
 //--------
+#include <config4cpp/StringBuffer.h>
 #include <config4cpp/StringVector.h>
+#include <stddef.h>
 
 
 namespace CONFIG4CPP_NAMESPACE {
 
 extern void splitScopedNameIntoVector(const char * str, StringVector & vec); 
 
+//--------
+// The directory part of a file name, or "." if it has none.
+//--------
+extern void getDirName(const char * fileName, StringBuffer & dirName);
+
+//--------
+// A 64-bit hash of size bytes, used to tell whether the contents
+// of a file have changed.
+//--------
+extern unsigned long long hashBytes(const char * data, size_t size);
+
 }; // namespace CONFIG4CPP_NAMESPACE
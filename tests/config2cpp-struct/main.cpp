@@ -0,0 +1,141 @@
+//----------------------------------------------------------------------
+// Copyright 2011 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions.
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.  
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------
+
+
+//--------
+// Tests the struct that "config2cpp -struct Settings" generates: load()
+// fills in every member, leaves an optional member that is not set
+// alone, and throws if a required variable is not set.
+//--------
+
+//--------
+// #include's
+//--------
+#include "StructConfiguration.h"
+#include <config4cpp/SchemaValidator.h>
+using config4cpp::Configuration;
+using config4cpp::ConfigurationException;
+using config4cpp::SchemaValidator;
+#include <stdio.h>
+#include <string.h>
+
+
+static int failures = 0;
+
+static void
+check(bool ok, const char * what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+#define CHECK(expr) check((expr), #expr)
+
+
+
+int
+main(int, char **)
+{
+	Configuration *			cfg = Configuration::create();
+	StructConfiguration		defaults;
+	SchemaValidator			sv;
+	Settings				all;
+	Settings				partial;
+	Settings				fallback;
+	bool					threw;
+
+	try {
+		//--------
+		// Every variable is set, and the configuration is valid.
+		//--------
+		cfg->parse(Configuration::INPUT_STRING,
+				"name = \"x\"; port = \"81\"; verbose = \"false\";\n"
+				"ratio = \"1.5\"; timeout = \"2 seconds\";\n"
+				"hosts = [\"h1\", \"h2\", \"h3\"]; log.level = \"4\";\n"
+				"palette { colour = \"dark-blue\"; }\n");
+		sv.parseSchema(defaults.getSchema());
+		sv.validate(cfg, "", "");
+		all.load(cfg);
+		CHECK(all.name == "x");
+		CHECK(all.port == 81);
+		CHECK(!all.verbose);
+		CHECK(all.ratio == 1.5f);
+		CHECK(all.timeout == std::chrono::milliseconds(2000));
+		CHECK(all.hosts.length() == 3 && strcmp(all.hosts[2], "h3") == 0);
+		CHECK(all.log_level == 4);
+		CHECK(all.palette_colour == Settings::colour_enum::dark_blue);
+
+		//--------
+		// Optional variables that are not set keep their values,
+		// with no fallback configuration to supply them.
+		//--------
+		cfg->empty();
+		cfg->parse(Configuration::INPUT_STRING, "name = \"y\";");
+		partial.port = 42;
+		partial.load(cfg);
+		CHECK(partial.name == "y");
+		CHECK(partial.port == 42);
+		CHECK(!partial.verbose);
+		CHECK(partial.timeout == std::chrono::milliseconds(0));
+		CHECK(partial.hosts.length() == 0);
+		CHECK(partial.palette_colour == Settings::colour_enum::red);
+
+		//--------
+		// ... or come from the fallback configuration, if there is one.
+		//--------
+		cfg->setFallbackConfiguration(Configuration::INPUT_STRING,
+				defaults.getString());
+		fallback.load(cfg);
+		CHECK(fallback.name == "y");
+		CHECK(fallback.port == 8080);
+		CHECK(fallback.log_level == 3);
+		CHECK(fallback.palette_colour == Settings::colour_enum::dark_blue);
+	} catch (const ConfigurationException & ex) {
+		fprintf(stderr, "FAILED: %s\n", ex.c_str());
+		failures++;
+	}
+
+	//--------
+	// A required variable that is not set is an error.
+	//--------
+	cfg->destroy();
+	cfg = Configuration::create();
+	cfg->parse(Configuration::INPUT_STRING, "port = \"1\";");
+	threw = false;
+	try {
+		partial.load(cfg);
+	} catch (const ConfigurationException &) {
+		threw = true;
+	}
+	CHECK(threw);
+
+	cfg->destroy();
+	if (failures != 0) {
+		return 1;
+	}
+	printf("config2cpp -struct tests passed\n");
+	return 0;
+}
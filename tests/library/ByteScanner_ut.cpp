@@ -0,0 +1,154 @@
+#include "src/ByteScanner.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// The project has no dependency on a testing framework, and I don't want to add
+// one (yet), so we will just do something very basic here.
+
+namespace {
+namespace cfg = CONFIG4CPP_NAMESPACE;
+
+char const *
+reference_find_stop(char const * ptr, char const * end, char stop1, char stop2)
+{
+    for (; ptr != end; ++ptr) {
+        auto const ch = static_cast<unsigned char>(*ptr);
+        if (ch < 0x20 || ch >= 0x80 || *ptr == stop1 || *ptr == stop2) {
+            break;
+        }
+    }
+    return ptr;
+}
+
+char const *
+reference_skip_blanks(char const * ptr, char const * end)
+{
+    while (ptr != end && (*ptr == ' ' || *ptr == '\t')) {
+        ++ptr;
+    }
+    return ptr;
+}
+
+// A buffer of plain bytes, with a single interesting byte at each position in
+// turn, checked at every starting offset so that the vector loops and the
+// scalar tail are both exercised.
+void
+check_every_position(char const * impl, char plain, char interesting)
+{
+    for (std::size_t len = 0; len < 100; ++len) {
+        for (std::size_t pos = 0; pos <= len; ++pos) {
+            std::string buf(len, plain);
+            if (pos < len) {
+                buf[pos] = interesting;
+            }
+            char const * const begin = buf.data();
+            char const * const end = begin + buf.size();
+            for (std::size_t start = 0; start <= std::min<std::size_t>(len, 40);
+                 ++start)
+            {
+                auto const stop = cfg::ByteScanner::findStop(
+                    begin + start, end, '"', '%');
+                auto const blank = cfg::ByteScanner::skipBlanks(
+                    begin + start, end);
+                if (stop != reference_find_stop(begin + start, end, '"', '%')
+                    || blank != reference_skip_blanks(begin + start, end))
+                {
+                    throw std::runtime_error(
+                        std::string(impl) + ": wrong result for len=" +
+                        std::to_string(len) + " pos=" + std::to_string(pos) +
+                        " start=" + std::to_string(start) + " byte=" +
+                        std::to_string(static_cast<unsigned char>(interesting)));
+                }
+            }
+        }
+    }
+}
+
+void
+check_random_buffers(char const * impl)
+{
+    // Mostly plain text, with a sprinkling of every kind of stop byte.
+    static char const mix[] = "abc xyz\t%\"\n\r\x01\x7f\x80\xc3\xff  ";
+    for (int trial = 0; trial < 2000; ++trial) {
+        std::string buf(std::rand() % 300, 'a');
+        for (auto & ch : buf) {
+            if (std::rand() % 16 == 0) {
+                ch = mix[std::rand() % (sizeof(mix) - 1)];
+            } else if (std::rand() % 4 == 0) {
+                ch = ' ';
+            }
+        }
+        char const * ptr = buf.data();
+        char const * const end = ptr + buf.size();
+        while (ptr != end) {
+            auto const stop = cfg::ByteScanner::findStop(ptr, end, '%', '%');
+            if (stop != reference_find_stop(ptr, end, '%', '%')) {
+                throw std::runtime_error(
+                    std::string(impl) + ": findStop differs on random input");
+            }
+            if (cfg::ByteScanner::skipBlanks(ptr, end) !=
+                reference_skip_blanks(ptr, end))
+            {
+                throw std::runtime_error(
+                    std::string(impl) + ": skipBlanks differs on random input");
+            }
+            ptr = stop == end ? end : stop + 1;
+        }
+    }
+}
+
+int
+Main(int argc, char * argv[])
+{
+    (void)argc;
+    (void)argv;
+    std::vector<cfg::ByteScanner::Impl> const impls = {
+        cfg::ByteScanner::IMPL_PORTABLE,
+        cfg::ByteScanner::IMPL_SSE2,
+        cfg::ByteScanner::IMPL_AVX2,
+        cfg::ByteScanner::IMPL_BEST,
+    };
+    for (auto impl : impls) {
+        if (not cfg::ByteScanner::select(impl)) {
+            continue; // not supported by this CPU
+        }
+        char const * const name = cfg::ByteScanner::implName();
+        for (char interesting : {'"', '%', '\n', '\r', '\t', '\0', '\x1f',
+                                 '\x7f', '\x80', '\xff', '!', '$', '&'})
+        {
+            check_every_position(name, 'x', interesting);
+        }
+        check_every_position(name, ' ', 'x');
+        check_every_position(name, '\t', '\n');
+        check_random_buffers(name);
+    }
+    return 0;
+}
+
+} // anonymous namespace
+
+int
+main(int argc, char * argv[])
+{
+    std::string error;
+
+    // I don't want to depend on advanced things just for this test.
+    // We don't need a rigorous RNG.
+    unsigned seed = std::time(nullptr);
+    std::srand(seed);
+    try {
+        return Main(argc, argv);
+    } catch (std::exception const & ex) {
+        error = std::string("exception: ") + ex.what();
+    } catch (...) {
+        error = "unknown exception";
+    }
+    std::cerr << error << '\n' << "random seed is " << seed << '\n';
+    return 1;
+}
@@ -7,6 +7,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 // The project has no dependency on a testing framework, and I don't want to add
 // one (yet), so we will just do something very basic here.
@@ -48,6 +49,9 @@ struct TestConfigScope
 
     // The ordered list of all names that have been added to the scope.
     std::vector<std::string> ordered;
+
+    // Names that have been removed from the scope.
+    std::vector<std::string> removed;
 };
 
 TestConfigScope::
@@ -121,6 +125,7 @@ TestConfigScope()
                 unsigned index = std::rand() % ordered.size();
                 std::string name = ordered[index];
                 ordered.erase(ordered.begin() + index);
+                removed.push_back(name);
                 if (not removeItem(name.c_str())) {
                     throw std::runtime_error(
                         "ConfigScope::removeItem returned false");
@@ -202,6 +207,102 @@ listScopedNamesHelper_in_order(TestConfigScope const & scope)
     scope.verifyListOrder(vec);
 }
 
+void
+findItem_after_removals(TestConfigScope const & scope)
+{
+    // Removing items leaves tombstones in the hash table, so make sure that
+    // every remaining name can still be found, and removed names cannot.
+    for (auto const & name : scope.ordered) {
+        cfg::ConfigItem * item = scope.findItem(name.c_str());
+        if (item == nullptr || name != item->name()) {
+            throw std::runtime_error("could not find \"" + name + '"');
+        }
+    }
+    for (auto const & name : scope.removed) {
+        bool const readded =
+            std::find(scope.ordered.begin(), scope.ordered.end(), name) !=
+            scope.ordered.end();
+        if (not readded && scope.findItem(name.c_str()) != nullptr) {
+            throw std::runtime_error("found removed name \"" + name + '"');
+        }
+    }
+}
+
+void
+names_and_values_are_interned()
+{
+    // Equal names and short values in different scopes share one copy; a
+    // long value is copied, but is still equal.
+    cfg::ConfigScope root(NULL, "");
+    std::string const long_value(cfg::StringPool::MAX_LENGTH + 10, 'x');
+    cfg::ConfigItem * items[2][2];
+    for (int i = 0; i < 2; ++i) {
+        cfg::ConfigScope * scope;
+        std::string const name = "uid-" + std::to_string(i) + "-server";
+        root.ensureScopeExists(name.c_str(), scope);
+        items[i][0] = scope->addOrReplaceString("host", "db.example.com");
+        items[i][1] = scope->addOrReplaceString("motd", long_value.c_str());
+    }
+    if (items[0][0]->name() != items[1][0]->name()
+        || items[0][0]->stringVal() != items[1][0]->stringVal())
+    {
+        throw std::runtime_error("equal short strings were not interned");
+    }
+    if (items[0][1]->stringVal() == items[1][1]->stringVal()
+        || long_value != items[1][1]->stringVal())
+    {
+        throw std::runtime_error("long strings were interned");
+    }
+}
+
+void
+large_values_are_released()
+{
+    // A replaced or removed value, or a removed scope, gives back its
+    // large blocks, so replacing big values again and again does not
+    // grow the arena by much more than the items themselves.
+    cfg::Arena arena;
+    cfg::StringPool pool(arena);
+    cfg::ConfigScope * root = new (arena) cfg::ConfigScope(&pool);
+    std::vector<std::string> const values(5000, "v");
+    std::vector<char const *> ptrs;
+    for (auto const & value : values) {
+        ptrs.push_back(value.c_str());
+    }
+    std::string const big_string(cfg::Arena::LARGE_BLOCK, 's');
+    std::size_t bytes_after_first_round = 0;
+    for (int round = 0; round < 50; ++round) {
+        cfg::ConfigItem * replaced;
+        cfg::ConfigScope * scope;
+        root->addOrReplaceList("list", &ptrs[0], (int)ptrs.size(), &replaced);
+        if (replaced != nullptr) {
+            root->releaseItem(replaced);
+        }
+        root->addOrReplaceString("string", big_string.c_str(), &replaced);
+        if (replaced != nullptr) {
+            root->releaseItem(replaced);
+        }
+        root->ensureScopeExists("scope", scope);
+        scope->addOrReplaceList("list", &ptrs[0], (int)ptrs.size());
+        if (not root->removeItem("scope", &replaced) or replaced == nullptr) {
+            throw std::runtime_error("ConfigScope::removeItem failed");
+        }
+        root->releaseItem(replaced);
+        if (round == 0) {
+            bytes_after_first_round = arena.bytesReserved();
+        }
+    }
+    if (arena.bytesReserved() > bytes_after_first_round + 64 * 1024) {
+        throw std::runtime_error(
+            "large values were not released: " +
+            std::to_string(bytes_after_first_round) + " bytes grew to " +
+            std::to_string(arena.bytesReserved()));
+    }
+    if (big_string != root->findItem("string")->stringVal()) {
+        throw std::runtime_error("the last string was not kept");
+    }
+}
+
 int
 Main(int argc, char * argv[])
 {
@@ -212,6 +313,9 @@ Main(int argc, char * argv[])
     listLocallyScopedNames_in_order(scope);
     listLocalNames_in_order(scope);
     listScopedNamesHelper_in_order(scope);
+    findItem_after_removals(scope);
+    names_and_values_are_interned();
+    large_values_are_released();
     return 0;
 }
 
@@ -1,13 +1,30 @@
 #include "config4cpp/ConfigurationException.h"
+#include "config4cpp/ConfigWatcher.h"
 #include "config4cpp/ConfigurationExt.h"
+#include "config4cpp/SchemaValidator.h"
+#include "src/ByteScanner.h"
 #include "src/ConfigScope.h"
 
+#include <algorithm>
+#include <atomic>
+#include <clocale>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(WIN32)
+#include <sys/stat.h>
+#endif
 
 // The project has no dependency on a testing framework, and I don't want to add
 // one (yet), so we will just do something very basic here.
@@ -39,6 +56,33 @@ random_string(std::vector<std::string> const & names)
     return result;
 }
 
+// A directory of its own for a test's files, removed with everything in
+// it when the test ends.
+struct TempDir
+{
+    TempDir()
+    {
+        auto const tmp = std::filesystem::temp_directory_path();
+        do {
+            path = tmp / ("Configuration_ut_" + std::to_string(std::rand()));
+        } while (not std::filesystem::create_directory(path));
+    }
+
+    ~TempDir()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+
+    std::string
+    file(char const * name) const
+    {
+        return (path / name).string();
+    }
+
+    std::filesystem::path path;
+};
+
 struct Test
 {
     Test();
@@ -404,6 +448,1653 @@ test_glob_include()
 #endif
 }
 
+void
+test_key_lookup()
+{
+    cfg::ext::Configuration fallback_config;
+    fallback_config.insertString("only.in.fallback", "fallback value");
+    cfg::ext::Configuration config;
+    config->setFallbackConfiguration(fallback_config.operator -> ());
+    config.parse(
+        cfg::ext::Configuration::INPUT_STRING,
+        R"(top="my top";
+           a { b { c="42"; flag="true"; size="2 KB"; } }
+           timeout="1500 milliseconds";
+           list=["x", "y", "z"];
+           )");
+
+    using Key = cfg::Configuration::Key;
+    cfg::Configuration const & c = *config.operator -> ();
+
+    // A Key must find exactly what the equivalent (scope, name) pair finds.
+    for (auto [scope, name] : {
+             std::pair{"", "top"},
+             std::pair{"a", "b.c"},
+             std::pair{"a.b", "c"},
+             std::pair{"", ".top"},
+             std::pair{"only", "in.fallback"}}) {
+        Key const key(scope, name);
+        EXPECT_EQ(c.type(scope, name), c.type(key));
+        EXPECT_EQ(
+            std::string(c.lookupString(scope, name)),
+            std::string(c.lookupString(key)));
+    }
+
+    EXPECT_EQ(42, c.lookupInt(Key("a.b", "c")));
+    EXPECT_EQ(7, c.lookupInt(Key("a.b", "missing"), 7));
+    EXPECT_EQ(0.5f, c.lookupFloat(Key("a.b", "missing"), 0.5f));
+    EXPECT(c.lookupBoolean(Key("a.b", "flag")));
+    EXPECT(c.lookupBoolean(Key("", "missing"), true));
+    EXPECT_EQ(2048, c.lookupMemorySizeBytes(Key("a.b", "size")));
+    EXPECT_EQ(3, c.lookupMemorySizeBytes(Key("a.b", "missing"), 3));
+    EXPECT_EQ(1500, c.lookupDurationMilliseconds(Key("", "timeout")));
+    EXPECT_EQ(-1, c.lookupDurationSeconds(Key("", "missing"), -1));
+    EXPECT_EQ(0, c.type(Key("", "")));
+
+    char const ** array;
+    int size;
+    c.lookupList(Key("", "list"), array, size);
+    EXPECT_EQ(3, size);
+    EXPECT_EQ("z"s, array[2]);
+
+    // Wrong types and missing values are reported as they are for strings.
+    auto const throws = [](auto && fn) {
+        try {
+            fn();
+        } catch (cfg::ConfigurationException const &) {
+            return true;
+        }
+        return false;
+    };
+    EXPECT(throws([&] { c.lookupString(Key("", "a")); }));
+    EXPECT(throws([&] { c.lookupString(Key("", "list")); }));
+    EXPECT(throws([&] { c.lookupString(Key("", "missing")); }));
+    EXPECT(throws([&] { c.lookupInt(Key("", "top")); }));
+    EXPECT(throws([&] { c.lookupList(Key("", "top"), array, size); }));
+    EXPECT(throws([&] { c.lookupList(Key("", "missing"), array, size); }));
+}
+
+void
+test_typed_value_cache()
+{
+    cfg::Configuration * c = cfg::Configuration::create();
+    c->parse(
+        cfg::Configuration::INPUT_STRING,
+        R"(n="42"; timeout="2 seconds"; colour="green"; ratio="0.25";)");
+
+    // Repeated lookups are served from the value remembered by the item,
+    // but must still give the same answers, including for a different
+    // conversion of the same string.
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(42, c->lookupInt("", "n"));
+        EXPECT_EQ(0.25f, c->lookupFloat("", "ratio"));
+        EXPECT_EQ(2000, c->lookupDurationMilliseconds("", "timeout"));
+        EXPECT_EQ(2, c->lookupDurationSeconds("", "timeout"));
+    }
+    EXPECT_EQ("42"s, c->lookupString("", "n"));
+
+    // The same string looked up with two different enum tables.
+    cfg::EnumNameAndValue const colours[] = {{"red", 1}, {"green", 2}};
+    cfg::EnumNameAndValue const others[] = {{"blue", 7}, {"green", 8}};
+    cfg::EnumNameAndValue const reordered[] = {{"green", 9}, {"red", 10}};
+    EXPECT_EQ(2, c->lookupEnum("", "colour", "colour", colours, 2));
+    EXPECT_EQ(8, c->lookupEnum("", "colour", "colour", others, 2));
+    EXPECT_EQ(9, c->lookupEnum("", "colour", "colour", reordered, 2));
+    EXPECT_EQ(2, c->lookupEnum("", "colour", "colour", colours, 2));
+
+    // Replacing or removing a value must not leave a stale result behind.
+    c->insertString("", "n", "43");
+    EXPECT_EQ(43, c->lookupInt("", "n"));
+    c->insertString("", "timeout", "5 seconds");
+    EXPECT_EQ(5000, c->lookupDurationMilliseconds("", "timeout"));
+    c->remove("", "n");
+    EXPECT_EQ(-1, c->lookupInt("", "n", -1));
+    c->insertString("", "n", "not a number");
+    bool threw = false;
+    try {
+        c->lookupInt("", "n");
+    } catch (cfg::ConfigurationException const &) {
+        threw = true;
+    }
+    EXPECT(threw);
+    c->destroy();
+}
+
+void
+test_freeze()
+{
+    cfg::Configuration * fallback = cfg::Configuration::create();
+    fallback->insertString("", "from_fallback", "fallback value");
+    cfg::Configuration * c = cfg::Configuration::create();
+    c->setFallbackConfiguration(fallback);
+    c->parse(
+        cfg::Configuration::INPUT_STRING,
+        R"(top="my top";
+           a { b { c="42"; list=["x", "y"]; } empty { } }
+           z="last";
+           )");
+
+    cfg::Configuration * frozen = c->freeze();
+    EXPECT(frozen->isFrozen());
+    EXPECT(not c->isFrozen());
+
+    // The copy has the same contents, in the same order.
+    cfg::StringVector expected, actual;
+    c->listFullyScopedNames("", "", cfg::Configuration::CFG_SCOPE_AND_VARS,
+        true, expected);
+    frozen->listFullyScopedNames("", "",
+        cfg::Configuration::CFG_SCOPE_AND_VARS, true, actual);
+    EXPECT_EQ(expected.length(), actual.length());
+    for (int i = 0; i < expected.length(); ++i) {
+        EXPECT_EQ(std::string(expected[i]), std::string(actual[i]));
+    }
+    EXPECT_EQ(42, frozen->lookupInt("a.b", "c"));
+    EXPECT_EQ("fallback value"s, frozen->lookupString("", "from_fallback"));
+    EXPECT_EQ(std::string(c->fileName()), std::string(frozen->fileName()));
+
+    // Neither the original nor its fallback is shared with the copy.
+    c->insertString("", "top", "changed");
+    fallback->insertString("", "from_fallback", "changed");
+    EXPECT_EQ("my top"s, frozen->lookupString("", "top"));
+    EXPECT_EQ("fallback value"s, frozen->lookupString("", "from_fallback"));
+
+    // Updates are refused.
+    auto const throws = [](auto && fn) {
+        try {
+            fn();
+        } catch (cfg::ConfigurationException const &) {
+            return true;
+        }
+        return false;
+    };
+    EXPECT(throws([&] { frozen->insertString("", "x", "y"); }));
+    EXPECT(throws([&] { frozen->remove("", "top"); }));
+    EXPECT(throws([&] { frozen->empty(); }));
+    EXPECT(throws([&] { frozen->ensureScopeExists("", "s"); }));
+    EXPECT(throws([&] {
+        frozen->parse(cfg::Configuration::INPUT_STRING, "x=\"y\";");
+    }));
+    EXPECT(throws([&] { frozen->setFallbackConfiguration(c); }));
+    EXPECT_EQ("my top"s, frozen->lookupString("", "top"));
+
+    // Any number of threads can read the frozen copy at once.
+    cfg::Configuration::Key const key("a.b", "c");
+    std::vector<std::thread> threads;
+    std::atomic<int> failures{0};
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 10000; ++i) {
+                if (frozen->lookupInt(key) != 42
+                    || frozen->lookupString("", "z")[0] != 'l')
+                {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(0, failures.load());
+
+    frozen->destroy();
+    c->destroy();
+    fallback->destroy();
+}
+
+void
+test_configuration_handle()
+{
+    cfg::ext::ConfigurationHandle handle;
+    handle.reload(cfg::Configuration::INPUT_STRING, R"(x="1";)");
+
+    auto first = handle.read();
+    char const * x = first->lookupString("", "x");
+    EXPECT_EQ("1"s, x);
+
+    // A reload does not disturb a reader that is still using the old one.
+    handle.reload(cfg::Configuration::INPUT_STRING, R"(x="2";)");
+    EXPECT_EQ("2"s, handle.read()->lookupString("", "x"));
+    EXPECT_EQ("1"s, x);
+    EXPECT_EQ(1u, handle.numRetired());
+    first = handle.read();
+    handle.reclaim();
+    EXPECT_EQ(0u, handle.numRetired());
+    EXPECT_EQ("2"s, first->lookupString("", "x"));
+
+    // A failed parse or validation leaves the current configuration alone.
+    auto const throws = [](auto && fn) {
+        try {
+            fn();
+        } catch (cfg::ConfigurationException const &) {
+            return true;
+        }
+        return false;
+    };
+    EXPECT(throws([&] {
+        handle.reload(cfg::Configuration::INPUT_STRING, "x = ;");
+    }));
+    EXPECT(throws([&] {
+        handle.reload(
+            cfg::Configuration::INPUT_STRING,
+            R"(x="3";)",
+            "",
+            [](cfg::Configuration const & c) {
+                if (c.lookupInt("", "x") > 2) {
+                    throw cfg::ConfigurationException("x is too big");
+                }
+            });
+    }));
+    EXPECT_EQ("2"s, handle.read()->lookupString("", "x"));
+
+    handle.reloadAsync(cfg::Configuration::INPUT_STRING, R"(x="4";)").get();
+    EXPECT_EQ("4"s, handle.read()->lookupString("", "x"));
+
+    // Readers always see a complete configuration while reloads happen.
+    handle.reload(cfg::Configuration::INPUT_STRING, R"(a="-"; b="-";)");
+    std::atomic<bool> done{false};
+    std::atomic<int> failures{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&] {
+            while (not done) {
+                auto snapshot = handle.read();
+                if (std::string(snapshot->lookupString("", "a")) !=
+                    snapshot->lookupString("", "b"))
+                {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 200; ++i) {
+        auto const n = std::to_string(i);
+        auto const input = "a=\"" + n + "\"; b=\"" + n + "\";";
+        handle.reload(cfg::Configuration::INPUT_STRING, input.c_str());
+    }
+    done = true;
+    for (auto & reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(0, failures.load());
+    first = handle.read();
+    handle.reclaim();
+    EXPECT_EQ(0u, handle.numRetired());
+}
+
+void
+test_parse_file()
+{
+    auto const path = std::string("Configuration_ut_") +
+        std::to_string(std::rand()) + ".cfg";
+    auto const write = [&](char const * text) {
+        std::ofstream(path, std::ios::binary) << text;
+    };
+
+    // A regular file is mapped; '\r' is ignored as it is for strings.
+    write("a = \"1\";\r\nb { c = [\"x\", \"y\"]; }\r\n# last line");
+    {
+        cfg::ext::Configuration config;
+        config.parse(cfg::Configuration::INPUT_FILE, path.c_str());
+        EXPECT_EQ(1, config->lookupInt("", "a"));
+        if (auto opt = config.lookupList("b.c"); EXPECT(opt)) {
+            EXPECT_EQ(2u, opt->size());
+        }
+    }
+
+    // An empty file cannot be mapped, but is still valid input.
+    write("");
+    {
+        cfg::ext::Configuration config;
+        config.parse(cfg::Configuration::INPUT_FILE, path.c_str());
+        EXPECT_EQ(cfg::Configuration::CFG_NO_VALUE, config->type("", "a"));
+    }
+    std::remove(path.c_str());
+
+    std::string error;
+    try {
+        cfg::ext::Configuration config;
+        config.parse(cfg::Configuration::INPUT_FILE, path.c_str());
+    } catch (cfg::ConfigurationException const & ex) {
+        error = ex.c_str();
+    }
+    EXPECT_EQ(0u, error.find("cannot open " + path));
+
+#if !defined(WIN32)
+    // A pipe cannot be mapped, so it is read instead.
+    if (mkfifo(path.c_str(), 0600) == 0) {
+        std::thread writer([&] { write("from_pipe = \"yes\";"); });
+        cfg::ext::Configuration config;
+        config.parse(cfg::Configuration::INPUT_FILE, path.c_str());
+        writer.join();
+        EXPECT_EQ("yes"s, config->lookupString("", "from_pipe"));
+        std::remove(path.c_str());
+    }
+#endif
+}
+
+void
+test_multibyte_input()
+{
+    auto const parse_error = [](char const * text) {
+        std::string error;
+        try {
+            cfg::ext::Configuration config;
+            config.parse(cfg::Configuration::INPUT_STRING, text);
+        } catch (cfg::ConfigurationException const & ex) {
+            error = ex.c_str();
+        }
+        return error;
+    };
+
+    // 7-bit input does not depend on the locale.
+    {
+        cfg::ext::Configuration config;
+        config.parse(
+            cfg::Configuration::INPUT_STRING,
+            "a_1 = \"x\ty\";\n\tb:c/d\\e.f-g$h?i = \"2\"; # comment\n");
+        EXPECT_EQ("x\ty"s, config->lookupString("", "a_1"));
+        EXPECT_EQ(2, config->lookupInt("", "b:c/d\\e.f-g$h?i"));
+    }
+    EXPECT_EQ(
+        "<string-based configuration>, line 2: "
+        "Invalid multi-byte character on line 2"s,
+        parse_error("a = \"1\";\nb = \"\xff\xfe\";\n"));
+
+    // Multi-byte characters are decoded with the locale.
+    std::string const saved = std::setlocale(LC_CTYPE, nullptr);
+    if (std::setlocale(LC_CTYPE, "C.UTF-8") != nullptr) {
+        cfg::ext::Configuration config;
+        config.parse(
+            cfg::Configuration::INPUT_STRING,
+            "greeting = \"h\xc3\xa9llo w\xc3\xb6rld\";\n"
+            "omega = <%\xce\xa9%>;\n");
+        EXPECT_EQ(
+            "h\xc3\xa9llo w\xc3\xb6rld"s,
+            config->lookupString("", "greeting"));
+        EXPECT_EQ("\xce\xa9"s, config->lookupString("", "omega"));
+        EXPECT_EQ(
+            "<string-based configuration>, line 2: "
+            "Invalid multi-byte character on line 2"s,
+            parse_error("a = \"1\";\nb = \"\xff\xfe\";\n"));
+        // A 7-bit byte cannot complete a multi-byte sequence.
+        EXPECT_EQ(
+            "<string-based configuration>, line 1: "
+            "Invalid multi-byte character on line 1"s,
+            parse_error("a = \"\xc3x\";\n"));
+        std::setlocale(LC_CTYPE, saved.c_str());
+    }
+}
+
+void
+test_lexer_scanning()
+{
+    // Long comments, strings and block strings are skipped over with a
+    // ByteScanner, so check each implementation, with interesting bytes on
+    // either side of the vector boundaries.
+    for (auto impl : {cfg::ByteScanner::IMPL_PORTABLE,
+                      cfg::ByteScanner::IMPL_SSE2,
+                      cfg::ByteScanner::IMPL_AVX2,
+                      cfg::ByteScanner::IMPL_BEST})
+    {
+        if (not cfg::ByteScanner::select(impl)) {
+            continue;
+        }
+        for (std::size_t len = 0; len < 70; ++len) {
+            std::string const pad(len, 'x');
+            std::string const text =
+                "# " + pad + "\n" +
+                "    \t  # " + pad + " \"%\r\n" +
+                "s = \"" + pad + "%%" + pad + "%\"\t\r" + pad + "%n\";\n" +
+                "b = <%" + pad + "\n" + pad + "%" + pad + "\r\n%%>;" +
+                std::string(len, ' ') + "\n" +
+                "e = \"" + pad + "\n";
+            std::string error;
+            cfg::ext::Configuration config;
+            try {
+                config.parse(cfg::Configuration::INPUT_STRING, text.c_str());
+            } catch (cfg::ConfigurationException const & ex) {
+                error = ex.c_str();
+            }
+            EXPECT_EQ(
+                "<string-based configuration>, line 7: "
+                "end-of-line not allowed in string '" + pad + "'",
+                error);
+
+            config.parse(
+                cfg::Configuration::INPUT_STRING,
+                text.substr(0, text.rfind("e = ")).c_str());
+            EXPECT_EQ(
+                pad + "%" + pad + "\"\t" + pad + "\n",
+                std::string(config->lookupString("", "s")));
+            EXPECT_EQ(
+                pad + "\n" + pad + "%" + pad + "\n%",
+                std::string(config->lookupString("", "b")));
+        }
+    }
+    cfg::ByteScanner::select(cfg::ByteScanner::IMPL_BEST);
+}
+
+void
+test_binary_format()
+{
+    auto const path = std::string("Configuration_ut_") +
+        std::to_string(std::rand()) + ".cfgc";
+    auto const parse_error = [&](char const * source) {
+        std::string error;
+        try {
+            cfg::ext::Configuration config;
+            config.parse(source);
+        } catch (cfg::ConfigurationException const & ex) {
+            error = ex.c_str();
+        }
+        return error;
+    };
+
+    cfg::ext::Configuration text;
+    text.parse(
+        cfg::Configuration::INPUT_STRING,
+        "a = \"1\";\n"
+        "uid-x = \"first\";\n"
+        "s {\n"
+        "    z = [\"x\", \"y\", \"\"];\n"
+        "    empty = [];\n"
+        "    t { deep = \"1\"; shared = \"x\"; }\n"
+        "    b = \"x\";\n"
+        "}\n");
+    text.writeBinary(path);
+
+    // Loading the image gives the same entries, in the same order.
+    cfg::ext::Configuration binary;
+    binary.parse(cfg::Configuration::INPUT_BINARY, path.c_str());
+    EXPECT_EQ(std::string(binary.fileName()), path);
+    std::string expected, actual;
+    text.dump(expected);
+    binary.dump(actual);
+    EXPECT_EQ(expected, actual);
+    cfg::StringVector text_names, binary_names;
+    text->listFullyScopedNames(
+        "", "", cfg::Configuration::CFG_SCOPE_AND_VARS, true, text_names);
+    binary->listFullyScopedNames(
+        "", "", cfg::Configuration::CFG_SCOPE_AND_VARS, true, binary_names);
+    EXPECT_EQ(text_names.length(), binary_names.length());
+    for (int i = 0; i < text_names.length(); ++i) {
+        EXPECT_EQ(std::string(text_names[i]), std::string(binary_names[i]));
+    }
+    EXPECT_EQ(1, binary->lookupInt("s.t", "deep"));
+    if (auto opt = binary.lookupList("s.z"); EXPECT(opt)) {
+        EXPECT_EQ(3u, opt->size());
+    }
+
+    // "uid-" numbers carry on from where the saved configuration stopped.
+    binary.parse(cfg::Configuration::INPUT_STRING, "uid-x = \"second\";");
+    EXPECT_EQ("first"s, binary->lookupString("", "uid-000000000-x"));
+    EXPECT_EQ("second"s, binary->lookupString("", "uid-000000001-x"));
+
+    // Like parsing text, loading adds to (and replaces) existing entries.
+    {
+        cfg::ext::Configuration config;
+        config.parse(cfg::Configuration::INPUT_STRING, "a = \"0\"; c = \"2\";");
+        config.parse(("bin#" + path).c_str());
+        EXPECT_EQ(1, config->lookupInt("", "a"));
+        EXPECT_EQ(2, config->lookupInt("", "c"));
+    }
+    {
+        std::string error;
+        cfg::ext::Configuration config;
+        config.parse(cfg::Configuration::INPUT_STRING, "s = \"0\";");
+        try {
+            config.parse(cfg::Configuration::INPUT_BINARY, path.c_str());
+        } catch (cfg::ConfigurationException const & ex) {
+            error = ex.c_str();
+        }
+        EXPECT_EQ(
+            path + ": scope 's' was previously used as a variable name",
+            error);
+    }
+
+    // The same image can be kept in memory, as config2cpp -compiled does.
+    {
+        auto const memory_image = text.writeBinaryImage();
+        cfg::ext::Configuration config;
+        config.parseBinaryImage(memory_image, "embedded");
+        EXPECT_EQ("embedded"s, std::string(config.fileName()));
+        std::string dumped;
+        config.dump(dumped);
+        EXPECT_EQ(expected, dumped);
+
+        std::string error;
+        try {
+            cfg::ext::Configuration truncated;
+            truncated.parseBinaryImage(
+                std::string_view(memory_image).substr(0, 40), "embedded");
+        } catch (cfg::ConfigurationException const & ex) {
+            error = ex.c_str();
+        }
+        EXPECT_EQ(
+            "embedded: truncated or corrupt precompiled configuration"s,
+            error);
+    }
+
+    // Damaged files are rejected rather than trusted.
+    std::string image;
+    {
+        std::ifstream in(path, std::ios::binary);
+        image.assign(std::istreambuf_iterator<char>(in), {});
+    }
+    auto const rewrite = [&](std::string const & bytes) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+        return parse_error(("bin#" + path).c_str());
+    };
+    EXPECT_EQ(
+        path + ": truncated or corrupt precompiled configuration",
+        rewrite(image.substr(0, image.size() - 4)));
+    // Words are little-endian on every machine; a file with any other
+    // byte-order mark is rejected.
+    EXPECT_EQ("\x04\x03\x02\x01"s, image.substr(12, 4));
+    EXPECT_EQ("\x01\x00\x00\x00"s, image.substr(8, 4));
+    auto swapped = image;
+    std::reverse(swapped.begin() + 12, swapped.begin() + 16);
+    EXPECT_EQ(
+        path + ": precompiled configuration has a bad byte-order mark",
+        rewrite(swapped));
+    auto bad_version = image;
+    bad_version[8] = 99;
+    EXPECT_EQ(
+        path + ": unsupported precompiled configuration version 99 "
+        "(expected 1)",
+        rewrite(bad_version));
+    for (std::size_t i = 32; i < image.size(); i += 4) {
+        // Point every word in turn well past the end of the image.
+        auto damaged = image;
+        damaged[i + 3] = '\x7f';
+        auto const error = rewrite(damaged);
+        EXPECT(error.empty() || error.find(path + ": ") == 0);
+    }
+    // A scope referred to twice, or scopes nested too deeply, are
+    // rejected rather than read again or recursed into without limit.
+    cfg::ext::Configuration siblings;
+    siblings.parse(cfg::Configuration::INPUT_STRING, "a { } b { }");
+    auto shared = siblings.writeBinaryImage();
+    std::size_t root = 0;
+    for (int i = 3; i >= 0; --i) {
+        root = root * 256 + static_cast<unsigned char>(shared[20 + i]);
+    }
+    // Make b's value the offset of a's scope.
+    shared.replace(root + 4 + 20 + 8, 4, shared, root + 4 + 8, 4);
+    EXPECT_EQ(
+        path + ": truncated or corrupt precompiled configuration",
+        rewrite(shared));
+    auto const nested = [&](int depth) {
+        std::string source;
+        for (int i = 0; i < depth; ++i) {
+            source += "s { ";
+        }
+        source += "x = \"1\"; ";
+        for (int i = 0; i < depth; ++i) {
+            source += "} ";
+        }
+        cfg::ext::Configuration config;
+        config.parse(cfg::Configuration::INPUT_STRING, source.c_str());
+        return rewrite(config.writeBinaryImage());
+    };
+    EXPECT_EQ(""s, nested(1000));
+    EXPECT_EQ(
+        path + ": truncated or corrupt precompiled configuration",
+        nested(1001));
+    EXPECT_EQ(
+        path + ": not a precompiled configuration",
+        rewrite("a = \"1\";\n"));
+    std::remove(path.c_str());
+}
+
+void
+test_source_locations()
+{
+    auto const base = std::string("Configuration_ut_") +
+        std::to_string(std::rand());
+    auto const main_path = base + ".cfg";
+    auto const other_path = base + "_inc.cfg";
+    auto const binary_path = base + ".cfgc";
+    std::ofstream(other_path, std::ios::binary)
+        << "shared = \"other\";\n"
+           "\n"
+           "list = [\"a\"];\n";
+    std::ofstream(main_path, std::ios::binary)
+        << "top = \"1\";\n"
+           "@include \"" << other_path << "\";\n"
+           "s {\n"
+           "    inner = \"2\";\n"
+           "}\n"
+           "list += [\"b\"];\n"
+           "top ?= \"unused\";\n"
+           "copy { @copyFrom \"s\"; }\n";
+
+    cfg::ext::Configuration config;
+    config.parse(cfg::Configuration::INPUT_FILE, main_path.c_str());
+    config->insertString("", "inserted", "3");
+    auto const check = [&](cfg::ext::Configuration const & c) {
+        auto const expect_at = [&](char const * name, std::string const & file,
+                                   int line) {
+            if (auto loc = c.lookupLocation(name); EXPECT(loc)) {
+                EXPECT_EQ(file, std::string(loc->fileName));
+                EXPECT_EQ(line, loc->lineNumber);
+            }
+        };
+        expect_at("top", main_path, 1);
+        expect_at("shared", other_path, 1);
+        expect_at("s.inner", main_path, 4);
+        // "+=" replaces the entry; "?=" leaves it alone.
+        expect_at("list", main_path, 6);
+        // A copied entry keeps the location of the original.
+        expect_at("copy.inner", main_path, 4);
+        EXPECT(not c.lookupLocation("inserted"));
+        EXPECT(not c.lookupLocation("s"));
+        EXPECT(not c.lookupLocation("missing"));
+    };
+    check(config);
+
+    // The location is a parseable comment in dump(), if it is wanted.
+    std::string dumped;
+    config.dump(dumped, true, "s", true);
+    EXPECT_EQ(
+        "s {\n\tinner = \"2\"; # " + main_path + ":4\n}\n", dumped);
+    dumped.clear();
+    config.dump(dumped, true, "s");
+    EXPECT_EQ("s {\n\tinner = \"2\";\n}\n", dumped);
+    char const * file;
+    int line;
+    std::string error;
+    try {
+        config->lookupLocation("", "missing", file, line);
+    } catch (cfg::ConfigurationException const & ex) {
+        error = ex.c_str();
+    }
+    EXPECT_EQ(main_path + ": 'missing' is not an entry", error);
+
+    // Locations survive freeze() and the precompiled format.
+    cfg::Configuration * frozen = config->freeze();
+    EXPECT(frozen->lookupLocation("s", "inner", file, line));
+    EXPECT_EQ(main_path, std::string(file));
+    EXPECT_EQ(4, line);
+    frozen->destroy();
+    config.writeBinary(binary_path);
+    cfg::ext::Configuration binary;
+    binary.parse(cfg::Configuration::INPUT_BINARY, binary_path.c_str());
+    check(binary);
+
+    std::remove(main_path.c_str());
+    std::remove(other_path.c_str());
+    std::remove(binary_path.c_str());
+
+    // An image holds file names relative to the file that was parsed, not
+    // the absolute paths of the machine that built it.
+    {
+        TempDir dir;
+        std::filesystem::create_directory(dir.path / "sub");
+        auto const inc = dir.file("sub/inc.cfg");
+        auto const top = dir.file("top.cfg");
+        std::ofstream(inc) << "shared = \"x\";\n";
+        std::ofstream(top) << "top = \"1\";\n@include \"" << inc << "\";\n";
+        cfg::ext::Configuration absolute;
+        absolute.parse(cfg::Configuration::INPUT_FILE, top.c_str());
+        auto const image = absolute.writeBinaryImage();
+        EXPECT(image.find(dir.path.string()) == std::string::npos);
+        cfg::ext::Configuration embedded;
+        embedded.parseBinaryImage(image, "embedded");
+        if (auto loc = embedded.lookupLocation("top"); EXPECT(loc)) {
+            EXPECT_EQ("top.cfg"s, std::string(loc->fileName));
+        }
+        if (auto loc = embedded.lookupLocation("shared"); EXPECT(loc)) {
+            EXPECT_EQ(
+                (std::filesystem::path("sub") / "inc.cfg").string(),
+                std::string(loc->fileName));
+            EXPECT_EQ(1, loc->lineNumber);
+        }
+    }
+
+    // Reading locations does not block, or go wrong, while other threads
+    // add file names to the table.
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&failures, &base, t] {
+            for (int i = 0; i < 200; ++i) {
+                auto const name = base + "_thread" + std::to_string(t) + "_" +
+                    std::to_string(i);
+                cfg::ext::Configuration c;
+                c.parse(cfg::Configuration::INPUT_STRING, "x = \"1\";", name);
+                auto const loc = c.lookupLocation("x");
+                if (not loc or name != loc->fileName) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(0, failures.load());
+}
+
+void
+test_reparse_changed()
+{
+    auto const base = std::string("Configuration_ut_") +
+        std::to_string(std::rand());
+    auto const main_path = base + ".cfg";
+    auto const path = [&](char const * suffix) {
+        return base + "_" + suffix + ".cfg";
+    };
+    auto const write = [](std::string const & file, std::string const & text) {
+        std::ofstream(file, std::ios::binary | std::ios::trunc) << text;
+    };
+    auto const throws = [](auto && fn) {
+        try {
+            fn();
+        } catch (cfg::ConfigurationException const &) {
+            return true;
+        }
+        return false;
+    };
+    write(path("a"), "x = \"a\";\ny = \"a\";\ns { v = \"a\"; }\n");
+    write(path("b"), "x = \"b\";\nz = \"b\";\ns { w = \"b\"; }\n");
+    write(path("c"), "y = \"c\";\n");
+    write(main_path,
+          "@include \"" + path("a") + "\";\n"
+          "@include \"" + path("b") + "\";\n"
+          "@include \"" + path("c") + "\";\n");
+
+    cfg::ext::Configuration config;
+    config.parse(cfg::Configuration::INPUT_FILE, main_path.c_str());
+    auto const value = [&](char const * name) {
+        auto opt = config.lookupString(name);
+        return opt ? std::string(*opt) : "<none>"s;
+    };
+    EXPECT(not config.reparseChanged());
+    EXPECT_EQ("b"s, value("x"));
+
+    // Only the middle file changed, and a later file still overrides it.
+    write(path("b"), "x = \"b2\";\ny = \"b2\";\ns { w = \"b2\"; }\n");
+    EXPECT(config.reparseChanged());
+    EXPECT_EQ("b2"s, value("x"));
+    EXPECT_EQ("c"s, value("y"));
+    EXPECT_EQ("<none>"s, value("z"));
+    EXPECT_EQ("a"s, value("s.v"));
+    EXPECT_EQ("b2"s, value("s.w"));
+    EXPECT(not config.reparseChanged());
+
+    // A name the file no longer sets falls back to an earlier file.
+    write(path("b"), "z = \"b3\";\ns { w = \"b3\"; }\n");
+    EXPECT(config.reparseChanged());
+    EXPECT_EQ("a"s, value("x"));
+    EXPECT_EQ("b3"s, value("z"));
+    if (auto loc = config.lookupLocation("z"); EXPECT(loc)) {
+        EXPECT_EQ(path("b"), std::string(loc->fileName));
+        EXPECT_EQ(1, loc->lineNumber);
+    }
+
+    // @copyFrom depends on earlier files, so everything is parsed again.
+    write(path("b"), "x = \"b4\";\nt { @copyFrom \"s\"; }\ns { w = \"b4\"; }\n");
+    EXPECT(config.reparseChanged());
+    EXPECT_EQ("b4"s, value("x"));
+    EXPECT_EQ("a"s, value("t.v"));
+    EXPECT_EQ("<none>"s, value("t.w"));
+    write(path("b"), "x = \"b\";\ns { w = \"b\"; }\n");
+    EXPECT(config.reparseChanged());
+    EXPECT_EQ("<none>"s, value("t.v"));
+    EXPECT_EQ("b"s, value("s.w"));
+
+    // An error keeps the old values, and leaves the file to be parsed
+    // again next time.
+    write(path("c"), "y = ;\n");
+    EXPECT(throws([&] { config.reparseChanged(); }));
+    EXPECT_EQ("c"s, value("y"));
+    EXPECT_EQ("b"s, value("x"));
+    EXPECT_EQ("b"s, value("s.w"));
+    EXPECT(throws([&] { config.reparseChanged(); }));
+    write(path("c"), "y = \"c5\";\n");
+    EXPECT(config.reparseChanged());
+    EXPECT_EQ("c5"s, value("y"));
+    EXPECT_EQ("b"s, value("x"));
+
+#if defined(CONFIG4CPP_GLOB)
+    // A file that now matches an @include pattern is picked up.
+    auto const glob_path = base + "_top.cfg";
+    write(glob_path, "@include \"" + base + "_g*.cfg\";\n");
+    write(path("g1"), "x = \"g1\";\n");
+    cfg::ext::Configuration globbed;
+    globbed.parse(cfg::Configuration::INPUT_FILE, glob_path.c_str());
+    EXPECT(not globbed.reparseChanged());
+    write(path("g2"), "x = \"g2\";\n");
+    EXPECT(globbed.reparseChanged());
+    if (auto opt = globbed.lookupString("x"); EXPECT(opt)) {
+        EXPECT_EQ("g2"s, *opt);
+    }
+    std::remove(path("g1").c_str());
+    std::remove(path("g2").c_str());
+    std::remove(glob_path.c_str());
+#endif
+
+    // A change to a file read by readFile() is noticed.
+    auto const reader_path = base + "_reader.cfg";
+    write(path("r"), "r1");
+    write(reader_path, "r = readFile(\"" + path("r") + "\");\n");
+    cfg::ext::Configuration reader;
+    reader.parse(cfg::Configuration::INPUT_FILE, reader_path.c_str());
+    EXPECT(not reader.reparseChanged());
+    write(path("r"), "r22");
+    EXPECT(reader.reparseChanged());
+    if (auto opt = reader.lookupString("r"); EXPECT(opt)) {
+        EXPECT_EQ("r22"s, *opt);
+    }
+    std::remove(path("r").c_str());
+    std::remove(reader_path.c_str());
+
+    // A full parse sees the fallback configuration, as the first one did.
+    auto const fallback_path = base + "_fallback.cfg";
+    write(fallback_path, "msg = greeting + \" world\";\nname ?= \"local\";\n");
+    cfg::ext::Configuration fallback;
+    fallback.parse(cfg::Configuration::INPUT_STRING,
+                   "greeting = \"hello\"; name = \"fallback\";");
+    cfg::ext::Configuration with_fallback;
+    with_fallback->setFallbackConfiguration(fallback.operator -> ());
+    with_fallback.parse(cfg::Configuration::INPUT_FILE, fallback_path.c_str());
+    write(fallback_path,
+          "msg = greeting + \" there\";\nname ?= \"local, again\";\n");
+    EXPECT(with_fallback.reparseChanged());
+    EXPECT_EQ("hello there"s, with_fallback->lookupString("", "msg"));
+    EXPECT_EQ("fallback"s, with_fallback->lookupString("", "name"));
+    std::remove(fallback_path.c_str());
+
+    // "uid-" numbers carry on after the last one a full parse used.
+    auto const uid_path = base + "_uid.cfg";
+    write(uid_path, "uid-x = \"1\";\n");
+    cfg::ext::Configuration uids;
+    uids.parse(cfg::Configuration::INPUT_FILE, uid_path.c_str());
+    write(uid_path, "uid-x = \"1\";\nuid-x = \"2\";\n");
+    EXPECT(uids.reparseChanged());
+    uids.parse(cfg::Configuration::INPUT_STRING, "uid-x = \"3\";");
+    EXPECT_EQ("2"s, uids->lookupString("", "uid-000000001-x"));
+    EXPECT_EQ("3"s, uids->lookupString("", "uid-000000002-x"));
+    std::remove(uid_path.c_str());
+
+    // Only a configuration built from files alone can be brought up to date.
+    config->insertString("", "inserted", "1");
+    EXPECT(throws([&] { config.reparseChanged(); }));
+    config->empty();
+    config.parse(cfg::Configuration::INPUT_FILE, main_path.c_str());
+    EXPECT(not config.reparseChanged());
+    cfg::ext::Configuration string_based;
+    string_based.parse(cfg::Configuration::INPUT_STRING, "x = \"1\";");
+    EXPECT(throws([&] { string_based.reparseChanged(); }));
+
+    std::remove(main_path.c_str());
+    std::remove(path("a").c_str());
+    std::remove(path("b").c_str());
+    std::remove(path("c").c_str());
+}
+
+void
+test_config_watcher()
+{
+    TempDir const dir;
+    auto const main_path = dir.file("main.cfg");
+    auto const inc_path = dir.file("inc.cfg");
+    auto const read_path = dir.file("read.txt");
+    auto const other_path = dir.file("other.txt");
+    auto const missing_path = dir.file("missing.cfg");
+    auto const unwatched_path = dir.file("sub/missing.cfg");
+    auto const write = [](std::string const & file, std::string const & text) {
+        std::ofstream(file, std::ios::binary | std::ios::trunc) << text;
+    };
+    write(inc_path, "x = \"1\";\n");
+    write(read_path, "r1");
+    write(main_path,
+          "@include \"" + inc_path + "\";\n"
+          "@include \"" + missing_path + "\" @ifExists;\n"
+          "r = readFile(\"" + read_path + "\");\n");
+
+    cfg::ext::Configuration config;
+    config.parse(cfg::Configuration::INPUT_FILE, main_path.c_str());
+    cfg::StringVector files;
+    cfg::StringVector dirs;
+    config->listDependencies(files, dirs);
+    if (EXPECT_EQ(4, files.length())) {
+        EXPECT_EQ(main_path, std::string(files[0]));
+        EXPECT_EQ(inc_path, std::string(files[1]));
+        EXPECT_EQ(missing_path, std::string(files[2]));
+        EXPECT_EQ(read_path, std::string(files[3]));
+    }
+    EXPECT_EQ(0, dirs.length());
+#if defined(CONFIG4CPP_GLOB)
+    cfg::ext::Configuration globbed;
+    globbed.parse(cfg::Configuration::INPUT_STRING,
+                  "@include \"" + dir.file("inc*.cfg") + "\";");
+    globbed->listDependencies(files, dirs);
+    if (EXPECT_EQ(1, files.length()) && EXPECT_EQ(1, dirs.length())) {
+        EXPECT_EQ(inc_path, std::string(files[0]));
+        EXPECT_EQ(dir.path.string(), std::string(dirs[0]));
+    }
+#endif
+    // Dependencies outlive changes made other than by parsing.
+    config->insertString("", "inserted", "1");
+    config->listDependencies(files, dirs);
+    EXPECT_EQ(4, files.length());
+
+    config->empty();
+    config.parse(cfg::Configuration::INPUT_FILE, main_path.c_str());
+    auto const value = [&](char const * name) {
+        auto opt = config.lookupString(name);
+        return opt ? std::string(*opt) : "<none>"s;
+    };
+    cfg::ConfigWatcher watcher(config.operator -> (), 20);
+    EXPECT(not watcher.reloadIfChanged(0));
+
+    // A change to a file that is not a dependency is ignored.
+    write(other_path, "other");
+    EXPECT(not watcher.reloadIfChanged(100));
+
+    write(inc_path, "x = \"22\";\n");
+    EXPECT(watcher.reloadIfChanged(5000));
+    EXPECT_EQ("22"s, value("x"));
+    write(read_path, "r22");
+    EXPECT(watcher.reloadIfChanged(5000));
+    EXPECT_EQ("r22"s, value("r"));
+    write(missing_path, "x = \"333\";\n");
+    EXPECT(watcher.reloadIfChanged(5000));
+    EXPECT_EQ("333"s, value("x"));
+    EXPECT(not watcher.reloadIfChanged(0));
+
+    // A file in a directory that cannot be watched, because it does not
+    // exist yet, is polled instead.
+    write(main_path,
+          "@include \"" + inc_path + "\";\n"
+          "@include \"" + missing_path + "\" @ifExists;\n"
+          "@include \"" + unwatched_path + "\" @ifExists;\n"
+          "r = readFile(\"" + read_path + "\");\n");
+    EXPECT(watcher.reloadIfChanged(5000));
+    std::filesystem::create_directory(dir.path / "sub");
+    write(unwatched_path, "x = \"4444\";\n");
+    EXPECT(watcher.reloadIfChanged(5000));
+    EXPECT_EQ("4444"s, value("x"));
+    std::filesystem::remove(unwatched_path);
+    EXPECT(watcher.reloadIfChanged(5000));
+    EXPECT_EQ("333"s, value("x"));
+
+    // A burst of edits causes a single reload.
+    int reloads = 0;
+    cfg::ConfigWatcher counter(
+        config.operator -> (),
+        [&](cfg::Configuration * c) {
+            ++reloads;
+            c->empty();
+            c->parse(cfg::Configuration::INPUT_FILE, main_path.c_str());
+        },
+        200);
+    for (int i = 0; i < 5; ++i) {
+        write(inc_path, "x = \"" + std::to_string(i) + "\";\n");
+    }
+    EXPECT(counter.reloadIfChanged(5000));
+    EXPECT_EQ(1, reloads);
+    EXPECT(not counter.reloadIfChanged(0));
+    EXPECT_EQ("333"s, value("x"));
+}
+
+void
+test_arena_reuse()
+{
+    // Enough entries to grow the hash tables and a list large enough to
+    // need a block of its own, replaced, removed and then emptied.
+    cfg::ext::Configuration config;
+    std::vector<std::string> big(5000, "x");
+    std::vector<char const *> big_ptrs;
+    for (auto const & s : big) {
+        big_ptrs.push_back(s.c_str());
+    }
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 2000; ++i) {
+            auto const name = "n" + std::to_string(i);
+            config->insertString("", name.c_str(), name.c_str());
+        }
+        config->insertList("", "big", big_ptrs.data(), (int)big_ptrs.size());
+        config->insertList("", "big", big_ptrs.data(), 2);
+        config->remove("", "n0");
+        EXPECT_EQ(std::string("n1"), config->lookupString("", "n1"));
+        EXPECT_EQ(cfg::Configuration::CFG_NO_VALUE, config->type("", "n0"));
+        cfg::StringVector list;
+        config->lookupList("", "big", list);
+        EXPECT_EQ(2, list.length());
+        config->empty();
+        EXPECT_EQ(cfg::Configuration::CFG_NO_VALUE,
+                  config->type("", "n1"));
+    }
+}
+
+// A straightforward (quadratic space) reference for "*" wildcards.
+bool
+reference_match(std::string const & str, std::string const & pattern)
+{
+    std::vector<std::vector<bool>> m(
+        pattern.size() + 1, std::vector<bool>(str.size() + 1, false));
+    m[0][0] = true;
+    for (std::size_t p = 1; p <= pattern.size(); ++p) {
+        for (std::size_t s = 0; s <= str.size(); ++s) {
+            if (pattern[p - 1] == '*') {
+                m[p][s] = m[p - 1][s] || (s > 0 && m[p][s - 1]);
+            } else {
+                m[p][s] =
+                    s > 0 && m[p - 1][s - 1] && pattern[p - 1] == str[s - 1];
+            }
+        }
+    }
+    return m[pattern.size()][str.size()];
+}
+
+void
+test_pattern_match()
+{
+    using cfg::Configuration;
+
+    auto const random_text = [](char const * alphabet, int max_len) {
+        std::string result;
+        int const len = std::rand() % (max_len + 1);
+        for (int i = 0; i < len; ++i) {
+            result += alphabet[std::rand() % std::strlen(alphabet)];
+        }
+        return result;
+    };
+    for (int i = 0; i < 20000; ++i) {
+        auto const str = random_text("ab", 10);
+        auto const pattern = random_text("ab**", 8);
+        bool const expected = reference_match(str, pattern);
+        if (Configuration::patternMatch(str.c_str(), pattern.c_str())
+                != expected
+            || Configuration::patternMatch(
+                   str.c_str(), Configuration::Pattern(pattern.c_str()))
+                != expected)
+        {
+            throw std::runtime_error(
+                "pattern \"" + pattern + "\" and string \"" + str +
+                "\" should " + (expected ? "" : "not ") + "match");
+        }
+    }
+    EXPECT(Configuration::Pattern().matches(""));
+    EXPECT(not Configuration::Pattern().matches("a"));
+    EXPECT_EQ(3, Configuration::Pattern("*.a**").numWildcards());
+    EXPECT_EQ("*.a**"s, Configuration::Pattern("*.a**").c_str());
+
+    // Patterns with many wildcards used to take exponential time.
+    std::string const many(2000, 'a');
+    std::string const pathological = "*a*a*a*a*a*a*a*a*a*a*a*a*a*a*a*a*b";
+    EXPECT(not Configuration::patternMatch(many.c_str(), pathological.c_str()));
+    EXPECT(not Configuration::Pattern(pathological.c_str()).matches(many.c_str()));
+    EXPECT(Configuration::patternMatch((many + "b").c_str(), pathological.c_str()));
+
+    std::string const saved = std::setlocale(LC_CTYPE, nullptr);
+    if (std::setlocale(LC_CTYPE, "C.UTF-8") != nullptr) {
+        char const * const str = "h\xc3\xa9llo.w\xc3\xb6rld";
+        for (char const * pattern :
+             {"h*", "*rld", "h\xc3\xa9*", "*\xc3\xa9*\xc3\xb6*", "h?llo*",
+              "h*l*o.*", "*\xc3\xa9", "h\xc3\xa9llo.w\xc3\xb6rld"}) {
+            bool const expected = std::strchr(pattern, '?') == nullptr &&
+                std::strcmp(pattern, "*\xc3\xa9") != 0;
+            EXPECT_EQ(expected, Configuration::patternMatch(str, pattern));
+            EXPECT_EQ(
+                expected,
+                Configuration::Pattern(pattern).matches(str));
+        }
+        // A wildcard matches a whole character, never part of one.
+        EXPECT(Configuration::patternMatch("\xc3\xa9", "?") == false);
+        EXPECT(Configuration::patternMatch("x\xc3\xa9y", "x*y"));
+        EXPECT(not Configuration::patternMatch("x\xc3\xa9", "x*\xa9"));
+        // Bytes that do not decode can still be matched.
+        EXPECT(Configuration::patternMatch("a\xff", "a*"));
+        EXPECT(Configuration::patternMatch("a\xff", "*\xff"));
+        std::setlocale(LC_CTYPE, saved.c_str());
+    }
+}
+
+void
+test_list_filter_patterns()
+{
+    cfg::ext::Configuration config;
+    config.parse(
+        cfg::Configuration::INPUT_STRING,
+        "alpha { one = \"1\"; two = \"2\"; uid-item { x = \"3\"; } }\n"
+        "beta { one = \"1\"; alphabet = \"2\"; uid-item { x = \"4\"; } }\n"
+        "gamma.delta.one = \"5\";\n");
+
+    cfg::StringVector all;
+    config->listFullyScopedNames(
+        "", "", cfg::Configuration::CFG_SCOPE_AND_VARS, true, all);
+
+    // Every kind of pattern (exact, prefix, suffix and general), with
+    // some that match nothing, compared with matching one at a time.
+    std::vector<std::vector<char const *>> const lists = {
+        {"alpha.one"},
+        {"alpha*"},
+        {"*.one"},
+        {"*"},
+        {"*a*e*"},
+        {"uid-item"},
+        {"alpha.uid-item*", "*.x"},
+        {"beta.one", "gamma*", "*bet", "*.uid-item.*", "nothing", "*nothing"},
+        {"name\xc3\xa9", "*\xc3\xa9"},
+        {"*\xa9"},
+    };
+    std::string const saved = std::setlocale(LC_CTYPE, nullptr);
+    std::setlocale(LC_CTYPE, "C.UTF-8");
+    for (auto const & list : lists) {
+        cfg::StringVector patterns, actual, expected;
+        for (char const * pattern : list) {
+            patterns.add(pattern);
+        }
+        for (int i = 0; i < all.length(); ++i) {
+            cfg::StringBuffer buf;
+            char const * unexpanded = config->unexpandUid(all[i], buf);
+            for (char const * pattern : list) {
+                if (cfg::Configuration::patternMatch(unexpanded, pattern)) {
+                    expected.add(all[i]);
+                    break;
+                }
+            }
+        }
+        config->listFullyScopedNames(
+            "", "", cfg::Configuration::CFG_SCOPE_AND_VARS, true, patterns,
+            actual);
+        EXPECT_EQ(expected.length(), actual.length());
+        for (int i = 0; i < expected.length(); ++i) {
+            EXPECT_EQ(std::string(expected[i]), std::string(actual[i]));
+        }
+    }
+    std::setlocale(LC_CTYPE, saved.c_str());
+}
+
+void
+test_for_each()
+{
+    auto const throws = [](auto && fn) {
+        try {
+            fn();
+        } catch (cfg::ConfigurationException const &) {
+            return true;
+        }
+        return false;
+    };
+
+    cfg::ext::Configuration config;
+    config.parse(
+        cfg::Configuration::INPUT_STRING,
+        "a = \"1\";\n"
+        "s { list = [\"x\", \"y\"]; t { deep = \"2\"; } }\n"
+        "uid-item { x = \"3\"; }\n"
+        "b = \"4\";\n");
+
+    // The same names, in the same order, as listFullyScopedNames(), with
+    // the values stored in them. With no fallback or override
+    // configuration, those are the values that lookups give.
+    for (auto const type_mask :
+         {cfg::Configuration::CFG_SCOPE_AND_VARS,
+          cfg::Configuration::CFG_VARIABLES, cfg::Configuration::CFG_SCOPE}) {
+        for (char const * scope : {"", "s"}) {
+            for (bool const recursive : {true, false}) {
+                cfg::StringVector names;
+                config->listFullyScopedNames(
+                    scope, "", type_mask, recursive, names);
+                int count = 0;
+                config.forEach(
+                    scope, type_mask, recursive,
+                    [&](cfg::Configuration::Entry const & entry) {
+                        if (not EXPECT(count < names.length())) {
+                            return;
+                        }
+                        std::string const name = names[count++];
+                        EXPECT_EQ(name, std::string(entry.scopedName));
+                        EXPECT_EQ(
+                            int(name.size()), entry.scopedNameLength);
+                        EXPECT_EQ(config->type("", name.c_str()), entry.type);
+                        EXPECT_EQ(
+                            name.substr(name.rfind('.') + 1),
+                            std::string(entry.localName));
+                        if (entry.type == cfg::Configuration::CFG_STRING) {
+                            EXPECT_EQ(
+                                std::string(
+                                    config->lookupString("", name.c_str())),
+                                std::string(entry.stringValue));
+                        } else {
+                            EXPECT(entry.stringValue == nullptr);
+                        }
+                        if (entry.type == cfg::Configuration::CFG_LIST) {
+                            EXPECT_EQ(2, entry.listLength);
+                            EXPECT_EQ("y"s, std::string(entry.listValue[1]));
+                        } else {
+                            EXPECT(entry.listValue == nullptr);
+                        }
+                    });
+                EXPECT_EQ(names.length(), count);
+            }
+        }
+    }
+
+    EXPECT(throws([&] {
+        config.forEach("a", cfg::Configuration::CFG_SCOPE_AND_VARS, true,
+                       [](cfg::Configuration::Entry const &) {});
+    }));
+
+    // Only the configuration's own entries are visited, with their own
+    // values, even where lookups would find the fallback's or override's.
+    cfg::ext::Configuration fallback;
+    fallback.parse(cfg::Configuration::INPUT_STRING,
+                   "a = \"fallback\"; only_in_fallback = \"5\";");
+    cfg::ext::Configuration override_cfg;
+    override_cfg.parse(cfg::Configuration::INPUT_STRING,
+                       "b = \"override\";");
+    config->setFallbackConfiguration(fallback.operator -> ());
+    config->setOverrideConfiguration(override_cfg.operator -> ());
+    EXPECT_EQ("5"s, config->lookupString("", "only_in_fallback"));
+    EXPECT_EQ("override"s, config->lookupString("", "b"));
+    std::vector<std::string> visited;
+    config.forEach("", cfg::Configuration::CFG_STRING, false,
+                   [&](cfg::Configuration::Entry const & entry) {
+                       visited.push_back(
+                           std::string(entry.scopedName) + "=" +
+                           entry.stringValue);
+                   });
+    EXPECT_EQ(2u, visited.size());
+    if (visited.size() == 2) {
+        EXPECT_EQ("a=1"s, visited[0]);
+        EXPECT_EQ("b=4"s, visited[1]);
+    }
+    config->setFallbackConfiguration(nullptr);
+    config->setOverrideConfiguration(nullptr);
+}
+
+void
+test_list_view()
+{
+    static_assert(std::ranges::random_access_range<cfg::ext::ListView>);
+    auto const throws = [](auto && fn) {
+        try {
+            fn();
+        } catch (cfg::ConfigurationException const &) {
+            return true;
+        }
+        return false;
+    };
+
+    cfg::ext::Configuration config;
+    config.parse(
+        cfg::Configuration::INPUT_STRING,
+        "s { allow = [\"alpha\", \"\", \"gamma\"]; empty = []; }\n"
+        "str = \"x\";\n");
+
+    // The view is the stored list itself, not a copy.
+    if (auto view = config.lookupListView("s.allow"); EXPECT(view)) {
+        char const ** array;
+        int size;
+        config->lookupList("s", "allow", array, size);
+        EXPECT(view->data() == array);
+        EXPECT_EQ(std::size_t(3), view->size());
+        EXPECT_EQ("alpha"s, std::string((*view)[0]));
+        EXPECT(view->begin()[1].empty());
+        EXPECT_EQ("gamma"s, std::string(view->back()));
+        auto const copied = *config.lookupList("s.allow");
+        EXPECT(std::equal(view->begin(), view->end(), copied.begin(),
+                          copied.end()));
+        EXPECT(std::ranges::find(*view, "gamma") == view->end() - 1);
+    }
+    if (auto view = config.lookupListView("s.empty"); EXPECT(view)) {
+        EXPECT(view->empty());
+        EXPECT(view->begin() == view->end());
+    }
+    EXPECT(not config.lookupListView("s.missing"));
+    EXPECT(throws([&] { config.lookupListView("str"); }));
+}
+
+// Returns the error message from validating scope against schema, or ""
+// if it is valid.
+std::string
+schema_error(cfg::Configuration const * config, char const ** schema,
+             char const * scope = "", int num_threads = 1)
+{
+    cfg::SchemaValidator validator;
+    validator.numThreads(num_threads);
+    validator.parseSchema(schema);
+    try {
+        validator.validate(config, scope, "");
+    } catch (cfg::ConfigurationException const & ex) {
+        return ex.c_str();
+    }
+    return "";
+}
+
+void
+test_pattern_table()
+{
+    cfg::ext::Configuration config;
+    config.parse(
+        cfg::Configuration::INPUT_STRING,
+        R"(foo {
+               log_levels = [
+                   "A::op3", "4",
+                   "B::op1", "3",
+                   "B::*",   "1",
+                   "*::create*", "2",
+               ];
+               odd = ["a", "b", "c"];
+           })");
+    cfg::Configuration const * c = config.operator -> ();
+    cfg::Configuration::PatternTable table(c, "foo", "log_levels");
+    EXPECT_EQ(4, table.numRows());
+    EXPECT_EQ(2, table.numColumns());
+    EXPECT_EQ("B::*"s, table.cell(2, 0));
+    EXPECT_EQ("1"s, table.cell(2, 1));
+
+    // The first matching row wins, and remembered rows give the same answer.
+    for (int round = 0; round < 2; ++round) {
+        EXPECT_EQ(0, table.findRow("A::op3"));
+        EXPECT_EQ(1, table.findRow("B::op1"));
+        EXPECT_EQ(2, table.findRow("B::create"));
+        EXPECT_EQ(3, table.findRow("A::createFoo"));
+        EXPECT_EQ(-1, table.findRow("A::op1"));
+        EXPECT_EQ(-1, table.findRow(""));
+    }
+
+    // Threads looking up the same names at once agree with each other.
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; ++i) {
+        names.push_back((i % 3 ? "B::call"s : "A::create"s) + std::to_string(i));
+    }
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (auto const & name : names) {
+                int const expected = name[0] == 'B' ? 2 : 3;
+                if (table.findRow(name.c_str()) != expected) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(0, mismatches.load());
+
+    // A change to the configuration rebuilds the table on the next lookup,
+    // which forgets the rows that were found with the old table.
+    config.parse(cfg::Configuration::INPUT_STRING,
+                 R"(foo.log_levels = ["*", "0"];)");
+    EXPECT_EQ(0, table.findRow("A::op1"));
+    EXPECT_EQ(0, table.findRow("B::op1"));
+    EXPECT_EQ(1, table.numRows());
+    config.insertList("foo.log_levels", std::vector<char const *>{"B::*", "5"});
+    EXPECT_EQ(-1, table.findRow("A::op1"));
+    EXPECT_EQ(0, table.findRow("B::op1"));
+    EXPECT_EQ("5"s, table.cell(0, 1));
+
+    std::string error;
+    try {
+        table.reload(c, "foo", "odd");
+    } catch (cfg::ConfigurationException const & ex) {
+        error = ex.c_str();
+    }
+    EXPECT_EQ("<string-based configuration>: the number of entries in the "
+              "'foo.odd' table is not a multiple of 2"s, error);
+    EXPECT_EQ(0, table.numRows());
+    EXPECT_EQ(-1, table.findRow("B::op1"));
+    config.insertList("foo.odd", std::vector<char const *>{"B::*", "5"});
+    EXPECT_EQ(0, table.findRow("B::op1"));
+
+    // So does reparseChanged(), as a ConfigWatcher uses it.
+    TempDir dir;
+    std::string const file = dir.file("levels.cfg");
+    std::ofstream(file) << R"(log_levels = ["A::*", "1"];)";
+    cfg::ext::Configuration watched;
+    watched.parse(cfg::Configuration::INPUT_FILE, file.c_str());
+    cfg::Configuration::PatternTable fileTable(
+        watched.operator -> (), "", "log_levels");
+    EXPECT_EQ(-1, fileTable.findRow("B::op1"));
+    std::ofstream(file, std::ios::trunc)
+        << R"(log_levels = ["A::*", "1", "B::*", "2"];)";
+    EXPECT(watched->reparseChanged());
+    EXPECT_EQ(1, fileTable.findRow("B::op1"));
+    EXPECT_EQ(2, fileTable.numRows());
+
+    // A fallback configuration's changes count too.
+    cfg::ext::Configuration fallback;
+    fallback.parse(cfg::Configuration::INPUT_STRING,
+                   R"(log_levels = ["*", "3"];)");
+    cfg::ext::Configuration primary;
+    primary->setFallbackConfiguration(fallback.operator -> ());
+    unsigned long const before = primary->generation();
+    fallback.insertString("x", "1");
+    EXPECT(primary->generation() != before);
+}
+
+void
+test_schema_ignore_rules()
+{
+    cfg::ext::Configuration config;
+    config.parse(
+        cfg::Configuration::INPUT_STRING,
+        "uid-host { name = \"a\"; extra { x = \"1\"; } }\n"
+        "uid-host { name = \"b\"; misc = \"2\"; }\n"
+        "notes { a = \"1\"; b { c = \"2\"; } }\n"
+        "notesX = \"3\";\n"
+        "vars { v = \"1\"; s { t = \"2\"; } }\n"
+        "scopes { v = \"1\"; s { t = \"2\"; } }\n");
+
+    char const * rules[] = {
+        "uid-host = scope",
+        "uid-host.name = string",
+        "notes = scope",
+        "notesX = string",
+        "vars = scope",
+        "scopes = scope",
+        "@ignoreEverythingIn notes",
+        "@ignoreScopesIn uid-host",
+        "@ignoreVariablesIn uid-host",
+        "@ignoreVariablesIn vars",
+        "@ignoreScopesIn scopes",
+        nullptr,
+        nullptr,
+    };
+    // vars.s and scopes.v are not ignored, so the schema is incomplete.
+    EXPECT_EQ("<string-based configuration>: the 'vars.s' scope is unknown."s,
+              schema_error(config.operator->(), rules));
+    rules[9] = "@ignoreEverythingIn vars";
+    EXPECT_EQ(
+        "<string-based configuration>: the 'scopes.v' variable is unknown."s,
+        schema_error(config.operator->(), rules));
+    rules[11] = "scopes.v = string";
+    EXPECT_EQ(""s, schema_error(config.operator->(), rules));
+
+    // An ignore rule applies only to a whole scope name, so "notes" does
+    // not cover "notesX", and unknown names in a uid- scope are reported
+    // with their expanded names.
+    char const * partial[] = {
+        "uid-host = scope",
+        "uid-host.name = string",
+        "notes = scope",
+        "vars = scope",
+        "scopes = scope",
+        "@ignoreEverythingIn notes",
+        "@ignoreEverythingIn vars",
+        "@ignoreEverythingIn scopes",
+        "@ignoreVariablesIn uid-host",
+        nullptr,
+    };
+    EXPECT_EQ("<string-based configuration>: the 'uid-000000000-host.extra' "
+              "scope is unknown."s,
+              schema_error(config.operator->(), partial));
+    partial[8] = "@ignoreScopesIn uid-host";
+    EXPECT_EQ("<string-based configuration>: the 'uid-000000001-host.misc' "
+              "variable is unknown."s,
+              schema_error(config.operator->(), partial));
+    partial[8] = "@ignoreEverythingIn uid-host";
+    EXPECT_EQ("<string-based configuration>: the 'notesX' variable is "
+              "unknown."s,
+              schema_error(config.operator->(), partial));
+
+    // Validating a nested scope matches rules against names relative to
+    // that scope.
+    char const * nested[] = {
+        "a = string",
+        "b = scope",
+        "@ignoreScopesIn b",
+        nullptr,
+    };
+    EXPECT_EQ("<string-based configuration>: the 'notes.b.c' variable is "
+              "unknown."s,
+              schema_error(config.operator->(), nested, "notes"));
+    nested[2] = "@ignoreVariablesIn b";
+    EXPECT_EQ(""s, schema_error(config.operator->(), nested, "notes"));
+
+    // Id rules are found by their unexpanded names, and a value of the
+    // wrong type is still reported.
+    char const * typed[] = {
+        "uid-host = scope",
+        "uid-host.name = int",
+        "@ignoreEverythingIn uid-host.extra",
+        "@ignoreScopesIn notes",
+        "@ignoreVariablesIn notes",
+        "notes = scope",
+        "notesX = int",
+        "vars = scope",
+        "scopes = scope",
+        "@ignoreEverythingIn vars",
+        "@ignoreEverythingIn scopes",
+        "uid-host.misc = string",
+        nullptr,
+    };
+    EXPECT(schema_error(config.operator->(), typed).find("uid-000000000-host.name")
+           != std::string::npos);
+}
+
+void
+test_schema_parallel_validation()
+{
+    char const * schema[] = {
+        "uid-upstream = scope",
+        "uid-upstream.host = string",
+        "uid-upstream.port = int[1, 65535]",
+        "uid-upstream.uid-server = scope",
+        "uid-upstream.uid-server.weight = int",
+        "timeout = durationMilliseconds",
+        nullptr,
+    };
+    auto const make_input = [](std::vector<int> const & bad) {
+        std::string input = "timeout = \"5 seconds\";\n";
+        for (int i = 0; i < 500; ++i) {
+            bool const is_bad =
+                std::find(bad.begin(), bad.end(), i) != bad.end();
+            input += "uid-upstream { host = \"h" + std::to_string(i) +
+                "\"; port = \"" + (is_bad ? "x" : "80") + "\";\n";
+            for (int j = 0; j < 3; ++j) {
+                input += "  uid-server { weight = \"" + std::to_string(j) +
+                    "\"; }\n";
+            }
+            input += "}\n";
+        }
+        return input;
+    };
+
+    // Every thread count reports the same error as the serial path,
+    // which is the first invalid item, wherever it is.
+    std::vector<std::vector<int>> const bad_lists = {
+        {}, {0}, {499}, {250}, {3, 400}, {499, 17, 260}};
+    for (auto const & bad : bad_lists) {
+        cfg::ext::Configuration config;
+        config.parse(
+            cfg::Configuration::INPUT_STRING, make_input(bad).c_str());
+        std::string const expected = schema_error(config.operator->(), schema);
+        EXPECT_EQ(bad.empty(), expected.empty());
+        if (!bad.empty()) {
+            auto const first = *std::min_element(bad.begin(), bad.end());
+            char uid[32];
+            std::snprintf(uid, sizeof(uid), "uid-%09d-upstream", first * 4);
+            EXPECT(expected.find(uid) != std::string::npos);
+        }
+        for (int num_threads : {2, 3, 8, 64}) {
+            EXPECT_EQ(
+                expected,
+                schema_error(config.operator->(), schema, "", num_threads));
+        }
+    }
+}
+
+void
+test_schema_collect_errors()
+{
+    cfg::ext::Configuration config;
+    config.parse(
+        cfg::Configuration::INPUT_STRING,
+        "uid-upstream { host = \"a\"; port = \"80\"; }\n"
+        "uid-upstream { host = \"b\"; port = \"x\"; }\n"
+        "uid-upstream { port = \"81\"; colour = \"red\"; }\n"
+        "timeout = \"soon\";\n"
+        "extra { x = \"1\"; }\n");
+    char const * schema[] = {
+        "uid-upstream = scope",
+        "@required uid-upstream.host = string",
+        "uid-upstream.port = int[1, 65535]",
+        "timeout = durationMilliseconds",
+        "@required name = string",
+        nullptr,
+    };
+    using Error = cfg::SchemaValidator::Error;
+    struct Expected
+    {
+        char const * name;
+        char const * rule;
+        char const * type;
+        int line; // -1 for scopes and missing entries
+    };
+    std::vector<Expected> const expected = {
+        {"uid-000000001-upstream.port", "uid-upstream.port = int[1, 65535]",
+         "int", 2},
+        {"uid-000000002-upstream.colour", "", "", 3},
+        {"timeout", "timeout = durationMilliseconds", "durationMilliseconds",
+         4},
+        {"extra", "", "", -1},
+        {"extra.x", "", "", 5},
+        {"name", "@required name = string", "string", -1},
+        {"uid-000000002-upstream.host", "@required uid-upstream.host = string",
+         "string", -1},
+    };
+
+    // The first error collected is the one that is thrown, and every
+    // thread count collects the same errors in the same order.
+    std::string const first = schema_error(config.operator->(), schema);
+    for (int num_threads : {1, 2, 4}) {
+        cfg::SchemaValidator validator;
+        validator.numThreads(num_threads);
+        validator.parseSchema(schema);
+        std::vector<Error> errors(1);
+        validator.validate(
+            config.operator->(), "", "", true,
+            cfg::Configuration::CFG_SCOPE_AND_VARS,
+            cfg::SchemaValidator::DO_NOT_FORCE, errors);
+        EXPECT_EQ(expected.size(), errors.size());
+        EXPECT_EQ(first, std::string(errors[0].message.c_str()));
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(std::string(expected[i].name),
+                      errors[i].fullyScopedName.c_str());
+            EXPECT_EQ(std::string(expected[i].rule), errors[i].rule.c_str());
+            EXPECT_EQ(std::string(expected[i].type),
+                      errors[i].typeName.c_str());
+            EXPECT(std::strstr(errors[i].message.c_str(),
+                               errors[i].fullyScopedName.c_str()));
+            EXPECT_EQ("<string-based configuration>"s,
+                      errors[i].fileName.c_str());
+            EXPECT_EQ(expected[i].line, errors[i].lineNumber);
+        }
+    }
+}
+
 int
 Main(int argc, char * argv[])
 {
@@ -420,6 +2111,26 @@ Main(int argc, char * argv[])
     test_fallback_config();
     test_override_config();
     test_glob_include();
+    test_key_lookup();
+    test_typed_value_cache();
+    test_freeze();
+    test_configuration_handle();
+    test_parse_file();
+    test_multibyte_input();
+    test_lexer_scanning();
+    test_binary_format();
+    test_source_locations();
+    test_reparse_changed();
+    test_config_watcher();
+    test_arena_reuse();
+    test_pattern_match();
+    test_list_filter_patterns();
+    test_for_each();
+    test_list_view();
+    test_pattern_table();
+    test_schema_ignore_rules();
+    test_schema_parallel_validation();
+    test_schema_collect_errors();
     return 0;
 }
 